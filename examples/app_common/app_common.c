@@ -814,6 +814,18 @@ static void SampleSenderBandwidthEstimationHandler( void * pCustomContext,
 }
 #endif
 
+static void HandlePictureLossIndication( void * pCustomContext,
+                                         RtcpPliPacket_t * pRtcpPliPacket )
+{
+    AppMediaSourcesContext_t * pAppMediaSourcesContext = ( AppMediaSourcesContext_t * ) pCustomContext;
+
+    if( ( pAppMediaSourcesContext != NULL ) && ( pRtcpPliPacket != NULL ) )
+    {
+        LogDebug( ( "Received keyframe request for ssrc: %lu", pRtcpPliPacket->mediaSourceSsrc ) );
+        ( void ) AppMediaSource_RequestKeyFrame( pAppMediaSourcesContext );
+    }
+}
+
 static int32_t InitializeAppSession( AppContext_t * pAppContext,
                                      AppSession_t * pAppSession )
 {
@@ -850,6 +862,19 @@ static int32_t InitializeAppSession( AppContext_t * pAppContext,
     }
 #endif /* ENABLE_TWCC_SUPPORT */
 
+    if( peerConnectionResult == PEER_CONNECTION_RESULT_OK )
+    {
+        /* All sessions share one encoder, so PLI/FIR from every viewer goes to the same arbiter. */
+        peerConnectionResult = PeerConnection_SetPictureLossIndicationCallback( &pAppSession->peerConnectionSession,
+                                                                                HandlePictureLossIndication,
+                                                                                pAppContext->pAppMediaSourcesContext );
+        if( peerConnectionResult != PEER_CONNECTION_RESULT_OK )
+        {
+            LogError( ( "Fail to set Picture Loss Indication Callback, result: %d", peerConnectionResult ) );
+            ret = -1;
+        }
+    }
+
     if( ret == 0 )
     {
         pAppSession->pSignalingControllerContext = &( pAppContext->signalingControllerContext );
@@ -893,7 +918,13 @@ static PeerConnectionResult_t HandleRxAudioFrame( void * pCustomContext,
     AppContext_t * pAppContext = ( AppContext_t * ) pCustomContext;
     MediaFrame_t frame;
 
-    if( pFrame != NULL )
+    if( ( pFrame != NULL ) &&
+        ( ( pFrame->flags & PEER_CONNECTION_FRAME_FLAG_OPUS_FEC ) != 0U ) )
+    {
+        /* The media sink plays packets as they are and can't decode in-band FEC, skip the recovered frame. */
+        LogDebug( ( "Skipping Opus FEC frame with length: %u", pFrame->dataLength ) );
+    }
+    else if( pFrame != NULL )
     {
         LogDebug( ( "Received audio frame with length: %u", pFrame->dataLength ) );
 
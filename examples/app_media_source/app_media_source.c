@@ -45,18 +45,31 @@
 #define DEMO_TRANSCEIVER_MAX_TX_QUEUE_MSG_NUM ( 10 )
 #define DEMO_TRANSCEIVER_MAX_RX_QUEUE_MSG_NUM ( 10 )
 
+/* Maximum frames drained from a data queue per wake-up. */
+#define DEMO_TRANSCEIVER_QUEUE_BATCH_MSG_NUM ( 4 )
+
+/* Minimum spacing between two encoder IDRs triggered by PLI/FIR. Requests arriving
+ * inside this window are merged and served once the window expires. */
+#ifndef APP_MEDIA_SOURCE_MIN_KEYFRAME_INTERVAL_MS
+#define APP_MEDIA_SOURCE_MIN_KEYFRAME_INTERVAL_MS ( 1000 )
+#endif
+
 static void VideoTx_Task( void * pParameter );
 static void AudioTx_Task( void * pParameter );
 static int32_t OnFrameReadyToSend( void * pCtx,
                                    MediaFrame_t * pFrame );
+static int32_t ServiceKeyFrameRequest( AppMediaSourcesContext_t * pCtx,
+                                       uint8_t isNewRequest );
 
 static void VideoTx_Task( void * pParameter )
 {
     AppMediaSourceContext_t * pVideoContext = ( AppMediaSourceContext_t * )pParameter;
     MessageQueueResult_t retMessageQueue;
     uint8_t skipProcess = 0;
-    MediaFrame_t frame;
-    size_t frameLength;
+    MediaFrame_t frames[ DEMO_TRANSCEIVER_QUEUE_BATCH_MSG_NUM ];
+    MediaFrame_t * pFrame;
+    size_t frameNum;
+    size_t i;
 
     if( pVideoContext == NULL )
     {
@@ -70,30 +83,42 @@ static void VideoTx_Task( void * pParameter )
         /* Intentional infinite loop to keep addressing media frames from hardware. */
         while( 1 )
         {
-            /* Recevied message from data queue. */
-            frameLength = sizeof( MediaFrame_t );
-            retMessageQueue = MessageQueue_Recv( &pVideoContext->dataTxQueue,
-                                                 &frame,
-                                                 &frameLength );
+            /* Recevied messages from data queue, all frames already pending are handled in one wake-up. */
+            retMessageQueue = MessageQueue_RecvBatch( &pVideoContext->dataTxQueue,
+                                                      frames,
+                                                      sizeof( frames ),
+                                                      &frameNum,
+                                                      portMAX_DELAY );
             if( retMessageQueue == MESSAGE_QUEUE_RESULT_OK )
             {
-                /* Received a media frame. */
-                LogVerbose( ( "Video Tx frame(%ld), trackKind: %d, timestamp: %llu, payload: 0x%x 0x%x 0x%x 0x%x", frame.size, frame.trackKind, frame.timestampUs, frame.pData[0], frame.pData[1], frame.pData[2], frame.pData[3] ) );
-
-                if( pVideoContext->pSourcesContext->onMediaSinkHookFunc )
+                for( i = 0; i < frameNum; i++ )
                 {
-                    ( void ) pVideoContext->pSourcesContext->onMediaSinkHookFunc( pVideoContext->pSourcesContext->pOnMediaSinkHookCustom,
-                                                                                  &frame );
+                    /* Received a media frame. */
+                    pFrame = &frames[ i ];
+                    LogVerbose( ( "Video Tx frame(%ld), trackKind: %d, timestamp: %llu, payload: 0x%x 0x%x 0x%x 0x%x", pFrame->size, pFrame->trackKind, pFrame->timestampUs, pFrame->pData[0], pFrame->pData[1], pFrame->pData[2], pFrame->pData[3] ) );
+
+                    if( pVideoContext->pSourcesContext->onMediaSinkHookFunc )
+                    {
+                        ( void ) pVideoContext->pSourcesContext->onMediaSinkHookFunc( pVideoContext->pSourcesContext->pOnMediaSinkHookCustom,
+                                                                                      pFrame );
+                    }
+
+                    if( pFrame->freeData )
+                    {
+                        vPortFree( pFrame->pData );
+                    }
                 }
 
-                if( frame.freeData )
+                /* Serve a keyframe request that was held back by the minimum IDR interval. */
+                if( pVideoContext->pSourcesContext->keyFrameRequestPending != 0U )
                 {
-                    vPortFree( frame.pData );
+                    ( void ) ServiceKeyFrameRequest( pVideoContext->pSourcesContext,
+                                                     0U );
                 }
             }
             else
             {
-                LogError( ( " VideoTx_Task: MessageQueue_Recv failed with error %d", retMessageQueue ) );
+                LogError( ( " VideoTx_Task: MessageQueue_RecvBatch failed with error %d", retMessageQueue ) );
             }
         }
     }
@@ -109,8 +134,10 @@ static void AudioTx_Task( void * pParameter )
     AppMediaSourceContext_t * pAudioContext = ( AppMediaSourceContext_t * )pParameter;
     MessageQueueResult_t retMessageQueue;
     uint8_t skipProcess = 0;
-    MediaFrame_t frame;
-    size_t frameLength;
+    MediaFrame_t frames[ DEMO_TRANSCEIVER_QUEUE_BATCH_MSG_NUM ];
+    MediaFrame_t * pFrame;
+    size_t frameNum;
+    size_t i;
 
     if( pAudioContext == NULL )
     {
@@ -124,29 +151,34 @@ static void AudioTx_Task( void * pParameter )
         /* Intentional infinite loop to keep addressing media frames from hardware. */
         while( 1 )
         {
-            /* Recevied message from data queue. */
-            frameLength = sizeof( MediaFrame_t );
-            retMessageQueue = MessageQueue_Recv( &pAudioContext->dataTxQueue,
-                                                 &frame,
-                                                 &frameLength );
+            /* Recevied messages from data queue, all frames already pending are handled in one wake-up. */
+            retMessageQueue = MessageQueue_RecvBatch( &pAudioContext->dataTxQueue,
+                                                      frames,
+                                                      sizeof( frames ),
+                                                      &frameNum,
+                                                      portMAX_DELAY );
             if( retMessageQueue == MESSAGE_QUEUE_RESULT_OK )
             {
-                /* Received a media frame. */
-                LogVerbose( ( "Audio Tx frame(%ld), track kind: %d, timestampUs: %llu", frame.size, frame.trackKind, frame.timestampUs ) );
-
-                if( pAudioContext->pSourcesContext->onMediaSinkHookFunc )
+                for( i = 0; i < frameNum; i++ )
                 {
-                    ( void ) pAudioContext->pSourcesContext->onMediaSinkHookFunc( pAudioContext->pSourcesContext->pOnMediaSinkHookCustom,
-                                                                                  &frame );
-                }
-                if( frame.freeData )
-                {
-                    vPortFree( frame.pData );
+                    /* Received a media frame. */
+                    pFrame = &frames[ i ];
+                    LogVerbose( ( "Audio Tx frame(%ld), track kind: %d, timestampUs: %llu", pFrame->size, pFrame->trackKind, pFrame->timestampUs ) );
+
+                    if( pAudioContext->pSourcesContext->onMediaSinkHookFunc )
+                    {
+                        ( void ) pAudioContext->pSourcesContext->onMediaSinkHookFunc( pAudioContext->pSourcesContext->pOnMediaSinkHookCustom,
+                                                                                      pFrame );
+                    }
+                    if( pFrame->freeData )
+                    {
+                        vPortFree( pFrame->pData );
+                    }
                 }
             }
             else
             {
-                LogError( ( " AudioTx_Task: MessageQueue_Recv failed with error %d", retMessageQueue ) );
+                LogError( ( " AudioTx_Task: MessageQueue_RecvBatch failed with error %d", retMessageQueue ) );
             }
         }
     }
@@ -452,6 +484,64 @@ static int32_t InitializeAudioSource( AppMediaSourceContext_t * pAudioSource )
     return ret;
 }
 
+static int32_t ServiceKeyFrameRequest( AppMediaSourcesContext_t * pCtx,
+                                       uint8_t isNewRequest )
+{
+    int32_t ret = 0;
+    TickType_t currentTick;
+
+    if( xSemaphoreTake( pCtx->mediaMutex,
+                        portMAX_DELAY ) == pdTRUE )
+    {
+        if( isNewRequest != 0U )
+        {
+            pCtx->keyFrameRequestPending = 1U;
+        }
+
+        currentTick = xTaskGetTickCount();
+
+        if( pCtx->keyFrameRequestPending == 0U )
+        {
+            /* Already served by another request. */
+        }
+        else if( pCtx->totalNumReadyPeer == 0U )
+        {
+            /* Nobody is receiving video, the next stream start begins with an IDR anyway. */
+            pCtx->keyFrameRequestPending = 0U;
+        }
+        else if( ( pCtx->keyFrameRequestIssued == 0U ) ||
+                 ( ( currentTick - pCtx->lastKeyFrameRequestTick ) >= pdMS_TO_TICKS( APP_MEDIA_SOURCE_MIN_KEYFRAME_INTERVAL_MS ) ) )
+        {
+            ret = AppMediaSourcePort_RequestKeyFrame();
+            if( ret == 0 )
+            {
+                LogInfo( ( "Requested keyframe from encoder." ) );
+                pCtx->lastKeyFrameRequestTick = currentTick;
+                pCtx->keyFrameRequestIssued = 1U;
+                pCtx->keyFrameRequestPending = 0U;
+            }
+            else
+            {
+                LogWarn( ( "Fail to request keyframe from encoder, result: %ld", ret ) );
+            }
+        }
+        else
+        {
+            /* Keep it pending, VideoTx_Task retries once the interval expires. */
+            LogDebug( ( "Coalescing keyframe request." ) );
+        }
+
+        xSemaphoreGive( pCtx->mediaMutex );
+    }
+    else
+    {
+        LogError( ( "Failed to lock media mutex for keyframe request." ) );
+        ret = -1;
+    }
+
+    return ret;
+}
+
 static int32_t OnFrameReadyToSend( void * pCtx,
                                    MediaFrame_t * pFrame )
 {
@@ -474,13 +564,20 @@ static int32_t OnFrameReadyToSend( void * pCtx,
         if( retMessageQueue == MESSAGE_QUEUE_RESULT_MQ_IS_FULL )
         {
             dropFrameSize = sizeof( MediaFrame_t );
-            ( void ) MessageQueue_Recv( &pMediaSource->dataTxQueue,
-                                        &dropFrame,
-                                        &dropFrameSize );
+            retMessageQueue = MessageQueue_DropOldest( &pMediaSource->dataTxQueue,
+                                                       &dropFrame,
+                                                       &dropFrameSize );
 
-            if( dropFrame.freeData )
+            if( retMessageQueue == MESSAGE_QUEUE_RESULT_OK )
             {
-                vPortFree( dropFrame.pData );
+                LogDebug( ( "Drop oldest Tx frame, track kind: %d, total dropped: %lu",
+                            dropFrame.trackKind,
+                            MessageQueue_GetDroppedNum( &pMediaSource->dataTxQueue ) ) );
+
+                if( dropFrame.freeData )
+                {
+                    vPortFree( dropFrame.pData );
+                }
             }
         }
     }
@@ -696,11 +793,11 @@ int32_t AppMediaSource_RecvFrame( AppMediaSourcesContext_t * pCtx,
             if( retMessageQueue == MESSAGE_QUEUE_RESULT_MQ_IS_FULL )
             {
                 frameSize = sizeof( MediaFrame_t );
-                ( void ) MessageQueue_Recv( &pMediaSource->dataRxQueue,
-                                            &frame,
-                                            &frameSize );
+                retMessageQueue = MessageQueue_DropOldest( &pMediaSource->dataRxQueue,
+                                                           &frame,
+                                                           &frameSize );
 
-                if( frame.freeData )
+                if( ( retMessageQueue == MESSAGE_QUEUE_RESULT_OK ) && frame.freeData )
                 {
                     vPortFree( frame.pData );
                 }
@@ -755,3 +852,22 @@ int32_t AppMediaSource_RecvFrame( AppMediaSourcesContext_t * pCtx,
 
     return ret;
 }
+
+int32_t AppMediaSource_RequestKeyFrame( AppMediaSourcesContext_t * pCtx )
+{
+    int32_t ret = 0;
+
+    if( pCtx == NULL )
+    {
+        LogError( ( "Invalid input, pCtx: %p", pCtx ) );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        ret = ServiceKeyFrameRequest( pCtx,
+                                      1U );
+    }
+
+    return ret;
+}
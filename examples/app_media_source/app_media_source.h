@@ -56,6 +56,12 @@ typedef struct AppMediaSourcesContext
     AppMediaSourceOnMediaSinkHook onMediaSinkHookFunc;
     void * pOnMediaSinkHookCustom;
     uint8_t totalNumReadyPeer;
+
+    /* Keyframe requests from all sessions are coalesced here so that several lossy
+     * viewers trigger at most one encoder IDR per APP_MEDIA_SOURCE_MIN_KEYFRAME_INTERVAL_MS. */
+    TickType_t lastKeyFrameRequestTick;
+    uint8_t keyFrameRequestIssued;
+    volatile uint8_t keyFrameRequestPending;
 } AppMediaSourcesContext_t;
 
 int32_t AppMediaSource_Init( AppMediaSourcesContext_t * pCtx,
@@ -67,6 +73,7 @@ int32_t AppMediaSource_InitAudioTransceiver( AppMediaSourcesContext_t * pCtx,
                                              Transceiver_t * pAudioTranceiver );
 int32_t AppMediaSource_RecvFrame( AppMediaSourcesContext_t * pCtx,
                                   MediaFrame_t * pFrame );
+int32_t AppMediaSource_RequestKeyFrame( AppMediaSourcesContext_t * pCtx );
 
 #ifdef __cplusplus
 }
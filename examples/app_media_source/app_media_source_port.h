@@ -45,6 +45,7 @@ int32_t AppMediaSourcePort_Start( OnFrameReadyToSend_t onVideoFrameReadyToSendFu
 void AppMediaSourcePort_Stop( void );
 void AppMediaSourcePort_Destroy( void );
 void AppMediaSourcePort_PlayAudioFrame( MediaFrame_t * pFrame );
+int32_t AppMediaSourcePort_RequestKeyFrame( void );
 
 #ifdef __cplusplus
 }
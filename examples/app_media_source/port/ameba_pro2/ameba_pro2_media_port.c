@@ -158,6 +158,8 @@ static g711_params_t g711dParams = {
 #endif /* ( AUDIO_G711_MULAW || AUDIO_G711_ALAW ) */
 
 #if ( AUDIO_OPUS )
+/* The encoder is set up once for all viewers and opusc_params_t has no in-band FEC or DTX switch,
+ * so the remote useinbandfec/usedtx preferences are not applied to what we send. */
 static opusc_params_t opuscParams = {
     .sample_rate = 8000, // 16000
     .channel = 1,
@@ -798,6 +800,27 @@ void AppMediaSourcePort_Stop( void )
     #endif
 }
 
+int32_t AppMediaSourcePort_RequestKeyFrame( void )
+{
+    int32_t ret = 0;
+
+    if( pVideoContext == NULL )
+    {
+        LogError( ( "Video module is not initialized." ) );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        /* Ask the encoder to emit an IDR as its next frame. */
+        mm_module_ctrl( pVideoContext,
+                        CMD_VIDEO_FORCE_IFRAME,
+                        MEDIA_PORT_V1_CHANNEL );
+    }
+
+    return ret;
+}
+
 void AppMediaSourcePort_PlayAudioFrame( MediaFrame_t * pFrame )
 {
     uint8_t skipProcess = 0U;
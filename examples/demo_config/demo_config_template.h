@@ -90,6 +90,13 @@
     #error only one of video codec should be set
 #endif
 
+/* Master keeps the video frames since the latest keyframe and replays them to a
+ * viewer as soon as it connects, so it starts decoding without waiting for an IDR.
+ * It costs up to 256 KiB of heap while any session is active. */
+#ifndef ENABLE_KEYFRAME_CACHE
+    #define ENABLE_KEYFRAME_CACHE 0
+#endif
+
 /* Join Storage Session setting. */
 #ifndef JOIN_STORAGE_SESSION
     #define JOIN_STORAGE_SESSION 0
@@ -27,6 +27,10 @@
 #include "string_utils.h"
 #include "mbedtls/md.h"
 #include "mbedtls/md5.h"
+#include "mbedtls/sha1.h"
+#if ICE_CONTROLLER_CRC32_BACKEND == ICE_CONTROLLER_CRC32_BACKEND_ARM_CRC32
+#include <arm_acle.h>
+#endif /* ICE_CONTROLLER_CRC32_BACKEND == ICE_CONTROLLER_CRC32_BACKEND_ARM_CRC32 */
 #include "task.h"
 #if METRIC_PRINT_ENABLED
 #include "metric.h"
@@ -45,6 +49,14 @@
 #define MAX_QUEUE_MSG_NUM ( 30 )
 #define REQUEST_QUEUE_POLL_ID ( 0 )
 
+#define ICE_CONTROLLER_HMAC_SHA1_BLOCK_LENGTH ( 64 )
+#define ICE_CONTROLLER_HMAC_SHA1_LENGTH ( 20 )
+#define ICE_CONTROLLER_HMAC_IPAD ( 0x36 )
+#define ICE_CONTROLLER_HMAC_OPAD ( 0x5C )
+
+/* Pairs are checked in rounds: host/srflx IPv6, host/srflx IPv4, relay IPv6, relay IPv4. */
+#define ICE_CONTROLLER_CHECK_ROUND_COUNT ( 4 )
+
 static const uint32_t gCrc32Table[256] = {
     0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f, 0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
     0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2, 0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
@@ -70,6 +82,12 @@ static const uint32_t gCrc32Table[256] = {
     0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
 };
 
+#if ICE_CONTROLLER_CRC32_BACKEND == ICE_CONTROLLER_CRC32_BACKEND_SLICING_BY_8
+/* gCrc32SliceTable[k][n] is the CRC of byte n followed by k + 1 zero bytes, derived from gCrc32Table at init. */
+static uint32_t gCrc32SliceTable[ 7 ][ 256 ];
+static uint8_t isCrc32SliceTableReady = 0U;
+#endif /* ICE_CONTROLLER_CRC32_BACKEND == ICE_CONTROLLER_CRC32_BACKEND_SLICING_BY_8 */
+
 static void OnTimerExpire( void * pContext )
 {
     IceControllerContext_t * pCtx = ( IceControllerContext_t * ) pContext;
@@ -187,21 +205,76 @@ static IceResult_t IceController_CalculateRandom( uint8_t * pOutputBuffer,
     return ICE_RESULT_OK;
 }
 
+#if ICE_CONTROLLER_CRC32_BACKEND == ICE_CONTROLLER_CRC32_BACKEND_SLICING_BY_8
+static void InitializeCrc32SliceTable( void )
+{
+    uint32_t i, k;
+    uint32_t previous;
+
+    for( i = 0; i < 256; i++ )
+    {
+        previous = gCrc32Table[ i ];
+        for( k = 0; k < 7; k++ )
+        {
+            previous = gCrc32Table[ previous & 0xFF ] ^ ( previous >> 8 );
+            gCrc32SliceTable[ k ][ i ] = previous;
+        }
+    }
+
+    isCrc32SliceTableReady = 1U;
+}
+#endif /* ICE_CONTROLLER_CRC32_BACKEND == ICE_CONTROLLER_CRC32_BACKEND_SLICING_BY_8 */
+
 static IceResult_t IceController_CalculateCrc32( uint32_t initialResult,
                                                  const uint8_t * pBuffer,
                                                  size_t bufferLength,
                                                  uint32_t * pCalculatedCrc32 )
 {
     uint32_t c = initialResult ^ 0xFFFFFFFF, i = 0;
+    #if ICE_CONTROLLER_CRC32_BACKEND == ICE_CONTROLLER_CRC32_BACKEND_SLICING_BY_8
+    uint32_t low, high;
+    #endif /* ICE_CONTROLLER_CRC32_BACKEND == ICE_CONTROLLER_CRC32_BACKEND_SLICING_BY_8 */
 
     if( pBuffer == NULL )
     {
         bufferLength = 0;
     }
 
-    for( i = 0; i < bufferLength; ++i )
+    #if ICE_CONTROLLER_CRC32_BACKEND == ICE_CONTROLLER_CRC32_BACKEND_CUSTOM
+    c = IceController_PlatformCrc32( initialResult, pBuffer, bufferLength ) ^ 0xFFFFFFFF;
+    bufferLength = 0;
+    #elif ICE_CONTROLLER_CRC32_BACKEND == ICE_CONTROLLER_CRC32_BACKEND_ARM_CRC32
+    for( ; bufferLength - i >= 4U; i += 4 )
+    {
+        c = __crc32w( c, ( uint32_t ) pBuffer[i] | ( ( uint32_t ) pBuffer[i + 1] << 8 ) |
+                      ( ( uint32_t ) pBuffer[i + 2] << 16 ) | ( ( uint32_t ) pBuffer[i + 3] << 24 ) );
+    }
+    #elif ICE_CONTROLLER_CRC32_BACKEND == ICE_CONTROLLER_CRC32_BACKEND_SLICING_BY_8
+    if( isCrc32SliceTableReady != 0U )
+    {
+        /* Words are assembled byte by byte, so this is independent of alignment and endianness. */
+        for( ; bufferLength - i >= 8U; i += 8 )
+        {
+            low = c ^ ( ( uint32_t ) pBuffer[i] | ( ( uint32_t ) pBuffer[i + 1] << 8 ) |
+                        ( ( uint32_t ) pBuffer[i + 2] << 16 ) | ( ( uint32_t ) pBuffer[i + 3] << 24 ) );
+            high = ( uint32_t ) pBuffer[i + 4] | ( ( uint32_t ) pBuffer[i + 5] << 8 ) |
+                   ( ( uint32_t ) pBuffer[i + 6] << 16 ) | ( ( uint32_t ) pBuffer[i + 7] << 24 );
+            c = gCrc32SliceTable[ 6 ][ low & 0xFF ] ^ gCrc32SliceTable[ 5 ][ ( low >> 8 ) & 0xFF ] ^
+                gCrc32SliceTable[ 4 ][ ( low >> 16 ) & 0xFF ] ^ gCrc32SliceTable[ 3 ][ low >> 24 ] ^
+                gCrc32SliceTable[ 2 ][ high & 0xFF ] ^ gCrc32SliceTable[ 1 ][ ( high >> 8 ) & 0xFF ] ^
+                gCrc32SliceTable[ 0 ][ ( high >> 16 ) & 0xFF ] ^ gCrc32Table[ high >> 24 ];
+        }
+    }
+    #endif /* ICE_CONTROLLER_CRC32_BACKEND */
+
+    /* Remaining tail bytes, or the whole buffer with the table backend. */
+    for( ; i < bufferLength; ++i )
     {
+        #if ICE_CONTROLLER_CRC32_BACKEND == ICE_CONTROLLER_CRC32_BACKEND_ARM_CRC32
+        c = __crc32b( c, pBuffer[i] );
+        #else
         c = gCrc32Table[ ( c ^ pBuffer[i] ) & 0xFF ] ^ ( c >> 8 );
+        #endif /* ICE_CONTROLLER_CRC32_BACKEND == ICE_CONTROLLER_CRC32_BACKEND_ARM_CRC32 */
     }
 
     *pCalculatedCrc32 = ( c ^ 0xFFFFFFFF );
@@ -209,6 +282,170 @@ static IceResult_t IceController_CalculateCrc32( uint32_t initialResult,
     return ICE_RESULT_OK;
 }
 
+/* SHA-1 states after absorbing the key XOR ipad/opad block. The key is fixed for the whole
+ * session, so each STUN message only pays for hashing the message itself. */
+typedef struct IceControllerHmacCacheEntry
+{
+    uint8_t key[ ICE_CONTROLLER_HMAC_SHA1_BLOCK_LENGTH ];
+    size_t keyLength;
+    uint32_t lastUsedSeq;
+    mbedtls_sha1_context innerContext;
+    mbedtls_sha1_context outerContext;
+} IceControllerHmacCacheEntry_t;
+
+static IceControllerHmacCacheEntry_t hmacCache[ ICE_CONTROLLER_HMAC_CACHE_SIZE ];
+static uint32_t hmacCacheSeq = 0;
+static SemaphoreHandle_t hmacCacheMutex = NULL;
+
+static int PrepareHmacCacheEntry( IceControllerHmacCacheEntry_t * pEntry,
+                                  const uint8_t * pKey,
+                                  size_t keyLength )
+{
+    int retMbedtls;
+    uint8_t pad[ ICE_CONTROLLER_HMAC_SHA1_BLOCK_LENGTH ];
+    size_t i;
+
+    /* Keys longer than a block are not cached, so the key is used as is. */
+    memset( pad, 0, sizeof( pad ) );
+    memcpy( pad, pKey, keyLength );
+    for( i = 0; i < ICE_CONTROLLER_HMAC_SHA1_BLOCK_LENGTH; i++ )
+    {
+        pad[ i ] ^= ICE_CONTROLLER_HMAC_IPAD;
+    }
+
+    mbedtls_sha1_free( &pEntry->innerContext );
+    mbedtls_sha1_init( &pEntry->innerContext );
+    retMbedtls = mbedtls_sha1_starts_ret( &pEntry->innerContext );
+    if( retMbedtls == 0 )
+    {
+        retMbedtls = mbedtls_sha1_update_ret( &pEntry->innerContext, pad, sizeof( pad ) );
+    }
+
+    if( retMbedtls == 0 )
+    {
+        for( i = 0; i < ICE_CONTROLLER_HMAC_SHA1_BLOCK_LENGTH; i++ )
+        {
+            pad[ i ] ^= ICE_CONTROLLER_HMAC_IPAD ^ ICE_CONTROLLER_HMAC_OPAD;
+        }
+
+        mbedtls_sha1_free( &pEntry->outerContext );
+        mbedtls_sha1_init( &pEntry->outerContext );
+        retMbedtls = mbedtls_sha1_starts_ret( &pEntry->outerContext );
+    }
+
+    if( retMbedtls == 0 )
+    {
+        retMbedtls = mbedtls_sha1_update_ret( &pEntry->outerContext, pad, sizeof( pad ) );
+    }
+
+    if( retMbedtls == 0 )
+    {
+        memcpy( pEntry->key, pKey, keyLength );
+        pEntry->keyLength = keyLength;
+    }
+    else
+    {
+        pEntry->keyLength = 0;
+    }
+
+    return retMbedtls;
+}
+
+/* Copy the precomputed pad states of pKey into the caller's contexts, return 0 if the key is served from cache. */
+static int GetHmacPadContexts( const uint8_t * pKey,
+                               size_t keyLength,
+                               mbedtls_sha1_context * pInnerContext,
+                               mbedtls_sha1_context * pOuterContext )
+{
+    int retMbedtls = -1;
+    IceControllerHmacCacheEntry_t * pEntry = NULL;
+    size_t i;
+
+    if( ( hmacCacheMutex != NULL ) &&
+        ( keyLength > 0 ) &&
+        ( keyLength <= ICE_CONTROLLER_HMAC_SHA1_BLOCK_LENGTH ) &&
+        ( xSemaphoreTake( hmacCacheMutex, portMAX_DELAY ) == pdTRUE ) )
+    {
+        for( i = 0; i < ICE_CONTROLLER_HMAC_CACHE_SIZE; i++ )
+        {
+            if( ( hmacCache[ i ].keyLength == keyLength ) &&
+                ( memcmp( hmacCache[ i ].key, pKey, keyLength ) == 0 ) )
+            {
+                pEntry = &hmacCache[ i ];
+                retMbedtls = 0;
+                break;
+            }
+            else if( ( pEntry == NULL ) || ( hmacCache[ i ].lastUsedSeq < pEntry->lastUsedSeq ) )
+            {
+                /* Track the least recently used entry for replacement. */
+                pEntry = &hmacCache[ i ];
+            }
+            else
+            {
+                /* Empty else marker. */
+            }
+        }
+
+        if( retMbedtls != 0 )
+        {
+            retMbedtls = PrepareHmacCacheEntry( pEntry, pKey, keyLength );
+        }
+
+        if( retMbedtls == 0 )
+        {
+            pEntry->lastUsedSeq = ++hmacCacheSeq;
+            mbedtls_sha1_clone( pInnerContext, &pEntry->innerContext );
+            mbedtls_sha1_clone( pOuterContext, &pEntry->outerContext );
+        }
+
+        xSemaphoreGive( hmacCacheMutex );
+    }
+
+    return retMbedtls;
+}
+
+static int CalculateCachedHmac( const uint8_t * pKey,
+                                size_t keyLength,
+                                const uint8_t * pBuffer,
+                                size_t bufferLength,
+                                uint8_t * pOutputBuffer )
+{
+    int retMbedtls;
+    mbedtls_sha1_context innerContext;
+    mbedtls_sha1_context outerContext;
+    uint8_t innerHash[ ICE_CONTROLLER_HMAC_SHA1_LENGTH ];
+
+    mbedtls_sha1_init( &innerContext );
+    mbedtls_sha1_init( &outerContext );
+
+    retMbedtls = GetHmacPadContexts( pKey, keyLength, &innerContext, &outerContext );
+
+    if( retMbedtls == 0 )
+    {
+        retMbedtls = mbedtls_sha1_update_ret( &innerContext, pBuffer, bufferLength );
+    }
+
+    if( retMbedtls == 0 )
+    {
+        retMbedtls = mbedtls_sha1_finish_ret( &innerContext, innerHash );
+    }
+
+    if( retMbedtls == 0 )
+    {
+        retMbedtls = mbedtls_sha1_update_ret( &outerContext, innerHash, sizeof( innerHash ) );
+    }
+
+    if( retMbedtls == 0 )
+    {
+        retMbedtls = mbedtls_sha1_finish_ret( &outerContext, pOutputBuffer );
+    }
+
+    mbedtls_sha1_free( &innerContext );
+    mbedtls_sha1_free( &outerContext );
+
+    return retMbedtls;
+}
+
 static IceResult_t IceController_MbedtlsHmac( const uint8_t * pPassword,
                                               size_t passwordLength,
                                               const uint8_t * pBuffer,
@@ -228,12 +465,22 @@ static IceResult_t IceController_MbedtlsHmac( const uint8_t * pPassword,
 
     if( ret == ICE_RESULT_OK )
     {
-        retMbedtls = mbedtls_md_hmac( mbedtls_md_info_from_type( MBEDTLS_MD_SHA1 ),
-                                      pPassword,
-                                      passwordLength,
-                                      pBuffer,
-                                      bufferLength,
-                                      pOutputBuffer );
+        retMbedtls = CalculateCachedHmac( pPassword,
+                                          passwordLength,
+                                          pBuffer,
+                                          bufferLength,
+                                          pOutputBuffer );
+        if( retMbedtls != 0 )
+        {
+            /* Key not cacheable or cache unavailable, fall back to the full HMAC. */
+            retMbedtls = mbedtls_md_hmac( mbedtls_md_info_from_type( MBEDTLS_MD_SHA1 ),
+                                          pPassword,
+                                          passwordLength,
+                                          pBuffer,
+                                          bufferLength,
+                                          pOutputBuffer );
+        }
+
         if( retMbedtls != 0 )
         {
             LogError( ( "mbedtls_md_hmac fails, return=%d.", retMbedtls ) );
@@ -339,7 +586,7 @@ static void ProcessLocalCandidates( IceControllerContext_t * pCtx )
     size_t stunBufferLength = ICE_CONTROLLER_STUN_MESSAGE_BUFFER_SIZE;
     IceControllerSocketContext_t * pSocketContext;
     #if LIBRARY_LOG_LEVEL >= LOG_VERBOSE
-    char ipFromBuffer[ INET_ADDRSTRLEN ];
+    char ipFromBuffer[ INET6_ADDRSTRLEN ];
     #endif /* #if LIBRARY_LOG_LEVEL >= LOG_VERBOSE */
     uint64_t currentTimeSeconds = NetworkingUtils_GetCurrentTimeSec( NULL );
 
@@ -394,7 +641,7 @@ static void ProcessLocalCandidates( IceControllerContext_t * pCtx )
 
                 result = IceControllerNet_SendPacket( pCtx,
                                                       pSocketContext,
-                                                      &( pSocketContext->pIceServer->iceEndpoint ),
+                                                      IceControllerNet_GetIceServerEndpoint( pSocketContext ),
                                                       stunBuffer,
                                                       stunBufferLength );
 
@@ -417,7 +664,8 @@ static void ProcessLocalCandidates( IceControllerContext_t * pCtx )
 
 static IceControllerResult_t HandleCandidatePairRequest( IceControllerContext_t * pCtx,
                                                          IceControllerSocketContext_t * pTargetSocketContext,
-                                                         IceCandidatePair_t * pTargetCandidatePair )
+                                                         IceCandidatePair_t * pTargetCandidatePair,
+                                                         uint8_t * pIsRequestSent )
 {
     IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
     IceResult_t iceResult;
@@ -425,8 +673,8 @@ static IceControllerResult_t HandleCandidatePairRequest( IceControllerContext_t
     size_t stunBufferLength = ICE_CONTROLLER_STUN_MESSAGE_BUFFER_SIZE;
     IceControllerSocketContext_t * pSocketContext = pTargetSocketContext;
     #if LIBRARY_LOG_LEVEL >= LOG_VERBOSE
-    char ipFromBuffer[ INET_ADDRSTRLEN ];
-    char ipToBuffer[ INET_ADDRSTRLEN ];
+    char ipFromBuffer[ INET6_ADDRSTRLEN ];
+    char ipToBuffer[ INET6_ADDRSTRLEN ];
     #endif /* #if LIBRARY_LOG_LEVEL >= LOG_VERBOSE  */
     IceEndpoint_t * pDestEndpoint = NULL;
     uint64_t currentTimeSeconds = NetworkingUtils_GetCurrentTimeSec( NULL );
@@ -519,19 +767,63 @@ static IceControllerResult_t HandleCandidatePairRequest( IceControllerContext_t
         {
             LogWarn( ( "Unable to send packet to remote address, result: %d", ret ) );
         }
+        else if( ( ret == ICE_CONTROLLER_RESULT_OK ) && ( pIsRequestSent != NULL ) )
+        {
+            *pIsRequestSent = 1U;
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
     } while( 0 );
 
     return ret;
 }
 
-static void ProcessCandidatePairs( IceControllerContext_t * pCtx )
+static uint8_t GetCandidatePairCheckRound( const IceCandidatePair_t * pCandidatePair )
+{
+    uint8_t round;
+
+    if( pCandidatePair->pRemoteCandidate == NULL )
+    {
+        /* Let the pair request handler deal with it once, in the last round. */
+        round = ICE_CONTROLLER_CHECK_ROUND_COUNT - 1U;
+    }
+    else if( pCandidatePair->pLocalCandidate->endpoint.transportAddress.family != pCandidatePair->pRemoteCandidate->endpoint.transportAddress.family )
+    {
+        /* Pairs mixing address families can never succeed. */
+        round = ICE_CONTROLLER_CHECK_ROUND_COUNT;
+    }
+    else
+    {
+        /* Host and srflx pairs go before relay pairs, and within each group IPv6 pairs get
+         * their checks out first on dual-stack hosts (RFC 8421). */
+        round = ( pCandidatePair->pLocalCandidate->endpoint.transportAddress.family == STUN_ADDRESS_IPv6 ) ? 0U : 1U;
+
+        if( ( pCandidatePair->pLocalCandidate->candidateType == ICE_CANDIDATE_TYPE_RELAY ) ||
+            ( pCandidatePair->pRemoteCandidate->candidateType == ICE_CANDIDATE_TYPE_RELAY ) )
+        {
+            round += 2U;
+        }
+    }
+
+    return round;
+}
+
+/* Send the next paced connectivity check and return the delay until the next one is due. */
+static uint32_t ProcessCandidatePairs( IceControllerContext_t * pCtx )
 {
     IceControllerResult_t result = ICE_CONTROLLER_RESULT_OK;
     IceResult_t iceResult;
-    uint32_t i;
     size_t count;
     IceControllerSocketContext_t * pSocketContext = NULL;
+    IceCandidatePair_t * pCandidatePair = NULL;
     uint8_t isLocked = 0U;
+    uint8_t isRequestSent = 0U;
+    uint8_t isCycleCompleted = 0U;
+    uint64_t currentTimeMs = NetworkingUtils_GetCurrentTimeUs( NULL ) / 1000;
+    uint64_t elapsedTimeMs;
+    uint32_t nextIntervalMs = ICE_CONTROLLER_CHECK_PACING_INTERVAL_MS;
 
     /* Take ice lock. */
     if( xSemaphoreTake( pCtx->iceMutex, portMAX_DELAY ) == pdTRUE )
@@ -566,26 +858,81 @@ static void ProcessCandidatePairs( IceControllerContext_t * pCtx )
 
     if( result == ICE_CONTROLLER_RESULT_OK )
     {
-        for( i = 0; i < count; i++ )
+        /* Aggressive nomination: retransmit the request of the first nominating pair once its
+         * timeout expires, while the remaining pairs are still checked in the background. */
+        if( ( pCtx->pNominatingCandidatePair != NULL ) &&
+            ( currentTimeMs - pCtx->nominationRequestSentMs >= pCtx->nominationRtoMs ) )
+        {
+            ( void ) HandleCandidatePairRequest( pCtx,
+                                                 NULL,
+                                                 pCtx->pNominatingCandidatePair,
+                                                 NULL );
+            pCtx->nominationRequestSentMs = currentTimeMs;
+            if( pCtx->nominationRtoMs < ICE_CONTROLLER_NOMINATION_MAX_RTO_MS )
+            {
+                pCtx->nominationRtoMs *= 2U;
+            }
+        }
+
+        /* Pairs are already sorted by priority. Walk them round by round and send at most one
+         * check per pacing interval. */
+        while( ( isRequestSent == 0U ) && ( isCycleCompleted == 0U ) )
         {
+            if( pCtx->checkPairIndex >= count )
+            {
+                pCtx->checkPairIndex = 0;
+                pCtx->checkRound++;
+
+                if( pCtx->checkRound >= ICE_CONTROLLER_CHECK_ROUND_COUNT )
+                {
+                    pCtx->checkRound = 0;
+                    isCycleCompleted = 1U;
+                }
+                continue;
+            }
+
+            pCandidatePair = &pCtx->iceContext.pCandidatePairs[ pCtx->checkPairIndex ];
+            pCtx->checkPairIndex++;
+
+            if( ( GetCandidatePairCheckRound( pCandidatePair ) != pCtx->checkRound ) ||
+                ( pCandidatePair == pCtx->pNominatingCandidatePair ) )
+            {
+                continue;
+            }
+
             pSocketContext = FindSocketContextByLocalCandidate( pCtx,
-                                                                pCtx->iceContext.pCandidatePairs[i].pLocalCandidate );
+                                                                pCandidatePair->pLocalCandidate );
             if( pSocketContext == NULL )
             {
-                LogWarn( ( "Not able to find socket context mapping to local candidate ID: 0x%x", pCtx->iceContext.pCandidatePairs[i].pLocalCandidate->candidateId ) );
+                LogWarn( ( "Not able to find socket context mapping to local candidate ID: 0x%x", pCandidatePair->pLocalCandidate->candidateId ) );
                 continue;
             }
 
             result = HandleCandidatePairRequest( pCtx,
                                                  pSocketContext,
-                                                 &pCtx->iceContext.pCandidatePairs[i] );
+                                                 pCandidatePair,
+                                                 &isRequestSent );
         }
     }
 
+    if( isCycleCompleted != 0U )
+    {
+        /* Every pair got its check in this pass, hold the next pass until the minimum
+         * pass period is reached so that retransmissions are not sent faster than before. */
+        elapsedTimeMs = currentTimeMs - pCtx->checkCycleStartMs;
+        if( elapsedTimeMs + ICE_CONTROLLER_CHECK_PACING_INTERVAL_MS < ICE_CONTROLLER_CONNECTIVITY_TIMER_INTERVAL_MS )
+        {
+            nextIntervalMs = ( uint32_t ) ( ICE_CONTROLLER_CONNECTIVITY_TIMER_INTERVAL_MS - elapsedTimeMs );
+        }
+        pCtx->checkCycleStartMs = currentTimeMs + nextIntervalMs;
+    }
+
     if( isLocked != 0U )
     {
         xSemaphoreGive( pCtx->iceMutex );
     }
+
+    return nextIntervalMs;
 }
 
 static void PrintCandidatesStatus( IceControllerContext_t * pCtx )
@@ -743,8 +1090,18 @@ void IceController_HandleEvent( IceControllerContext_t * pCtx,
         {
             case ICE_CONTROLLER_EVENT_DTLS_HANDSHAKE_DONE:
             {
-                ReleaseOtherSockets( pCtx, pCtx->pNominatedSocketContext );
-                LogDebug( ( "Released all other socket contexts" ) );
+                if( pCtx->state == ICE_CONTROLLER_STATE_PROCESS_CANDIDATES_AND_PAIRS )
+                {
+                    /* DTLS finished on an early selected pair, a better pair might still be nominated. */
+                    pCtx->releaseOtherSocketsPending = 1U;
+                    LogDebug( ( "Defer releasing other socket contexts until nomination completes" ) );
+                }
+                else
+                {
+                    pCtx->releaseOtherSocketsPending = 0U;
+                    ReleaseOtherSockets( pCtx, pCtx->pNominatedSocketContext );
+                    LogDebug( ( "Released all other socket contexts" ) );
+                }
                 break;
             }
             default:
@@ -774,8 +1131,12 @@ IceControllerResult_t IceController_AddRemoteCandidate( IceControllerContext_t *
 
     if( ret == ICE_CONTROLLER_RESULT_OK )
     {
-        /* TODO: Skip IPv6 remote candidiate for now. */
+        #if ICE_CONTROLLER_ENABLE_IPV6
+        if( ( pRemoteCandidate->pEndpoint->transportAddress.family != STUN_ADDRESS_IPv4 ) &&
+            ( pRemoteCandidate->pEndpoint->transportAddress.family != STUN_ADDRESS_IPv6 ) )
+        #else
         if( pRemoteCandidate->pEndpoint->transportAddress.family != STUN_ADDRESS_IPv4 )
+        #endif /* #if ICE_CONTROLLER_ENABLE_IPV6 */
         {
             LogInfo( ( "Dropping IPv6 remote candidate: %s/%u",
                        IceControllerNet_LogIpAddressInfo( pRemoteCandidate->pEndpoint,
@@ -853,6 +1214,9 @@ IceControllerResult_t IceController_AddRemoteCandidate( IceControllerContext_t *
             iceResult = Ice_AddRemoteCandidate( &pCtx->iceContext,
                                                 pRemoteCandidate );
 
+            /* New pairs are inserted in priority order, so the pair pointer may have moved. */
+            pCtx->pNominatingCandidatePair = NULL;
+
             xSemaphoreGive( pCtx->iceMutex );
 
             if( iceResult != ICE_RESULT_OK )
@@ -869,6 +1233,13 @@ IceControllerResult_t IceController_AddRemoteCandidate( IceControllerContext_t *
                               pRemoteCandidate->pEndpoint->transportAddress.port ) );
 
                 LogDebug( ( "Added new remote candidate with ID: 0x%04x", pCtx->iceContext.pRemoteCandidates[ pCtx->iceContext.numRemoteCandidates - 1 ].candidateId ) );
+
+                /* Check the new pairs on the next pacing slot instead of waiting for the current pass to end. */
+                if( pCtx->state == ICE_CONTROLLER_STATE_PROCESS_CANDIDATES_AND_PAIRS )
+                {
+                    IceController_UpdateTimerInterval( pCtx,
+                                                       ICE_CONTROLLER_CHECK_PACING_INTERVAL_MS );
+                }
             }
         }
         else
@@ -885,6 +1256,7 @@ IceControllerResult_t IceController_ProcessIceCandidatesAndPairs( IceControllerC
 {
     IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
     uint64_t currentTimeMs = NetworkingUtils_GetCurrentTimeUs( NULL ) / 1000;
+    uint32_t nextIntervalMs = ICE_CONTROLLER_CONNECTIVITY_TIMER_INTERVAL_MS;
 
     if( pCtx == NULL )
     {
@@ -903,11 +1275,15 @@ IceControllerResult_t IceController_ProcessIceCandidatesAndPairs( IceControllerC
 
     if( ret == ICE_CONTROLLER_RESULT_OK )
     {
-        /* Send next candidate pair request for each candidate pair. */
-        ProcessCandidatePairs( pCtx );
+        /* Send the next paced candidate pair request. */
+        nextIntervalMs = ProcessCandidatePairs( pCtx );
 
-        /* Send request for local candidates. */
-        ProcessLocalCandidates( pCtx );
+        /* Send request for local candidates, these keep the original connectivity interval. */
+        if( currentTimeMs >= pCtx->nextLocalCandidatesProcessMs )
+        {
+            ProcessLocalCandidates( pCtx );
+            pCtx->nextLocalCandidatesProcessMs = currentTimeMs + ICE_CONTROLLER_CONNECTIVITY_TIMER_INTERVAL_MS;
+        }
     }
 
     if( ret == ICE_CONTROLLER_RESULT_OK )
@@ -942,7 +1318,7 @@ IceControllerResult_t IceController_ProcessIceCandidatesAndPairs( IceControllerC
     {
         /* Re-set the timer. */
         IceController_UpdateTimerInterval( pCtx,
-                                           ICE_CONTROLLER_CONNECTIVITY_TIMER_INTERVAL_MS );
+                                           nextIntervalMs );
     }
 
     if( ret == ICE_CONTROLLER_RESULT_OK )
@@ -979,7 +1355,7 @@ IceControllerResult_t IceController_PeriodConnectionCheck( IceControllerContext_
             /* Check nominated candidated pair lifetime by calling Ice_CreateNextPairRequest. */
             if( xSemaphoreTake( pCtx->iceMutex, portMAX_DELAY ) == pdTRUE )
             {
-                ( void ) HandleCandidatePairRequest( pCtx, pCtx->pNominatedSocketContext, pCtx->pNominatedSocketContext->pCandidatePair );
+                ( void ) HandleCandidatePairRequest( pCtx, pCtx->pNominatedSocketContext, pCtx->pNominatedSocketContext->pCandidatePair, NULL );
                 xSemaphoreGive( pCtx->iceMutex );
             }
             else
@@ -1177,6 +1553,15 @@ IceControllerResult_t IceController_Init( IceControllerContext_t * pCtx,
 
     if( ret == ICE_CONTROLLER_RESULT_OK )
     {
+        /* Take the sockets of a previous session out of the egress queues before wiping them. */
+        for( i = 0; i < ICE_CONTROLLER_MAX_LOCAL_CANDIDATE_COUNT; i++ )
+        {
+            IceControllerEgress_FlushSocket( &pCtx->socketsContexts[ i ] );
+        }
+
+        /* The timer of a previous session must not stay armed on the handler being wiped. */
+        TimerController_Reset( &pCtx->timerHandler );
+
         memset( pCtx,
                 0,
                 sizeof( IceControllerContext_t ) );
@@ -1240,6 +1625,30 @@ IceControllerResult_t IceController_Init( IceControllerContext_t * pCtx,
         }
     }
 
+    #if ICE_CONTROLLER_CRC32_BACKEND == ICE_CONTROLLER_CRC32_BACKEND_SLICING_BY_8
+    if( ( ret == ICE_CONTROLLER_RESULT_OK ) && ( isCrc32SliceTableReady == 0U ) )
+    {
+        InitializeCrc32SliceTable();
+    }
+    #endif /* ICE_CONTROLLER_CRC32_BACKEND == ICE_CONTROLLER_CRC32_BACKEND_SLICING_BY_8 */
+
+    if( ret == ICE_CONTROLLER_RESULT_OK )
+    {
+        /* Shared by all sessions, only the first call creates the egress task. */
+        ret = IceControllerEgress_Init();
+    }
+
+    if( ( ret == ICE_CONTROLLER_RESULT_OK ) && ( hmacCacheMutex == NULL ) )
+    {
+        /* Shared by all sessions, sessions are initialized one by one from the application. */
+        hmacCacheMutex = xSemaphoreCreateMutex();
+        if( hmacCacheMutex == NULL )
+        {
+            LogError( ( "Fail to create HMAC cache mutex for Ice controller." ) );
+            ret = ICE_CONTROLLER_RESULT_FAIL_MUTEX_CREATE;
+        }
+    }
+
     /* Initialize socket listener task. */
     if( ret == ICE_CONTROLLER_RESULT_OK )
     {
@@ -1547,6 +1956,13 @@ IceControllerResult_t IceController_Start( IceControllerContext_t * pCtx,
     {
         /* Update the connectivity timeout before starting connectivity check. */
         pCtx->connectivityCheckTimeoutMs = currentTimeMs + ICE_CONTROLLER_CONNECTIVITY_CHECK_TIMEOUT_MS;
+
+        pCtx->checkRound = 0;
+        pCtx->checkPairIndex = 0;
+        pCtx->checkCycleStartMs = currentTimeMs;
+        pCtx->nextLocalCandidatesProcessMs = 0;
+        pCtx->pNominatingCandidatePair = NULL;
+        pCtx->releaseOtherSocketsPending = 0U;
     }
 
     if( ret == ICE_CONTROLLER_RESULT_OK )
@@ -1562,9 +1978,17 @@ IceControllerResult_t IceController_Start( IceControllerContext_t * pCtx,
     return ret;
 }
 
-IceControllerResult_t IceController_SendToRemotePeer( IceControllerContext_t * pCtx,
-                                                      const uint8_t * pBuffer,
-                                                      size_t bufferLength )
+/* pTurnBuffer is where the TURN channel data message is built, with the packet
+ * starting ICE_TURN_CHANNEL_DATA_MESSAGE_HEADER_LENGTH bytes into it. When the
+ * caller's buffer already sits at that offset the packet is framed in place,
+ * otherwise it is copied there first. */
+static IceControllerResult_t SendToRemotePeer( IceControllerContext_t * pCtx,
+                                               const uint8_t * pBuffer,
+                                               size_t bufferLength,
+                                               uint8_t * pTurnBuffer,
+                                               size_t turnBufferSize,
+                                               uint8_t isQueued,
+                                               IceControllerSendPriority_t priority )
 {
     IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
     IceResult_t iceResult;
@@ -1572,14 +1996,6 @@ IceControllerResult_t IceController_SendToRemotePeer( IceControllerContext_t * p
     size_t sendingBufferLength = bufferLength;
     size_t turnBufferLength;
     IceEndpoint_t * pDestEndpoint = NULL;
-    uint8_t turnSendBuffer[ ICE_CONTROLLER_MAX_MTU ];
-
-    if( ( pCtx == NULL ) ||
-        ( pBuffer == NULL ) )
-    {
-        LogError( ( "Invalid input, pCtx: %p, pBuffer: %p", pCtx, pBuffer ) );
-        ret = ICE_CONTROLLER_RESULT_BAD_PARAMETER;
-    }
 
     if( ret == ICE_CONTROLLER_RESULT_OK )
     {
@@ -1614,21 +2030,25 @@ IceControllerResult_t IceController_SendToRemotePeer( IceControllerContext_t * p
     {
         if( pCtx->pNominatedSocketContext->pLocalCandidate->candidateType == ICE_CANDIDATE_TYPE_RELAY )
         {
-            if( bufferLength + ICE_TURN_CHANNEL_DATA_MESSAGE_HEADER_LENGTH > ICE_CONTROLLER_MAX_MTU )
+            if( ( bufferLength + ICE_TURN_CHANNEL_DATA_MESSAGE_HEADER_LENGTH > ICE_CONTROLLER_MAX_MTU ) ||
+                ( bufferLength + ICE_TURN_CHANNEL_DATA_MESSAGE_HEADER_LENGTH > turnBufferSize ) )
             {
                 LogError( ( "The sending buffer is larger than MTU, length: %u", sendingBufferLength ) );
                 ret = ICE_CONTROLLER_RESULT_FAIL_EXCEED_MTU;
             }
             else
             {
-                memcpy( turnSendBuffer + ICE_TURN_CHANNEL_DATA_MESSAGE_HEADER_LENGTH, pBuffer, bufferLength );
+                if( pTurnBuffer + ICE_TURN_CHANNEL_DATA_MESSAGE_HEADER_LENGTH != pBuffer )
+                {
+                    memcpy( pTurnBuffer + ICE_TURN_CHANNEL_DATA_MESSAGE_HEADER_LENGTH, pBuffer, bufferLength );
+                }
 
                 if( xSemaphoreTake( pCtx->iceMutex, portMAX_DELAY ) == pdTRUE )
                 {
-                    turnBufferLength = ICE_CONTROLLER_MAX_MTU;
+                    turnBufferLength = turnBufferSize;
                     iceResult = Ice_CreateTurnChannelDataMessage( &pCtx->iceContext,
                                                                   pCtx->pNominatedSocketContext->pCandidatePair,
-                                                                  turnSendBuffer + ICE_TURN_CHANNEL_DATA_MESSAGE_HEADER_LENGTH,
+                                                                  pTurnBuffer + ICE_TURN_CHANNEL_DATA_MESSAGE_HEADER_LENGTH,
                                                                   bufferLength,
                                                                   &turnBufferLength );
                     xSemaphoreGive( pCtx->iceMutex );
@@ -1646,7 +2066,7 @@ IceControllerResult_t IceController_SendToRemotePeer( IceControllerContext_t * p
                         if( iceResult == ICE_RESULT_OK )
                         {
                             /* Set sending buffer/length to turn buffer since TURN channel header has been appended successfully. */
-                            pSendingBuffer = turnSendBuffer;
+                            pSendingBuffer = pTurnBuffer;
                             sendingBufferLength = turnBufferLength;
                         }
                     }
@@ -1660,7 +2080,16 @@ IceControllerResult_t IceController_SendToRemotePeer( IceControllerContext_t * p
         }
     }
 
-    if( ret == ICE_CONTROLLER_RESULT_OK )
+    if( ( ret == ICE_CONTROLLER_RESULT_OK ) && ( isQueued != 0U ) )
+    {
+        ret = IceControllerEgress_Enqueue( pCtx,
+                                           pCtx->pNominatedSocketContext,
+                                           pDestEndpoint,
+                                           pSendingBuffer,
+                                           sendingBufferLength,
+                                           priority );
+    }
+    else if( ret == ICE_CONTROLLER_RESULT_OK )
     {
         ret = IceControllerNet_SendPacket( pCtx,
                                            pCtx->pNominatedSocketContext,
@@ -1668,6 +2097,74 @@ IceControllerResult_t IceController_SendToRemotePeer( IceControllerContext_t * p
                                            pSendingBuffer,
                                            sendingBufferLength );
     }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    return ret;
+}
+
+IceControllerResult_t IceController_SendToRemotePeer( IceControllerContext_t * pCtx,
+                                                      const uint8_t * pBuffer,
+                                                      size_t bufferLength )
+{
+    IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
+    uint8_t turnSendBuffer[ ICE_CONTROLLER_MAX_MTU ];
+
+    if( ( pCtx == NULL ) ||
+        ( pBuffer == NULL ) )
+    {
+        LogError( ( "Invalid input, pCtx: %p, pBuffer: %p", pCtx, pBuffer ) );
+        ret = ICE_CONTROLLER_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == ICE_CONTROLLER_RESULT_OK )
+    {
+        /* DTLS, SCTP and RTCP report packets are sent from the calling task, the priority is unused. */
+        ret = SendToRemotePeer( pCtx,
+                                pBuffer,
+                                bufferLength,
+                                turnSendBuffer,
+                                sizeof( turnSendBuffer ),
+                                0U,
+                                ICE_CONTROLLER_SEND_PRIORITY_AUDIO );
+    }
+
+    return ret;
+}
+
+/* Same as IceController_SendToRemotePeer(), but pBuffer must have ICE_CONTROLLER_SEND_HEADROOM_LENGTH
+ * writable bytes in front of it and bufferCapacity writable bytes from it, so that relayed packets get
+ * their TURN channel data header written in place instead of being copied to a stack buffer.
+ * With ICE_CONTROLLER_EGRESS_PACKET_COUNT set, the packet is queued by priority for the egress task. */
+IceControllerResult_t IceController_SendToRemotePeerInPlace( IceControllerContext_t * pCtx,
+                                                             uint8_t * pBuffer,
+                                                             size_t bufferLength,
+                                                             size_t bufferCapacity,
+                                                             IceControllerSendPriority_t priority )
+{
+    IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
+
+    if( ( pCtx == NULL ) ||
+        ( pBuffer == NULL ) ||
+        ( bufferCapacity < bufferLength ) )
+    {
+        LogError( ( "Invalid input, pCtx: %p, pBuffer: %p, bufferLength: %u, bufferCapacity: %u",
+                    pCtx, pBuffer, bufferLength, bufferCapacity ) );
+        ret = ICE_CONTROLLER_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == ICE_CONTROLLER_RESULT_OK )
+    {
+        ret = SendToRemotePeer( pCtx,
+                                pBuffer,
+                                bufferLength,
+                                pBuffer - ICE_CONTROLLER_SEND_HEADROOM_LENGTH,
+                                bufferCapacity + ICE_CONTROLLER_SEND_HEADROOM_LENGTH,
+                                ICE_CONTROLLER_EGRESS_PACKET_COUNT > 0 ? 1U : 0U,
+                                priority );
+    }
 
     return ret;
 }
@@ -1843,7 +2340,7 @@ void IceController_UpdateTimerInterval( IceControllerContext_t * pCtx,
         }
         else if( newIntervalMs != pCtx->timerIntervalMs )
         {
-            LogInfo( ( "Timer interval is updated from %lu to %lu", pCtx->timerIntervalMs, newIntervalMs ) );
+            LogDebug( ( "Timer interval is updated from %lu to %lu", pCtx->timerIntervalMs, newIntervalMs ) );
             pCtx->timerIntervalMs = newIntervalMs;
         }
         else
@@ -26,6 +26,14 @@ extern "C" {
 #include <stdio.h>
 #include "ice_controller_data_types.h"
 
+#if ICE_CONTROLLER_CRC32_BACKEND == ICE_CONTROLLER_CRC32_BACKEND_CUSTOM
+/* Implemented by the platform port (e.g. on a hardware CRC engine), same semantics as zlib crc32():
+ * returns the CRC32 of pBuffer continuing from crc. */
+uint32_t IceController_PlatformCrc32( uint32_t crc,
+                                      const uint8_t * pBuffer,
+                                      size_t bufferLength );
+#endif /* ICE_CONTROLLER_CRC32_BACKEND == ICE_CONTROLLER_CRC32_BACKEND_CUSTOM */
+
 IceControllerResult_t IceController_Init( IceControllerContext_t * pCtx,
                                           IceControllerInitConfig_t * pInitConfig );
 IceControllerResult_t IceController_Destroy( IceControllerContext_t * pCtx );
@@ -42,6 +50,11 @@ IceControllerResult_t IceController_ProcessIceCandidatesAndPairs( IceControllerC
 IceControllerResult_t IceController_SendToRemotePeer( IceControllerContext_t * pCtx,
                                                       const uint8_t * pBuffer,
                                                       size_t bufferLength );
+IceControllerResult_t IceController_SendToRemotePeerInPlace( IceControllerContext_t * pCtx,
+                                                             uint8_t * pBuffer,
+                                                             size_t bufferLength,
+                                                             size_t bufferCapacity,
+                                                             IceControllerSendPriority_t priority );
 IceControllerResult_t IceController_AddIceServerConfig( IceControllerContext_t * pCtx,
                                                         IceControllerIceServerConfig_t * pIceServersConfig );
 IceControllerResult_t IceController_PeriodConnectionCheck( IceControllerContext_t * pCtx );
@@ -41,7 +41,9 @@ extern "C" {
  */
 #define ICE_CONTROLLER_MAX_ICE_SERVER_COUNT ( 7 )
 
-#define ICE_CONTROLLER_IP_ADDR_STRING_BUFFER_LENGTH ( 39 )
+/* Fits the longest IPv6 text form including the NUL, e.g. an IPv4-mapped
+ * address like "ffff:ffff:ffff:ffff:ffff:ffff:255.255.255.255" (45 chars). */
+#define ICE_CONTROLLER_IP_ADDR_STRING_BUFFER_LENGTH ( INET6_ADDRSTRLEN )
 #define ICE_CONTROLLER_STUN_MESSAGE_BUFFER_SIZE ( 1024 )
 
 /**
@@ -72,7 +74,40 @@ extern "C" {
 #else
 #define ICE_CONTROLLER_CONNECTIVITY_TIMER_INTERVAL_MS ( 200 )
 #endif /* LIBRARY_LOG_LEVEL >= LOG_VERBOSE */
+/* Connectivity checks are paced one per Ta (RFC 8445, section 14.2) instead of sending a burst
+ * for every pair on each tick. ICE_CONTROLLER_CONNECTIVITY_TIMER_INTERVAL_MS is kept as the
+ * minimum period of a full pass over the pairs, which bounds the per-pair retransmission rate. */
+#ifndef ICE_CONTROLLER_CHECK_PACING_INTERVAL_MS
+#if LIBRARY_LOG_LEVEL >= LOG_DEBUG
+#define ICE_CONTROLLER_CHECK_PACING_INTERVAL_MS ( ICE_CONTROLLER_CONNECTIVITY_TIMER_INTERVAL_MS )
+#else
+#define ICE_CONTROLLER_CHECK_PACING_INTERVAL_MS ( 20 )
+#endif /* LIBRARY_LOG_LEVEL >= LOG_DEBUG */
+#endif /* ICE_CONTROLLER_CHECK_PACING_INTERVAL_MS */
+/* The nominating request is retransmitted with a doubling timeout, starting at the per-pair
+ * retransmission period and capped at 8 times that, like a STUN client transaction. */
+#define ICE_CONTROLLER_NOMINATION_INITIAL_RTO_MS ( ICE_CONTROLLER_CONNECTIVITY_TIMER_INTERVAL_MS )
+#define ICE_CONTROLLER_NOMINATION_MAX_RTO_MS ( ICE_CONTROLLER_NOMINATION_INITIAL_RTO_MS * 8 )
 #define ICE_CONTROLLER_PERIODIC_TIMER_INTERVAL_MS ( 1000 )
+
+/* CRC32 implementation used for STUN FINGERPRINT, selected at build time. */
+#define ICE_CONTROLLER_CRC32_BACKEND_TABLE ( 0 )        /* Byte-at-a-time lookup, 1KB table. */
+#define ICE_CONTROLLER_CRC32_BACKEND_SLICING_BY_8 ( 1 ) /* 8 bytes per step, 8KB of tables. */
+#define ICE_CONTROLLER_CRC32_BACKEND_ARM_CRC32 ( 2 )    /* ARMv8 CRC32 instructions. */
+#define ICE_CONTROLLER_CRC32_BACKEND_CUSTOM ( 3 )       /* Platform provided IceController_PlatformCrc32(), e.g. hardware CRC engine. */
+#ifndef ICE_CONTROLLER_CRC32_BACKEND
+#if defined( __ARM_FEATURE_CRC32 )
+#define ICE_CONTROLLER_CRC32_BACKEND ( ICE_CONTROLLER_CRC32_BACKEND_ARM_CRC32 )
+#else
+#define ICE_CONTROLLER_CRC32_BACKEND ( ICE_CONTROLLER_CRC32_BACKEND_SLICING_BY_8 )
+#endif /* defined( __ARM_FEATURE_CRC32 ) */
+#endif /* ICE_CONTROLLER_CRC32_BACKEND */
+
+/* Number of STUN integrity keys (ICE passwords / TURN long-term keys) whose HMAC-SHA1
+ * inner and outer pad states are kept precomputed, shared by all sessions. */
+#ifndef ICE_CONTROLLER_HMAC_CACHE_SIZE
+#define ICE_CONTROLLER_HMAC_CACHE_SIZE ( 8 )
+#endif /* ICE_CONTROLLER_HMAC_CACHE_SIZE */
 #define ICE_CONTROLLER_CLOSING_INTERVAL_MS ( 100 )
 
 /* Expiration timeout in mili-seconds. */
@@ -83,6 +118,48 @@ extern "C" {
 
 #define ICE_CONTROLLER_MAX_MTU ( 1500 )
 
+/**
+ * Space a caller of IceController_SendToRemotePeerInPlace() must keep writable
+ * in front of and after the packet. The headroom takes the TURN channel data
+ * header, the tailroom takes the padding to a 4-byte boundary used over TCP.
+ */
+#define ICE_CONTROLLER_SEND_HEADROOM_LENGTH ( ICE_TURN_CHANNEL_DATA_MESSAGE_HEADER_LENGTH )
+#define ICE_CONTROLLER_SEND_TAILROOM_LENGTH ( 3 )
+
+/* Retry interval and give-up time when the network stack runs out of buffers while sending. */
+#define ICE_CONTROLLER_RESEND_DELAY_MS ( 50 )
+#define ICE_CONTROLLER_RESEND_TIMEOUT_MS ( 1000 )
+
+/**
+ * Number of packets, shared by all sessions, that can wait in the per-socket
+ * egress queues. When non-zero, IceController_SendToRemotePeerInPlace() copies
+ * the packet into the queue of the nominated socket and returns; a single
+ * egress task drains the queues by priority and backs off per socket when the
+ * network stack is out of buffers. 0 keeps sending from the calling task.
+ */
+#ifndef ICE_CONTROLLER_EGRESS_PACKET_COUNT
+#define ICE_CONTROLLER_EGRESS_PACKET_COUNT ( 0 )
+#endif /* ICE_CONTROLLER_EGRESS_PACKET_COUNT */
+
+/* Packets of the pool that video can't take, so audio and retransmissions still get queued during a keyframe burst. */
+#define ICE_CONTROLLER_EGRESS_RESERVED_PACKET_COUNT ( ICE_CONTROLLER_EGRESS_PACKET_COUNT / 8 )
+#define ICE_CONTROLLER_EGRESS_TASK_NAME "IceEgressTask"
+#define ICE_CONTROLLER_EGRESS_TASK_STACK_SIZE ( 4096 )
+
+/**
+ * Gather IPv6 host/srflx/relay candidates in addition to IPv4 ones when the
+ * lwIP stack is built with IPv6. Set to 0 to force IPv4 only gathering.
+ */
+#ifndef ICE_CONTROLLER_ENABLE_IPV6
+#define ICE_CONTROLLER_ENABLE_IPV6 ( LWIP_IPV6 )
+#endif
+
+/**
+ * Maximum number of IPv6 addresses collected from the network interface.
+ * Link-local addresses are skipped because they require a scope ID to be routable.
+ */
+#define ICE_CONTROLLER_MAX_LOCAL_IPV6_ADDRESS_COUNT ( 2 )
+
 typedef enum IceControllerSocketType
 {
     ICE_CONTROLLER_SOCKET_TYPE_NONE = 0,
@@ -135,6 +212,7 @@ typedef enum IceControllerResult
     /* Info codes. */
     ICE_CONTROLLER_RESULT_OK = 0,
     ICE_CONTROLLER_RESULT_FOUND_CONNECTION,
+    ICE_CONTROLLER_RESULT_FOUND_VALID_PAIR,
     ICE_CONTROLLER_RESULT_CONNECTION_IN_PROGRESS,
     ICE_CONTROLLER_RESULT_CONNECTION_CLOSED,
     ICE_CONTROLLER_RESULT_CONTEXT_ALREADY_CLOSED,
@@ -158,6 +236,7 @@ typedef enum IceControllerResult
     ICE_CONTROLLER_RESULT_FAIL_SOCKET_TYPE,
     ICE_CONTROLLER_RESULT_FAIL_SOCKET_GETSOCKNAME,
     ICE_CONTROLLER_RESULT_FAIL_SOCKET_SENDTO,
+    ICE_CONTROLLER_RESULT_FAIL_ADDRESS_FAMILY_MISMATCH,
     ICE_CONTROLLER_RESULT_FAIL_ADD_HOST_CANDIDATE,
     ICE_CONTROLLER_RESULT_FAIL_ADD_RELAY_CANDIDATE,
     ICE_CONTROLLER_RESULT_FAIL_ADD_REMOTE_CANDIDATE,
@@ -188,8 +267,20 @@ typedef enum IceControllerResult
     ICE_CONTROLLER_RESULT_JSON_CANDIDATE_INVALID_TYPE_ID,
     ICE_CONTROLLER_RESULT_JSON_CANDIDATE_INVALID_TYPE,
     ICE_CONTROLLER_RESULT_JSON_CANDIDATE_LACK_OF_ELEMENT,
+    ICE_CONTROLLER_RESULT_SOCKET_SEND_BUSY,
+    ICE_CONTROLLER_RESULT_FAIL_EGRESS_QUEUE_FULL,
+    ICE_CONTROLLER_RESULT_FAIL_CREATE_TASK_EGRESS,
 } IceControllerResult_t;
 
+/* Lower value is sent first by the egress task. */
+typedef enum IceControllerSendPriority
+{
+    ICE_CONTROLLER_SEND_PRIORITY_AUDIO = 0,
+    ICE_CONTROLLER_SEND_PRIORITY_RETRANSMISSION, /* RTX/NACK responses, late already. */
+    ICE_CONTROLLER_SEND_PRIORITY_VIDEO,
+    ICE_CONTROLLER_SEND_PRIORITY_COUNT,
+} IceControllerSendPriority_t;
+
 typedef enum IceControllerEvent
 {
     ICE_CONTROLLER_EVENT_NONE = 0,
@@ -251,6 +342,7 @@ typedef struct IceControllerIceServer
     char url[ ICE_CONTROLLER_ICE_SERVER_URL_MAX_LENGTH ];
     size_t urlLength;
     IceEndpoint_t iceEndpoint; //IP address
+    IceEndpoint_t iceEndpointIpv6; //IPv6 address, used by IPv6 srflx candidates on dual-stack hosts
     char userName[ ICE_CONTROLLER_ICE_SERVER_USERNAME_MAX_LENGTH ]; //user name
     size_t userNameLength;
     char password[ ICE_CONTROLLER_ICE_SERVER_PASSWORD_MAX_LENGTH ]; //password
@@ -269,6 +361,17 @@ typedef struct IceControllerSocketContext
     IceControllerIceServer_t * pIceServer;
     IceCandidatePair_t * pCandidatePair;
     int socketFd;
+    uint16_t family; /* STUN_ADDRESS_IPv4 or STUN_ADDRESS_IPv6, the address family of the socket itself. */
+
+    #if ICE_CONTROLLER_EGRESS_PACKET_COUNT > 0
+    /* Egress queues, protected by the egress mutex. */
+    struct IceControllerEgressPacket * pEgressHead[ ICE_CONTROLLER_SEND_PRIORITY_COUNT ];
+    struct IceControllerEgressPacket * pEgressTail[ ICE_CONTROLLER_SEND_PRIORITY_COUNT ];
+    struct IceControllerSocketContext * pNextEgressSocket; /* Next socket with queued packets. */
+    uint8_t isEgressScheduled;
+    uint8_t isEgressBackoff; /* Set when the stack ran out of buffers, don't send before egressRetryTick. */
+    TickType_t egressRetryTick;
+    #endif /* ICE_CONTROLLER_EGRESS_PACKET_COUNT > 0 */
 } IceControllerSocketContext_t;
 
 typedef struct IceControllerIceServerConfig
@@ -392,6 +495,19 @@ typedef struct IceControllerContext
 
     uint64_t connectivityCheckTimeoutMs;
     uint8_t addLocalCandidates;
+
+    /* Connectivity check pacing: position of the next check in the prioritized walk over the pairs. */
+    uint8_t checkRound;
+    size_t checkPairIndex;
+    uint64_t checkCycleStartMs;
+    uint64_t nextLocalCandidatesProcessMs;
+    /* First pair that started nomination, its request is retransmitted on its own timeout until nomination completes. */
+    IceCandidatePair_t * pNominatingCandidatePair;
+    uint64_t nominationRequestSentMs;
+    uint32_t nominationRtoMs;
+    /* DTLS runs on the first valid pair before nomination completes, other sockets are
+     * released only once the nominated pair is known. */
+    uint8_t releaseOtherSocketsPending;
 } IceControllerContext_t;
 
 #ifdef __cplusplus
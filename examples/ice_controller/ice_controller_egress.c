@@ -0,0 +1,517 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "logging.h"
+#include "ice_controller.h"
+#include "ice_controller_private.h"
+#include "task.h"
+
+#if ICE_CONTROLLER_EGRESS_PACKET_COUNT > 0
+
+#define ICE_CONTROLLER_EGRESS_PACKET_BUFFER_LENGTH ( ICE_CONTROLLER_SEND_HEADROOM_LENGTH + ICE_CONTROLLER_MAX_MTU + ICE_CONTROLLER_SEND_TAILROOM_LENGTH )
+
+typedef struct IceControllerEgressPacket
+{
+    struct IceControllerEgressPacket * pNext;
+    IceControllerContext_t * pCtx;
+    IceEndpoint_t remoteEndpoint;
+    IceControllerSendPriority_t priority;
+    uint8_t isBusy;
+    TickType_t firstBusyTick; /* First time the network stack had no buffer for this packet. */
+    size_t bufferLength;
+    uint8_t buffer[ ICE_CONTROLLER_EGRESS_PACKET_BUFFER_LENGTH ];
+} IceControllerEgressPacket_t;
+
+typedef struct IceControllerEgress
+{
+    uint8_t isInited;
+    SemaphoreHandle_t mutex;
+    TaskHandle_t taskHandler;
+
+    IceControllerEgressPacket_t * pFreePackets;
+    size_t freePacketCount;
+
+    /* Sockets with queued packets, served round robin. A socket is in this
+     * list if and only if it has at least one queued packet. */
+    IceControllerSocketContext_t * pReadyHead;
+    IceControllerSocketContext_t * pReadyTail;
+
+    IceControllerEgressPacket_t packets[ ICE_CONTROLLER_EGRESS_PACKET_COUNT ];
+} IceControllerEgress_t;
+
+static IceControllerEgress_t egress;
+
+/* All the functions below until IceControllerEgress_Task() expect the egress mutex to be held. */
+static void FreePacket( IceControllerEgressPacket_t * pPacket )
+{
+    pPacket->pNext = egress.pFreePackets;
+    egress.pFreePackets = pPacket;
+    egress.freePacketCount++;
+}
+
+static void ScheduleSocket( IceControllerSocketContext_t * pSocketContext )
+{
+    if( pSocketContext->isEgressScheduled == 0U )
+    {
+        pSocketContext->pNextEgressSocket = NULL;
+        pSocketContext->isEgressScheduled = 1U;
+
+        if( egress.pReadyTail == NULL )
+        {
+            egress.pReadyHead = pSocketContext;
+        }
+        else
+        {
+            egress.pReadyTail->pNextEgressSocket = pSocketContext;
+        }
+
+        egress.pReadyTail = pSocketContext;
+    }
+}
+
+static void UnscheduleSocket( IceControllerSocketContext_t * pSocketContext,
+                              IceControllerSocketContext_t * pPrevious )
+{
+    if( pPrevious == NULL )
+    {
+        egress.pReadyHead = pSocketContext->pNextEgressSocket;
+    }
+    else
+    {
+        pPrevious->pNextEgressSocket = pSocketContext->pNextEgressSocket;
+    }
+
+    if( egress.pReadyTail == pSocketContext )
+    {
+        egress.pReadyTail = pPrevious;
+    }
+
+    pSocketContext->pNextEgressSocket = NULL;
+    pSocketContext->isEgressScheduled = 0U;
+}
+
+static uint8_t HasQueuedPacket( IceControllerSocketContext_t * pSocketContext )
+{
+    uint8_t hasPacket = 0U;
+    int i;
+
+    for( i = 0; i < ICE_CONTROLLER_SEND_PRIORITY_COUNT; i++ )
+    {
+        if( pSocketContext->pEgressHead[ i ] != NULL )
+        {
+            hasPacket = 1U;
+            break;
+        }
+    }
+
+    return hasPacket;
+}
+
+static IceControllerEgressPacket_t * PopNextPacket( IceControllerSocketContext_t ** ppSocketContext,
+                                                    TickType_t * pWaitTicks )
+{
+    IceControllerEgressPacket_t * pPacket = NULL;
+    IceControllerSocketContext_t * pSocketContext = egress.pReadyHead;
+    IceControllerSocketContext_t * pPrevious = NULL;
+    TickType_t now = xTaskGetTickCount();
+    TickType_t waitTicks;
+    int i;
+
+    *pWaitTicks = portMAX_DELAY;
+
+    while( ( pSocketContext != NULL ) && ( pPacket == NULL ) )
+    {
+        waitTicks = pSocketContext->egressRetryTick - now;
+
+        if( ( pSocketContext->isEgressBackoff != 0U ) && ( ( int32_t ) waitTicks > 0 ) )
+        {
+            /* The network stack had no buffer for this socket, leave it alone until the retry time. */
+            if( waitTicks < *pWaitTicks )
+            {
+                *pWaitTicks = waitTicks;
+            }
+
+            pPrevious = pSocketContext;
+            pSocketContext = pSocketContext->pNextEgressSocket;
+        }
+        else
+        {
+            pSocketContext->isEgressBackoff = 0U;
+
+            for( i = 0; i < ICE_CONTROLLER_SEND_PRIORITY_COUNT; i++ )
+            {
+                if( pSocketContext->pEgressHead[ i ] != NULL )
+                {
+                    pPacket = pSocketContext->pEgressHead[ i ];
+                    pSocketContext->pEgressHead[ i ] = pPacket->pNext;
+                    if( pSocketContext->pEgressHead[ i ] == NULL )
+                    {
+                        pSocketContext->pEgressTail[ i ] = NULL;
+                    }
+                    pPacket->pNext = NULL;
+                    break;
+                }
+            }
+
+            /* Move the socket to the end of the list so that other sockets get their turn. */
+            UnscheduleSocket( pSocketContext, pPrevious );
+            if( HasQueuedPacket( pSocketContext ) != 0U )
+            {
+                ScheduleSocket( pSocketContext );
+            }
+
+            *ppSocketContext = pSocketContext;
+        }
+    }
+
+    return pPacket;
+}
+
+static void AppendPacket( IceControllerSocketContext_t * pSocketContext,
+                          IceControllerEgressPacket_t * pPacket )
+{
+    pPacket->pNext = NULL;
+
+    if( pSocketContext->pEgressTail[ pPacket->priority ] == NULL )
+    {
+        pSocketContext->pEgressHead[ pPacket->priority ] = pPacket;
+    }
+    else
+    {
+        pSocketContext->pEgressTail[ pPacket->priority ]->pNext = pPacket;
+    }
+
+    pSocketContext->pEgressTail[ pPacket->priority ] = pPacket;
+    ScheduleSocket( pSocketContext );
+}
+
+static void RequeueBusyPacket( IceControllerSocketContext_t * pSocketContext,
+                               IceControllerEgressPacket_t * pPacket )
+{
+    if( xSemaphoreTake( egress.mutex, portMAX_DELAY ) == pdTRUE )
+    {
+        if( pSocketContext->state == ICE_CONTROLLER_SOCKET_CONTEXT_STATE_NONE )
+        {
+            /* Closed while the packet was out of the queue, the flush already happened. */
+            FreePacket( pPacket );
+        }
+        else
+        {
+            /* Put it back in front to keep the order of the queue. */
+            pPacket->pNext = pSocketContext->pEgressHead[ pPacket->priority ];
+            pSocketContext->pEgressHead[ pPacket->priority ] = pPacket;
+            if( pSocketContext->pEgressTail[ pPacket->priority ] == NULL )
+            {
+                pSocketContext->pEgressTail[ pPacket->priority ] = pPacket;
+            }
+
+            pSocketContext->egressRetryTick = xTaskGetTickCount() + pdMS_TO_TICKS( ICE_CONTROLLER_RESEND_DELAY_MS );
+            pSocketContext->isEgressBackoff = 1U;
+            ScheduleSocket( pSocketContext );
+        }
+
+        xSemaphoreGive( egress.mutex );
+    }
+}
+
+static void ReleasePacket( IceControllerEgressPacket_t * pPacket )
+{
+    if( xSemaphoreTake( egress.mutex, portMAX_DELAY ) == pdTRUE )
+    {
+        FreePacket( pPacket );
+        xSemaphoreGive( egress.mutex );
+    }
+}
+
+static void IceControllerEgress_Task( void * pParameter )
+{
+    IceControllerEgressPacket_t * pPacket;
+    IceControllerSocketContext_t * pSocketContext = NULL;
+    IceControllerResult_t ret;
+    TickType_t waitTicks = portMAX_DELAY;
+    TickType_t now;
+
+    ( void ) pParameter;
+
+    for( ;; )
+    {
+        /* Woken up by new packets, or by the retry time of a busy socket. */
+        ( void ) ulTaskNotifyTake( pdTRUE,
+                                   waitTicks );
+
+        for( ;; )
+        {
+            pPacket = NULL;
+
+            if( xSemaphoreTake( egress.mutex, portMAX_DELAY ) == pdTRUE )
+            {
+                pPacket = PopNextPacket( &pSocketContext, &waitTicks );
+                xSemaphoreGive( egress.mutex );
+            }
+
+            if( pPacket == NULL )
+            {
+                break;
+            }
+
+            /* The socket mutex is taken inside, never hold the egress mutex here. */
+            ret = IceControllerNet_TrySendPacket( pPacket->pCtx,
+                                                  pSocketContext,
+                                                  &pPacket->remoteEndpoint,
+                                                  pPacket->buffer,
+                                                  pPacket->bufferLength );
+
+            now = xTaskGetTickCount();
+            if( ( ret == ICE_CONTROLLER_RESULT_SOCKET_SEND_BUSY ) && ( pPacket->isBusy == 0U ) )
+            {
+                pPacket->isBusy = 1U;
+                pPacket->firstBusyTick = now;
+            }
+
+            if( ( ret == ICE_CONTROLLER_RESULT_SOCKET_SEND_BUSY ) &&
+                ( now - pPacket->firstBusyTick < pdMS_TO_TICKS( ICE_CONTROLLER_RESEND_TIMEOUT_MS ) ) )
+            {
+                RequeueBusyPacket( pSocketContext, pPacket );
+            }
+            else
+            {
+                if( ret == ICE_CONTROLLER_RESULT_SOCKET_SEND_BUSY )
+                {
+                    LogWarn( ( "Drop queued packet, no network buffer before timeout: %dms", ICE_CONTROLLER_RESEND_TIMEOUT_MS ) );
+                }
+                else if( ret != ICE_CONTROLLER_RESULT_OK )
+                {
+                    LogDebug( ( "Fail to send queued packet, result: %d", ret ) );
+                }
+                else
+                {
+                    /* Empty else marker. */
+                }
+
+                ReleasePacket( pPacket );
+            }
+        }
+    }
+}
+
+IceControllerResult_t IceControllerEgress_Init( void )
+{
+    IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
+    int i;
+
+    if( egress.isInited == 0U )
+    {
+        memset( &egress,
+                0,
+                sizeof( IceControllerEgress_t ) );
+
+        for( i = 0; i < ICE_CONTROLLER_EGRESS_PACKET_COUNT; i++ )
+        {
+            FreePacket( &egress.packets[ i ] );
+        }
+
+        egress.mutex = xSemaphoreCreateMutex();
+        if( egress.mutex == NULL )
+        {
+            LogError( ( "Fail to create mutex for Ice controller egress." ) );
+            ret = ICE_CONTROLLER_RESULT_FAIL_MUTEX_CREATE;
+        }
+
+        if( ret == ICE_CONTROLLER_RESULT_OK )
+        {
+            /* Same priority as the session tasks, media tasks only copy into the queues. */
+            if( xTaskCreate( IceControllerEgress_Task,
+                             ICE_CONTROLLER_EGRESS_TASK_NAME,
+                             ICE_CONTROLLER_EGRESS_TASK_STACK_SIZE,
+                             NULL,
+                             tskIDLE_PRIORITY + 4,
+                             &egress.taskHandler ) != pdPASS )
+            {
+                LogError( ( "xTaskCreate(%s) failed", ICE_CONTROLLER_EGRESS_TASK_NAME ) );
+                vSemaphoreDelete( egress.mutex );
+                egress.mutex = NULL;
+                ret = ICE_CONTROLLER_RESULT_FAIL_CREATE_TASK_EGRESS;
+            }
+        }
+
+        if( ret == ICE_CONTROLLER_RESULT_OK )
+        {
+            egress.isInited = 1U;
+        }
+    }
+
+    return ret;
+}
+
+IceControllerResult_t IceControllerEgress_Enqueue( IceControllerContext_t * pCtx,
+                                                   IceControllerSocketContext_t * pSocketContext,
+                                                   IceEndpoint_t * pRemoteEndpoint,
+                                                   const uint8_t * pBuffer,
+                                                   size_t bufferLength,
+                                                   IceControllerSendPriority_t priority )
+{
+    IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
+    IceControllerEgressPacket_t * pPacket = NULL;
+
+    if( ( pCtx == NULL ) || ( pSocketContext == NULL ) || ( pRemoteEndpoint == NULL ) || ( pBuffer == NULL ) ||
+        ( priority >= ICE_CONTROLLER_SEND_PRIORITY_COUNT ) )
+    {
+        LogError( ( "Invalid input, pCtx: %p, pSocketContext: %p, pRemoteEndpoint: %p, pBuffer: %p, priority: %d",
+                    pCtx, pSocketContext, pRemoteEndpoint, pBuffer, priority ) );
+        ret = ICE_CONTROLLER_RESULT_BAD_PARAMETER;
+    }
+    else if( egress.isInited == 0U )
+    {
+        /* Not initialized yet, send from the calling task. */
+        ret = IceControllerNet_SendPacket( pCtx, pSocketContext, pRemoteEndpoint, pBuffer, bufferLength );
+    }
+    else if( bufferLength > ICE_CONTROLLER_EGRESS_PACKET_BUFFER_LENGTH )
+    {
+        LogWarn( ( "Packet length %u exceeds egress buffer length %u", bufferLength, ICE_CONTROLLER_EGRESS_PACKET_BUFFER_LENGTH ) );
+        ret = ICE_CONTROLLER_RESULT_FAIL_EXCEED_MTU;
+    }
+    else if( xSemaphoreTake( egress.mutex, portMAX_DELAY ) == pdTRUE )
+    {
+        if( ( egress.pFreePackets == NULL ) ||
+            ( ( priority == ICE_CONTROLLER_SEND_PRIORITY_VIDEO ) && ( egress.freePacketCount <= ICE_CONTROLLER_EGRESS_RESERVED_PACKET_COUNT ) ) )
+        {
+            ret = ICE_CONTROLLER_RESULT_FAIL_EGRESS_QUEUE_FULL;
+        }
+        else
+        {
+            pPacket = egress.pFreePackets;
+            egress.pFreePackets = pPacket->pNext;
+            egress.freePacketCount--;
+        }
+
+        xSemaphoreGive( egress.mutex );
+
+        if( ret == ICE_CONTROLLER_RESULT_FAIL_EGRESS_QUEUE_FULL )
+        {
+            LogWarn( ( "Egress queue is full, drop packet with priority: %d", priority ) );
+        }
+    }
+    else
+    {
+        LogError( ( "Failed to lock egress mutex." ) );
+        ret = ICE_CONTROLLER_RESULT_FAIL_MUTEX_TAKE;
+    }
+
+    if( pPacket != NULL )
+    {
+        /* Copy without holding the mutex, the packet is owned by this task until appended. */
+        pPacket->pCtx = pCtx;
+        memcpy( &pPacket->remoteEndpoint, pRemoteEndpoint, sizeof( IceEndpoint_t ) );
+        pPacket->priority = priority;
+        pPacket->isBusy = 0U;
+        pPacket->bufferLength = bufferLength;
+        memcpy( pPacket->buffer, pBuffer, bufferLength );
+
+        if( xSemaphoreTake( egress.mutex, portMAX_DELAY ) == pdTRUE )
+        {
+            if( pSocketContext->state == ICE_CONTROLLER_SOCKET_CONTEXT_STATE_NONE )
+            {
+                FreePacket( pPacket );
+                ret = ICE_CONTROLLER_RESULT_FAIL_SOCKET_CONTEXT_ALREADY_CLOSED;
+            }
+            else
+            {
+                AppendPacket( pSocketContext, pPacket );
+            }
+
+            xSemaphoreGive( egress.mutex );
+        }
+
+        if( ret == ICE_CONTROLLER_RESULT_OK )
+        {
+            ( void ) xTaskNotifyGive( egress.taskHandler );
+        }
+    }
+
+    return ret;
+}
+
+void IceControllerEgress_FlushSocket( IceControllerSocketContext_t * pSocketContext )
+{
+    IceControllerSocketContext_t * pCurrent;
+    IceControllerSocketContext_t * pPrevious = NULL;
+    IceControllerEgressPacket_t * pPacket;
+    int i;
+
+    if( ( pSocketContext != NULL ) &&
+        ( egress.isInited != 0U ) &&
+        ( xSemaphoreTake( egress.mutex, portMAX_DELAY ) == pdTRUE ) )
+    {
+        /* Only trust the queue of a socket found in the ready list, the context
+         * might be uninitialized memory when called before a session init. */
+        pCurrent = egress.pReadyHead;
+        while( ( pCurrent != NULL ) && ( pCurrent != pSocketContext ) )
+        {
+            pPrevious = pCurrent;
+            pCurrent = pCurrent->pNextEgressSocket;
+        }
+
+        if( pCurrent != NULL )
+        {
+            UnscheduleSocket( pSocketContext, pPrevious );
+
+            for( i = 0; i < ICE_CONTROLLER_SEND_PRIORITY_COUNT; i++ )
+            {
+                while( pSocketContext->pEgressHead[ i ] != NULL )
+                {
+                    pPacket = pSocketContext->pEgressHead[ i ];
+                    pSocketContext->pEgressHead[ i ] = pPacket->pNext;
+                    FreePacket( pPacket );
+                }
+            }
+        }
+
+        memset( pSocketContext->pEgressHead, 0, sizeof( pSocketContext->pEgressHead ) );
+        memset( pSocketContext->pEgressTail, 0, sizeof( pSocketContext->pEgressTail ) );
+        pSocketContext->pNextEgressSocket = NULL;
+        pSocketContext->isEgressScheduled = 0U;
+        pSocketContext->isEgressBackoff = 0U;
+
+        xSemaphoreGive( egress.mutex );
+    }
+}
+
+#else /* ICE_CONTROLLER_EGRESS_PACKET_COUNT > 0 */
+
+IceControllerResult_t IceControllerEgress_Init( void )
+{
+    return ICE_CONTROLLER_RESULT_OK;
+}
+
+IceControllerResult_t IceControllerEgress_Enqueue( IceControllerContext_t * pCtx,
+                                                   IceControllerSocketContext_t * pSocketContext,
+                                                   IceEndpoint_t * pRemoteEndpoint,
+                                                   const uint8_t * pBuffer,
+                                                   size_t bufferLength,
+                                                   IceControllerSendPriority_t priority )
+{
+    ( void ) priority;
+
+    return IceControllerNet_SendPacket( pCtx, pSocketContext, pRemoteEndpoint, pBuffer, bufferLength );
+}
+
+void IceControllerEgress_FlushSocket( IceControllerSocketContext_t * pSocketContext )
+{
+    ( void ) pSocketContext;
+}
+
+#endif /* ICE_CONTROLLER_EGRESS_PACKET_COUNT > 0 */
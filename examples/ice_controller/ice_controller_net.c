@@ -18,6 +18,7 @@
 #include <time.h>
 #include "lwip/sockets.h"
 #include "lwip/netdb.h"
+#include "lwip/netif.h"
 #include "lwip_netconf.h"
 #include "logging.h"
 #include "ice_controller.h"
@@ -49,14 +50,17 @@
 #define ICE_CONTROLLER_STUN_MESSAGE_TYPE_STRING_SEND_INDICATION "SEND_INDICATION"
 #define ICE_CONTROLLER_STUN_MESSAGE_TYPE_STRING_DATA_INDICATION "DATA_INDICATION"
 
-#define ICE_CONTROLLER_RESEND_DELAY_MS ( 50 )
-#define ICE_CONTROLLER_RESEND_TIMEOUT_MS ( 1000 )
-
 static void GetLocalIPAdresses( IceEndpoint_t * pLocalIceEndpoints,
                                 size_t * pLocalIceEndpointsNum )
 {
     size_t localEndpointsSize = *pLocalIceEndpointsNum;
+    size_t localEndpointsCount = 0;
     uint8_t * pIpv4Address;
+    #if ICE_CONTROLLER_ENABLE_IPV6
+    const ip6_addr_t * pIpv6Address;
+    size_t ipv6AddressCount = 0;
+    int i;
+    #endif /* #if ICE_CONTROLLER_ENABLE_IPV6 */
 
     if( localEndpointsSize >= 1 )
     {
@@ -67,8 +71,42 @@ static void GetLocalIPAdresses( IceEndpoint_t * pLocalIceEndpoints,
         memcpy( pLocalIceEndpoints[ 0 ].transportAddress.address, pIpv4Address, STUN_IPV4_ADDRESS_SIZE );
         pLocalIceEndpoints[ 0 ].isPointToPoint = 0;
 
-        *pLocalIceEndpointsNum = 1;
+        localEndpointsCount = 1;
+    }
+
+    #if ICE_CONTROLLER_ENABLE_IPV6
+    /* Collect the preferred global IPv6 addresses of the same interface for dual-stack gathering. */
+    for( i = 0; i < LWIP_IPV6_NUM_ADDRESSES; i++ )
+    {
+        if( ( localEndpointsCount >= localEndpointsSize ) ||
+            ( ipv6AddressCount >= ICE_CONTROLLER_MAX_LOCAL_IPV6_ADDRESS_COUNT ) )
+        {
+            break;
+        }
+
+        if( !ip6_addr_ispreferred( netif_ip6_addr_state( &xnetif[ 0 ], i ) ) )
+        {
+            continue;
+        }
+
+        pIpv6Address = ip_2_ip6( netif_ip6_addr( &xnetif[ 0 ], i ) );
+        if( ip6_addr_islinklocal( pIpv6Address ) )
+        {
+            continue;
+        }
+
+        memset( &pLocalIceEndpoints[ localEndpointsCount ], 0, sizeof( IceEndpoint_t ) );
+        pLocalIceEndpoints[ localEndpointsCount ].transportAddress.family = STUN_ADDRESS_IPv6;
+        pLocalIceEndpoints[ localEndpointsCount ].transportAddress.port = 0;
+        memcpy( pLocalIceEndpoints[ localEndpointsCount ].transportAddress.address, pIpv6Address->addr, STUN_IPV6_ADDRESS_SIZE );
+        pLocalIceEndpoints[ localEndpointsCount ].isPointToPoint = 0;
+
+        localEndpointsCount++;
+        ipv6AddressCount++;
     }
+    #endif /* #if ICE_CONTROLLER_ENABLE_IPV6 */
+
+    *pLocalIceEndpointsNum = localEndpointsCount;
 }
 
 void IceControllerNet_UpdateSocketContext( IceControllerContext_t * pCtx,
@@ -115,7 +153,9 @@ static IceControllerResult_t CreateSocketContextUdp( IceControllerContext_t * pC
     IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
     IceControllerSocketContext_t * pSocketContext = NULL;
     struct sockaddr_in ipv4Address;
-    // struct sockaddr_in6 ipv6Addr;
+    #if ICE_CONTROLLER_ENABLE_IPV6
+    struct sockaddr_in6 ipv6Address;
+    #endif /* #if ICE_CONTROLLER_ENABLE_IPV6 */
     struct sockaddr * pSockAddress = NULL;
     socklen_t addressLength;
     struct timeval tv = {
@@ -164,17 +204,19 @@ static IceControllerResult_t CreateSocketContextUdp( IceControllerContext_t * pC
         }
         else
         {
-            /* TODO: skip IPv6 for now. */
-            // memset( &ipv6Addr, 0x00, sizeof(ipv6Addr) );
-            // ipv6Addr.sin6_family = AF_INET6;
-            // ipv6Addr.sin6_port = 0; // use next available port
-            // memcpy(&ipv6Addr.sin6_addr, pBindEndpoint->transportAddress.address, STUN_IPV4_ADDRESS_SIZE);
-            // pSockAddress = (struct sockaddr*) &ipv6Addr;
-            // addressLength = sizeof(struct sockaddr_in6);
+            #if ICE_CONTROLLER_ENABLE_IPV6
+            memset( &ipv6Address, 0, sizeof( ipv6Address ) );
+            ipv6Address.sin6_family = AF_INET6;
+            ipv6Address.sin6_port = 0; // use next available port
+            memcpy( &ipv6Address.sin6_addr, pBindEndpoint->transportAddress.address, STUN_IPV6_ADDRESS_SIZE );
+            pSockAddress = ( struct sockaddr * ) &ipv6Address;
+            addressLength = sizeof( struct sockaddr_in6 );
+            #else
             ret = ICE_CONTROLLER_RESULT_IPV6_NOT_SUPPORT;
             close( pSocketContext->socketFd );
             pSocketContext->socketFd = -1;
             pCtx->socketsContextsCount--;
+            #endif /* #if ICE_CONTROLLER_ENABLE_IPV6 */
         }
     }
 
@@ -202,7 +244,16 @@ static IceControllerResult_t CreateSocketContextUdp( IceControllerContext_t * pC
         }
         else
         {
-            pBindEndpoint->transportAddress.port = ( uint16_t ) pBindEndpoint->transportAddress.family == STUN_ADDRESS_IPv4 ? ntohs( ipv4Address.sin_port ) : 0U;
+            if( pBindEndpoint->transportAddress.family == STUN_ADDRESS_IPv4 )
+            {
+                pBindEndpoint->transportAddress.port = ( uint16_t ) ntohs( ipv4Address.sin_port );
+            }
+            #if ICE_CONTROLLER_ENABLE_IPV6
+            else
+            {
+                pBindEndpoint->transportAddress.port = ( uint16_t ) ntohs( ipv6Address.sin6_port );
+            }
+            #endif /* #if ICE_CONTROLLER_ENABLE_IPV6 */
         }
     }
 
@@ -217,6 +268,7 @@ static IceControllerResult_t CreateSocketContextUdp( IceControllerContext_t * pC
     {
         /* Assign to output when success. */
         pSocketContext->socketType = ICE_CONTROLLER_SOCKET_TYPE_UDP;
+        pSocketContext->family = family;
         *ppOutSocketContext = pSocketContext;
     }
 
@@ -240,12 +292,12 @@ static IceControllerResult_t CreateSocketContextTcp( IceControllerContext_t * pC
     TlsTransportStatus_t xNetworkStatus;
     NetworkCredentials_t credentials;
     const char * pRemoteIpPos;
-    char remoteIpAddr[ INET_ADDRSTRLEN ];
+    char remoteIpAddr[ INET6_ADDRSTRLEN ];
 
-    pRemoteIpPos = inet_ntop( AF_INET,
+    pRemoteIpPos = inet_ntop( family == STUN_ADDRESS_IPv4 ? AF_INET : AF_INET6,
                               pConnectEndpoint->transportAddress.address,
                               remoteIpAddr,
-                              INET_ADDRSTRLEN );
+                              INET6_ADDRSTRLEN );
     LogInfo( ( "Start TLS handshaking with %s:%d", pRemoteIpPos ? pRemoteIpPos : "UNKNOWN", pConnectEndpoint->transportAddress.port ) );
     if( pRemoteIpPos == NULL )
     {
@@ -330,6 +382,7 @@ static IceControllerResult_t CreateSocketContextTcp( IceControllerContext_t * pC
         setsockopt( pSocketContext->socketFd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof( struct timeval ) );
 
         pSocketContext->socketType = ICE_CONTROLLER_SOCKET_TYPE_TLS;
+        pSocketContext->family = family;
         *ppOutSocketContext = pSocketContext;
     }
 
@@ -406,13 +459,14 @@ static IceControllerResult_t SendSocketPacket( IceControllerSocketContext_t * pS
                                                int flags,
                                                struct sockaddr * pDestinationAddress,
                                                socklen_t addressLength,
-                                               IceEndpoint_t * pDestinationEndpoint )
+                                               IceEndpoint_t * pDestinationEndpoint,
+                                               uint8_t isBlocking )
 {
     IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
     int sentBytes, sendTotalBytes = 0;
     uint32_t totalDelayMs = 0;
     #if LIBRARY_LOG_LEVEL >= LOG_VERBOSE
-    char ipBuffer[ INET_ADDRSTRLEN ];
+    char ipBuffer[ INET6_ADDRSTRLEN ];
     #endif /* #if LIBRARY_LOG_LEVEL >= LOG_VERBOSE  */
 
     while( sendTotalBytes < length )
@@ -446,6 +500,14 @@ static IceControllerResult_t SendSocketPacket( IceControllerSocketContext_t * pS
             {
                 /* Just retry for these kinds of errno. */
             }
+            else if( ( ( errno == ENOMEM ) || ( errno == ENOSPC ) || ( errno == ENOBUFS ) ) &&
+                     ( isBlocking == 0U ) &&
+                     ( sendTotalBytes == 0 ) )
+            {
+                /* Nothing is written yet, let the egress task retry later rather than stalling here. */
+                ret = ICE_CONTROLLER_RESULT_SOCKET_SEND_BUSY;
+                break;
+            }
             else if( ( errno == ENOMEM ) || ( errno == ENOSPC ) || ( errno == ENOBUFS ) )
             {
                 vTaskDelay( pdMS_TO_TICKS( ICE_CONTROLLER_RESEND_DELAY_MS ) );
@@ -506,6 +568,10 @@ void IceControllerNet_FreeSocketContext( IceControllerContext_t * pCtx,
             pSocketContext->state = ICE_CONTROLLER_SOCKET_CONTEXT_STATE_NONE;
 
             xSemaphoreGive( pCtx->socketMutex );
+
+            /* Drop the packets still waiting for the egress task. Done after the state
+             * change so that a packet put back by the egress task is dropped as well. */
+            IceControllerEgress_FlushSocket( pSocketContext );
         }
         else
         {
@@ -524,7 +590,7 @@ static void AddHostCandidate( IceControllerContext_t * pCtx,
     IceControllerCallbackContent_t localCandidateReadyContent;
     int32_t retLocalCandidateReady;
     #if LIBRARY_LOG_LEVEL >= LOG_VERBOSE
-    char ipBuffer[ INET_ADDRSTRLEN ];
+    char ipBuffer[ INET6_ADDRSTRLEN ];
     #endif /* #if LIBRARY_LOG_LEVEL >= LOG_VERBOSE  */
 
     ret = CreateSocketContext( pCtx, pLocalIceEndpoint->transportAddress.family, pLocalIceEndpoint, NULL, ICE_SOCKET_PROTOCOL_UDP, &pSocketContext );
@@ -593,8 +659,9 @@ static void AddSrflxCandidate( IceControllerContext_t * pCtx,
     IceResult_t iceResult;
     uint32_t i;
     IceControllerSocketContext_t * pSocketContext = NULL;
+    IceEndpoint_t * pServerEndpoint = NULL;
     #if LIBRARY_LOG_LEVEL >= LOG_VERBOSE
-    char ipBuffer[ INET_ADDRSTRLEN ];
+    char ipBuffer[ INET6_ADDRSTRLEN ];
     #endif /* #if LIBRARY_LOG_LEVEL >= LOG_VERBOSE  */
     IceControllerResult_t dnsResult;
 
@@ -609,8 +676,21 @@ static void AddSrflxCandidate( IceControllerContext_t * pCtx,
             continue;
         }
 
+        /* Resolve the STUN server in the same address family as the local endpoint.
+         * IPv6 results are kept in a separate endpoint so that IPv4 sockets keep using the IPv4 server address. */
+        if( pLocalIceEndpoint->transportAddress.family == STUN_ADDRESS_IPv6 )
+        {
+            pServerEndpoint = &pCtx->iceServers[ i ].iceEndpointIpv6;
+            pServerEndpoint->transportAddress.port = pCtx->iceServers[ i ].iceEndpoint.transportAddress.port;
+        }
+        else
+        {
+            pServerEndpoint = &pCtx->iceServers[ i ].iceEndpoint;
+        }
+
         dnsResult = IceControllerNet_DnsLookUp( pCtx->iceServers[ i ].url,
-                                                &pCtx->iceServers[ i ].iceEndpoint.transportAddress );
+                                                pLocalIceEndpoint->transportAddress.family,
+                                                &pServerEndpoint->transportAddress );
         if( dnsResult != ICE_CONTROLLER_RESULT_OK )
         {
             LogWarn( ( "Fail to get the DNS result of STUN server: %.*s",
@@ -619,9 +699,7 @@ static void AddSrflxCandidate( IceControllerContext_t * pCtx,
             continue;
         }
 
-        /* Only support IPv4 STUN for now. */
-        if( ( pCtx->iceServers[ i ].iceEndpoint.transportAddress.family == STUN_ADDRESS_IPv4 ) &&
-            ( pLocalIceEndpoint->transportAddress.family == pCtx->iceServers[ i ].iceEndpoint.transportAddress.family ) )
+        if( pLocalIceEndpoint->transportAddress.family == pServerEndpoint->transportAddress.family )
         {
             ret = CreateSocketContext( pCtx, pLocalIceEndpoint->transportAddress.family, pLocalIceEndpoint, NULL, ICE_SOCKET_PROTOCOL_UDP, &pSocketContext );
             if( ( ret != ICE_CONTROLLER_RESULT_OK ) ||
@@ -633,7 +711,8 @@ static void AddSrflxCandidate( IceControllerContext_t * pCtx,
         }
         else
         {
-            LogWarn( ( "STUN server's IP family is not supported: %.*s",
+            LogInfo( ( "STUN server has no address in local IP family %d: %.*s",
+                       pLocalIceEndpoint->transportAddress.family,
                        ( int ) pCtx->iceServers[ i ].urlLength,
                        pCtx->iceServers[ i ].url ) );
             continue;
@@ -686,7 +765,7 @@ static void AddRelayCandidates( IceControllerContext_t * pCtx )
     uint32_t i;
     IceControllerSocketContext_t * pSocketContext = NULL;
     #if LIBRARY_LOG_LEVEL >= LOG_VERBOSE
-    char ipBuffer[ INET_ADDRSTRLEN ];
+    char ipBuffer[ INET6_ADDRSTRLEN ];
     #endif /* #if LIBRARY_LOG_LEVEL >= LOG_VERBOSE  */
     IceControllerResult_t dnsResult;
 
@@ -747,7 +826,9 @@ static void AddRelayCandidates( IceControllerContext_t * pCtx )
                            pCtx->iceServers[i].protocol == ICE_SOCKET_PROTOCOL_UDP ? "UDP" : "TLS" ) );
             }
 
+            /* Prefer IPv4 TURN transport and fall back to IPv6 for IPv6-only TURN servers. */
             dnsResult = IceControllerNet_DnsLookUp( pCtx->iceServers[ i ].url,
+                                                    STUN_ADDRESS_IPv4,
                                                     &pCtx->iceServers[ i ].iceEndpoint.transportAddress );
             if( dnsResult != ICE_CONTROLLER_RESULT_OK )
             {
@@ -757,7 +838,7 @@ static void AddRelayCandidates( IceControllerContext_t * pCtx )
                 continue;
             }
 
-            ret = CreateSocketContext( pCtx, STUN_ADDRESS_IPv4, NULL, &pCtx->iceServers[i].iceEndpoint, pCtx->iceServers[i].protocol, &pSocketContext );
+            ret = CreateSocketContext( pCtx, pCtx->iceServers[i].iceEndpoint.transportAddress.family, NULL, &pCtx->iceServers[i].iceEndpoint, pCtx->iceServers[i].protocol, &pSocketContext );
 
             if( ret == ICE_CONTROLLER_RESULT_OK )
             {
@@ -973,8 +1054,8 @@ static IceControllerResult_t CheckNomination( IceControllerContext_t * pCtx,
 {
     IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
     #if LIBRARY_LOG_LEVEL >= LOG_VERBOSE
-        char ipBuffer[ INET_ADDRSTRLEN ];
-        char ipBuffer2[ INET_ADDRSTRLEN ];
+        char ipBuffer[ INET6_ADDRSTRLEN ];
+        char ipBuffer2[ INET6_ADDRSTRLEN ];
     #endif /* #if LIBRARY_LOG_LEVEL >= LOG_VERBOSE */
 
     if( ( pCtx == NULL ) ||
@@ -989,7 +1070,7 @@ static IceControllerResult_t CheckNomination( IceControllerContext_t * pCtx,
     if( ret == ICE_CONTROLLER_RESULT_OK )
     {
         if( ( pCandidatePair->state == ICE_CANDIDATE_PAIR_STATE_SUCCEEDED ) &&
-            ( pCtx->pNominatedSocketContext == NULL ) )
+            ( pCtx->state == ICE_CONTROLLER_STATE_PROCESS_CANDIDATES_AND_PAIRS ) )
         {
             #if METRIC_PRINT_ENABLED
             Metric_EndEvent( METRIC_EVENT_ICE_FIND_P2P_CONNECTION );
@@ -1014,9 +1095,9 @@ IceControllerResult_t IceControllerNet_ConvertIpString( const char * pIpAddr,
                                                         IceEndpoint_t * pDestinationIceEndpoint )
 {
     IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
-    char ipAddress[ ICE_CONTROLLER_IP_ADDR_STRING_BUFFER_LENGTH + 1 ];
+    char ipAddress[ ICE_CONTROLLER_IP_ADDR_STRING_BUFFER_LENGTH ];
 
-    if( ipAddrLength > ICE_CONTROLLER_IP_ADDR_STRING_BUFFER_LENGTH )
+    if( ipAddrLength >= ICE_CONTROLLER_IP_ADDR_STRING_BUFFER_LENGTH )
     {
         LogWarn( ( "invalid IP address detected, IP: %.*s",
                    ( int ) ipAddrLength, pIpAddr ) );
@@ -1053,11 +1134,12 @@ IceControllerResult_t IceControllerNet_Htons( uint16_t port,
     return ICE_CONTROLLER_RESULT_OK;
 }
 
-IceControllerResult_t IceControllerNet_SendPacket( IceControllerContext_t * pCtx,
-                                                   IceControllerSocketContext_t * pSocketContext,
-                                                   IceEndpoint_t * pRemoteEndpoint,
-                                                   const uint8_t * pBuffer,
-                                                   size_t bufferLength )
+static IceControllerResult_t SendPacket( IceControllerContext_t * pCtx,
+                                         IceControllerSocketContext_t * pSocketContext,
+                                         IceEndpoint_t * pRemoteEndpoint,
+                                         const uint8_t * pBuffer,
+                                         size_t bufferLength,
+                                         uint8_t isBlocking )
 {
     IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
     struct sockaddr * pDestinationAddress = NULL;
@@ -1098,13 +1180,15 @@ IceControllerResult_t IceControllerNet_SendPacket( IceControllerContext_t * pCtx
 
     if( ret == ICE_CONTROLLER_RESULT_OK )
     {
-        /* Set socket destination address, including IP type (v4/v6), IP address and port. */
-        if( pSocketContext->pLocalCandidate->endpoint.transportAddress.family != pRemoteEndpoint->transportAddress.family )
+        /* Set socket destination address, including IP type (v4/v6), IP address and port.
+         * Compare with the socket family rather than the local candidate, a relay candidate might
+         * carry a relayed address of the other family than the TURN server transport. */
+        if( pSocketContext->family != pRemoteEndpoint->transportAddress.family )
         {
             LogWarn( ( "The sending IP family: %d is different from receiving IP family: %d",
-                       pSocketContext->pLocalCandidate->endpoint.transportAddress.family,
+                       pSocketContext->family,
                        pRemoteEndpoint->transportAddress.family ) );
-            ret = ICE_CONTROLLER_RESULT_FAIL_SOCKET_SENDTO;
+            ret = ICE_CONTROLLER_RESULT_FAIL_ADDRESS_FAMILY_MISMATCH;
         }
     }
 
@@ -1138,7 +1222,7 @@ IceControllerResult_t IceControllerNet_SendPacket( IceControllerContext_t * pCtx
         if( ( pSocketContext->socketType == ICE_CONTROLLER_SOCKET_TYPE_UDP ) ||
             ( pSocketContext->socketType == ICE_CONTROLLER_SOCKET_TYPE_TLS ) )
         {
-            ret = SendSocketPacket( pSocketContext, pBuffer, bufferLength, 0, pDestinationAddress, addressLength, pRemoteEndpoint );
+            ret = SendSocketPacket( pSocketContext, pBuffer, bufferLength, 0, pDestinationAddress, addressLength, pRemoteEndpoint, isBlocking );
         }
         else
         {
@@ -1190,6 +1274,26 @@ IceControllerResult_t IceControllerNet_SendPacket( IceControllerContext_t * pCtx
     return ret;
 }
 
+IceControllerResult_t IceControllerNet_SendPacket( IceControllerContext_t * pCtx,
+                                                   IceControllerSocketContext_t * pSocketContext,
+                                                   IceEndpoint_t * pRemoteEndpoint,
+                                                   const uint8_t * pBuffer,
+                                                   size_t bufferLength )
+{
+    return SendPacket( pCtx, pSocketContext, pRemoteEndpoint, pBuffer, bufferLength, 1U );
+}
+
+/* Same as IceControllerNet_SendPacket(), but returns ICE_CONTROLLER_RESULT_SOCKET_SEND_BUSY
+ * instead of waiting when the network stack has no buffer for the packet. */
+IceControllerResult_t IceControllerNet_TrySendPacket( IceControllerContext_t * pCtx,
+                                                      IceControllerSocketContext_t * pSocketContext,
+                                                      IceEndpoint_t * pRemoteEndpoint,
+                                                      const uint8_t * pBuffer,
+                                                      size_t bufferLength )
+{
+    return SendPacket( pCtx, pSocketContext, pRemoteEndpoint, pBuffer, bufferLength, 0U );
+}
+
 void IceControllerNet_AddLocalCandidates( IceControllerContext_t * pCtx )
 {
     IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
@@ -1564,9 +1668,23 @@ IceControllerResult_t IceControllerNet_HandleStunPacket( IceControllerContext_t
             case ICE_HANDLE_STUN_PACKET_RESULT_START_NOMINATION:
                 /* Add logic to start nomination flow here. NOTE: Take care of sending binding request part. */
                 ret = SendNominationRequest( pCtx, pSocketContext, pCandidatePair, pTransactionIdBuffer );
+                if( ret == ICE_CONTROLLER_RESULT_OK )
+                {
+                    if( pCtx->pNominatingCandidatePair == NULL )
+                    {
+                        /* Nominate the first valid pair right away, the check timer retransmits its request. */
+                        pCtx->pNominatingCandidatePair = pCandidatePair;
+                        pCtx->nominationRequestSentMs = NetworkingUtils_GetCurrentTimeUs( NULL ) / 1000;
+                        pCtx->nominationRtoMs = ICE_CONTROLLER_NOMINATION_INITIAL_RTO_MS;
+                    }
+
+                    /* The pair is valid, DTLS can start on it while nomination is in flight. */
+                    ret = ICE_CONTROLLER_RESULT_FOUND_VALID_PAIR;
+                }
                 break;
             case ICE_HANDLE_STUN_PACKET_RESULT_VALID_CANDIDATE_PAIR:
                 LogInfo( ( "A valid candidate pair is found" ) );
+                ret = ICE_CONTROLLER_RESULT_FOUND_VALID_PAIR;
                 break;
             case ICE_HANDLE_STUN_PACKET_RESULT_CANDIDATE_PAIR_READY:
                 ret = CheckNomination( pCtx,
@@ -1672,14 +1790,18 @@ IceControllerResult_t IceControllerNet_HandleStunPacket( IceControllerContext_t
 }
 
 IceControllerResult_t IceControllerNet_DnsLookUp( char * pUrl,
+                                                  uint16_t preferredFamily,
                                                   IceTransportAddress_t * pIceTransportAddress )
 {
     IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
     int dnsResult;
     struct addrinfo * pResult = NULL;
     struct addrinfo * pIterator;
+    struct addrinfo * pFound = NULL;
     struct sockaddr_in * ipv4Address;
-    // struct sockaddr_in6 * ipv6Address;
+    #if ICE_CONTROLLER_ENABLE_IPV6
+    struct sockaddr_in6 * ipv6Address;
+    #endif /* #if ICE_CONTROLLER_ENABLE_IPV6 */
     struct addrinfo hints = { 0 };
 
     if( ( pUrl == NULL ) || ( pIceTransportAddress == NULL ) )
@@ -1689,9 +1811,13 @@ IceControllerResult_t IceControllerNet_DnsLookUp( char * pUrl,
 
     if( ret == ICE_CONTROLLER_RESULT_OK )
     {
-        /* Restrict getaddrinfo to query IPv4 only. */
         memset( &hints, 0, sizeof( struct addrinfo ) );
+        #if ICE_CONTROLLER_ENABLE_IPV6
+        hints.ai_family = AF_UNSPEC;
+        #else
+        /* Restrict getaddrinfo to query IPv4 only. */
         hints.ai_family = AF_INET;
+        #endif /* #if ICE_CONTROLLER_ENABLE_IPV6 */
         dnsResult = getaddrinfo( pUrl, NULL, &hints, &pResult );
         if( dnsResult != 0 )
         {
@@ -1702,30 +1828,49 @@ IceControllerResult_t IceControllerNet_DnsLookUp( char * pUrl,
 
     if( ret == ICE_CONTROLLER_RESULT_OK )
     {
+        /* Pick the first result in preferred family, otherwise the first result of any supported family. */
         for( pIterator = pResult; pIterator; pIterator = pIterator->ai_next )
         {
-            if( pIterator->ai_family == AF_INET )
+            if( ( pIterator->ai_family != AF_INET ) &&
+                ( pIterator->ai_family != AF_INET6 ) )
             {
-                ipv4Address = ( struct sockaddr_in * ) pIterator->ai_addr;
-                pIceTransportAddress->family = STUN_ADDRESS_IPv4;
-                memcpy( pIceTransportAddress->address, &ipv4Address->sin_addr, STUN_IPV4_ADDRESS_SIZE );
-                break;
+                continue;
             }
-            else if( pIterator->ai_family == AF_INET6 )
+
+            if( pFound == NULL )
             {
-                /* TODO: IPv6 */
-                // ipv6Address = ( struct sockaddr_in6 * ) pIterator->ai_addr;
-                // pIceTransportAddress->family = STUN_ADDRESS_IPv6;
-                // memcpy( pIceTransportAddress->address, &ipv6Address->sin6_addr, STUN_IPV6_ADDRESS_SIZE );
-                // break;
-                continue;
+                pFound = pIterator;
+            }
+
+            if( ( ( preferredFamily == STUN_ADDRESS_IPv4 ) && ( pIterator->ai_family == AF_INET ) ) ||
+                ( ( preferredFamily == STUN_ADDRESS_IPv6 ) && ( pIterator->ai_family == AF_INET6 ) ) )
+            {
+                pFound = pIterator;
+                break;
             }
         }
 
-        if( pIterator == NULL )
+        if( pFound == NULL )
+        {
+            LogWarn( ( "No IP address found for the given url: %s", pUrl ) );
+            ret = ICE_CONTROLLER_RESULT_FAIL_DNS_QUERY;
+        }
+        else if( pFound->ai_family == AF_INET )
         {
+            ipv4Address = ( struct sockaddr_in * ) pFound->ai_addr;
+            pIceTransportAddress->family = STUN_ADDRESS_IPv4;
+            memcpy( pIceTransportAddress->address, &ipv4Address->sin_addr, STUN_IPV4_ADDRESS_SIZE );
+        }
+        else
+        {
+            #if ICE_CONTROLLER_ENABLE_IPV6
+            ipv6Address = ( struct sockaddr_in6 * ) pFound->ai_addr;
+            pIceTransportAddress->family = STUN_ADDRESS_IPv6;
+            memcpy( pIceTransportAddress->address, &ipv6Address->sin6_addr, STUN_IPV6_ADDRESS_SIZE );
+            #else
             LogWarn( ( "No IPv4 address found for the given url: %s", pUrl ) );
             ret = ICE_CONTROLLER_RESULT_FAIL_DNS_QUERY;
+            #endif /* #if ICE_CONTROLLER_ENABLE_IPV6 */
         }
     }
 
@@ -1737,6 +1882,26 @@ IceControllerResult_t IceControllerNet_DnsLookUp( char * pUrl,
     return ret;
 }
 
+IceEndpoint_t * IceControllerNet_GetIceServerEndpoint( IceControllerSocketContext_t * pSocketContext )
+{
+    IceEndpoint_t * pRet = NULL;
+
+    if( ( pSocketContext != NULL ) && ( pSocketContext->pIceServer != NULL ) )
+    {
+        if( ( pSocketContext->family == STUN_ADDRESS_IPv6 ) &&
+            ( pSocketContext->pIceServer->iceEndpointIpv6.transportAddress.family == STUN_ADDRESS_IPv6 ) )
+        {
+            pRet = &( pSocketContext->pIceServer->iceEndpointIpv6 );
+        }
+        else
+        {
+            pRet = &( pSocketContext->pIceServer->iceEndpoint );
+        }
+    }
+
+    return pRet;
+}
+
 #if LIBRARY_LOG_LEVEL >= LOG_INFO
 const char * IceControllerNet_LogIpAddressInfo( const IceEndpoint_t * pIceEndpoint,
                                                 char * pIpBuffer,
@@ -46,12 +46,19 @@ IceControllerResult_t IceControllerNet_HandleStunPacket( IceControllerContext_t
                                                          IceEndpoint_t * pRemoteIceEndpoint,
                                                          IceCandidatePair_t * pCandidatePair );
 IceControllerResult_t IceControllerNet_DnsLookUp( char * pUrl,
+                                                  uint16_t preferredFamily,
                                                   IceTransportAddress_t * pIceTransportAddress );
+IceEndpoint_t * IceControllerNet_GetIceServerEndpoint( IceControllerSocketContext_t * pSocketContext );
 IceControllerResult_t IceControllerNet_SendPacket( IceControllerContext_t * pCtx,
                                                    IceControllerSocketContext_t * pSocketContext,
                                                    IceEndpoint_t * pRemoteEndpoint,
                                                    const uint8_t * pBuffer,
                                                    size_t bufferLength );
+IceControllerResult_t IceControllerNet_TrySendPacket( IceControllerContext_t * pCtx,
+                                                      IceControllerSocketContext_t * pSocketContext,
+                                                      IceEndpoint_t * pRemoteEndpoint,
+                                                      const uint8_t * pBuffer,
+                                                      size_t bufferLength );
 void IceControllerNet_FreeSocketContext( IceControllerContext_t * pCtx,
                                          IceControllerSocketContext_t * pSocketContext );
 void IceControllerNet_UpdateSocketContext( IceControllerContext_t * pCtx,
@@ -70,6 +77,15 @@ IceControllerResult_t IceController_SendTurnRefreshAllocation( IceControllerCont
 IceControllerResult_t IceController_SendTurnRefreshPermission( IceControllerContext_t * pCtx,
                                                                IceCandidatePair_t * pTargetCandidatePair );
 
+IceControllerResult_t IceControllerEgress_Init( void );
+IceControllerResult_t IceControllerEgress_Enqueue( IceControllerContext_t * pCtx,
+                                                   IceControllerSocketContext_t * pSocketContext,
+                                                   IceEndpoint_t * pRemoteEndpoint,
+                                                   const uint8_t * pBuffer,
+                                                   size_t bufferLength,
+                                                   IceControllerSendPriority_t priority );
+void IceControllerEgress_FlushSocket( IceControllerSocketContext_t * pSocketContext );
+
 IceControllerResult_t IceControllerSocketListener_Init( IceControllerContext_t * pCtx,
                                                         OnRecvNonStunPacketCallback_t onRecvNonStunPacketFunc,
                                                         void * pOnRecvNonStunPacketCallbackContext );
@@ -178,10 +178,14 @@ static IceCandidatePair_t * FindCandidatePairByRemoteIceEndpoint( IceControllerC
     return pCandidatePair;
 }
 
+/* Move the media path to the pair of this socket context. With isNominated set to 0 the pair
+ * is only valid, DTLS starts on it while ICE keeps checking and the path migrates to the
+ * nominated pair later on. */
 static IceControllerResult_t UpdateNominatedSocketContext( IceControllerContext_t * pCtx,
                                                            IceControllerSocketContext_t * pSocketContext,
                                                            IceCandidatePair_t * pCandidatePair,
-                                                           IceEndpoint_t * pRemoteIceEndpoint )
+                                                           IceEndpoint_t * pRemoteIceEndpoint,
+                                                           uint8_t isNominated )
 {
     IceControllerResult_t ret = ICE_CONTROLLER_RESULT_OK;
     IceCandidatePair_t * pOriginalCandidatePair = NULL;
@@ -189,7 +193,7 @@ static IceControllerResult_t UpdateNominatedSocketContext( IceControllerContext_
     void * pOnIceEventCallbackCustomContext = NULL;
     int32_t retPeerToPeerConnectionFound = 0;
     #if LIBRARY_LOG_LEVEL >= LOG_INFO
-    char ipBuffer[ INET_ADDRSTRLEN ];
+    char ipBuffer[ INET6_ADDRSTRLEN ];
     #endif
 
     /* Find valid candidate pair pointer for current packet.
@@ -253,18 +257,30 @@ static IceControllerResult_t UpdateNominatedSocketContext( IceControllerContext_
             /* We have finished accessing the shared resource.  Release the mutex. */
             xSemaphoreGive( pCtx->socketMutex );
 
-            LogInfo( ( "Nominated pair is changed from local/remote candidate ID: 0x%04x / 0x%04x to local/remote candidate ID: 0x%04x / 0x%04x",
+            LogInfo( ( "%s pair is changed from local/remote candidate ID: 0x%04x / 0x%04x to local/remote candidate ID: 0x%04x / 0x%04x",
+                       isNominated != 0U ? "Nominated" : "Early selected",
                        pOriginalCandidatePair == NULL? 0:pOriginalCandidatePair->pLocalCandidate->candidateId,
                        pOriginalCandidatePair == NULL? 0:pOriginalCandidatePair->pRemoteCandidate->candidateId,
                        pCandidatePair->pLocalCandidate->candidateId,
                        pCandidatePair->pRemoteCandidate->candidateId ) );
 
-            if( pOriginalCandidatePair == NULL )
+            if( ( isNominated != 0U ) &&
+                ( pCtx->state == ICE_CONTROLLER_STATE_PROCESS_CANDIDATES_AND_PAIRS ) )
             {
                 IceController_UpdateState( pCtx, ICE_CONTROLLER_STATE_READY );
                 IceController_UpdateTimerInterval( pCtx, ICE_CONTROLLER_PERIODIC_TIMER_INTERVAL_MS );
 
-                /* Found nominated pair, execute DTLS handshake and release all other resources. */
+                /* DTLS already completed on the early selected pair, release the sockets it skipped. */
+                if( pCtx->releaseOtherSocketsPending != 0U )
+                {
+                    IceController_HandleEvent( pCtx,
+                                               ICE_CONTROLLER_EVENT_DTLS_HANDSHAKE_DONE );
+                }
+            }
+
+            if( pOriginalCandidatePair == NULL )
+            {
+                /* Found the first usable pair, execute DTLS handshake. Other resources are released once it's done. */
                 if( onIceEventCallbackFunc )
                 {
                     retPeerToPeerConnectionFound = onIceEventCallbackFunc( pOnIceEventCallbackCustomContext,
@@ -413,7 +429,7 @@ static void HandleRxPacket( IceControllerContext_t * pCtx,
                 {
                     if( pCtx->pNominatedSocketContext != pSocketContext )
                     {
-                        ret = UpdateNominatedSocketContext( pCtx, pSocketContext, pCandidatePair, &remoteIceEndpoint );
+                        ret = UpdateNominatedSocketContext( pCtx, pSocketContext, pCandidatePair, &remoteIceEndpoint, 1U );
                     }
 
                     if( ret == ICE_CONTROLLER_RESULT_OK )
@@ -442,14 +458,28 @@ static void HandleRxPacket( IceControllerContext_t * pCtx,
                                                          &remoteIceEndpoint,
                                                          pCandidatePair );
                 if( ( ret == ICE_CONTROLLER_RESULT_FOUND_CONNECTION ) &&
-                    ( pCtx->pNominatedSocketContext == NULL ) )
+                    ( pCtx->state == ICE_CONTROLLER_STATE_PROCESS_CANDIDATES_AND_PAIRS ) )
+                {
+                    /* Nomination completed, migrates DTLS/SRTP if it started on another pair. */
+                    UpdateNominatedSocketContext( pCtx,
+                                                  pSocketContext,
+                                                  pCandidatePair,
+                                                  &remoteIceEndpoint,
+                                                  1U );
+                }
+                else if( ( ret == ICE_CONTROLLER_RESULT_FOUND_VALID_PAIR ) &&
+                         ( pCtx->pNominatedSocketContext == NULL ) )
                 {
+                    /* Start DTLS on the first valid pair, overlapping with the remaining checks. */
                     UpdateNominatedSocketContext( pCtx,
                                                   pSocketContext,
                                                   pCandidatePair,
-                                                  &remoteIceEndpoint );
+                                                  &remoteIceEndpoint,
+                                                  0U );
                 }
-                else if( ( ret == ICE_CONTROLLER_RESULT_FOUND_CONNECTION ) || ( ret == ICE_CONTROLLER_RESULT_OK ) )
+                else if( ( ret == ICE_CONTROLLER_RESULT_FOUND_CONNECTION ) ||
+                         ( ret == ICE_CONTROLLER_RESULT_FOUND_VALID_PAIR ) ||
+                         ( ret == ICE_CONTROLLER_RESULT_OK ) )
                 {
                     /* Handle STUN packet successfully, keep processing. */
                 }
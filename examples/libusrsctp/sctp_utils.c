@@ -63,6 +63,10 @@ static int OnSctpInboundPacket( struct socket * pSocket,
                                 int flags,
                                 void * pUlpInfo );
 
+static int OnSctpSendBufferAvailable( struct socket * pSocket,
+                                      uint32_t sendBufferFree,
+                                      void * pUlpInfo );
+
 static SctpUtilsResult_t SendOpenDataChannelAck( SctpSession_t * pSctpSession,
                                                  uint16_t channelId );
 /*-----------------------------------------------------------*/
@@ -76,6 +80,7 @@ static SctpUtilsResult_t ConfigureSctpSocket( struct socket * pSocket )
     struct sctp_initmsg initmsg;
     uint32_t i;
     uint32_t valueOn = 1;
+    int sendBufferSize = SCTP_SEND_BUFFER_SIZE;
     uint16_t eventTypes[] = { SCTP_ASSOC_CHANGE,
                               SCTP_PEER_ADDR_CHANGE,
                               SCTP_REMOTE_ERROR,
@@ -120,6 +125,20 @@ static SctpUtilsResult_t ConfigureSctpSocket( struct socket * pSocket )
         }
     }
 
+    if( retStatus == SCTP_UTILS_RESULT_OK )
+    {
+        /* Bound the memory a fast sender can queue in the SCTP stack. */
+        if( usrsctp_setsockopt( pSocket,
+                                SOL_SOCKET,
+                                SO_SNDBUF,
+                                &( sendBufferSize ),
+                                sizeof( sendBufferSize ) ) != 0 )
+        {
+            LogError( ( "usrsctp_setsockopt failed: SOL_SOCKET, SO_SNDBUF!" ) );
+            retStatus = SCTP_UTILS_RESULT_FAIL;
+        }
+    }
+
     if( retStatus == SCTP_UTILS_RESULT_OK )
     {
         memset( &( event ), 0, sizeof( event ) );
@@ -286,6 +305,33 @@ static SctpUtilsResult_t HandleDcepMessage( SctpSession_t * pSctpSession,
 }
 /*-----------------------------------------------------------*/
 
+/* Called by the SCTP stack when at least SCTP_SEND_BUFFER_WAKEUP_THRESHOLD
+ * bytes of the send buffer are free. */
+static int OnSctpSendBufferAvailable( struct socket * pSocket,
+                                      uint32_t sendBufferFree,
+                                      void * pUlpInfo )
+{
+    SctpSession_t * pSctpSession = ( SctpSession_t * ) pUlpInfo;
+    uint32_t bufferedAmount = 0;
+
+    ( void )( pSocket );
+
+    if( ( pSctpSession != NULL ) &&
+        ( pSctpSession->sctpSessionCallbacks.sendBufferAvailableCallback != NULL ) )
+    {
+        if( sendBufferFree < SCTP_SEND_BUFFER_SIZE )
+        {
+            bufferedAmount = SCTP_SEND_BUFFER_SIZE - sendBufferFree;
+        }
+
+        pSctpSession->sctpSessionCallbacks.sendBufferAvailableCallback( pSctpSession->sctpSessionCallbacks.pUserData,
+                                                                        bufferedAmount );
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
 /* Process an incoming SCTP packet, this API is passed as a callback to the
  * SCTP stack to be called while there is a valid packet ready. */
 static int OnSctpInboundPacket( struct socket * pSocket,
@@ -470,8 +516,8 @@ SctpUtilsResult_t Sctp_CreateSession( SctpSession_t * pSctpSession,
                                                SOCK_STREAM,
                                                IPPROTO_SCTP,
                                                &OnSctpInboundPacket,
-                                               NULL,
-                                               0,
+                                               &OnSctpSendBufferAvailable,
+                                               SCTP_SEND_BUFFER_WAKEUP_THRESHOLD,
                                                pSctpSession );
         if( pSctpSession->socket == NULL )
         {
@@ -767,9 +813,58 @@ SctpUtilsResult_t Sctp_SendMessage( SctpSession_t * pSctpSession,
                            SCTP_SENDV_SPA,
                            0 ) <= 0 )
         {
-            LogError( ( "usrsctp_sendv failed!" ) );
+            if( ( errno == EWOULDBLOCK ) || ( errno == EAGAIN ) )
+            {
+                /* The socket is non-blocking and the send buffer is full. */
+                LogDebug( ( "usrsctp_sendv would block, message length: %lu", ( unsigned long ) messageLen ) );
+                retStatus = SCTP_UTILS_RESULT_WOULD_BLOCK;
+            }
+            else
+            {
+                LogError( ( "usrsctp_sendv failed!" ) );
+                retStatus = SCTP_UTILS_RESULT_FAIL;
+            }
+        }
+    }
+
+    return retStatus;
+}
+/*-----------------------------------------------------------*/
+
+/* Get the number of bytes queued in the SCTP send buffer, shared by all the
+ * streams of the association. */
+SctpUtilsResult_t Sctp_GetBufferedAmount( SctpSession_t * pSctpSession,
+                                          uint32_t * pBufferedAmount )
+{
+    SctpUtilsResult_t retStatus = SCTP_UTILS_RESULT_OK;
+    struct sctp_sockstat sockStat;
+    socklen_t sockStatLength = ( socklen_t ) sizeof( sockStat );
+
+    if( ( pSctpSession == NULL ) ||
+        ( pSctpSession->socket == NULL ) ||
+        ( pBufferedAmount == NULL ) )
+    {
+        retStatus = SCTP_UTILS_RESULT_BAD_PARAM;
+    }
+
+    if( retStatus == SCTP_UTILS_RESULT_OK )
+    {
+        /* One-to-one socket, the association ID is ignored. */
+        memset( &( sockStat ), 0, sizeof( sockStat ) );
+
+        if( usrsctp_getsockopt( pSctpSession->socket,
+                                IPPROTO_SCTP,
+                                SCTP_GET_SNDBUF_USE,
+                                &( sockStat ),
+                                &( sockStatLength ) ) != 0 )
+        {
+            LogError( ( "usrsctp_getsockopt failed: IPPROTO_SCTP, SCTP_GET_SNDBUF_USE!" ) );
             retStatus = SCTP_UTILS_RESULT_FAIL;
         }
+        else
+        {
+            *pBufferedAmount = sockStat.ss_total_sndbuf;
+        }
     }
 
     return retStatus;
@@ -38,13 +38,26 @@
                                               MAX_DATA_CHANNEL_NAME_LEN +           \
                                               MAX_DATA_CHANNEL_PROTOCOL_LEN + 2 )
 
+/* Size of the SCTP socket send buffer shared by all data channels of a session.
+ * Once it is full, Sctp_SendMessage() returns SCTP_UTILS_RESULT_WOULD_BLOCK. */
+#ifndef SCTP_SEND_BUFFER_SIZE
+#define SCTP_SEND_BUFFER_SIZE               ( 64 * 1024 )
+#endif
+
+/* The send buffer available callback fires each time acknowledged data
+ * leaves at least this many bytes free in the send buffer. */
+#ifndef SCTP_SEND_BUFFER_WAKEUP_THRESHOLD
+#define SCTP_SEND_BUFFER_WAKEUP_THRESHOLD   ( SCTP_SEND_BUFFER_SIZE / 2 )
+#endif
+
 /*-----------------------------------------------------------*/
 
 typedef enum SctpUtilsResult
 {
     SCTP_UTILS_RESULT_OK = 0,
     SCTP_UTILS_RESULT_BAD_PARAM,
-    SCTP_UTILS_RESULT_FAIL
+    SCTP_UTILS_RESULT_FAIL,
+    SCTP_UTILS_RESULT_WOULD_BLOCK
 } SctpUtilsResult_t;
 
 /*-----------------------------------------------------------*/
@@ -83,6 +96,13 @@ typedef void ( * SctpSessionDataChannelMessage_t )( void * pUserData,
                                                     uint8_t * pData,
                                                     uint32_t dataLength );
 
+/*
+ * Callback that is fired from the SCTP stack when acknowledged data has freed
+ * space in the send buffer. bufferedAmount is the number of bytes still queued.
+ */
+typedef void ( * SctpSessionSendBufferAvailable_t )( void * pUserData,
+                                                     uint32_t bufferedAmount );
+
 /*-----------------------------------------------------------*/
 
 typedef struct SctpSessionCallbacks
@@ -92,6 +112,7 @@ typedef struct SctpSessionCallbacks
     SctpSessionDataChannelOpen_t dataChannelOpenCallback;
     SctpSessionDataChannelAck_t dataChannelOpenAckCallback;
     SctpSessionDataChannelMessage_t dataChannelMessageCallback;
+    SctpSessionSendBufferAvailable_t sendBufferAvailableCallback;
 } SctpSessionCallbacks_t;
 
 typedef struct SctpSession
@@ -152,6 +173,9 @@ SctpUtilsResult_t Sctp_SendMessage( SctpSession_t * pSctpSession,
 SctpUtilsResult_t Sctp_CloseDataChannel( SctpSession_t * pSctpSession,
                                          const SctpDataChannel_t * pDataChannel );
 
+SctpUtilsResult_t Sctp_GetBufferedAmount( SctpSession_t * pSctpSession,
+                                          uint32_t * pBufferedAmount );
+
 /*-----------------------------------------------------------*/
 
 #endif /* DATA_CHANNEL_SCTP_H */
@@ -33,8 +33,50 @@
 #include "app_media_source.h"
 #include "logging.h"
 
+#ifndef ENABLE_KEYFRAME_CACHE
+    #define ENABLE_KEYFRAME_CACHE ( 0 )
+#endif
+
+#if ENABLE_KEYFRAME_CACHE
+/* The group of pictures since the last keyframe is cached up to this size, a longer one
+ * is dropped and joining viewers wait for the next keyframe. */
+#define MASTER_KEYFRAME_CACHE_MAX_SIZE ( 256 * 1024 )
+#define MASTER_KEYFRAME_CACHE_MAX_FRAMES ( 128 )
+#define MASTER_PARAMETER_SETS_MAX_SIZE ( 256 )
+
+#define MASTER_VIDEO_FRAME_FLAG_KEYFRAME ( 1U << 0 )
+#define MASTER_VIDEO_FRAME_FLAG_PARAMETER_SETS ( 1U << 1 )
+#define MASTER_VIDEO_FRAME_FLAG_SLICE ( 1U << 2 )
+
+typedef struct MasterCachedFrame
+{
+    uint32_t offset;
+    uint32_t length;
+    uint64_t timestampUs;
+} MasterCachedFrame_t;
+
+typedef struct MasterKeyframeCache
+{
+    /* Frames since the latest keyframe, the keyframe first and prefixed with the parameter sets it needs.
+     * A joining viewer gets all of them, so every delta frame it decodes has its references. */
+    uint8_t * pBuffer;
+    uint32_t bufferLength;
+    MasterCachedFrame_t frames[ MASTER_KEYFRAME_CACHE_MAX_FRAMES ];
+    uint32_t frameCount;
+    /* Parameter sets delivered by the encoder as a frame of their own. */
+    uint8_t parameterSets[ MASTER_PARAMETER_SETS_MAX_SIZE ];
+    uint32_t parameterSetsLength;
+    /* Set once a session has been sent video since it became ready. */
+    uint8_t sessionVideoStarted[ AWS_MAX_VIEWER_NUM ];
+} MasterKeyframeCache_t;
+#endif /* ENABLE_KEYFRAME_CACHE */
+
 AppContext_t appContext;
 AppMediaSourcesContext_t appMediaSourceContext;
+#if ENABLE_KEYFRAME_CACHE
+/* Only accessed from the video Tx task. */
+static MasterKeyframeCache_t keyframeCache;
+#endif /* ENABLE_KEYFRAME_CACHE */
 
 static void Master_Task( void * pParameter );
 
@@ -45,6 +87,172 @@ static int32_t OnMediaSinkHook( void * pCustom,
                                 MediaFrame_t * pFrame );
 static int32_t InitializeAppMediaSource( AppContext_t * pAppContext,
                                          AppMediaSourcesContext_t * pAppMediaSourceContext );
+#if ENABLE_KEYFRAME_CACHE
+static uint8_t ScanVideoFrame( const uint8_t * pData,
+                               uint32_t dataLength );
+static void AppendCachedFrame( const uint8_t * pPrefix,
+                               uint32_t prefixLength,
+                               const MediaFrame_t * pFrame );
+static void UpdateKeyframeCache( const MediaFrame_t * pFrame );
+static void ReleaseKeyframeCache( void );
+#endif /* ENABLE_KEYFRAME_CACHE */
+
+#if ENABLE_KEYFRAME_CACHE
+/* Walk the Annex-B start codes up to the first slice and report what the frame carries.
+ * Slice payloads are not scanned, keeping the cost independent of the frame size. */
+static uint8_t ScanVideoFrame( const uint8_t * pData,
+                               uint32_t dataLength )
+{
+    uint8_t flags = 0U;
+    uint8_t naluType;
+    uint32_t i;
+
+    for( i = 0; ( i + 3U < dataLength ) && ( ( flags & MASTER_VIDEO_FRAME_FLAG_SLICE ) == 0U ); i++ )
+    {
+        if( ( pData[ i ] != 0x00 ) || ( pData[ i + 1U ] != 0x00 ) || ( pData[ i + 2U ] != 0x01 ) )
+        {
+            continue;
+        }
+
+        #if USE_VIDEO_CODEC_H265
+        {
+            naluType = ( pData[ i + 3U ] >> 1 ) & 0x3F;
+            if( ( naluType >= 32U ) && ( naluType <= 34U ) )
+            {
+                /* VPS, SPS, PPS. */
+                flags |= MASTER_VIDEO_FRAME_FLAG_PARAMETER_SETS;
+            }
+            else if( ( naluType >= 16U ) && ( naluType <= 21U ) )
+            {
+                /* IRAP pictures: BLA, IDR, CRA. */
+                flags |= MASTER_VIDEO_FRAME_FLAG_KEYFRAME | MASTER_VIDEO_FRAME_FLAG_SLICE;
+            }
+            else if( naluType < 32U )
+            {
+                flags |= MASTER_VIDEO_FRAME_FLAG_SLICE;
+            }
+            else
+            {
+                /* Empty else marker. */
+            }
+        }
+        #else /* USE_VIDEO_CODEC_H265 */
+        {
+            naluType = pData[ i + 3U ] & 0x1F;
+            if( ( naluType == 7U ) || ( naluType == 8U ) )
+            {
+                /* SPS, PPS. */
+                flags |= MASTER_VIDEO_FRAME_FLAG_PARAMETER_SETS;
+            }
+            else if( naluType == 5U )
+            {
+                /* IDR slice. */
+                flags |= MASTER_VIDEO_FRAME_FLAG_KEYFRAME | MASTER_VIDEO_FRAME_FLAG_SLICE;
+            }
+            else if( ( naluType >= 1U ) && ( naluType <= 4U ) )
+            {
+                flags |= MASTER_VIDEO_FRAME_FLAG_SLICE;
+            }
+            else
+            {
+                /* Empty else marker. */
+            }
+        }
+        #endif /* USE_VIDEO_CODEC_H265 */
+
+        i += 2U;
+    }
+
+    return flags;
+}
+
+/* Append a frame to the cached group of pictures, or drop the group if it doesn't fit. */
+static void AppendCachedFrame( const uint8_t * pPrefix,
+                               uint32_t prefixLength,
+                               const MediaFrame_t * pFrame )
+{
+    MasterCachedFrame_t * pCachedFrame;
+    uint32_t requiredSize = prefixLength + pFrame->size;
+
+    if( keyframeCache.pBuffer == NULL )
+    {
+        /* Allocated on first use, and released again once no session is active. */
+        keyframeCache.pBuffer = ( uint8_t * ) pvPortMalloc( MASTER_KEYFRAME_CACHE_MAX_SIZE );
+        if( keyframeCache.pBuffer == NULL )
+        {
+            LogWarn( ( "Fail to allocate %u bytes for keyframe cache", MASTER_KEYFRAME_CACHE_MAX_SIZE ) );
+        }
+    }
+
+    if( ( keyframeCache.pBuffer == NULL ) ||
+        ( keyframeCache.frameCount >= MASTER_KEYFRAME_CACHE_MAX_FRAMES ) ||
+        ( requiredSize > MASTER_KEYFRAME_CACHE_MAX_SIZE - keyframeCache.bufferLength ) )
+    {
+        LogDebug( ( "Group of pictures too large to cache, frames: %lu, bytes: %lu",
+                    ( unsigned long ) keyframeCache.frameCount,
+                    ( unsigned long ) ( keyframeCache.bufferLength + requiredSize ) ) );
+        keyframeCache.frameCount = 0U;
+        keyframeCache.bufferLength = 0U;
+    }
+    else
+    {
+        pCachedFrame = &keyframeCache.frames[ keyframeCache.frameCount ];
+        pCachedFrame->offset = keyframeCache.bufferLength;
+        pCachedFrame->length = requiredSize;
+        pCachedFrame->timestampUs = pFrame->timestampUs;
+        memcpy( keyframeCache.pBuffer + keyframeCache.bufferLength, pPrefix, prefixLength );
+        memcpy( keyframeCache.pBuffer + keyframeCache.bufferLength + prefixLength, pFrame->pData, pFrame->size );
+        keyframeCache.bufferLength += requiredSize;
+        keyframeCache.frameCount++;
+    }
+}
+
+/* Keep the frames since the latest keyframe. */
+static void UpdateKeyframeCache( const MediaFrame_t * pFrame )
+{
+    uint8_t flags = ScanVideoFrame( pFrame->pData, pFrame->size );
+
+    if( flags == MASTER_VIDEO_FRAME_FLAG_PARAMETER_SETS )
+    {
+        if( pFrame->size <= MASTER_PARAMETER_SETS_MAX_SIZE )
+        {
+            memcpy( keyframeCache.parameterSets, pFrame->pData, pFrame->size );
+            keyframeCache.parameterSetsLength = pFrame->size;
+        }
+    }
+    else if( ( flags & MASTER_VIDEO_FRAME_FLAG_KEYFRAME ) != 0U )
+    {
+        /* A keyframe starts a new group of pictures. */
+        keyframeCache.frameCount = 0U;
+        keyframeCache.bufferLength = 0U;
+        AppendCachedFrame( keyframeCache.parameterSets,
+                           ( ( flags & MASTER_VIDEO_FRAME_FLAG_PARAMETER_SETS ) == 0U ) ? keyframeCache.parameterSetsLength : 0U,
+                           pFrame );
+    }
+    else if( keyframeCache.frameCount > 0U )
+    {
+        AppendCachedFrame( NULL,
+                           0U,
+                           pFrame );
+    }
+    else
+    {
+        /* No keyframe to build on, wait for the next one. */
+    }
+}
+
+/* The cache is only useful to a viewer that is connecting, drop it while no session is active. */
+static void ReleaseKeyframeCache( void )
+{
+    if( keyframeCache.pBuffer != NULL )
+    {
+        vPortFree( keyframeCache.pBuffer );
+        keyframeCache.pBuffer = NULL;
+    }
+    keyframeCache.bufferLength = 0U;
+    keyframeCache.frameCount = 0U;
+}
+#endif /* ENABLE_KEYFRAME_CACHE */
 
 static int32_t InitTransceiver( void * pMediaCtx,
                                 TransceiverTrackKind_t trackKind,
@@ -90,6 +298,11 @@ static int32_t OnMediaSinkHook( void * pCustom,
     Transceiver_t * pTransceiver = NULL;
     PeerConnectionFrame_t peerConnectionFrame;
     int i;
+    #if ENABLE_KEYFRAME_CACHE
+    PeerConnectionFrame_t cachedFrame;
+    uint32_t j;
+    uint8_t activeSessionCount = 0U;
+    #endif /* ENABLE_KEYFRAME_CACHE */
 
     if( ( pAppContext == NULL ) || ( pFrame == NULL ) )
     {
@@ -97,6 +310,29 @@ static int32_t OnMediaSinkHook( void * pCustom,
         ret = -1;
     }
 
+    #if ENABLE_KEYFRAME_CACHE
+    if( ( ret == 0 ) && ( pFrame->trackKind == TRANSCEIVER_TRACK_KIND_VIDEO ) )
+    {
+        for( i = 0; i < AWS_MAX_VIEWER_NUM; i++ )
+        {
+            if( pAppContext->appSessions[ i ].peerConnectionSession.state >= PEER_CONNECTION_SESSION_STATE_START )
+            {
+                activeSessionCount++;
+            }
+        }
+
+        if( activeSessionCount > 0U )
+        {
+            UpdateKeyframeCache( pFrame );
+        }
+        else
+        {
+            /* Nobody to replay the cache to, give the memory back. */
+            ReleaseKeyframeCache();
+        }
+    }
+    #endif /* ENABLE_KEYFRAME_CACHE */
+
     if( ret == 0 )
     {
         peerConnectionFrame.version = PEER_CONNECTION_FRAME_CURRENT_VERSION;
@@ -121,6 +357,44 @@ static int32_t OnMediaSinkHook( void * pCustom,
                 break;
             }
 
+            #if ENABLE_KEYFRAME_CACHE
+            if( pFrame->trackKind == TRANSCEIVER_TRACK_KIND_VIDEO )
+            {
+                if( pAppContext->appSessions[ i ].peerConnectionSession.state != PEER_CONNECTION_SESSION_STATE_CONNECTION_READY )
+                {
+                    keyframeCache.sessionVideoStarted[ i ] = 0U;
+                }
+                else if( ( keyframeCache.sessionVideoStarted[ i ] == 0U ) && ( keyframeCache.frameCount > 0U ) )
+                {
+                    keyframeCache.sessionVideoStarted[ i ] = 1U;
+
+                    /* A newly ready viewer gets the cached group of pictures, which ends with the live frame,
+                     * and then continues with the live frames that follow. */
+                    for( j = 0U; j < keyframeCache.frameCount; j++ )
+                    {
+                        cachedFrame.version = PEER_CONNECTION_FRAME_CURRENT_VERSION;
+                        cachedFrame.presentationUs = keyframeCache.frames[ j ].timestampUs;
+                        cachedFrame.pData = keyframeCache.pBuffer + keyframeCache.frames[ j ].offset;
+                        cachedFrame.dataLength = keyframeCache.frames[ j ].length;
+
+                        peerConnectionResult = PeerConnection_WriteFrame( &pAppContext->appSessions[ i ].peerConnectionSession,
+                                                                          pTransceiver,
+                                                                          &cachedFrame );
+                        if( peerConnectionResult != PEER_CONNECTION_RESULT_OK )
+                        {
+                            LogWarn( ( "Fail to write cached frame, result: %d", peerConnectionResult ) );
+                            break;
+                        }
+                    }
+                    continue;
+                }
+                else
+                {
+                    keyframeCache.sessionVideoStarted[ i ] = 1U;
+                }
+            }
+            #endif /* ENABLE_KEYFRAME_CACHE */
+
             if( pAppContext->appSessions[ i ].peerConnectionSession.state == PEER_CONNECTION_SESSION_STATE_CONNECTION_READY )
             {
                 peerConnectionResult = PeerConnection_WriteFrame( &pAppContext->appSessions[ i ].peerConnectionSession,
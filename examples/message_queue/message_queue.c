@@ -56,6 +56,7 @@ MessageQueueResult_t MessageQueue_Create( MessageQueueHandler_t * pMessageQueueH
             strncpy( pMessageQueueHandler->pQueueName, pQueueName, MESSAGE_QUEUE_NAME_MAX_LENGTH );
             pMessageQueueHandler->messageMaxLength = messageMaxLength;
             pMessageQueueHandler->messageQueueMaxNum = messageQueueMaxNum;
+            pMessageQueueHandler->droppedMessageNum = 0U;
         }
     }
 
@@ -93,7 +94,11 @@ MessageQueueResult_t MessageQueue_Send( MessageQueueHandler_t * pMessageQueueHan
         retSend = xQueueSend( pMessageQueueHandler->messageQueue, pMessage, 0 );
         if( retSend != pdTRUE )
         {
-            LogError( ( "xQueueSend returns failed" ) );
+            /* Send never blocks, the message is dropped when the queue is full. */
+            pMessageQueueHandler->droppedMessageNum++;
+            LogError( ( "xQueueSend returns failed, %s dropped %lu messages in total",
+                        pMessageQueueHandler->pQueueName,
+                        pMessageQueueHandler->droppedMessageNum ) );
             ret = MESSAGE_QUEUE_RESULT_MQ_SEND_FAILED;
         }
     }
@@ -132,6 +137,117 @@ MessageQueueResult_t MessageQueue_Recv( MessageQueueHandler_t * pMessageQueueHan
     return ret;
 }
 
+MessageQueueResult_t MessageQueue_RecvBatch( MessageQueueHandler_t * pMessageQueueHandler,
+                                             void * pMessages,
+                                             size_t messagesLength,
+                                             size_t * pMessageNum,
+                                             TickType_t waitTicks )
+{
+    MessageQueueResult_t ret = MESSAGE_QUEUE_RESULT_OK;
+    BaseType_t retRecv;
+    size_t maxMessageNum = 0;
+    size_t messageNum = 0;
+    uint8_t * pCurrentMessage = ( uint8_t * ) pMessages;
+
+    if( ( pMessageQueueHandler == NULL ) || ( pMessages == NULL ) || ( pMessageNum == NULL ) )
+    {
+        LogError( ( "Invalid input, pMessageQueueHandler: %p, pMessages: %p, pMessageNum: %p",
+                    pMessageQueueHandler,
+                    pMessages,
+                    pMessageNum ) );
+        ret = MESSAGE_QUEUE_RESULT_BAD_PARAMETER;
+    }
+    else
+    {
+        maxMessageNum = messagesLength / pMessageQueueHandler->messageMaxLength;
+        if( maxMessageNum == 0 )
+        {
+            LogError( ( "Invalid input, messagesLength: %u is less than messageMaxLength: %u",
+                        messagesLength,
+                        pMessageQueueHandler->messageMaxLength ) );
+            ret = MESSAGE_QUEUE_RESULT_BAD_PARAMETER;
+        }
+    }
+
+    if( ret == MESSAGE_QUEUE_RESULT_OK )
+    {
+        retRecv = xQueueReceive( pMessageQueueHandler->messageQueue, pCurrentMessage, waitTicks );
+        if( retRecv == pdTRUE )
+        {
+            messageNum++;
+            pCurrentMessage += pMessageQueueHandler->messageMaxLength;
+        }
+        else if( waitTicks != portMAX_DELAY )
+        {
+            ret = MESSAGE_QUEUE_RESULT_MQ_IS_EMPTY;
+        }
+        else
+        {
+            LogError( ( "xQueueReceive returns failed" ) );
+            ret = MESSAGE_QUEUE_RESULT_MQ_RECV_FAILED;
+        }
+    }
+
+    if( ret == MESSAGE_QUEUE_RESULT_OK )
+    {
+        /* Drain the rest that's already pending without blocking again. */
+        while( ( messageNum < maxMessageNum ) &&
+               ( xQueueReceive( pMessageQueueHandler->messageQueue, pCurrentMessage, 0 ) == pdTRUE ) )
+        {
+            messageNum++;
+            pCurrentMessage += pMessageQueueHandler->messageMaxLength;
+        }
+    }
+
+    if( pMessageNum != NULL )
+    {
+        *pMessageNum = messageNum;
+    }
+
+    return ret;
+}
+
+MessageQueueResult_t MessageQueue_DropOldest( MessageQueueHandler_t * pMessageQueueHandler,
+                                              void * pMessage,
+                                              size_t * pMessageLength )
+{
+    MessageQueueResult_t ret = MESSAGE_QUEUE_RESULT_OK;
+
+    if( ( pMessageQueueHandler == NULL ) || ( pMessage == NULL ) || ( pMessageLength == NULL ) ||
+        ( *pMessageLength < pMessageQueueHandler->messageMaxLength ) )
+    {
+        ret = MESSAGE_QUEUE_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == MESSAGE_QUEUE_RESULT_OK )
+    {
+        /* Never block here, the consumer might have drained the queue in the meantime. */
+        if( xQueueReceive( pMessageQueueHandler->messageQueue, pMessage, 0 ) == pdTRUE )
+        {
+            pMessageQueueHandler->droppedMessageNum++;
+            *pMessageLength = pMessageQueueHandler->messageMaxLength;
+        }
+        else
+        {
+            ret = MESSAGE_QUEUE_RESULT_MQ_IS_EMPTY;
+        }
+    }
+
+    return ret;
+}
+
+uint32_t MessageQueue_GetDroppedNum( MessageQueueHandler_t * pMessageQueueHandler )
+{
+    uint32_t ret = 0U;
+
+    if( pMessageQueueHandler != NULL )
+    {
+        ret = pMessageQueueHandler->droppedMessageNum;
+    }
+
+    return ret;
+}
+
 MessageQueueResult_t MessageQueue_IsEmpty( MessageQueueHandler_t * pMessageQueueHandler )
 {
     MessageQueueResult_t ret = MESSAGE_QUEUE_RESULT_OK;
@@ -54,6 +54,10 @@ typedef struct MessageQueueHandler
     /* Message queue setting. */
     size_t messageMaxLength;
     size_t messageQueueMaxNum;
+
+    /* Number of messages dropped because the queue was full, including the ones
+     * evicted by MessageQueue_DropOldest(). Updated without locking, for statistics only. */
+    uint32_t droppedMessageNum;
 } MessageQueueHandler_t;
 
 MessageQueueResult_t MessageQueue_Create( MessageQueueHandler_t * pMessageQueueHandler,
@@ -68,6 +72,22 @@ MessageQueueResult_t MessageQueue_Send( MessageQueueHandler_t * pMessageQueueHan
 MessageQueueResult_t MessageQueue_Recv( MessageQueueHandler_t * pMessageQueueHandler,
                                         void * pMessage,
                                         size_t * pMessageLength );
+/* Block up to waitTicks for the first message, then drain whatever else is already queued
+ * without blocking, so a consumer wakes up once per burst instead of once per message.
+ * pMessages must hold messagesLength / messageMaxLength messages, the number received is
+ * returned in pMessageNum. Creating the queue with messageMaxLength = sizeof( void * )
+ * passes ownership of pointers instead of copying the messages. */
+MessageQueueResult_t MessageQueue_RecvBatch( MessageQueueHandler_t * pMessageQueueHandler,
+                                             void * pMessages,
+                                             size_t messagesLength,
+                                             size_t * pMessageNum,
+                                             TickType_t waitTicks );
+/* Remove the oldest message without blocking and count it as dropped. The message is returned
+ * for the caller to release its resources. */
+MessageQueueResult_t MessageQueue_DropOldest( MessageQueueHandler_t * pMessageQueueHandler,
+                                              void * pMessage,
+                                              size_t * pMessageLength );
+uint32_t MessageQueue_GetDroppedNum( MessageQueueHandler_t * pMessageQueueHandler );
 MessageQueueResult_t MessageQueue_IsEmpty( MessageQueueHandler_t * pMessageQueueHandler );
 MessageQueueResult_t MessageQueue_IsFull( MessageQueueHandler_t * pMessageQueueHandler );
 
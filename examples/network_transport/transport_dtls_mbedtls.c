@@ -403,6 +403,13 @@ static DtlsTransportStatus_t dtlsSetup( DtlsNetworkContext_t * pDtlsNetworkConte
         returnStatus = DTLS_TRANSPORT_INSUFFICIENT_MEMORY;
     }
 
+    if( returnStatus == DTLS_SUCCESS )
+    {
+        mbedtls_ssl_conf_handshake_timeout( &( pDtlsTransportParams->dtlsSslContext.config ),
+                                            DTLS_HANDSHAKE_TIMEOUT_MIN_MS,
+                                            DTLS_HANDSHAKE_TIMEOUT_MAX_MS );
+    }
+
     if( returnStatus == DTLS_SUCCESS )
     {
         mbedtlsError = setCredentials( &( pDtlsTransportParams->dtlsSslContext ),
@@ -1256,6 +1263,14 @@ DtlsTransportStatus_t DTLS_Init( DtlsNetworkContext_t * pNetworkContext,
                              DtlsUdpSendWrap,
                              DtlsUdpRecvWrap,
                              NULL );
+
+        /* mbedTLS already packs the messages of a flight into shared datagrams, bound them by the
+         * path MTU so that a large Certificate is fragmented at the DTLS layer instead of by IP. */
+        if( pNetworkCredentials->mtu != 0U )
+        {
+            mbedtls_ssl_set_mtu( &( pDtlsTransportParams->dtlsSslContext.context ),
+                                 pNetworkCredentials->mtu );
+        }
     }
 
     if( returnStatus != DTLS_SUCCESS )
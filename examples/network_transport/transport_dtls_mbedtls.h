@@ -201,6 +201,13 @@ typedef struct DtlsNetworkCredentials
     mbedtls_x509_crt * pClientCert;             /**< @brief Client certificate context. */
     mbedtls_pk_context * pPrivateKey;
 
+    /**
+     * @brief Largest datagram the transport can carry, excluding IP/UDP headers.
+     * Handshake records are fragmented to fit in it. 0 keeps the mbedTLS default,
+     * which only limits datagrams by the record buffer size.
+     */
+    uint16_t mtu;
+
     DtlsKeyingMaterial dtlsKeyingMaterial; /**< @brief derivated SRTP keys */
 } DtlsNetworkCredentials_t;
 
@@ -264,6 +271,16 @@ typedef enum DtlsTransportStatus
 #define GENERATED_CERTIFICATE_NAME "KVS-WebRTC-Client"
 #define KEYING_EXTRACTOR_LABEL "EXTRACTOR-dtls_srtp"
 
+/* Handshake retransmission timer, doubled on every retransmission from MIN up to MAX.
+ * The mbedTLS defaults (1s to 60s) only leave room for a handful of retries within the
+ * peer connection handshake timeout, so start lower and cap the backoff earlier. */
+#ifndef DTLS_HANDSHAKE_TIMEOUT_MIN_MS
+#define DTLS_HANDSHAKE_TIMEOUT_MIN_MS ( 400 )
+#endif
+#ifndef DTLS_HANDSHAKE_TIMEOUT_MAX_MS
+#define DTLS_HANDSHAKE_TIMEOUT_MAX_MS ( 6400 )
+#endif
+
 /////////////////////////////////////////////////////
 /// DTLS related status codes
 /////////////////////////////////////////////////////
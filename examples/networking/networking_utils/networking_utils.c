@@ -53,6 +53,64 @@
    2. Any value from 0 to 2^32-1 represents a fraction of a second */
 #define NETWORKING_NTP_TIMESCALE 4294967296ULL
 
+#define NETWORKING_UTILS_SHA256_BLOCK_LENGTH ( 64 )
+#define NETWORKING_UTILS_SHA256_DIGEST_LENGTH ( 32 )
+#define NETWORKING_UTILS_HMAC_INNER_PAD ( 0x36 )
+#define NETWORKING_UTILS_HMAC_OUTER_PAD ( 0x5C )
+
+/* SigV4 signing key is HMAC( HMAC( HMAC( HMAC( "AWS4" + secret, date ), region ), service ), "aws4_request" ). */
+#define NETWORKING_UTILS_SIGV4_KEY_PREFIX "AWS4"
+#define NETWORKING_UTILS_SIGV4_SCOPE_TERMINATOR "aws4_request"
+#define NETWORKING_UTILS_SIGV4_DATE_LENGTH ( 8 ) /* YYYYMMDD part of the ISO8601 date. */
+
+/* Each HMAC of the derivation chain takes an inner and an outer hash. */
+#define NETWORKING_UTILS_SIGNING_KEY_HASH_STEPS ( 8 )
+
+/* Every hash of the derivation chain is one key block followed by at most one digest sized input. */
+#define NETWORKING_UTILS_HASH_MEMO_MESSAGE_MAX_LENGTH ( NETWORKING_UTILS_SHA256_BLOCK_LENGTH + NETWORKING_UTILS_SHA256_DIGEST_LENGTH )
+
+typedef struct NetworkingUtilsHashContext
+{
+    mbedtls_sha256_context sha256Context;
+
+    /* Short messages are held back until hashFinal so that the hashes of the
+     * signing key derivation can be answered from the signing key cache. */
+    uint8_t pendingMessage[ NETWORKING_UTILS_HASH_MEMO_MESSAGE_MAX_LENGTH ];
+    size_t pendingMessageLength;
+    uint8_t isPending;
+} NetworkingUtilsHashContext_t;
+
+#if NETWORKING_UTILS_SIGNING_KEY_CACHE_SIZE > 0
+typedef struct NetworkingUtilsHashStep
+{
+    uint8_t message[ NETWORKING_UTILS_HASH_MEMO_MESSAGE_MAX_LENGTH ];
+    size_t messageLength;
+    uint8_t digest[ NETWORKING_UTILS_SHA256_DIGEST_LENGTH ];
+} NetworkingUtilsHashStep_t;
+
+/* The service name is fixed to NETWORKING_UTILS_KVS_SERVICE_NAME, so the
+ * cache is keyed by date, region and the fingerprint of the secret key. */
+typedef struct NetworkingUtilsSigningKeyCacheEntry
+{
+    uint8_t isValid;
+    uint32_t lastUsed;
+    char date[ NETWORKING_UTILS_SIGV4_DATE_LENGTH ];
+    char region[ NETWORKING_UTILS_SIGNING_KEY_CACHE_REGION_MAX_LENGTH ];
+    size_t regionLength;
+    uint8_t secretKeyFingerprint[ NETWORKING_UTILS_SHA256_DIGEST_LENGTH ];
+
+    /* The SigV4 library derives the signing key itself through the crypto
+     * interface, so the cache keeps every hash of the derivation chain. */
+    NetworkingUtilsHashStep_t hashSteps[ NETWORKING_UTILS_SIGNING_KEY_HASH_STEPS ];
+} NetworkingUtilsSigningKeyCacheEntry_t;
+
+static NetworkingUtilsSigningKeyCacheEntry_t signingKeyCache[ NETWORKING_UTILS_SIGNING_KEY_CACHE_SIZE ];
+static uint32_t signingKeyCacheUseCounter = 0;
+
+/* Cache entry matching the request being signed, NULL outside of SigV4_GenerateHTTPAuthorization. */
+static NetworkingUtilsSigningKeyCacheEntry_t * pActiveSigningKeyEntry = NULL;
+#endif /* NETWORKING_UTILS_SIGNING_KEY_CACHE_SIZE > 0 */
+
 static int32_t Sha256Init( void * hashContext );
 static int32_t Sha256Update( void * hashContext,
                              const uint8_t * pInput,
@@ -64,7 +122,7 @@ static int32_t Sha256Final( void * hashContext,
 /**
  *  @brief mbedTLS Hash Context passed to SigV4 cryptointerface for generating the hash digest.
  */
-static mbedtls_sha256_context xHashContext = { 0 };
+static NetworkingUtilsHashContext_t xHashContext = { 0 };
 
 /**
  * @brief CryptoInterface provided to SigV4 library for generating the hash digest.
@@ -91,10 +149,170 @@ static SigV4Parameters_t sigv4Params =
     .pHttpParameters = NULL
 };
 
+static void Sha256Digest( const uint8_t * pInput,
+                          size_t inputLength,
+                          uint8_t * pOutput )
+{
+    mbedtls_sha256_context sha256Context;
+
+    mbedtls_sha256_init( &sha256Context );
+    mbedtls_sha256_starts( &sha256Context, 0 );
+    mbedtls_sha256_update( &sha256Context, pInput, inputLength );
+    mbedtls_sha256_finish( &sha256Context, pOutput );
+    mbedtls_sha256_free( &sha256Context );
+}
+
+#if NETWORKING_UTILS_SIGNING_KEY_CACHE_SIZE > 0
+static void RecordHmacSteps( const uint8_t * pKey,
+                             size_t keyLength,
+                             const uint8_t * pData,
+                             size_t dataLength,
+                             NetworkingUtilsHashStep_t * pInnerStep,
+                             NetworkingUtilsHashStep_t * pOuterStep )
+{
+    size_t i;
+
+    /* Keys are never longer than one block here, see GetSigningKeyCacheEntry(). */
+    memset( pInnerStep->message, 0, NETWORKING_UTILS_SHA256_BLOCK_LENGTH );
+    memcpy( pInnerStep->message, pKey, keyLength );
+
+    for( i = 0; i < NETWORKING_UTILS_SHA256_BLOCK_LENGTH; i++ )
+    {
+        pOuterStep->message[ i ] = pInnerStep->message[ i ] ^ NETWORKING_UTILS_HMAC_OUTER_PAD;
+        pInnerStep->message[ i ] ^= NETWORKING_UTILS_HMAC_INNER_PAD;
+    }
+
+    memcpy( &pInnerStep->message[ NETWORKING_UTILS_SHA256_BLOCK_LENGTH ], pData, dataLength );
+    pInnerStep->messageLength = NETWORKING_UTILS_SHA256_BLOCK_LENGTH + dataLength;
+    Sha256Digest( pInnerStep->message, pInnerStep->messageLength, pInnerStep->digest );
+
+    memcpy( &pOuterStep->message[ NETWORKING_UTILS_SHA256_BLOCK_LENGTH ], pInnerStep->digest, NETWORKING_UTILS_SHA256_DIGEST_LENGTH );
+    pOuterStep->messageLength = NETWORKING_UTILS_SHA256_BLOCK_LENGTH + NETWORKING_UTILS_SHA256_DIGEST_LENGTH;
+    Sha256Digest( pOuterStep->message, pOuterStep->messageLength, pOuterStep->digest );
+}
+
+static void DeriveSigningKey( NetworkingUtilsSigningKeyCacheEntry_t * pEntry,
+                              const SigV4Credentials_t * pSigv4Credential )
+{
+    uint8_t secretKey[ NETWORKING_UTILS_SHA256_BLOCK_LENGTH ];
+    size_t prefixLength = strlen( NETWORKING_UTILS_SIGV4_KEY_PREFIX );
+    NetworkingUtilsHashStep_t * pSteps = pEntry->hashSteps;
+
+    memcpy( secretKey, NETWORKING_UTILS_SIGV4_KEY_PREFIX, prefixLength );
+    memcpy( &secretKey[ prefixLength ], pSigv4Credential->pSecretAccessKey, pSigv4Credential->secretAccessKeyLen );
+
+    /* The outer digest of every HMAC is the key of the next one. */
+    RecordHmacSteps( secretKey, prefixLength + pSigv4Credential->secretAccessKeyLen,
+                     ( const uint8_t * ) pEntry->date, NETWORKING_UTILS_SIGV4_DATE_LENGTH,
+                     &pSteps[ 0 ], &pSteps[ 1 ] );
+    RecordHmacSteps( pSteps[ 1 ].digest, NETWORKING_UTILS_SHA256_DIGEST_LENGTH,
+                     ( const uint8_t * ) pEntry->region, pEntry->regionLength,
+                     &pSteps[ 2 ], &pSteps[ 3 ] );
+    RecordHmacSteps( pSteps[ 3 ].digest, NETWORKING_UTILS_SHA256_DIGEST_LENGTH,
+                     ( const uint8_t * ) NETWORKING_UTILS_KVS_SERVICE_NAME, strlen( NETWORKING_UTILS_KVS_SERVICE_NAME ),
+                     &pSteps[ 4 ], &pSteps[ 5 ] );
+    RecordHmacSteps( pSteps[ 5 ].digest, NETWORKING_UTILS_SHA256_DIGEST_LENGTH,
+                     ( const uint8_t * ) NETWORKING_UTILS_SIGV4_SCOPE_TERMINATOR, strlen( NETWORKING_UTILS_SIGV4_SCOPE_TERMINATOR ),
+                     &pSteps[ 6 ], &pSteps[ 7 ] );
+
+    memset( secretKey, 0, sizeof( secretKey ) );
+}
+
+static NetworkingUtilsSigningKeyCacheEntry_t * GetSigningKeyCacheEntry( const SigV4Credentials_t * pSigv4Credential,
+                                                                        const char * pAwsRegion,
+                                                                        size_t awsRegionLength,
+                                                                        const char * pDate )
+{
+    NetworkingUtilsSigningKeyCacheEntry_t * pEntry = NULL;
+    uint8_t fingerprint[ NETWORKING_UTILS_SHA256_DIGEST_LENGTH ];
+    int i;
+
+    /* Keys longer than one block are hashed first by HMAC, and long regions
+     * don't fit the memo message. Leave such requests to the SigV4 library. */
+    if( ( pSigv4Credential != NULL ) &&
+        ( pSigv4Credential->pSecretAccessKey != NULL ) &&
+        ( strlen( NETWORKING_UTILS_SIGV4_KEY_PREFIX ) + pSigv4Credential->secretAccessKeyLen <= NETWORKING_UTILS_SHA256_BLOCK_LENGTH ) &&
+        ( awsRegionLength <= NETWORKING_UTILS_SIGNING_KEY_CACHE_REGION_MAX_LENGTH ) )
+    {
+        Sha256Digest( ( const uint8_t * ) pSigv4Credential->pSecretAccessKey, pSigv4Credential->secretAccessKeyLen, fingerprint );
+
+        for( i = 0; i < NETWORKING_UTILS_SIGNING_KEY_CACHE_SIZE; i++ )
+        {
+            if( ( signingKeyCache[ i ].isValid != 0U ) &&
+                ( signingKeyCache[ i ].regionLength == awsRegionLength ) &&
+                ( memcmp( signingKeyCache[ i ].date, pDate, NETWORKING_UTILS_SIGV4_DATE_LENGTH ) == 0 ) &&
+                ( memcmp( signingKeyCache[ i ].region, pAwsRegion, awsRegionLength ) == 0 ) &&
+                ( memcmp( signingKeyCache[ i ].secretKeyFingerprint, fingerprint, NETWORKING_UTILS_SHA256_DIGEST_LENGTH ) == 0 ) )
+            {
+                pEntry = &signingKeyCache[ i ];
+                break;
+            }
+        }
+
+        if( pEntry == NULL )
+        {
+            /* Miss, replace an unused or the least recently used entry. */
+            pEntry = &signingKeyCache[ 0 ];
+
+            for( i = 1; ( i < NETWORKING_UTILS_SIGNING_KEY_CACHE_SIZE ) && ( pEntry->isValid != 0U ); i++ )
+            {
+                if( ( signingKeyCache[ i ].isValid == 0U ) ||
+                    ( signingKeyCache[ i ].lastUsed < pEntry->lastUsed ) )
+                {
+                    pEntry = &signingKeyCache[ i ];
+                }
+            }
+
+            memcpy( pEntry->date, pDate, NETWORKING_UTILS_SIGV4_DATE_LENGTH );
+            memcpy( pEntry->region, pAwsRegion, awsRegionLength );
+            pEntry->regionLength = awsRegionLength;
+            memcpy( pEntry->secretKeyFingerprint, fingerprint, NETWORKING_UTILS_SHA256_DIGEST_LENGTH );
+            DeriveSigningKey( pEntry, pSigv4Credential );
+            pEntry->isValid = 1U;
+        }
+
+        pEntry->lastUsed = ++signingKeyCacheUseCounter;
+    }
+
+    return pEntry;
+}
+
+static const uint8_t * LookupHashStep( const uint8_t * pMessage,
+                                       size_t messageLength )
+{
+    const uint8_t * pDigest = NULL;
+    int i;
+
+    if( pActiveSigningKeyEntry != NULL )
+    {
+        for( i = 0; i < NETWORKING_UTILS_SIGNING_KEY_HASH_STEPS; i++ )
+        {
+            if( ( pActiveSigningKeyEntry->hashSteps[ i ].messageLength == messageLength ) &&
+                ( memcmp( pActiveSigningKeyEntry->hashSteps[ i ].message, pMessage, messageLength ) == 0 ) )
+            {
+                pDigest = pActiveSigningKeyEntry->hashSteps[ i ].digest;
+                break;
+            }
+        }
+    }
+
+    return pDigest;
+}
+#endif /* NETWORKING_UTILS_SIGNING_KEY_CACHE_SIZE > 0 */
+
 static int32_t Sha256Init( void * hashContext )
 {
-    mbedtls_sha256_init( ( mbedtls_sha256_context * ) hashContext );
-    mbedtls_sha256_starts( hashContext, 0 );
+    NetworkingUtilsHashContext_t * pHashContext = ( NetworkingUtilsHashContext_t * ) hashContext;
+
+    mbedtls_sha256_init( &pHashContext->sha256Context );
+    mbedtls_sha256_starts( &pHashContext->sha256Context, 0 );
+
+    pHashContext->pendingMessageLength = 0;
+    #if NETWORKING_UTILS_SIGNING_KEY_CACHE_SIZE > 0
+    pHashContext->isPending = ( pActiveSigningKeyEntry != NULL ) ? 1U : 0U;
+    #else
+    pHashContext->isPending = 0U;
+    #endif
 
     return 0;
 }
@@ -103,7 +321,25 @@ static int32_t Sha256Update( void * hashContext,
                              const uint8_t * pInput,
                              size_t inputLen )
 {
-    mbedtls_sha256_update( hashContext, pInput, inputLen );
+    NetworkingUtilsHashContext_t * pHashContext = ( NetworkingUtilsHashContext_t * ) hashContext;
+
+    if( ( pHashContext->isPending != 0U ) &&
+        ( pHashContext->pendingMessageLength + inputLen <= NETWORKING_UTILS_HASH_MEMO_MESSAGE_MAX_LENGTH ) )
+    {
+        memcpy( &pHashContext->pendingMessage[ pHashContext->pendingMessageLength ], pInput, inputLen );
+        pHashContext->pendingMessageLength += inputLen;
+    }
+    else
+    {
+        if( pHashContext->isPending != 0U )
+        {
+            /* Too long to be a step of the derivation chain, hash it normally. */
+            mbedtls_sha256_update( &pHashContext->sha256Context, pHashContext->pendingMessage, pHashContext->pendingMessageLength );
+            pHashContext->isPending = 0U;
+        }
+
+        mbedtls_sha256_update( &pHashContext->sha256Context, pInput, inputLen );
+    }
 
     return 0;
 }
@@ -112,15 +348,46 @@ static int32_t Sha256Final( void * hashContext,
                             uint8_t * pOutput,
                             size_t outputLen )
 {
+    NetworkingUtilsHashContext_t * pHashContext = ( NetworkingUtilsHashContext_t * ) hashContext;
+    const uint8_t * pDigest = NULL;
+
     configASSERT( outputLen >= 32 );
 
     ( void ) outputLen;
 
-    mbedtls_sha256_finish( hashContext, pOutput );
+    if( pHashContext->isPending != 0U )
+    {
+        #if NETWORKING_UTILS_SIGNING_KEY_CACHE_SIZE > 0
+        pDigest = LookupHashStep( pHashContext->pendingMessage, pHashContext->pendingMessageLength );
+        #endif
+
+        if( pDigest == NULL )
+        {
+            mbedtls_sha256_update( &pHashContext->sha256Context, pHashContext->pendingMessage, pHashContext->pendingMessageLength );
+        }
+
+        pHashContext->isPending = 0U;
+    }
+
+    if( pDigest != NULL )
+    {
+        memcpy( pOutput, pDigest, NETWORKING_UTILS_SHA256_DIGEST_LENGTH );
+    }
+    else
+    {
+        mbedtls_sha256_finish( &pHashContext->sha256Context, pOutput );
+    }
 
     return 0;
 }
 
+void NetworkingUtils_InvalidateSigningKeyCache( void )
+{
+    #if NETWORKING_UTILS_SIGNING_KEY_CACHE_SIZE > 0
+    memset( signingKeyCache, 0, sizeof( signingKeyCache ) );
+    #endif
+}
+
 NetworkingUtilsResult_t NetworkingUtils_GetUrlHost( char * pUrl,
                                                     size_t urlLength,
                                                     char ** ppStart,
@@ -280,10 +547,18 @@ NetworkingUtilsResult_t NetworkingUtils_GenrerateAuthorizationHeader( Networking
         sigv4Params.pCredentials = pSigv4Credential;
         sigv4Params.pDateIso8601 = pDate;
 
+        #if NETWORKING_UTILS_SIGNING_KEY_CACHE_SIZE > 0
+        pActiveSigningKeyEntry = GetSigningKeyCacheEntry( pSigv4Credential, pAwsRegion, awsRegionLength, pDate );
+        #endif
+
         /* Reset buffer length then generate authorization. */
         sigv4Status = SigV4_GenerateHTTPAuthorization( &sigv4Params, pOutput, pOutputLength,
                                                        ppOutSignature, pOutSignatureLength );
 
+        #if NETWORKING_UTILS_SIGNING_KEY_CACHE_SIZE > 0
+        pActiveSigningKeyEntry = NULL;
+        #endif
+
         if( sigv4Status != SigV4Success )
         {
             LogError( ( "Fail to generate HTTP authorization with return 0x%x", sigv4Status ) );
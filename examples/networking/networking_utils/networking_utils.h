@@ -32,6 +32,16 @@ extern "C" {
 #define NETWORKING_UTILS_TIME_BUFFER_LENGTH ( 17 ) /* length of ISO8601 format (e.g. 20111008T070709Z) with NULL terminator */
 #define NETWORKING_UTILS_KVS_SERVICE_NAME "kinesisvideo"
 
+/* Number of derived SigV4 signing keys kept across requests. The key only
+ * changes with the date, region and secret key, so re-deriving it for every
+ * request is wasted work. Set to 0 to derive the key on every request. */
+#ifndef NETWORKING_UTILS_SIGNING_KEY_CACHE_SIZE
+#define NETWORKING_UTILS_SIGNING_KEY_CACHE_SIZE ( 2 )
+#endif
+
+/* Regions longer than this are signed without the cache. */
+#define NETWORKING_UTILS_SIGNING_KEY_CACHE_REGION_MAX_LENGTH ( 32 )
+
 typedef enum NetworkingUtilsResult
 {
     NETWORKING_UTILS_RESULT_OK = 0,
@@ -86,6 +96,8 @@ NetworkingUtilsResult_t NetworkingUtils_GenrerateAuthorizationHeader( Networking
 void NetworkingUtils_GetHeaderStartLocFromHttpRequest( HTTPRequestHeaders_t * pxRequestHeaders,
                                                        char ** pcStartHeaderLoc,
                                                        size_t * pxHeadersDataLen );
+/* Drop all cached signing keys, call it when the credentials are refreshed. */
+void NetworkingUtils_InvalidateSigningKeyCache( void );
 NetworkingUtilsResult_t NetworkingUtils_GetIso8601CurrentTime( char * pDate,
                                                                size_t dateBufferLength );
 
@@ -25,6 +25,7 @@
 #include "rtp_api.h"
 #include "rtcp_api.h"
 #include "peer_connection_rolling_buffer.h"
+#include "peer_connection_dtls_pool.h"
 #if METRIC_PRINT_ENABLED
 #include "metric.h"
 #endif
@@ -48,8 +49,11 @@
 #define PEER_CONNECTION_AUDIO_TIMER_NAME "RtcpAudioSenderReportTimer"
 #define PEER_CONNECTION_VIDEO_TIMER_NAME "RtcpVideoSenderReportTimer"
 #define PEER_CONNECTION_CLOSE_SESSION_TIMER_NAME "CloseSnTimer"
+#define PEER_CONNECTION_RECEIVER_REPORT_TIMER_NAME "RtcpReceiverReportTimer"
 
 #define PEER_CONNECTION_MAX_QUEUE_MSG_NUM ( 30 )
+/* Maximum requests drained from the request queue per wake-up. */
+#define PEER_CONNECTION_QUEUE_BATCH_MSG_NUM ( 4 )
 #define PEER_CONNECTION_RTCP_REPORT_TIMER_INTERVAL_MS ( 5000 )
 
 #define PEER_CONNECTION_MAX_DTLS_DECRYPTED_DATA_LENGTH ( 2048 )
@@ -65,6 +69,8 @@ static PeerConnectionResult_t SendPeerConnectionEvent( PeerConnectionSession_t *
                                                        size_t contentLength );
 static PeerConnectionResult_t HandleRequest( PeerConnectionSession_t * pSession,
                                              MessageQueueHandler_t * pRequestQueue );
+static PeerConnectionResult_t HandleRequestMessage( PeerConnectionSession_t * pSession,
+                                                    PeerConnectionSessionRequestMessage_t * pRequestMessage );
 static PeerConnectionResult_t HandleAddRemoteCandidateRequest( PeerConnectionSession_t * pSession,
                                                                PeerConnectionSessionRequestMessage_t * pRequestMessage );
 static PeerConnectionResult_t HandleProcessIceCandidatesAndPairs( PeerConnectionSession_t * pSession,
@@ -75,6 +81,9 @@ static PeerConnectionResult_t HandleIceClosing( PeerConnectionSession_t * pSessi
                                                 PeerConnectionSessionRequestMessage_t * pRequestMessage );
 static PeerConnectionResult_t PeerConnection_OnRtcpSenderReportCallback( PeerConnectionSession_t * pSession,
                                                                          PeerConnectionSessionRequestMessage_t * pRequestMessage );
+#if PEER_CONNECTION_ENABLE_RECEIVER_REPORT
+static PeerConnectionResult_t PeerConnection_OnRtcpReceiverReportCallback( PeerConnectionSession_t * pSession );
+#endif /* PEER_CONNECTION_ENABLE_RECEIVER_REPORT */
 static int32_t InitDtlsSession( PeerConnectionSession_t * pSession, uint8_t isServer );
 static int32_t ExecuteDtlsHandshake( PeerConnectionSession_t * pSession );
 static int32_t OnDtlsHandshakeComplete( PeerConnectionSession_t * pSession );
@@ -149,8 +158,8 @@ static void SessionProcessEndlessLoop( PeerConnectionSession_t * pSession )
 static void EmptyMessageQueue( MessageQueueHandler_t * pMessageQueue )
 {
     MessageQueueResult_t result;
-    PeerConnectionSessionRequestMessage_t requestMsg;
-    size_t requestMsgLength;
+    PeerConnectionSessionRequestMessage_t requestMsgs[ PEER_CONNECTION_QUEUE_BATCH_MSG_NUM ];
+    size_t requestMsgNum;
 
     if( pMessageQueue == NULL )
     {
@@ -158,17 +167,15 @@ static void EmptyMessageQueue( MessageQueueHandler_t * pMessageQueue )
     }
     else
     {
+        /* Never block, the session task might be draining the same queue. */
         do
         {
-            result = MessageQueue_IsEmpty( pMessageQueue );
-            if( result == MESSAGE_QUEUE_RESULT_MQ_HAVE_MESSAGE )
-            {
-                requestMsgLength = sizeof( PeerConnectionSessionRequestMessage_t );
-                ( void ) MessageQueue_Recv( pMessageQueue,
-                                            &requestMsg,
-                                            &requestMsgLength );
-            }
-        } while( result == MESSAGE_QUEUE_RESULT_MQ_HAVE_MESSAGE );
+            result = MessageQueue_RecvBatch( pMessageQueue,
+                                             requestMsgs,
+                                             sizeof( requestMsgs ),
+                                             &requestMsgNum,
+                                             0 );
+        } while( result == MESSAGE_QUEUE_RESULT_OK );
     }
 }
 
@@ -189,18 +196,6 @@ static PeerConnectionResult_t SendPeerConnectionEvent( PeerConnectionSession_t *
         ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
     }
 
-    if( ret == PEER_CONNECTION_RESULT_OK )
-    {
-        retMessageQueue = MessageQueue_IsFull( &pSession->requestQueue );
-        if( retMessageQueue == MESSAGE_QUEUE_RESULT_MQ_IS_FULL )
-        {
-            LogWarn( ( "The message queue in peer connection session: %p is full, dropping request type: %d",
-                       pSession,
-                       requestType ) );
-            ret = PEER_CONNECTION_RESULT_FAIL_MQ_SEND;
-        }
-    }
-
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
         if( pRequestContent != NULL )
@@ -208,12 +203,16 @@ static PeerConnectionResult_t SendPeerConnectionEvent( PeerConnectionSession_t *
             memcpy( &requestMessage.peerConnectionSessionRequestContent, pRequestContent, contentLength );
         }
 
+        /* The send never blocks, a full queue drops the request and counts it in the queue. */
         retMessageQueue = MessageQueue_Send( &pSession->requestQueue,
                                              &requestMessage,
                                              sizeof( PeerConnectionSessionRequestMessage_t ) );
         if( retMessageQueue != MESSAGE_QUEUE_RESULT_OK )
         {
-            LogError( ( "Fail to send message queue, error: %d, requestType: %d", retMessageQueue, requestType ) );
+            LogWarn( ( "The message queue in peer connection session: %p is full, dropping request type: %d, total dropped: %lu",
+                       pSession,
+                       requestType,
+                       MessageQueue_GetDroppedNum( &pSession->requestQueue ) ) );
             ret = PEER_CONNECTION_RESULT_FAIL_MQ_SEND;
         }
     }
@@ -269,6 +268,18 @@ static void OnRtcpSenderReportVideoTimerExpire( void * pParameter )
     }
 }
 
+#if PEER_CONNECTION_ENABLE_RECEIVER_REPORT
+static void OnRtcpReceiverReportTimerExpire( void * pParameter )
+{
+    PeerConnectionSession_t * pSession = ( PeerConnectionSession_t * ) pParameter;
+
+    ( void ) SendPeerConnectionEvent( pSession,
+                                      PEER_CONNECTION_SESSION_REQUEST_TYPE_RTCP_RECEIVER_REPORT,
+                                      NULL,
+                                      0 );
+}
+#endif /* PEER_CONNECTION_ENABLE_RECEIVER_REPORT */
+
 static void OnCloseSessionTimerExpire( void * pParameter )
 {
     PeerConnectionSession_t * pSession = ( PeerConnectionSession_t * ) pParameter;
@@ -294,6 +305,19 @@ static void OnCloseSessionTimerExpire( void * pParameter )
     }
 }
 
+static void AssignDtlsContext( PeerConnectionSession_t * pSession )
+{
+    if( pSession->pDtlsContext == NULL )
+    {
+        /* Prefer a fresh pre-generated certificate, fall back to the shared one when the pool is empty. */
+        pSession->pDtlsContext = PeerConnectionDtlsPool_Acquire();
+        if( pSession->pDtlsContext == NULL )
+        {
+            pSession->pDtlsContext = &pSession->pCtx->dtlsContext;
+        }
+    }
+}
+
 static void OnClosePeerConnection( PeerConnectionSession_t * pSession )
 {
     if( pSession == NULL )
@@ -307,6 +331,14 @@ static void OnClosePeerConnection( PeerConnectionSession_t * pSession )
         pSession->mLinesTransceiverCount = 0;
         memset( pSession->pTransceivers, 0, sizeof( pSession->pTransceivers ) );
 
+        /* Hand the certificate back to the pool so a fresh one is generated for the next session. */
+        if( ( pSession->pDtlsContext != NULL ) &&
+            ( pSession->pDtlsContext != &pSession->pCtx->dtlsContext ) )
+        {
+            PeerConnectionDtlsPool_Release( pSession->pDtlsContext );
+        }
+        pSession->pDtlsContext = NULL;
+
         /* Reset the state to inited for user to re-use. */
         pSession->state = PEER_CONNECTION_SESSION_STATE_INITED;
     }
@@ -317,70 +349,104 @@ static PeerConnectionResult_t HandleRequest( PeerConnectionSession_t * pSession,
 {
     PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
     MessageQueueResult_t retMessageQueue;
-    PeerConnectionSessionRequestMessage_t requestMsg;
-    size_t requestMsgLength;
-
-    /* Handle event. */
-    requestMsgLength = sizeof( PeerConnectionSessionRequestMessage_t );
-    retMessageQueue = MessageQueue_Recv( pRequestQueue,
-                                         &requestMsg,
-                                         &requestMsgLength );
+    PeerConnectionSessionRequestMessage_t requestMsgs[ PEER_CONNECTION_QUEUE_BATCH_MSG_NUM ];
+    size_t requestMsgNum = 0;
+    size_t i;
+
+    /* Handle all pending events in one wake-up. */
+    retMessageQueue = MessageQueue_RecvBatch( pRequestQueue,
+                                              requestMsgs,
+                                              sizeof( requestMsgs ),
+                                              &requestMsgNum,
+                                              portMAX_DELAY );
     if( retMessageQueue == MESSAGE_QUEUE_RESULT_OK )
     {
-        /* Received message, process it. */
-        LogDebug( ( "Peer connection receives request with type: %d", requestMsg.requestType ) );
-        switch( requestMsg.requestType )
+        for( i = 0; i < requestMsgNum; i++ )
         {
-            case PEER_CONNECTION_SESSION_REQUEST_TYPE_ADD_REMOTE_CANDIDATE:
-                ( void ) HandleAddRemoteCandidateRequest( pSession,
-                                                          &requestMsg );
-                break;
-            case PEER_CONNECTION_SESSION_REQUEST_TYPE_PROCESS_ICE_CANDIDATES_AND_PAIRS:
-                ( void ) HandleProcessIceCandidatesAndPairs( pSession,
-                                                             &requestMsg );
-                break;
-            case PEER_CONNECTION_SESSION_REQUEST_TYPE_PERIOD_CONNECTION_CHECK:
-                ( void ) HandlePeriodConnectionCheck( pSession,
-                                                      &requestMsg );
-
-                /* If a P2P connection is found and DTLS handshaking is in progress,
-                 * invoke the handshake here to retry and prevent packet loss in transit. */
-                if( pSession->state == PEER_CONNECTION_SESSION_STATE_P2P_CONNECTION_FOUND )
-                {
-                    ( void ) ExecuteDtlsHandshake( pSession );
-                }
-                break;
-            case PEER_CONNECTION_SESSION_REQUEST_TYPE_ICE_CLOSING:
-                ( void ) HandleIceClosing( pSession,
-                                           &requestMsg );
-                break;
-            case PEER_CONNECTION_SESSION_REQUEST_TYPE_ICE_CLOSED:
-                OnClosePeerConnection( pSession );
-                ret = PEER_CONNECTION_RESULT_CLOSING;
-                break;
-            case PEER_CONNECTION_SESSION_REQUEST_TYPE_RTCP_SENDER_REPORT:
-                ( void ) PeerConnection_OnRtcpSenderReportCallback( pSession,
-                                                                    &requestMsg );
-                break;
-            case PEER_CONNECTION_SESSION_REQUEST_TYPE_PEER_CONNECTION_CLOSE:
-                PeerConnection_CloseSession( pSession );
-                break;
-            case PEER_CONNECTION_SESSION_REQUEST_TYPE_PEER_CONNECTION_CLOSE_NO_ICE_FLOW:
-                PeerConnection_CloseSession( pSession );
+            ret = HandleRequestMessage( pSession,
+                                        &requestMsgs[ i ] );
 
-                /* Reset the state to init for next peer since ICE negotiation has not started yet */
-                OnClosePeerConnection( pSession );
-                break;
-            default:
-                /* Unknown request, drop it. */
-                LogDebug( ( "Dropping unknown request %d", requestMsg.requestType ) );
+            /* The rest of requests belong to the closed session, drop them. */
+            if( ret == PEER_CONNECTION_RESULT_CLOSING )
+            {
                 break;
+            }
         }
     }
 
     return ret;
 }
 
+static PeerConnectionResult_t HandleRequestMessage( PeerConnectionSession_t * pSession,
+                                                    PeerConnectionSessionRequestMessage_t * pRequestMessage )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+
+    /* Received message, process it. */
+    LogDebug( ( "Peer connection receives request with type: %d", pRequestMessage->requestType ) );
+    switch( pRequestMessage->requestType )
+    {
+        case PEER_CONNECTION_SESSION_REQUEST_TYPE_ADD_REMOTE_CANDIDATE:
+            ( void ) HandleAddRemoteCandidateRequest( pSession,
+                                                      pRequestMessage );
+            break;
+        case PEER_CONNECTION_SESSION_REQUEST_TYPE_PROCESS_ICE_CANDIDATES_AND_PAIRS:
+            ( void ) HandleProcessIceCandidatesAndPairs( pSession,
+                                                         pRequestMessage );
+
+            /* DTLS may already run on an early selected pair while ICE keeps checking,
+             * drive its retransmission timer on the faster connectivity check ticks. */
+            if( pSession->state == PEER_CONNECTION_SESSION_STATE_P2P_CONNECTION_FOUND )
+            {
+                ( void ) ExecuteDtlsHandshake( pSession );
+            }
+            break;
+        case PEER_CONNECTION_SESSION_REQUEST_TYPE_PERIOD_CONNECTION_CHECK:
+            ( void ) HandlePeriodConnectionCheck( pSession,
+                                                  pRequestMessage );
+
+            /* If a P2P connection is found and DTLS handshaking is in progress,
+             * invoke the handshake here to retry and prevent packet loss in transit. */
+            if( pSession->state == PEER_CONNECTION_SESSION_STATE_P2P_CONNECTION_FOUND )
+            {
+                ( void ) ExecuteDtlsHandshake( pSession );
+            }
+            break;
+        case PEER_CONNECTION_SESSION_REQUEST_TYPE_ICE_CLOSING:
+            ( void ) HandleIceClosing( pSession,
+                                       pRequestMessage );
+            break;
+        case PEER_CONNECTION_SESSION_REQUEST_TYPE_ICE_CLOSED:
+            OnClosePeerConnection( pSession );
+            ret = PEER_CONNECTION_RESULT_CLOSING;
+            break;
+        case PEER_CONNECTION_SESSION_REQUEST_TYPE_RTCP_SENDER_REPORT:
+            ( void ) PeerConnection_OnRtcpSenderReportCallback( pSession,
+                                                                pRequestMessage );
+            break;
+        #if PEER_CONNECTION_ENABLE_RECEIVER_REPORT
+        case PEER_CONNECTION_SESSION_REQUEST_TYPE_RTCP_RECEIVER_REPORT:
+            ( void ) PeerConnection_OnRtcpReceiverReportCallback( pSession );
+            break;
+        #endif /* PEER_CONNECTION_ENABLE_RECEIVER_REPORT */
+        case PEER_CONNECTION_SESSION_REQUEST_TYPE_PEER_CONNECTION_CLOSE:
+            PeerConnection_CloseSession( pSession );
+            break;
+        case PEER_CONNECTION_SESSION_REQUEST_TYPE_PEER_CONNECTION_CLOSE_NO_ICE_FLOW:
+            PeerConnection_CloseSession( pSession );
+
+            /* Reset the state to init for next peer since ICE negotiation has not started yet */
+            OnClosePeerConnection( pSession );
+            break;
+        default:
+            /* Unknown request, drop it. */
+            LogDebug( ( "Dropping unknown request %d", pRequestMessage->requestType ) );
+            break;
+    }
+
+    return ret;
+}
+
 static PeerConnectionResult_t HandleAddRemoteCandidateRequest( PeerConnectionSession_t * pSession,
                                                                PeerConnectionSessionRequestMessage_t * pRequestMessage )
 {
@@ -403,7 +469,7 @@ static PeerConnectionResult_t HandleAddRemoteCandidateRequest( PeerConnectionSes
                                                                     &remoteCandidateInfo );
             if( iceControllerResult != ICE_CONTROLLER_RESULT_OK )
             {
-                /* Skip unsupported candidate types (e.g. IPv6 or TCP candidates) - this is expected behavior. */
+                /* Skip unsupported candidate types (e.g. TCP candidates, or IPv6 ones when IPv6 is disabled) - this is expected behavior. */
                 LogDebug( ( "Fail to add remote candidate, result: %d.", iceControllerResult ) );
                 ret = PEER_CONNECTION_RESULT_FAIL_ICE_CONTROLLER_ADD_REMOTE_CANDIDATE;
             }
@@ -797,24 +863,27 @@ static int32_t InitDtlsSession( PeerConnectionSession_t * pSession, uint8_t isSe
         /* Disable SNI server name indication*/
         // https://mbed-tls.readthedocs.io/en/latest/kb/how-to/use-sni/
         pDtlsSession->xNetworkCredentials.disableSni = pdTRUE;
+        pDtlsSession->xNetworkCredentials.mtu = PEER_CONNECTION_DTLS_MTU;
 
         pDtlsSession->isServer = isServer;
     }
 
     if( ret == 0 )
     {
-        if( NULL == pSession->pCtx->dtlsContext.localCert.raw.p )
+        AssignDtlsContext( pSession );
+
+        if( NULL == pSession->pDtlsContext->localCert.raw.p )
         {
-            LogError( ( "Fail to get answer cert: NULL == pSession->pCtx->dtlsContext.localCert.raw.p" ) );
+            LogError( ( "Fail to get answer cert: NULL == pSession->pDtlsContext->localCert.raw.p" ) );
             ret = -23;
         }
         else
         {
             /* Assign local cert to the DTLS session. */
-            pDtlsSession->xNetworkCredentials.pClientCert = &pSession->pCtx->dtlsContext.localCert;
+            pDtlsSession->xNetworkCredentials.pClientCert = &pSession->pDtlsContext->localCert;
 
             // /* Assign local key to the DTLS session. */
-            pDtlsSession->xNetworkCredentials.pPrivateKey = &pSession->pCtx->dtlsContext.localKey;
+            pDtlsSession->xNetworkCredentials.pPrivateKey = &pSession->pDtlsContext->localKey;
 
             /* Attempt to create a DTLS connection. */
             xNetworkStatus = DTLS_Init( &pDtlsSession->xNetworkContext,
@@ -929,6 +998,23 @@ static void PeerConnection_SetTimer( PeerConnectionSession_t * pSession )
             /* Do Nothing, Coverity Happy. */
         }
     }
+
+    #if PEER_CONNECTION_ENABLE_RECEIVER_REPORT
+    retTimer = TimerController_IsTimerSet( &pSession->rtcpReceiverReportTimer );
+    if( retTimer == TIMER_CONTROLLER_RESULT_NOT_SET )
+    {
+        /* Start with the longest interval, the callback sizes it to the received bitrate. */
+        LogDebug( ( "Trigger rtcp Receiver Report timer." ) );
+        pSession->lastReceiverReportTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+        retTimer = TimerController_SetTimer( &pSession->rtcpReceiverReportTimer,
+                                             PEER_CONNECTION_RTCP_RECEIVER_REPORT_MAX_INTERVAL_MS,
+                                             PEER_CONNECTION_RTCP_RECEIVER_REPORT_MAX_INTERVAL_MS );
+        if( retTimer != TIMER_CONTROLLER_RESULT_OK )
+        {
+            LogError( ( "Fail to start RTCP Receiver Report timer, result: %d", retTimer ) );
+        }
+    }
+    #endif /* PEER_CONNECTION_ENABLE_RECEIVER_REPORT */
 }
 
 static int32_t OnDtlsHandshakeComplete( PeerConnectionSession_t * pSession )
@@ -1301,6 +1387,28 @@ static PeerConnectionResult_t PeerConnection_ResetTimer( PeerConnectionSession_t
         }
     }
 
+    #if PEER_CONNECTION_ENABLE_RECEIVER_REPORT
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        timerControllerResult = TimerController_IsTimerSet( &pSession->rtcpReceiverReportTimer );
+
+        if( timerControllerResult == TIMER_CONTROLLER_RESULT_SET )
+        {
+            TimerController_Reset( &pSession->rtcpReceiverReportTimer );
+            LogDebug( ( "Reset RTCP receiver report timer." ) );
+        }
+        else if( timerControllerResult == TIMER_CONTROLLER_RESULT_NOT_SET )
+        {
+            /* Do Nothing */
+        }
+        else
+        {
+            LogError( ( "Fail to reset RTCP receiver report timer." ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_TIMER_RESET;
+        }
+    }
+    #endif /* PEER_CONNECTION_ENABLE_RECEIVER_REPORT */
+
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
         timerControllerResult = TimerController_IsTimerSet( &pSession->closeSessionTimer );
@@ -1477,6 +1585,12 @@ static PeerConnectionResult_t SetDefaultPayloadTypes( PeerConnectionSession_t *
         {
             pSession->rtpConfig.isAudioCodecPayloadSet = 1;
             pSession->rtpConfig.audioCodecRtxPayload = 0;
+            #if PEER_CONNECTION_ENABLE_AUDIO_RED
+            /* Offered next to the codec, the answer decides whether it is used. */
+            pSession->rtpConfig.audioCodecRedPayload = PEER_CONNECTION_AUDIO_RED_DEFAULT_PAYLOAD;
+            #else
+            pSession->rtpConfig.audioCodecRedPayload = 0;
+            #endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
             pSession->rtpConfig.audioRtxSequenceNumber = 0;
             pSession->rtpConfig.audioSequenceNumber = 0;
             ret = GetDefaultCodec( pTransceiver->codecBitMap,
@@ -1529,6 +1643,19 @@ PeerConnectionResult_t PeerConnection_Init( PeerConnectionSession_t * pSession,
             /* pCtx->dtlsContext.isInitialized would be set to 1 in InitializeDtlsContext(). */
             ret = InitializeDtlsContext( &peerConnectionContext.dtlsContext );
         }
+
+        if( ret == PEER_CONNECTION_RESULT_OK )
+        {
+            ret = PeerConnectionDtlsPool_Init();
+        }
+
+        /* All session and ICE timers are served by the timer controller, start it before creating them. */
+        if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+            ( TimerController_Init() != TIMER_CONTROLLER_RESULT_OK ) )
+        {
+            LogError( ( "Fail to initialize timer controller." ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_TIMER_INIT;
+        }
     }
 
     if( ret == PEER_CONNECTION_RESULT_OK )
@@ -1687,6 +1814,24 @@ PeerConnectionResult_t PeerConnection_Init( PeerConnectionSession_t * pSession,
         }
     }
 
+    #if PEER_CONNECTION_ENABLE_RECEIVER_REPORT
+    /* Initialize timer for Receiver Reports. */
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        retTimer = TimerController_Create( &pSession->rtcpReceiverReportTimer,
+                                           PEER_CONNECTION_RECEIVER_REPORT_TIMER_NAME,
+                                           PEER_CONNECTION_RTCP_RECEIVER_REPORT_MAX_INTERVAL_MS,
+                                           PEER_CONNECTION_RTCP_RECEIVER_REPORT_MAX_INTERVAL_MS,
+                                           OnRtcpReceiverReportTimerExpire,
+                                           pSession );
+        if( retTimer != TIMER_CONTROLLER_RESULT_OK )
+        {
+            LogError( ( "Receiver report RTCP TimerController_Create return fail, result: %d", retTimer ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_TIMER_INIT;
+        }
+    }
+    #endif /* PEER_CONNECTION_ENABLE_RECEIVER_REPORT */
+
     /* Initialize timer for close peer connection session. */
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
@@ -1912,7 +2057,13 @@ PeerConnectionResult_t PeerConnection_SetRemoteDescription( PeerConnectionSessio
     {
         pSession->rtpConfig.videoRtxSequenceNumber = 0U;
         pSession->rtpConfig.audioRtxSequenceNumber = 0U;
-        pSession->rtpConfig.twccId = ( uint16_t ) pTargetRemoteSdp->sdpDescription.quickAccess.twccExtId;
+        pSession->rtpConfig.twccId = ( uint16_t ) pTargetRemoteSdp->sdpDescription.quickAccess.rtpExtensionIds[ SDP_CONTROLLER_RTP_EXTENSION_TWCC ];
+        #if PEER_CONNECTION_ENABLE_ABS_SEND_TIME_EXTENSION
+        pSession->rtpConfig.absSendTimeId = ( uint16_t ) pTargetRemoteSdp->sdpDescription.quickAccess.rtpExtensionIds[ SDP_CONTROLLER_RTP_EXTENSION_ABS_SEND_TIME ];
+        #endif /* PEER_CONNECTION_ENABLE_ABS_SEND_TIME_EXTENSION */
+        #if PEER_CONNECTION_ENABLE_PLAYOUT_DELAY_EXTENSION
+        pSession->rtpConfig.playoutDelayId = ( uint16_t ) pTargetRemoteSdp->sdpDescription.quickAccess.rtpExtensionIds[ SDP_CONTROLLER_RTP_EXTENSION_PLAYOUT_DELAY ];
+        #endif /* PEER_CONNECTION_ENABLE_PLAYOUT_DELAY_EXTENSION */
         pSession->rtpConfig.remoteVideoSsrc = pTargetRemoteSdp->sdpDescription.quickAccess.videoSsrc;
         pSession->rtpConfig.remoteAudioSsrc = pTargetRemoteSdp->sdpDescription.quickAccess.audioSsrc;
     }
@@ -2154,7 +2305,6 @@ PeerConnectionResult_t PeerConnection_CloseSession( PeerConnectionSession_t * pS
 
         /* Clear enable remote data channel */
         pSession->ucEnableDataChannelRemote = 0;
-        pSession->uKvsDataChannelCount = 0;
 
         /* Close and deallocate all data channels along with terminating
          * SCTP session. */
@@ -2303,6 +2453,9 @@ PeerConnectionResult_t PeerConnection_CreateOffer( PeerConnectionSession_t * pSe
 
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
+        /* The local fingerprint in SDP must match the certificate used in DTLS handshake. */
+        AssignDtlsContext( pSession );
+
         ret = PeerConnectionSdp_PopulateSessionDescription( pSession,
                                                             NULL,
                                                             pOutputBufferSessionDescription,
@@ -2341,6 +2494,9 @@ PeerConnectionResult_t PeerConnection_CreateAnswer( PeerConnectionSession_t * pS
 
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
+        /* The local fingerprint in SDP must match the certificate used in DTLS handshake. */
+        AssignDtlsContext( pSession );
+
         ret = PeerConnectionSdp_PopulateSessionDescription( pSession,
                                                             &pSession->remoteSessionDescription,
                                                             pOutputBufferSessionDescription,
@@ -2457,7 +2613,7 @@ static PeerConnectionResult_t PeerConnection_OnRtcpSenderReportCallback( PeerCon
         rtcpSenderReport.senderInfo.packetCount = pTransceiver->rtcpStats.rtpPacketsTransmitted;
         rtcpSenderReport.senderInfo.octetCount = pTransceiver->rtcpStats.rtpBytesTransmitted;
 
-        /* Since the Master isn't processing the received RTP Packets. We don't have any reception reports.*/
+        /* Reception reports for the streams we receive go out in the receiver reports. */
         rtcpSenderReport.pReceptionReports = NULL;
         rtcpSenderReport.numReceptionReports = 0;
 
@@ -2495,6 +2651,153 @@ static PeerConnectionResult_t PeerConnection_OnRtcpSenderReportCallback( PeerCon
     return ret;
 }
 
+#if PEER_CONNECTION_ENABLE_RECEIVER_REPORT
+static uint32_t GetReceiverReportIntervalMs( PeerConnectionSession_t * pSession,
+                                             uint64_t currentTimeUs,
+                                             size_t reportLength )
+{
+    uint64_t receivedBytes;
+    uint64_t elapsedUs = currentTimeUs - pSession->lastReceiverReportTimeUs;
+    uint64_t receivedBps = 0U;
+    uint64_t intervalMs = PEER_CONNECTION_RTCP_RECEIVER_REPORT_MAX_INTERVAL_MS;
+    uint64_t reducedMinimumMs;
+
+    receivedBytes = ( pSession->videoSrtpReceiver.rxStats.bytesReceived - pSession->videoSrtpReceiver.rxStats.bytesReceivedPrior ) +
+                    ( pSession->audioSrtpReceiver.rxStats.bytesReceived - pSession->audioSrtpReceiver.rxStats.bytesReceivedPrior );
+    pSession->videoSrtpReceiver.rxStats.bytesReceivedPrior = pSession->videoSrtpReceiver.rxStats.bytesReceived;
+    pSession->audioSrtpReceiver.rxStats.bytesReceivedPrior = pSession->audioSrtpReceiver.rxStats.bytesReceived;
+    pSession->lastReceiverReportTimeUs = currentTimeUs;
+
+    if( elapsedUs > 0U )
+    {
+        receivedBps = ( receivedBytes * 8U * 1000000U ) / elapsedUs;
+    }
+
+    if( receivedBps > 0U )
+    {
+        /* https://datatracker.ietf.org/doc/html/rfc3550#section-6.2
+         * RTCP gets 5% of the session bandwidth, shared by the two participants. The sender is
+         * more than 25% of the members, so there is no separate receiver share. The report size
+         * includes the UDP and IP headers. */
+        intervalMs = ( 2U * ( reportLength + PEER_CONNECTION_IP_UDP_HEADER_LENGTH ) * 8U * 1000U * 20U ) / receivedBps;
+
+        /* https://datatracker.ietf.org/doc/html/rfc3550#section-6.2 reduced minimum, 360 divided by the session bandwidth in kbps. */
+        reducedMinimumMs = ( 360U * 1000U * 1000U ) / receivedBps;
+        if( intervalMs < reducedMinimumMs )
+        {
+            intervalMs = reducedMinimumMs;
+        }
+    }
+
+    if( intervalMs < PEER_CONNECTION_RTCP_RECEIVER_REPORT_MIN_INTERVAL_MS )
+    {
+        intervalMs = PEER_CONNECTION_RTCP_RECEIVER_REPORT_MIN_INTERVAL_MS;
+    }
+    else if( intervalMs > PEER_CONNECTION_RTCP_RECEIVER_REPORT_MAX_INTERVAL_MS )
+    {
+        intervalMs = PEER_CONNECTION_RTCP_RECEIVER_REPORT_MAX_INTERVAL_MS;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    /* https://datatracker.ietf.org/doc/html/rfc3550#section-6.3.1 randomizes it to [0.5, 1.5] times. */
+    return ( uint32_t )( ( intervalMs / 2U ) + ( rand() % ( intervalMs + 1U ) ) );
+}
+
+static PeerConnectionResult_t PeerConnection_OnRtcpReceiverReportCallback( PeerConnectionSession_t * pSession )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    IceControllerResult_t iceControllerResult;
+    TimerControllerResult_t retTimer;
+    RtcpReceptionReport_t receptionReports[ PEER_CONNECTION_TRANSCEIVER_MAX_COUNT ];
+    size_t numReceptionReports = 0;
+    uint8_t srtcpPacket[ PEER_CONNECTION_SRTCP_RECEIVER_REPORT_PACKET_MAX_LENGTH ];
+    size_t srtcpPacketLength = sizeof( srtcpPacket );
+    uint64_t currentTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+    uint32_t intervalMs;
+
+    if( pSession == NULL )
+    {
+        LogError( ( "Invalid input, pSession: %p", pSession ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        if( PeerConnectionSrtcp_GetReceptionReport( &pSession->videoSrtpReceiver,
+                                                    currentTimeUs,
+                                                    &receptionReports[ numReceptionReports ] ) == PEER_CONNECTION_RESULT_OK )
+        {
+            numReceptionReports++;
+        }
+
+        if( PeerConnectionSrtcp_GetReceptionReport( &pSession->audioSrtpReceiver,
+                                                    currentTimeUs,
+                                                    &receptionReports[ numReceptionReports ] ) == PEER_CONNECTION_RESULT_OK )
+        {
+            numReceptionReports++;
+        }
+    }
+
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) && ( numReceptionReports > 0 ) )
+    {
+        ret = PeerConnectionSrtcp_ConstructReceiverReportPacket( pSession,
+                                                                 pSession->pTransceivers[ 0 ]->ssrc,
+                                                                 receptionReports,
+                                                                 numReceptionReports,
+                                                                 &( srtcpPacket[ 0 ] ),
+                                                                 &( srtcpPacketLength ) );
+        if( ret != PEER_CONNECTION_RESULT_OK )
+        {
+            LogError( ( "Fail to serialize and encrypt RTCP Receiver Report." ) );
+        }
+
+        /* Send the constructed RTCP packets through network. */
+        if( ret == PEER_CONNECTION_RESULT_OK )
+        {
+            iceControllerResult = IceController_SendToRemotePeer( &( pSession->iceControllerContext ),
+                                                                  ( srtcpPacket ),
+                                                                  srtcpPacketLength );
+
+            if( iceControllerResult != ICE_CONTROLLER_RESULT_OK )
+            {
+                LogWarn( ( "Fail to send RTCP packet, ret: %d", iceControllerResult ) );
+                ret = PEER_CONNECTION_RESULT_FAIL_ICE_CONTROLLER_SEND_RTCP_PACKET;
+            }
+            else
+            {
+                LogDebug( ( "Send RTCP Receiver Report for SSRC: %lu, fraction lost: %u, cumulative lost: %lu, highest seq: %lu, jitter: %lu",
+                            receptionReports[ 0 ].sourceSsrc,
+                            receptionReports[ 0 ].fractionLost,
+                            receptionReports[ 0 ].cumulativePacketsLost,
+                            receptionReports[ 0 ].extendedHighestSeqNumReceived,
+                            receptionReports[ 0 ].interArrivalJitter ) );
+            }
+        }
+    }
+
+    /* Size the next interval to the bitrate received since this one, unless the session is closing. */
+    if( ( pSession != NULL ) &&
+        ( TimerController_IsTimerSet( &pSession->rtcpReceiverReportTimer ) == TIMER_CONTROLLER_RESULT_SET ) )
+    {
+        intervalMs = GetReceiverReportIntervalMs( pSession,
+                                                  currentTimeUs,
+                                                  srtcpPacketLength );
+        retTimer = TimerController_SetTimer( &pSession->rtcpReceiverReportTimer,
+                                             intervalMs,
+                                             intervalMs );
+        if( retTimer != TIMER_CONTROLLER_RESULT_OK )
+        {
+            LogError( ( "Fail to update RTCP Receiver Report timer, result: %d", retTimer ) );
+        }
+    }
+
+    return ret;
+}
+#endif /* PEER_CONNECTION_ENABLE_RECEIVER_REPORT */
+
 PeerConnectionResult_t PeerConnection_SetPictureLossIndicationCallback( PeerConnectionSession_t * pSession,
                                                                         OnPictureLossIndicationCallback_t onPictureLossIndicationCallback,
                                                                         void * pUserContext )
@@ -60,6 +60,23 @@ extern "C" {
  */
 #define PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES ( 2 )
 
+/* RFC 2198 redundant audio puts the block headers in front of the block data. Each redundant block
+ * has a 4-byte header, the primary block that ends the payload has a 1-byte header with F = 0:
+    0                   1                   2                   3
+    0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |F|   block PT  |  timestamp offset         |   block length    |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ */
+// https://datatracker.ietf.org/doc/html/rfc2198#section-3
+#define PEER_CONNECTION_SRTP_RED_HEADER_LENGTH ( 4 )
+#define PEER_CONNECTION_SRTP_RED_PRIMARY_HEADER_LENGTH ( 1 )
+#define PEER_CONNECTION_SRTP_RED_FOLLOW_BIT ( 0x80 )
+#define PEER_CONNECTION_SRTP_RED_PAYLOAD_TYPE_MASK ( 0x7F )
+#define PEER_CONNECTION_SRTP_RED_MAX_TIMESTAMP_OFFSET ( 0x3FFF )
+/* The most blocks taken from one received RED packet, the primary included. Older blocks are skipped. */
+#define PEER_CONNECTION_SRTP_RED_MAX_BLOCKS ( 4 )
+
 #define PEER_CONNECTION_SRTP_H264_MAX_NALUS_IN_A_FRAME        ( 64 )
 #define PEER_CONNECTION_SRTP_H265_MAX_NALUS_IN_A_FRAME        ( 64 )
 #define PEER_CONNECTION_SRTP_RTP_PAYLOAD_MAX_LENGTH      ( 1200 )
@@ -72,21 +89,39 @@ extern "C" {
 #define PEER_CONNECTION_SRTP_CONVERT_TIME_US_TO_RTP_TIMESTAMP( clockRate, presentationUs ) ( uint32_t )( ( ( ( presentationUs ) * ( clockRate ) ) / PEER_CONNECTION_SRTP_US_IN_A_SECOND ) & 0xFFFFFFFF )
 #define PEER_CONNECTION_SRTP_CONVERT_RTP_TIMESTAMP_TO_TIME_US( clockRate, rtpTimestamp ) ( ( uint64_t )( rtpTimestamp ) * PEER_CONNECTION_SRTP_US_IN_A_SECOND / ( clockRate ) )
 
-#define PEER_CONNECTION_SRTP_JITTER_BUFFER_TOLERENCE_TIME_SECOND ( 2 )
-
-/*
- *
-     0                   1                   2                   3
-      0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+/* RTP header extensions use the one-byte header format, each element is a 4-bit ID,
+ * a 4-bit (length - 1) and the data, the elements are zero padded to 32-bit words.
+    0                   1                   2                   3
+    0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |       0xBE    |    0xDE       |           length=N            |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |  ID   | L=1   |transport-wide sequence number |  ID   | L=2   |
  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
- |       0xBE    |    0xDE       |           length=1            |
+ |                abs-send-time                  |  ID   | L=2   |
  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
- |  ID   | L=1   |transport-wide sequence number | zero padding  |
+ |       MIN delay       |       MAX delay       | zero padding  |
  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  */
+// https://datatracker.ietf.org/doc/html/rfc8285#section-4.2
+#define PEER_CONNECTION_SRTP_RTP_EXTENSION_ONE_BYTE_PROFILE ( 0xBEDE )
+#define PEER_CONNECTION_SRTP_RTP_EXTENSION_ONE_BYTE_MAX_ID ( 14 )
+#define PEER_CONNECTION_SRTP_RTP_EXTENSION_ONE_BYTE_HEADER( extId, dataLength ) ( uint8_t ) ( ( ( ( extId ) & 0xFu ) << 4u ) | ( ( ( dataLength ) - 1u ) & 0xFu ) )
+
 // https://tools.ietf.org/html/draft-holmer-rmcat-transport-wide-cc-extensions-01
-#define PEER_CONNECTION_SRTP_TWCC_EXT_PROFILE ( 0xBEDE )
-#define PEER_CONNECTION_SRTP_GET_TWCC_PAYLOAD( extId, sequenceNum ) ( ( ( ( extId ) & 0xfu ) << 28u ) | ( 1u << 24u ) | ( ( uint32_t ) ( sequenceNum ) << 8u ) )
+#define PEER_CONNECTION_SRTP_TWCC_EXT_DATA_LENGTH ( 2 )
+
+// http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time
+#define PEER_CONNECTION_SRTP_ABS_SEND_TIME_EXT_DATA_LENGTH ( 3 )
+/* 24-bit 6.18 fixed point seconds. The time wraps every 64 seconds, reduce it first so that
+ * the shift can't overflow an epoch based timestamp. */
+#define PEER_CONNECTION_SRTP_ABS_SEND_TIME_WRAP_US ( 64ull * PEER_CONNECTION_SRTP_US_IN_A_SECOND )
+#define PEER_CONNECTION_SRTP_GET_ABS_SEND_TIME( timeUs ) ( uint32_t ) ( ( ( ( ( uint64_t ) ( timeUs ) % PEER_CONNECTION_SRTP_ABS_SEND_TIME_WRAP_US ) << 18u ) / PEER_CONNECTION_SRTP_US_IN_A_SECOND ) & 0xFFFFFFu )
+
+// http://www.webrtc.org/experiments/rtp-hdrext/playout-delay
+#define PEER_CONNECTION_SRTP_PLAYOUT_DELAY_EXT_DATA_LENGTH ( 3 )
+#define PEER_CONNECTION_SRTP_PLAYOUT_DELAY_GRANULARITY_MS ( 10 )
+
 #define PEER_CONNECTION_SRTCP_NACK_MAX_SEQ_NUM ( 128 )
 
 #ifdef __cplusplus
@@ -101,8 +101,9 @@ PeerConnectionResult_t PeerConnectionG711Helper_FillFrameG711( PeerConnectionJit
             index = PEER_CONNECTION_JITTER_BUFFER_WRAP( i,
                                                         PEER_CONNECTION_JITTER_BUFFER_MAX_ENTRY_NUM );
             pPacket = &pJitterBuffer->rtpPackets[ index ];
-            g711Packet.pPacketData = pPacket->pPacketBuffer;
-            g711Packet.packetDataLength = pPacket->packetBufferLength;
+            PeerConnectionSrtp_GetPrimaryPayload( pPacket,
+                                                  &g711Packet.pPacketData,
+                                                  &g711Packet.packetDataLength );
             rtpTimestamp = pPacket->rtpTimestamp;
             LogDebug( ( "Adding packet seq: %u, length: %u, timestamp: %lu", i, g711Packet.packetDataLength, rtpTimestamp ) );
 
@@ -148,7 +149,7 @@ PeerConnectionResult_t PeerConnectionG711Helper_WriteG711Frame( PeerConnectionSe
     G711PacketizerContext_t g711PacketizerContext;
     G711Result_t resultG711;
     G711Packet_t packetG711;
-    uint8_t rtpBuffer[ PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ];
+    uint8_t rtpBuffer[ PEER_CONNECTION_PACKET_BUFFER_SIZE( PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ) ];
     PeerConnectionRollingBufferPacket_t * pRollingBufferPacket = NULL;
     uint8_t * pSrtpPacket = NULL;
     size_t srtpPacketLength = 0;
@@ -159,14 +160,15 @@ PeerConnectionResult_t PeerConnectionG711Helper_WriteG711Frame( PeerConnectionSe
     IceControllerResult_t resultIceController;
     uint16_t * pRtpSeq = NULL;
     uint32_t payloadType;
+    uint32_t rtpTimestamp = 0;
     uint32_t * pSsrc = NULL;
     uint32_t packetSent = 0;
     uint32_t bytesSent = 0;
     uint32_t randomRtpTimeoffset = 0;    // TODO : Spec required random rtp time offset ( current implementation of KVS SDK )
-    #if ENABLE_TWCC_SUPPORT
-    /* Add TWCC packet tracking */
-    TwccPacketInfo_t packetInfo;
-    #endif /* ENABLE_TWCC_SUPPORT */
+    #if PEER_CONNECTION_ENABLE_AUDIO_RED
+    uint8_t * pRedPayload = NULL;
+    size_t redHeadroom = 0;
+    #endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
 
     if( ( pSession == NULL ) ||
         ( pTransceiver == NULL ) ||
@@ -205,6 +207,8 @@ PeerConnectionResult_t PeerConnectionG711Helper_WriteG711Frame( PeerConnectionSe
         pSrtpSender = &pSession->audioSrtpSender;
         pRtpSeq = &pSession->rtpConfig.audioSequenceNumber;
         payloadType = pSession->rtpConfig.audioCodecPayload;
+        rtpTimestamp = PEER_CONNECTION_SRTP_CONVERT_TIME_US_TO_RTP_TIMESTAMP( PEER_CONNECTION_SRTP_PCM_CLOCKRATE,
+                                                                              pFrame->presentationUs );
         if( ( pSession->rtpConfig.audioCodecRtxPayload != 0 ) &&
             ( pSession->rtpConfig.audioCodecRtxPayload != pSession->rtpConfig.audioCodecPayload ) )
         {
@@ -246,8 +250,8 @@ PeerConnectionResult_t PeerConnectionG711Helper_WriteG711Frame( PeerConnectionSe
             packetG711.pPacketData = pRollingBufferPacket->pPacketBuffer + PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES;
             packetG711.packetDataLength = pRollingBufferPacket->packetBufferLength - PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES;
 
-            /* Using local buffer for SRTP packet, use the entire packet length. */
-            pSrtpPacket = rtpBuffer;
+            /* Using local buffer for SRTP packet, use the entire packet length after the headroom. */
+            pSrtpPacket = rtpBuffer + PEER_CONNECTION_PACKET_HEADROOM_LENGTH;
             srtpPacketLength = PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH;
         }
         else
@@ -260,6 +264,15 @@ PeerConnectionResult_t PeerConnectionG711Helper_WriteG711Frame( PeerConnectionSe
             srtpPacketLength = pRollingBufferPacket->packetBufferLength;
         }
 
+        #if PEER_CONNECTION_ENABLE_AUDIO_RED
+        /* Leave room in front of the payload for the RED headers and the previous payload. */
+        redHeadroom = PeerConnectionSrtp_GetRedHeadroom( pSession,
+                                                         rtpTimestamp );
+        pRedPayload = packetG711.pPacketData;
+        packetG711.pPacketData += redHeadroom;
+        packetG711.packetDataLength -= redHeadroom;
+        #endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
+
         resultG711 = G711Packetizer_GetPacket( &g711PacketizerContext,
                                                &packetG711 );
         if( resultG711 == G711_RESULT_NO_MORE_PACKETS )
@@ -284,30 +297,26 @@ PeerConnectionResult_t PeerConnectionG711Helper_WriteG711Frame( PeerConnectionSe
 
             pRollingBufferPacket->rtpPacket.header.csrcCount = 0;
             pRollingBufferPacket->rtpPacket.header.pCsrc = NULL;
-            pRollingBufferPacket->rtpPacket.header.timestamp = PEER_CONNECTION_SRTP_CONVERT_TIME_US_TO_RTP_TIMESTAMP( PEER_CONNECTION_SRTP_PCM_CLOCKRATE,
-                                                                                                                      pFrame->presentationUs );
+            pRollingBufferPacket->rtpPacket.header.timestamp = rtpTimestamp;
 
-            if( pSession->rtpConfig.twccId > 0 )
+            #if PEER_CONNECTION_ENABLE_AUDIO_RED
+            if( pSession->rtpConfig.audioCodecRedPayload != 0U )
             {
-                pRollingBufferPacket->rtpPacket.header.flags |= RTP_HEADER_FLAG_EXTENSION;
-                pRollingBufferPacket->rtpPacket.header.extension.extensionProfile = PEER_CONNECTION_SRTP_TWCC_EXT_PROFILE;
-                pRollingBufferPacket->rtpPacket.header.extension.extensionPayloadLength = 1;
-                pRollingBufferPacket->twccExtensionPayload = PEER_CONNECTION_SRTP_GET_TWCC_PAYLOAD( pSession->rtpConfig.twccId,
-                                                                                                    pSession->rtpConfig.twccSequence );
-                pRollingBufferPacket->rtpPacket.header.extension.pExtensionPayload = &pRollingBufferPacket->twccExtensionPayload;
-
-                #if ENABLE_TWCC_SUPPORT
-                memset( &packetInfo, 0, sizeof( TwccPacketInfo_t ) );
-                packetInfo.packetSize = packetG711.packetDataLength;
-                packetInfo.localSentTime = NetworkingUtils_GetCurrentTimeUs( NULL );
-                packetInfo.packetSeqNum = pSession->rtpConfig.twccSequence;
-
-                RtcpTwccManager_AddPacketInfo( &pSession->pCtx->rtcpTwccManager,
-                                               &packetInfo );
-                #endif /* ENABLE_TWCC_SUPPORT */
-
-                pSession->rtpConfig.twccSequence++;
+                /* Send the payload as the primary block of a RED packet, after the previous payload. */
+                packetG711.packetDataLength = PeerConnectionSrtp_WriteRedPayload( pSession,
+                                                                                  rtpTimestamp,
+                                                                                  pRedPayload,
+                                                                                  redHeadroom,
+                                                                                  packetG711.packetDataLength );
+                packetG711.pPacketData = pRedPayload;
+                pRollingBufferPacket->rtpPacket.header.payloadType = pSession->rtpConfig.audioCodecRedPayload;
             }
+            #endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
+
+            PeerConnectionSrtp_WriteRtpHeaderExtensions( pSession,
+                                                         TRANSCEIVER_TRACK_KIND_AUDIO,
+                                                         pRollingBufferPacket,
+                                                         packetG711.packetDataLength );
 
             pRollingBufferPacket->rtpPacket.payloadLength = packetG711.packetDataLength;
             pRollingBufferPacket->rtpPacket.pPayload = packetG711.pPacketData;
@@ -352,9 +361,12 @@ PeerConnectionResult_t PeerConnectionG711Helper_WriteG711Frame( PeerConnectionSe
         /* Write the constructed RTP packets through network. */
         if( ret == PEER_CONNECTION_RESULT_OK )
         {
-            resultIceController = IceController_SendToRemotePeer( &pSession->iceControllerContext,
-                                                                  pSrtpPacket,
-                                                                  srtpPacketLength );
+            /* Both the local buffer and the rolling buffer packet reserve headroom/tailroom, frame it in place. */
+            resultIceController = IceController_SendToRemotePeerInPlace( &pSession->iceControllerContext,
+                                                                         pSrtpPacket,
+                                                                         srtpPacketLength,
+                                                                         srtpPacketLength + PEER_CONNECTION_PACKET_TAILROOM_LENGTH,
+                                                                         ICE_CONTROLLER_SEND_PRIORITY_AUDIO );
             if( resultIceController != ICE_CONTROLLER_RESULT_OK )
             {
                 LogWarn( ( "Fail to send RTP packet, ret: %d", resultIceController ) );
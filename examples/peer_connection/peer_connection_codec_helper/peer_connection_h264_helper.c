@@ -148,7 +148,7 @@ PeerConnectionResult_t PeerConnectionH264Helper_WriteH264Frame( PeerConnectionSe
     H264PacketizerContext_t h264PacketizerContext;
     H264Result_t resultH264;
     H264Packet_t packetH264;
-    uint8_t rtpBuffer[ PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ];
+    uint8_t rtpBuffer[ PEER_CONNECTION_PACKET_BUFFER_SIZE( PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ) ];
     PeerConnectionRollingBufferPacket_t * pRollingBufferPacket = NULL;
     uint8_t * pSrtpPacket = NULL;
     size_t srtpPacketLength = 0;
@@ -164,10 +164,6 @@ PeerConnectionResult_t PeerConnectionH264Helper_WriteH264Frame( PeerConnectionSe
     uint32_t packetSent = 0;
     uint32_t bytesSent = 0;
     uint32_t randomRtpTimeoffset = 0;    // TODO : Spec required random rtp time offset ( current implementation of KVS SDK )
-    #if ENABLE_TWCC_SUPPORT
-    /* Add TWCC packet tracking */
-    TwccPacketInfo_t packetInfo;
-    #endif /* ENABLE_TWCC_SUPPORT */
 
     if( ( pSession == NULL ) ||
         ( pTransceiver == NULL ) ||
@@ -259,8 +255,8 @@ PeerConnectionResult_t PeerConnectionH264Helper_WriteH264Frame( PeerConnectionSe
             packetH264.pPacketData = pRollingBufferPacket->pPacketBuffer + PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES;
             packetH264.packetDataLength = pRollingBufferPacket->packetBufferLength - PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES;
 
-            /* Using local buffer for SRTP packet, use the entire packet length. */
-            pSrtpPacket = rtpBuffer;
+            /* Using local buffer for SRTP packet, use the entire packet length after the headroom. */
+            pSrtpPacket = rtpBuffer + PEER_CONNECTION_PACKET_HEADROOM_LENGTH;
             srtpPacketLength = PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH;
         }
         else
@@ -302,27 +298,10 @@ PeerConnectionResult_t PeerConnectionH264Helper_WriteH264Frame( PeerConnectionSe
             pRollingBufferPacket->rtpPacket.header.timestamp = PEER_CONNECTION_SRTP_CONVERT_TIME_US_TO_RTP_TIMESTAMP( PEER_CONNECTION_SRTP_VIDEO_CLOCKRATE,
                                                                                                                       pFrame->presentationUs );
 
-            if( pSession->rtpConfig.twccId > 0 )
-            {
-                pRollingBufferPacket->rtpPacket.header.flags |= RTP_HEADER_FLAG_EXTENSION;
-                pRollingBufferPacket->rtpPacket.header.extension.extensionProfile = PEER_CONNECTION_SRTP_TWCC_EXT_PROFILE;
-                pRollingBufferPacket->rtpPacket.header.extension.extensionPayloadLength = 1;
-                pRollingBufferPacket->twccExtensionPayload = PEER_CONNECTION_SRTP_GET_TWCC_PAYLOAD( pSession->rtpConfig.twccId,
-                                                                                                    pSession->rtpConfig.twccSequence );
-                pRollingBufferPacket->rtpPacket.header.extension.pExtensionPayload = &pRollingBufferPacket->twccExtensionPayload;
-
-                #if ENABLE_TWCC_SUPPORT
-                memset( &packetInfo, 0, sizeof( TwccPacketInfo_t ) );
-                packetInfo.packetSize = packetH264.packetDataLength;
-                packetInfo.localSentTime = NetworkingUtils_GetCurrentTimeUs( NULL );
-                packetInfo.packetSeqNum = pSession->rtpConfig.twccSequence;
-
-                RtcpTwccManager_AddPacketInfo( &pSession->pCtx->rtcpTwccManager,
-                                               &packetInfo );
-                #endif /* ENABLE_TWCC_SUPPORT */
-
-                pSession->rtpConfig.twccSequence++;
-            }
+            PeerConnectionSrtp_WriteRtpHeaderExtensions( pSession,
+                                                         TRANSCEIVER_TRACK_KIND_VIDEO,
+                                                         pRollingBufferPacket,
+                                                         packetH264.packetDataLength );
 
             pRollingBufferPacket->rtpPacket.payloadLength = packetH264.packetDataLength;
             pRollingBufferPacket->rtpPacket.pPayload = packetH264.pPacketData;
@@ -367,9 +346,12 @@ PeerConnectionResult_t PeerConnectionH264Helper_WriteH264Frame( PeerConnectionSe
         /* Write the constructed RTP packets through network. */
         if( ret == PEER_CONNECTION_RESULT_OK )
         {
-            resultIceController = IceController_SendToRemotePeer( &pSession->iceControllerContext,
-                                                                  pSrtpPacket,
-                                                                  srtpPacketLength );
+            /* Both the local buffer and the rolling buffer packet reserve headroom/tailroom, frame it in place. */
+            resultIceController = IceController_SendToRemotePeerInPlace( &pSession->iceControllerContext,
+                                                                         pSrtpPacket,
+                                                                         srtpPacketLength,
+                                                                         srtpPacketLength + PEER_CONNECTION_PACKET_TAILROOM_LENGTH,
+                                                                         ICE_CONTROLLER_SEND_PRIORITY_VIDEO );
             if( resultIceController != ICE_CONTROLLER_RESULT_OK )
             {
                 LogWarn( ( "Fail to send RTP packet, ret: %d", resultIceController ) );
@@ -147,7 +147,7 @@ PeerConnectionResult_t PeerConnectionH265Helper_WriteH265Frame( PeerConnectionSe
     H265PacketizerContext_t h265PacketizerContext;
     H265Result_t resulth265;
     H265Packet_t packeth265;
-    uint8_t rtpBuffer[ PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ];
+    uint8_t rtpBuffer[ PEER_CONNECTION_PACKET_BUFFER_SIZE( PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ) ];
     PeerConnectionRollingBufferPacket_t * pRollingBufferPacket = NULL;
     uint8_t * pSrtpPacket = NULL;
     size_t srtpPacketLength = 0;
@@ -163,10 +163,6 @@ PeerConnectionResult_t PeerConnectionH265Helper_WriteH265Frame( PeerConnectionSe
     uint32_t packetSent = 0;
     uint32_t bytesSent = 0;
     uint32_t randomRtpTimeoffset = 0;    // TODO : Spec required random rtp time offset ( current implementation of KVS SDK )
-    #if ENABLE_TWCC_SUPPORT
-    /* Add TWCC packet tracking */
-    TwccPacketInfo_t packetInfo;
-    #endif /* ENABLE_TWCC_SUPPORT */
 
     if( ( pSession == NULL ) ||
         ( pTransceiver == NULL ) ||
@@ -257,8 +253,8 @@ PeerConnectionResult_t PeerConnectionH265Helper_WriteH265Frame( PeerConnectionSe
             packeth265.pPacketData = pRollingBufferPacket->pPacketBuffer + PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES;
             packeth265.packetDataLength = pRollingBufferPacket->packetBufferLength - PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES;
 
-            /* Using local buffer for SRTP packet, use the entire packet length. */
-            pSrtpPacket = rtpBuffer;
+            /* Using local buffer for SRTP packet, use the entire packet length after the headroom. */
+            pSrtpPacket = rtpBuffer + PEER_CONNECTION_PACKET_HEADROOM_LENGTH;
             srtpPacketLength = PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH;
         }
         else
@@ -299,29 +295,10 @@ PeerConnectionResult_t PeerConnectionH265Helper_WriteH265Frame( PeerConnectionSe
             pRollingBufferPacket->rtpPacket.header.timestamp = PEER_CONNECTION_SRTP_CONVERT_TIME_US_TO_RTP_TIMESTAMP( PEER_CONNECTION_SRTP_VIDEO_CLOCKRATE,
                                                                                                                       pFrame->presentationUs );
 
-            if( pSession->rtpConfig.twccId > 0 )
-            {
-                pRollingBufferPacket->rtpPacket.header.flags |= RTP_HEADER_FLAG_EXTENSION;
-                pRollingBufferPacket->rtpPacket.header.extension.extensionProfile = PEER_CONNECTION_SRTP_TWCC_EXT_PROFILE;
-                pRollingBufferPacket->rtpPacket.header.extension.extensionPayloadLength = 1;
-                pRollingBufferPacket->twccExtensionPayload = PEER_CONNECTION_SRTP_GET_TWCC_PAYLOAD( pSession->rtpConfig.twccId,
-                                                                                                    pSession->rtpConfig.twccSequence );
-                pRollingBufferPacket->rtpPacket.header.extension.pExtensionPayload = &pRollingBufferPacket->twccExtensionPayload;
-
-                #if ENABLE_TWCC_SUPPORT
-                memset( &packetInfo,
-                        0,
-                        sizeof( TwccPacketInfo_t ) );
-                packetInfo.packetSize = packeth265.packetDataLength;
-                packetInfo.localSentTime = NetworkingUtils_GetCurrentTimeUs( NULL );
-                packetInfo.packetSeqNum = pSession->rtpConfig.twccSequence;
-
-                RtcpTwccManager_AddPacketInfo( &pSession->pCtx->rtcpTwccManager,
-                                               &packetInfo );
-                #endif /* ENABLE_TWCC_SUPPORT */
-
-                pSession->rtpConfig.twccSequence++;
-            }
+            PeerConnectionSrtp_WriteRtpHeaderExtensions( pSession,
+                                                         TRANSCEIVER_TRACK_KIND_VIDEO,
+                                                         pRollingBufferPacket,
+                                                         packeth265.packetDataLength );
 
             pRollingBufferPacket->rtpPacket.payloadLength = packeth265.packetDataLength;
             pRollingBufferPacket->rtpPacket.pPayload = packeth265.pPacketData;
@@ -366,9 +343,12 @@ PeerConnectionResult_t PeerConnectionH265Helper_WriteH265Frame( PeerConnectionSe
         /* Write the constructed RTP packets through network. */
         if( ret == PEER_CONNECTION_RESULT_OK )
         {
-            resultIceController = IceController_SendToRemotePeer( &pSession->iceControllerContext,
-                                                                  pSrtpPacket,
-                                                                  srtpPacketLength );
+            /* Both the local buffer and the rolling buffer packet reserve headroom/tailroom, frame it in place. */
+            resultIceController = IceController_SendToRemotePeerInPlace( &pSession->iceControllerContext,
+                                                                         pSrtpPacket,
+                                                                         srtpPacketLength,
+                                                                         srtpPacketLength + PEER_CONNECTION_PACKET_TAILROOM_LENGTH,
+                                                                         ICE_CONTROLLER_SEND_PRIORITY_VIDEO );
             if( resultIceController != ICE_CONTROLLER_RESULT_OK )
             {
                 LogWarn( ( "Fail to send RTP packet, ret: %d", resultIceController ) );
@@ -18,6 +18,64 @@
 #include "opus_packetizer.h"
 #include "opus_depacketizer.h"
 
+#define PEER_CONNECTION_OPUS_HELPER_TOC_CODE_MASK ( 0x03 )
+#define PEER_CONNECTION_OPUS_HELPER_FRAME_COUNT_MASK ( 0x3F )
+
+#if PEER_CONNECTION_ENABLE_OPUS_FEC_RECOVERY || PEER_CONNECTION_ENABLE_AUDIO_RED
+uint32_t PeerConnectionOpusHelper_GetOpusPacketDuration( const uint8_t * pPacket,
+                                                         size_t packetLength )
+{
+    /* Frame sizes in 48 kHz samples per TOC configuration, https://datatracker.ietf.org/doc/html/rfc6716#section-3.1 */
+    static const uint32_t silkFrameSizes[] = { 480U, 960U, 1920U, 2880U };
+    static const uint32_t hybridFrameSizes[] = { 480U, 960U };
+    static const uint32_t celtFrameSizes[] = { 120U, 240U, 480U, 960U };
+    uint32_t duration = 0U;
+    uint32_t frameSize;
+    uint32_t frameCount = 0U;
+    uint8_t config;
+
+    if( ( pPacket != NULL ) &&
+        ( packetLength > 0U ) )
+    {
+        config = pPacket[ 0 ] >> 3;
+        if( config < 12U )
+        {
+            frameSize = silkFrameSizes[ config & 0x03 ];
+        }
+        else if( config < 16U )
+        {
+            frameSize = hybridFrameSizes[ config & 0x01 ];
+        }
+        else
+        {
+            frameSize = celtFrameSizes[ config & 0x03 ];
+        }
+
+        switch( pPacket[ 0 ] & PEER_CONNECTION_OPUS_HELPER_TOC_CODE_MASK )
+        {
+            case 0:
+                frameCount = 1U;
+                break;
+            case 1:
+            case 2:
+                frameCount = 2U;
+                break;
+            default:
+                /* Code 3 carries the frame count in the byte after the TOC. */
+                if( packetLength > 1U )
+                {
+                    frameCount = pPacket[ 1 ] & PEER_CONNECTION_OPUS_HELPER_FRAME_COUNT_MASK;
+                }
+                break;
+        }
+
+        duration = frameSize * frameCount;
+    }
+
+    return duration;
+}
+#endif /* PEER_CONNECTION_ENABLE_OPUS_FEC_RECOVERY || PEER_CONNECTION_ENABLE_AUDIO_RED */
+
 PeerConnectionResult_t PeerConnectionOpusHelper_GetOpusPacketProperty( PeerConnectionJitterBufferPacket_t * pPacket,
                                                                        uint8_t * pIsStartPacket )
 {
@@ -101,8 +159,9 @@ PeerConnectionResult_t PeerConnectionOpusHelper_FillFrameOpus( PeerConnectionJit
             index = PEER_CONNECTION_JITTER_BUFFER_WRAP( i,
                                                         PEER_CONNECTION_JITTER_BUFFER_MAX_ENTRY_NUM );
             pPacket = &pJitterBuffer->rtpPackets[ index ];
-            opusPacket.pPacketData = pPacket->pPacketBuffer;
-            opusPacket.packetDataLength = pPacket->packetBufferLength;
+            PeerConnectionSrtp_GetPrimaryPayload( pPacket,
+                                                  &opusPacket.pPacketData,
+                                                  &opusPacket.packetDataLength );
             rtpTimestamp = pPacket->rtpTimestamp;
             LogDebug( ( "Adding packet seq: %u, length: %u, timestamp: %lu", i, opusPacket.packetDataLength, rtpTimestamp ) );
 
@@ -140,6 +199,77 @@ PeerConnectionResult_t PeerConnectionOpusHelper_FillFrameOpus( PeerConnectionJit
     return ret;
 }
 
+#if PEER_CONNECTION_ENABLE_OPUS_FEC_RECOVERY
+PeerConnectionResult_t PeerConnectionOpusHelper_FillFecFrameOpus( PeerConnectionJitterBuffer_t * pJitterBuffer,
+                                                                  uint16_t lostRtpSeq,
+                                                                  uint8_t * pOutBuffer,
+                                                                  size_t * pOutBufferLength,
+                                                                  uint32_t * pRtpTimestamp )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    uint16_t nextRtpSeq = lostRtpSeq + 1U;
+    PeerConnectionJitterBufferPacket_t * pNextPacket = NULL;
+    uint8_t * pNextPayload = NULL;
+    size_t nextPayloadLength = 0U;
+    uint32_t duration = 0U;
+
+    if( ( pJitterBuffer == NULL ) ||
+        ( pOutBuffer == NULL ) ||
+        ( pOutBufferLength == NULL ) ||
+        ( pRtpTimestamp == NULL ) )
+    {
+        LogError( ( "Invalid input, pJitterBuffer: %p, pOutBuffer: %p, pOutBufferLength: %p, pRtpTimestamp: %p", pJitterBuffer, pOutBuffer, pOutBufferLength, pRtpTimestamp ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        /* The in-band FEC of a packet only protects the frame right before it. */
+        pNextPacket = &pJitterBuffer->rtpPackets[ PEER_CONNECTION_JITTER_BUFFER_WRAP( nextRtpSeq,
+                                                                                       PEER_CONNECTION_JITTER_BUFFER_MAX_ENTRY_NUM ) ];
+        if( ( pNextPacket->isPushed == 0U ) ||
+            ( pNextPacket->sequenceNumber != nextRtpSeq ) )
+        {
+            LogDebug( ( "No packet after lost seq: %u to recover it from", lostRtpSeq ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_JITTER_BUFFER_SEQ_NOT_FOUND;
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        /* The FEC data has the same duration as the packet carrying it. Durations are in 48 kHz samples,
+         * which is also the Opus RTP clock, https://datatracker.ietf.org/doc/html/rfc7587#section-4.1 */
+        PeerConnectionSrtp_GetPrimaryPayload( pNextPacket,
+                                              &pNextPayload,
+                                              &nextPayloadLength );
+        duration = PeerConnectionOpusHelper_GetOpusPacketDuration( pNextPayload,
+                                                                   nextPayloadLength );
+        if( duration == 0U )
+        {
+            LogDebug( ( "Unable to get the duration of Opus packet seq: %u", nextRtpSeq ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_DEPACKETIZER_GET_PROPERTIES;
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        ret = PeerConnectionOpusHelper_FillFrameOpus( pJitterBuffer,
+                                                      nextRtpSeq,
+                                                      nextRtpSeq,
+                                                      pOutBuffer,
+                                                      pOutBufferLength,
+                                                      pRtpTimestamp );
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        *pRtpTimestamp = pNextPacket->rtpTimestamp - duration;
+    }
+
+    return ret;
+}
+#endif /* PEER_CONNECTION_ENABLE_OPUS_FEC_RECOVERY */
+
 PeerConnectionResult_t PeerConnectionOpusHelper_WriteOpusFrame( PeerConnectionSession_t * pSession,
                                                                 Transceiver_t * pTransceiver,
                                                                 const PeerConnectionFrame_t * pFrame )
@@ -148,7 +278,7 @@ PeerConnectionResult_t PeerConnectionOpusHelper_WriteOpusFrame( PeerConnectionSe
     OpusPacketizerContext_t opusPacketizerContext;
     OpusResult_t resultOpus;
     OpusPacket_t packetOpus;
-    uint8_t rtpBuffer[ PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ];
+    uint8_t rtpBuffer[ PEER_CONNECTION_PACKET_BUFFER_SIZE( PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ) ];
     PeerConnectionRollingBufferPacket_t * pRollingBufferPacket = NULL;
     uint8_t * pSrtpPacket = NULL;
     size_t srtpPacketLength = 0;
@@ -159,14 +289,15 @@ PeerConnectionResult_t PeerConnectionOpusHelper_WriteOpusFrame( PeerConnectionSe
     IceControllerResult_t resultIceController;
     uint16_t * pRtpSeq = NULL;
     uint32_t payloadType;
+    uint32_t rtpTimestamp = 0;
     uint32_t * pSsrc = NULL;
     uint32_t packetSent = 0;
     uint32_t bytesSent = 0;
     uint32_t randomRtpTimeoffset = 0;    // TODO : Spec required random rtp time offset ( current implementation of KVS SDK )
-    #if ENABLE_TWCC_SUPPORT
-    /* Add TWCC packet tracking */
-    TwccPacketInfo_t packetInfo;
-    #endif /* ENABLE_TWCC_SUPPORT */
+    #if PEER_CONNECTION_ENABLE_AUDIO_RED
+    uint8_t * pRedPayload = NULL;
+    size_t redHeadroom = 0;
+    #endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
 
     if( ( pSession == NULL ) ||
         ( pTransceiver == NULL ) ||
@@ -205,6 +336,8 @@ PeerConnectionResult_t PeerConnectionOpusHelper_WriteOpusFrame( PeerConnectionSe
         pSrtpSender = &pSession->audioSrtpSender;
         pRtpSeq = &pSession->rtpConfig.audioSequenceNumber;
         payloadType = pSession->rtpConfig.audioCodecPayload;
+        rtpTimestamp = PEER_CONNECTION_SRTP_CONVERT_TIME_US_TO_RTP_TIMESTAMP( PEER_CONNECTION_SRTP_OPUS_CLOCKRATE,
+                                                                              pFrame->presentationUs );
         if( ( pSession->rtpConfig.audioCodecRtxPayload != 0 ) &&
             ( pSession->rtpConfig.audioCodecRtxPayload != pSession->rtpConfig.audioCodecPayload ) )
         {
@@ -246,8 +379,8 @@ PeerConnectionResult_t PeerConnectionOpusHelper_WriteOpusFrame( PeerConnectionSe
             packetOpus.pPacketData = pRollingBufferPacket->pPacketBuffer + PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES;
             packetOpus.packetDataLength = pRollingBufferPacket->packetBufferLength - PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES;
 
-            /* Using local buffer for SRTP packet, use the entire packet length. */
-            pSrtpPacket = rtpBuffer;
+            /* Using local buffer for SRTP packet, use the entire packet length after the headroom. */
+            pSrtpPacket = rtpBuffer + PEER_CONNECTION_PACKET_HEADROOM_LENGTH;
             srtpPacketLength = PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH;
         }
         else
@@ -260,6 +393,15 @@ PeerConnectionResult_t PeerConnectionOpusHelper_WriteOpusFrame( PeerConnectionSe
             srtpPacketLength = pRollingBufferPacket->packetBufferLength;
         }
 
+        #if PEER_CONNECTION_ENABLE_AUDIO_RED
+        /* Leave room in front of the payload for the RED headers and the previous payload. */
+        redHeadroom = PeerConnectionSrtp_GetRedHeadroom( pSession,
+                                                         rtpTimestamp );
+        pRedPayload = packetOpus.pPacketData;
+        packetOpus.pPacketData += redHeadroom;
+        packetOpus.packetDataLength -= redHeadroom;
+        #endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
+
         resultOpus = OpusPacketizer_GetPacket( &opusPacketizerContext,
                                                &packetOpus );
         if( resultOpus == OPUS_RESULT_NO_MORE_PACKETS )
@@ -284,30 +426,26 @@ PeerConnectionResult_t PeerConnectionOpusHelper_WriteOpusFrame( PeerConnectionSe
 
             pRollingBufferPacket->rtpPacket.header.csrcCount = 0;
             pRollingBufferPacket->rtpPacket.header.pCsrc = NULL;
-            pRollingBufferPacket->rtpPacket.header.timestamp = PEER_CONNECTION_SRTP_CONVERT_TIME_US_TO_RTP_TIMESTAMP( PEER_CONNECTION_SRTP_OPUS_CLOCKRATE,
-                                                                                                                      pFrame->presentationUs );
+            pRollingBufferPacket->rtpPacket.header.timestamp = rtpTimestamp;
 
-            if( pSession->rtpConfig.twccId > 0 )
+            #if PEER_CONNECTION_ENABLE_AUDIO_RED
+            if( pSession->rtpConfig.audioCodecRedPayload != 0U )
             {
-                pRollingBufferPacket->rtpPacket.header.flags |= RTP_HEADER_FLAG_EXTENSION;
-                pRollingBufferPacket->rtpPacket.header.extension.extensionProfile = PEER_CONNECTION_SRTP_TWCC_EXT_PROFILE;
-                pRollingBufferPacket->rtpPacket.header.extension.extensionPayloadLength = 1;
-                pRollingBufferPacket->twccExtensionPayload = PEER_CONNECTION_SRTP_GET_TWCC_PAYLOAD( pSession->rtpConfig.twccId,
-                                                                                                    pSession->rtpConfig.twccSequence );
-                pRollingBufferPacket->rtpPacket.header.extension.pExtensionPayload = &pRollingBufferPacket->twccExtensionPayload;
-
-                #if ENABLE_TWCC_SUPPORT
-                memset( &packetInfo, 0, sizeof( TwccPacketInfo_t ) );
-                packetInfo.packetSize = packetOpus.packetDataLength;
-                packetInfo.localSentTime = NetworkingUtils_GetCurrentTimeUs( NULL );
-                packetInfo.packetSeqNum = pSession->rtpConfig.twccSequence;
-
-                RtcpTwccManager_AddPacketInfo( &pSession->pCtx->rtcpTwccManager,
-                                               &packetInfo );
-                #endif /* ENABLE_TWCC_SUPPORT */
-
-                pSession->rtpConfig.twccSequence++;
+                /* Send the payload as the primary block of a RED packet, after the previous payload. */
+                packetOpus.packetDataLength = PeerConnectionSrtp_WriteRedPayload( pSession,
+                                                                                  rtpTimestamp,
+                                                                                  pRedPayload,
+                                                                                  redHeadroom,
+                                                                                  packetOpus.packetDataLength );
+                packetOpus.pPacketData = pRedPayload;
+                pRollingBufferPacket->rtpPacket.header.payloadType = pSession->rtpConfig.audioCodecRedPayload;
             }
+            #endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
+
+            PeerConnectionSrtp_WriteRtpHeaderExtensions( pSession,
+                                                         TRANSCEIVER_TRACK_KIND_AUDIO,
+                                                         pRollingBufferPacket,
+                                                         packetOpus.packetDataLength );
 
             pRollingBufferPacket->rtpPacket.payloadLength = packetOpus.packetDataLength;
             pRollingBufferPacket->rtpPacket.pPayload = packetOpus.pPacketData;
@@ -352,9 +490,12 @@ PeerConnectionResult_t PeerConnectionOpusHelper_WriteOpusFrame( PeerConnectionSe
         /* Write the constructed RTP packets through network. */
         if( ret == PEER_CONNECTION_RESULT_OK )
         {
-            resultIceController = IceController_SendToRemotePeer( &pSession->iceControllerContext,
-                                                                  pSrtpPacket,
-                                                                  srtpPacketLength );
+            /* Both the local buffer and the rolling buffer packet reserve headroom/tailroom, frame it in place. */
+            resultIceController = IceController_SendToRemotePeerInPlace( &pSession->iceControllerContext,
+                                                                         pSrtpPacket,
+                                                                         srtpPacketLength,
+                                                                         srtpPacketLength + PEER_CONNECTION_PACKET_TAILROOM_LENGTH,
+                                                                         ICE_CONTROLLER_SEND_PRIORITY_AUDIO );
             if( resultIceController != ICE_CONTROLLER_RESULT_OK )
             {
                 LogWarn( ( "Fail to send RTP packet, ret: %d", resultIceController ) );
@@ -41,6 +41,22 @@ PeerConnectionResult_t PeerConnectionOpusHelper_FillFrameOpus( PeerConnectionJit
                                                                size_t * pOutBufferLength,
                                                                uint32_t * pRtpTimestamp );
 
+#if PEER_CONNECTION_ENABLE_OPUS_FEC_RECOVERY || PEER_CONNECTION_ENABLE_AUDIO_RED
+/* Duration of an Opus packet from its TOC byte, in 48 kHz samples. 0 if it can't be told. */
+uint32_t PeerConnectionOpusHelper_GetOpusPacketDuration( const uint8_t * pPacket,
+                                                         size_t packetLength );
+#endif /* PEER_CONNECTION_ENABLE_OPUS_FEC_RECOVERY || PEER_CONNECTION_ENABLE_AUDIO_RED */
+
+#if PEER_CONNECTION_ENABLE_OPUS_FEC_RECOVERY
+/* Fill the packet after a lost one as the lost frame, stamped with the lost frame's RTP timestamp,
+ * for the decoder to rebuild from in-band FEC. */
+PeerConnectionResult_t PeerConnectionOpusHelper_FillFecFrameOpus( PeerConnectionJitterBuffer_t * pJitterBuffer,
+                                                                  uint16_t lostRtpSeq,
+                                                                  uint8_t * pOutBuffer,
+                                                                  size_t * pOutBufferLength,
+                                                                  uint32_t * pRtpTimestamp );
+#endif /* PEER_CONNECTION_ENABLE_OPUS_FEC_RECOVERY */
+
 PeerConnectionResult_t PeerConnectionOpusHelper_WriteOpusFrame( PeerConnectionSession_t * pSession,
                                                                 Transceiver_t * pTransceiver,
                                                                 const PeerConnectionFrame_t * pFrame );
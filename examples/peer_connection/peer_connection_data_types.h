@@ -47,6 +47,7 @@ extern "C" {
 #include "rtp_data_types.h"
 #include "rtp_pkt_queue.h"
 #include "rtcp_data_types.h"
+#include "peer_connection_jitter_estimator.h"
 
 #define PEER_CONNECTION_TRANSCEIVER_MAX_COUNT ( 2 )
 #define PEER_CONNECTION_USER_NAME_LENGTH ( 32 )
@@ -64,8 +65,25 @@ extern "C" {
 
 #define PEER_CONNECTION_MAX_DTLS_DECRYPTED_DATA_LENGTH ( 2048 )
 
-#define MAX_SCTP_DATA_CHANNELS          4
-#define PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER 2
+/* Number of data channels each peer connection session can hold. */
+#ifndef PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER
+#define PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER ( 2 )
+#endif
+
+/* Size of the per-session hash index from SCTP stream ID to data channel.
+ * It must be a power of 2 and larger than PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER. */
+#ifndef PEER_CONNECTION_SCTP_DATA_CHANNEL_INDEX_SIZE
+#define PEER_CONNECTION_SCTP_DATA_CHANNEL_INDEX_SIZE ( 8 )
+#endif
+
+#if ( PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER > 255 )
+#error "PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER must fit the uint8_t data channel index."
+#endif
+
+#if ( PEER_CONNECTION_SCTP_DATA_CHANNEL_INDEX_SIZE <= PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER ) || \
+    ( ( PEER_CONNECTION_SCTP_DATA_CHANNEL_INDEX_SIZE & ( PEER_CONNECTION_SCTP_DATA_CHANNEL_INDEX_SIZE - 1 ) ) != 0 )
+#error "PEER_CONNECTION_SCTP_DATA_CHANNEL_INDEX_SIZE must be a power of 2 larger than PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER."
+#endif
 
 #define PEER_CONNECTION_TWCC_BITRATE_ADJUSTMENT_INTERVAL_US        1000 * 10000  //1,000,000 microseconds.
 #define PEER_CONNECTION_MIN_VIDEO_BITRATE_KBPS                     512     // Unit kilobits/sec. Value could change based on codec.
@@ -77,8 +95,175 @@ extern "C" {
 #define PEER_CONNECTION_INACTIVE_CONNECTION_TIMEOUT_MS ( 30000 )
 #define PEER_CONNECTION_DTLS_HANDSHAKING_TIMEOUT_MS    ( 24000 )
 
+/* DTLS datagrams must fit the ICE send buffer together with IPv6/UDP headers and TURN framing. */
+#define PEER_CONNECTION_IP_UDP_HEADER_LENGTH           ( 48 )
+#define PEER_CONNECTION_DTLS_MTU                       ( ICE_CONTROLLER_MAX_MTU - PEER_CONNECTION_IP_UDP_HEADER_LENGTH - ICE_CONTROLLER_SEND_HEADROOM_LENGTH - ICE_CONTROLLER_SEND_TAILROOM_LENGTH )
+
 #define PEER_CONNECTION_START_UP_BARRIER_BIT ( 1 << 0 )
 
+/* Number of DTLS certificates/keys pre-generated by a background task so that each session
+ * takes fresh credentials without paying for key generation on the connect path.
+ * 0 disables the pool and all sessions share the certificate generated at init. */
+#ifndef PEER_CONNECTION_DTLS_CERT_POOL_SIZE
+    #define PEER_CONNECTION_DTLS_CERT_POOL_SIZE ( 0 )
+#endif
+
+/* Number of serialized SDP answers cached by remote offer signature. Viewers sending the same
+ * offer layout reuse the cached answer with only the per-session fields patched.
+ * 0 disables the cache and every answer is built from scratch. */
+#ifndef PEER_CONNECTION_SDP_ANSWER_TEMPLATE_COUNT
+    #define PEER_CONNECTION_SDP_ANSWER_TEMPLATE_COUNT ( 0 )
+#endif
+
+/* Answer the abs-send-time RTP header extension when the remote offers it,
+ * so the far side can run its delay-based bandwidth estimation on our send time. */
+#ifndef PEER_CONNECTION_ENABLE_ABS_SEND_TIME_EXTENSION
+    #define PEER_CONNECTION_ENABLE_ABS_SEND_TIME_EXTENSION ( 0 )
+#endif
+
+/* Answer the playout-delay RTP header extension on video when the remote offers it.
+ * Every video packet then asks the receiver to keep its jitter buffer target between
+ * the min and max below, in milliseconds with 10 ms granularity (at most 40950 ms). */
+#ifndef PEER_CONNECTION_ENABLE_PLAYOUT_DELAY_EXTENSION
+    #define PEER_CONNECTION_ENABLE_PLAYOUT_DELAY_EXTENSION ( 0 )
+#endif
+
+#ifndef PEER_CONNECTION_PLAYOUT_DELAY_MIN_MS
+    #define PEER_CONNECTION_PLAYOUT_DELAY_MIN_MS ( 0 )
+#endif
+
+#ifndef PEER_CONNECTION_PLAYOUT_DELAY_MAX_MS
+    #define PEER_CONNECTION_PLAYOUT_DELAY_MAX_MS ( 100 )
+#endif
+
+#if ( PEER_CONNECTION_PLAYOUT_DELAY_MIN_MS > PEER_CONNECTION_PLAYOUT_DELAY_MAX_MS ) || ( PEER_CONNECTION_PLAYOUT_DELAY_MAX_MS > 40950 )
+#error "PEER_CONNECTION_PLAYOUT_DELAY_MIN_MS must not exceed PEER_CONNECTION_PLAYOUT_DELAY_MAX_MS, which must not exceed 40950."
+#endif
+
+/* Local extmap IDs used when we create the offer, answers reuse the remote IDs. */
+#define PEER_CONNECTION_ABS_SEND_TIME_EXTENSION_LOCAL_ID ( 2 )
+#define PEER_CONNECTION_PLAYOUT_DELAY_EXTENSION_LOCAL_ID ( 3 )
+
+/* Send generic NACKs (RFC 4585) for sequence gaps found in the receive jitter buffers,
+ * and accept the RTX retransmissions that answer them. */
+#ifndef PEER_CONNECTION_ENABLE_RECEIVER_NACK
+    #define PEER_CONNECTION_ENABLE_RECEIVER_NACK ( 1 )
+#endif
+
+/* Number of missing sequence numbers each receive jitter buffer keeps asking for. */
+#ifndef PEER_CONNECTION_JITTER_BUFFER_NACK_MAX_ENTRY_NUM
+    #define PEER_CONNECTION_JITTER_BUFFER_NACK_MAX_ENTRY_NUM ( 64 )
+#endif
+
+/* A missing packet is requested again once per RTT, up to this many times, before
+ * it's left to the jitter buffer to drop the frame. */
+#ifndef PEER_CONNECTION_RECEIVER_NACK_MAX_RETRIES
+    #define PEER_CONNECTION_RECEIVER_NACK_MAX_RETRIES ( 10 )
+#endif
+
+/* RTT used to space NACK retries until a receiver report gives us a measurement,
+ * and the lower bound of that spacing so a tiny RTT doesn't flood the sender. */
+#ifndef PEER_CONNECTION_RECEIVER_NACK_DEFAULT_RTT_MS
+    #define PEER_CONNECTION_RECEIVER_NACK_DEFAULT_RTT_MS ( 100 )
+#endif
+
+#ifndef PEER_CONNECTION_RECEIVER_NACK_MIN_RETRY_INTERVAL_MS
+    #define PEER_CONNECTION_RECEIVER_NACK_MIN_RETRY_INTERVAL_MS ( 20 )
+#endif
+
+#if ( PEER_CONNECTION_RECEIVER_NACK_MAX_RETRIES > 255 )
+#error "PEER_CONNECTION_RECEIVER_NACK_MAX_RETRIES must fit the uint8_t retry counter."
+#endif
+
+/* Let each receive jitter buffer size its wait for missing packets from the interarrival jitter
+ * of its stream and the reordering depth it measures, instead of always waiting the maximum.
+ * The delay stays within the per-kind bounds below, in milliseconds; without adaptation the
+ * maximum is used. */
+#ifndef PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER
+    #define PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER ( 1 )
+#endif
+
+#ifndef PEER_CONNECTION_JITTER_BUFFER_VIDEO_MIN_DELAY_MS
+    #define PEER_CONNECTION_JITTER_BUFFER_VIDEO_MIN_DELAY_MS ( 100 )
+#endif
+
+#ifndef PEER_CONNECTION_JITTER_BUFFER_VIDEO_MAX_DELAY_MS
+    #define PEER_CONNECTION_JITTER_BUFFER_VIDEO_MAX_DELAY_MS ( 2000 )
+#endif
+
+#ifndef PEER_CONNECTION_JITTER_BUFFER_AUDIO_MIN_DELAY_MS
+    #define PEER_CONNECTION_JITTER_BUFFER_AUDIO_MIN_DELAY_MS ( 40 )
+#endif
+
+/* Without adaptation the audio buffer keeps waiting as long as it always did. */
+#ifndef PEER_CONNECTION_JITTER_BUFFER_AUDIO_MAX_DELAY_MS
+    #if PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER
+        #define PEER_CONNECTION_JITTER_BUFFER_AUDIO_MAX_DELAY_MS ( 1000 )
+    #else
+        #define PEER_CONNECTION_JITTER_BUFFER_AUDIO_MAX_DELAY_MS ( 2000 )
+    #endif /* PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER */
+#endif
+
+#if ( PEER_CONNECTION_JITTER_BUFFER_VIDEO_MIN_DELAY_MS > PEER_CONNECTION_JITTER_BUFFER_VIDEO_MAX_DELAY_MS ) || \
+    ( PEER_CONNECTION_JITTER_BUFFER_AUDIO_MIN_DELAY_MS > PEER_CONNECTION_JITTER_BUFFER_AUDIO_MAX_DELAY_MS )
+#error "The jitter buffer min delay must not exceed its max delay."
+#endif
+
+/* Keep reception statistics for the incoming streams and send them back in periodic receiver reports,
+ * so the remote sender gets loss, jitter and RTT feedback. The report interval follows the RTCP
+ * bandwidth share of the received bitrate (RFC 3550 section 6.2), bounded by the min and max below. */
+#ifndef PEER_CONNECTION_ENABLE_RECEIVER_REPORT
+    #define PEER_CONNECTION_ENABLE_RECEIVER_REPORT ( 1 )
+#endif
+
+#ifndef PEER_CONNECTION_RTCP_RECEIVER_REPORT_MIN_INTERVAL_MS
+    #define PEER_CONNECTION_RTCP_RECEIVER_REPORT_MIN_INTERVAL_MS ( 500 )
+#endif
+
+#ifndef PEER_CONNECTION_RTCP_RECEIVER_REPORT_MAX_INTERVAL_MS
+    #define PEER_CONNECTION_RTCP_RECEIVER_REPORT_MAX_INTERVAL_MS ( 5000 )
+#endif
+
+#if ( PEER_CONNECTION_RTCP_RECEIVER_REPORT_MIN_INTERVAL_MS == 0 ) || ( PEER_CONNECTION_RTCP_RECEIVER_REPORT_MIN_INTERVAL_MS > PEER_CONNECTION_RTCP_RECEIVER_REPORT_MAX_INTERVAL_MS )
+#error "PEER_CONNECTION_RTCP_RECEIVER_REPORT_MIN_INTERVAL_MS must be non-zero and not exceed PEER_CONNECTION_RTCP_RECEIVER_REPORT_MAX_INTERVAL_MS."
+#endif
+
+/* The reception statistics hold the one interarrival jitter estimate of a stream,
+ * the receiver reports carry it and the adaptive jitter buffer sizes its wait from it. */
+#define PEER_CONNECTION_ENABLE_RECEIVER_STATS ( PEER_CONNECTION_ENABLE_RECEIVER_REPORT || PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER )
+
+/* When an Opus packet is still missing once the jitter buffer gives up waiting for it, hand the
+ * packet after it to the application as the lost frame, so the decoder can rebuild it from the
+ * in-band FEC data (useinbandfec=1). The frame is marked with PEER_CONNECTION_FRAME_FLAG_OPUS_FEC. */
+#ifndef PEER_CONNECTION_ENABLE_OPUS_FEC_RECOVERY
+    #define PEER_CONNECTION_ENABLE_OPUS_FEC_RECOVERY ( 1 )
+#endif
+
+/* Offer and accept RFC 2198 redundant audio (RED) for Opus and G.711. Each packet then also carries
+ * the previous payload, so the receiver rebuilds an isolated loss without waiting for a retransmission,
+ * at the cost of roughly doubling the audio bitrate. */
+#ifndef PEER_CONNECTION_ENABLE_AUDIO_RED
+    #define PEER_CONNECTION_ENABLE_AUDIO_RED ( 0 )
+#endif
+
+/* The RED payload type offered when we create the SDP offer. */
+#ifndef PEER_CONNECTION_AUDIO_RED_DEFAULT_PAYLOAD
+    #define PEER_CONNECTION_AUDIO_RED_DEFAULT_PAYLOAD ( 63 )
+#endif
+
+/* The largest previous payload repeated in a RED packet, larger ones are sent without redundancy. */
+#ifndef PEER_CONNECTION_AUDIO_RED_MAX_BLOCK_LENGTH
+    #define PEER_CONNECTION_AUDIO_RED_MAX_BLOCK_LENGTH ( 320 )
+#endif
+
+#if ( PEER_CONNECTION_AUDIO_RED_MAX_BLOCK_LENGTH > 1023 )
+#error "PEER_CONNECTION_AUDIO_RED_MAX_BLOCK_LENGTH must fit the 10-bit RED block length."
+#endif
+
+/* One-byte header extension elements (RFC 8285) written on each packet:
+ * TWCC (1 + 2 bytes), abs-send-time (1 + 3 bytes) and playout-delay (1 + 3 bytes), padded to 32-bit words. */
+#define PEER_CONNECTION_RTP_EXTENSION_MAX_WORDS ( 3 )
+
 typedef enum PeerConnectionResult
 {
     PEER_CONNECTION_RESULT_OK = 0,
@@ -103,6 +288,8 @@ typedef enum PeerConnectionResult
     PEER_CONNECTION_RESULT_FAIL_ICE_CONTROLLER_ADD_ICE_SERVER_CONFIG,
     PEER_CONNECTION_RESULT_FAIL_CREATE_CERT_AND_KEY,
     PEER_CONNECTION_RESULT_FAIL_CREATE_CERT_FINGERPRINT,
+    PEER_CONNECTION_RESULT_FAIL_CREATE_DTLS_POOL_MUTEX,
+    PEER_CONNECTION_RESULT_FAIL_CREATE_TASK_DTLS_POOL,
     PEER_CONNECTION_RESULT_FAIL_MQ_INIT,
     PEER_CONNECTION_RESULT_FAIL_MQ_SEND,
     PEER_CONNECTION_RESULT_FAIL_CREATE_SRTP_RX_SESSION,
@@ -114,6 +301,7 @@ typedef enum PeerConnectionResult
     PEER_CONNECTION_RESULT_FAIL_RTP_SERIALIZE,
     PEER_CONNECTION_RESULT_FAIL_RTP_DESERIALIZE,
     PEER_CONNECTION_RESULT_FAIL_RTP_RX_NO_MATCHING_SSRC,
+    PEER_CONNECTION_RESULT_FAIL_RED_DESERIALIZE,
     PEER_CONNECTION_RESULT_FAIL_RTCP_INIT,
     PEER_CONNECTION_RESULT_FAIL_RTCP_DESERIALIZE,
     PEER_CONNECTION_RESULT_FAIL_RTCP_PARSE_REMB,
@@ -123,6 +311,8 @@ typedef enum PeerConnectionResult
     PEER_CONNECTION_RESULT_FAIL_RTCP_PARSE_FIR,
     PEER_CONNECTION_RESULT_FAIL_RTCP_PARSE_SENDER_REPORT,
     PEER_CONNECTION_RESULT_FAIL_RTCP_SERIALIZE_SENDER_REPORT,
+    PEER_CONNECTION_RESULT_FAIL_RTCP_SERIALIZE_NACK,
+    PEER_CONNECTION_RESULT_FAIL_RTCP_SERIALIZE_RECEIVER_REPORT,
     PEER_CONNECTION_RESULT_FAIL_RTCP_PARSE_RECEIVER_REPORT,
     PEER_CONNECTION_RESULT_FAIL_RTCP_TWCC_INIT,
     PEER_CONNECTION_RESULT_FAIL_CREATE_TWCC_MUTEX,
@@ -141,6 +331,9 @@ typedef enum PeerConnectionResult
     PEER_CONNECTION_RESULT_FAIL_RTP_PACKET_QUEUE_RETRIEVE,
     PEER_CONNECTION_RESULT_FAIL_RTP_PACKET_ENQUEUE,
     PEER_CONNECTION_RESULT_FAIL_RTP_PACKET_NOT_FOUND,
+    PEER_CONNECTION_RESULT_FAIL_CREATE_ROLLING_BUFFER_MUTEX,
+    PEER_CONNECTION_RESULT_FAIL_TAKE_ROLLING_BUFFER_MUTEX,
+    PEER_CONNECTION_RESULT_FAIL_ROLLING_BUFFER_COPY_TOO_SMALL,
     PEER_CONNECTION_RESULT_FAIL_PACKETIZER_INIT,
     PEER_CONNECTION_RESULT_FAIL_PACKETIZER_ADD_FRAME,
     PEER_CONNECTION_RESULT_FAIL_PACKETIZER_GET_PACKET,
@@ -167,6 +360,8 @@ typedef enum PeerConnectionResult
     PEER_CONNECTION_RESULT_FAIL_SCTP_WRITE,
     PEER_CONNECTION_RESULT_FAIL_SCTP_READ,
     PEER_CONNECTION_RESULT_FAIL_SCTP_CLOSE,
+    PEER_CONNECTION_RESULT_FAIL_SCTP_WOULD_BLOCK,
+    PEER_CONNECTION_RESULT_FAIL_SCTP_BUFFERED_AMOUNT,
 } PeerConnectionResult_t;
 
 /*
@@ -199,12 +394,17 @@ typedef void ( * OnPictureLossIndicationCallback_t )( void * pCustomContext,
 /*
  * Media relates data structures.
  */
+/* The frame carries the Opus packet that follows a lost one. Decode it with in-band FEC
+ * (opus_decode with decode_fec set) to conceal the frame at presentationUs. */
+#define PEER_CONNECTION_FRAME_FLAG_OPUS_FEC ( 1U << 0 )
+
 typedef struct PeerConnectionFrame
 {
     uint32_t version;
     uint8_t * pData;
     size_t dataLength;
     uint64_t presentationUs;
+    uint32_t flags; /* Bit map of PEER_CONNECTION_FRAME_FLAG_*, set on received frames only. */
 } PeerConnectionFrame_t;
 
 typedef struct PeerConnectionJitterBufferPacket PeerConnectionJitterBufferPacket_t;
@@ -227,10 +427,22 @@ typedef PeerConnectionResult_t (* FillFrameFunc_t)( PeerConnectionJitterBuffer_t
                                                     size_t * pOutBufferLength,
                                                     uint32_t * pRtpTimestamp );
 
+/* Outgoing packets are built with room reserved around them so that they can be
+ * serialized, protected and framed for TURN without being copied again:
+ * - Headroom for the TURN channel data header, written in front of the packet.
+ * - Tailroom for the TURN padding appended after the packet.
+ * The SRTP authentication tag is covered by the gap between PEER_CONNECTION_SRTP_RTP_PAYLOAD_MAX_LENGTH
+ * and PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH, and the RTX OSN by PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES. */
+#define PEER_CONNECTION_PACKET_HEADROOM_LENGTH ( ICE_CONTROLLER_SEND_HEADROOM_LENGTH )
+#define PEER_CONNECTION_PACKET_TAILROOM_LENGTH ( ICE_CONTROLLER_SEND_TAILROOM_LENGTH )
+#define PEER_CONNECTION_PACKET_BUFFER_SIZE( packetLength ) ( PEER_CONNECTION_PACKET_HEADROOM_LENGTH + ( packetLength ) + PEER_CONNECTION_PACKET_TAILROOM_LENGTH )
+
+/* pPacketBuffer points PEER_CONNECTION_PACKET_HEADROOM_LENGTH bytes into the allocation,
+ * and PEER_CONNECTION_PACKET_TAILROOM_LENGTH bytes are available after packetBufferLength. */
 typedef struct PeerConnectionRollingBufferPacket
 {
     RtpPacket_t rtpPacket;
-    uint32_t twccExtensionPayload;
+    uint32_t extensionPayload[ PEER_CONNECTION_RTP_EXTENSION_MAX_WORDS ];
     uint8_t * pPacketBuffer;
     size_t packetBufferLength;
 } PeerConnectionRollingBufferPacket_t;
@@ -241,11 +453,19 @@ typedef struct PeerConnectionRollingBuffer
     RtpPacketQueue_t packetQueue;
     size_t maxSizePerPacket;
     size_t capacity; /* Buffer duration * highest expected bitrate (in bps) / 8 / maxPacketSize. */
+
+    /* Mutex to protect the packet queue only. It's held for a single enqueue or lookup,
+     * never across a whole frame, so NACK handling doesn't wait for the frame writer. */
+    SemaphoreHandle_t bufferMutex;
 } PeerConnectionRollingBuffer_t;
 
 typedef struct PeerConnectionJitterBufferPacket
 {
     uint8_t isPushed;
+    #if PEER_CONNECTION_ENABLE_AUDIO_RED
+    uint8_t isRedundantEncoding; /* The payload is RED encoded, the fill frame functions take the primary block only. */
+    uint8_t isRecovered; /* Rebuilt from the redundant block of a later packet, its receive time says nothing about the network. */
+    #endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
     uint16_t sequenceNumber;
     uint32_t rtpTimestamp;
     TickType_t receiveTick;
@@ -253,6 +473,13 @@ typedef struct PeerConnectionJitterBufferPacket
     size_t packetBufferLength;
 } PeerConnectionJitterBufferPacket_t;
 
+typedef struct PeerConnectionJitterBufferNackEntry
+{
+    uint16_t sequenceNumber;
+    uint8_t retryCount; /* The number of NACKs already sent for this sequence number. */
+    TickType_t nextRetryTick; /* The tick at or after which this sequence number is requested again. */
+} PeerConnectionJitterBufferNackEntry_t;
+
 typedef struct PeerConnectionJitterBuffer
 {
     uint8_t isInit;
@@ -261,6 +488,11 @@ typedef struct PeerConnectionJitterBuffer
     uint32_t clockRate; /* The clock rate based on the codec. For example: the clock rate is 90000 if the chosen RTP is H264/90000. */
     uint32_t codec; /* The codec. For example: the codec is set to H264 if the chosen RTP is H264/90000. */
     uint32_t tolerenceRtpTimeStamp; /* The buffer time in RTP time stamp format. */
+    uint32_t minTolerenceRtpTimeStamp; /* The lower bound of the buffer time in RTP time stamp format. */
+    uint32_t maxTolerenceRtpTimeStamp; /* The upper bound of the buffer time in RTP time stamp format. */
+    #if PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER
+    PeerConnectionJitterEstimator_t estimator; /* Sizes tolerenceRtpTimeStamp from the jitter and reordering of the stream. */
+    #endif /* PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER */
     uint32_t lastPopRtpTimestamp; /* The timestamp in last pop RTP packet. */
     TickType_t lastPopTick; /* The receive time ticks in last pop RTP packet. */
     uint16_t lastPopSequenceNumber; /* The RTP sequence number in last pop RTP packet. */
@@ -269,6 +501,12 @@ typedef struct PeerConnectionJitterBuffer
     uint32_t newestReceivedTimestamp; /* The newest timestamp in packet queue. */
     PeerConnectionJitterBufferPacket_t rtpPackets[ PEER_CONNECTION_JITTER_BUFFER_MAX_ENTRY_NUM ]; /* The buffer for packet queue. */
 
+    #if PEER_CONNECTION_ENABLE_RECEIVER_NACK
+    /* Sequence numbers missing between received packets, in sequence order, waiting for retransmission. */
+    PeerConnectionJitterBufferNackEntry_t nackEntries[ PEER_CONNECTION_JITTER_BUFFER_NACK_MAX_ENTRY_NUM ];
+    size_t nackEntryCount;
+    #endif /* PEER_CONNECTION_ENABLE_RECEIVER_NACK */
+
     /* Callback functions & custom contexts. */
     OnJitterBufferFrameReadyCallback_t onFrameReadyCallbackFunc;
     void * pOnFrameReadyCallbackContext;
@@ -288,6 +526,7 @@ typedef enum PeerConnectionSessionRequestType
     PEER_CONNECTION_SESSION_REQUEST_TYPE_PROCESS_ICE_CANDIDATES_AND_PAIRS,
     PEER_CONNECTION_SESSION_REQUEST_TYPE_PERIOD_CONNECTION_CHECK,
     PEER_CONNECTION_SESSION_REQUEST_TYPE_RTCP_SENDER_REPORT,
+    PEER_CONNECTION_SESSION_REQUEST_TYPE_RTCP_RECEIVER_REPORT,
     PEER_CONNECTION_SESSION_REQUEST_TYPE_ICE_CLOSING,
     PEER_CONNECTION_SESSION_REQUEST_TYPE_ICE_CLOSED,
     PEER_CONNECTION_SESSION_REQUEST_TYPE_PEER_CONNECTION_CLOSE,
@@ -330,11 +569,14 @@ typedef struct PeerConnectionRtpConfig
     uint32_t audioCodecPayload;
     uint32_t videoCodecRtxPayload;
     uint32_t audioCodecRtxPayload;
+    uint32_t audioCodecRedPayload; /* 0 means RED is not negotiated. */
     uint16_t videoRtxSequenceNumber;
     uint16_t audioRtxSequenceNumber;
 
     uint16_t twccId;
     uint16_t twccSequence;
+    uint16_t absSendTimeId;
+    uint16_t playoutDelayId;
 
     uint32_t remoteVideoSsrc;
     uint32_t remoteAudioSsrc;
@@ -345,17 +587,58 @@ typedef struct PeerConnectionSrtpSender
     /* RTP Tx rolling buffer. */
     PeerConnectionRollingBuffer_t txRollingBuffer;
 
-    /* Mutex to protect sender info like rolling buffer. */
+    /* Mutex to serialize frame writers, i.e. RTP sequence and packetizing.
+     * The rolling buffer has its own lock so NACK handling doesn't take this one. */
     SemaphoreHandle_t senderMutex;
     uint8_t isSenderMutexInit;
 } PeerConnectionSrtpSender_t;
 
+/* The previous audio payload, sent again as the redundant block of the next RED packet. */
+typedef struct PeerConnectionRedEncoder
+{
+    uint8_t payload[ PEER_CONNECTION_AUDIO_RED_MAX_BLOCK_LENGTH ];
+    size_t payloadLength; /* 0 when there is nothing to repeat. */
+    uint32_t rtpTimestamp;
+} PeerConnectionRedEncoder_t;
+
+/* One block of a RED payload, https://datatracker.ietf.org/doc/html/rfc2198#section-3 */
+typedef struct PeerConnectionRedBlock
+{
+    uint8_t payloadType;
+    uint16_t timestampOffset; /* How far the block is behind the RTP timestamp of the packet, 0 for the primary block. */
+    uint8_t * pData;
+    size_t dataLength;
+} PeerConnectionRedBlock_t;
+
+/* Reception statistics of an incoming RTP stream, https://datatracker.ietf.org/doc/html/rfc3550#appendix-A.3 */
+typedef struct PeerConnectionRtpReceiverStats
+{
+    uint8_t isStarted;
+    uint32_t ssrc;
+    uint16_t maxSequenceNumber; /* The highest sequence number received. */
+    uint32_t sequenceCycles; /* The count of sequence number wraps, shifted by 16 bits. */
+    uint32_t baseSequenceNumber;
+    uint32_t packetsReceived;
+    uint32_t expectedPrior; /* Expected packets at the last report, for the fraction lost. */
+    uint32_t receivedPrior; /* Received packets at the last report, for the fraction lost. */
+    uint64_t bytesReceived;
+    uint64_t bytesReceivedPrior; /* Received bytes at the last report, for the report interval. */
+    uint32_t lastTransit; /* Relative transit time of the previous packet, in RTP timestamp units. */
+    uint32_t jitter; /* Interarrival jitter in RTP timestamp units, scaled by 16. */
+    uint32_t lastSenderReportNtp; /* Middle 32 bits of the NTP timestamp in the latest SR (LSR). */
+    uint64_t lastSenderReportTimeUs; /* Local time the latest SR was received, for DLSR. */
+} PeerConnectionRtpReceiverStats_t;
+
 typedef struct PeerConnectionSrtpReceiver
 {
     /* RTP Rx jitter buffer. */
     PeerConnectionJitterBuffer_t rxJitterBuffer;
     uint8_t frameBuffer[ PEER_CONNECTION_FRAME_BUFFER_SIZE ];
 
+    #if PEER_CONNECTION_ENABLE_RECEIVER_STATS
+    PeerConnectionRtpReceiverStats_t rxStats;
+    #endif /* PEER_CONNECTION_ENABLE_RECEIVER_STATS */
+
     OnFrameReadyCallback_t onFrameReadyCallbackFunc;
     void * pOnFrameReadyCallbackCustomContext;
 } PeerConnectionSrtpReceiver_t;
@@ -383,11 +666,17 @@ typedef void (* OnDataChannelMessageReceived_t)( PeerConnectionDataChannel_t * p
                                                  uint8_t * pMessage,
                                                  uint32_t pMessageLen );
 
+typedef void (* OnDataChannelBufferedAmountLow_t)( PeerConnectionDataChannel_t * pDataChannel,
+                                                   uint32_t bufferedAmount,
+                                                   void * pCustomData );
+
 #if ENABLE_SCTP_DATA_CHANNEL
 typedef struct PeerConnectionDataChannel
 {
     uint8_t ucChannelActive;
     uint8_t ucChannelOpen;
+    /* Set once dataChannel.channelId holds the negotiated SCTP stream ID. */
+    uint8_t ucChannelIdValid;
     char ucDataChannelName[MAX_DATA_CHANNEL_NAME_LEN + 1];
     PeerConnectionSession_t * pPeerConnection;
     SctpDataChannel_t dataChannel;
@@ -395,7 +684,12 @@ typedef struct PeerConnectionDataChannel
     void * onMessageCustomData;
     void * onOpenCustomData;
     OnDataChannelMessageReceived_t onDataChannelMessage;
-    struct PeerConnectionDataChannel * pxNext;
+    /* Fired once the buffered amount drops to bufferedAmountLowThreshold or below
+     * after a send left it above the threshold. */
+    OnDataChannelBufferedAmountLow_t onBufferedAmountLow;
+    void * pBufferedAmountLowCustomData;
+    uint32_t bufferedAmountLowThreshold;
+    volatile uint8_t ucBufferedAmountLowPending;
 } PeerConnectionDataChannel_t;
 #endif /* ENABLE_SCTP_DATA_CHANNEL */
 
@@ -455,23 +749,41 @@ typedef struct PeerConnectionSession
     uint8_t ucEnableDataChannelRemote;
     /* SCTP Session */
     SctpSession_t sctpSession;
-    /* Data channel configs */
-    PeerConnectionDataChannel_t * pDataChannels;
+    /* Data channels owned by this session. */
+    PeerConnectionDataChannel_t dataChannels[ PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER ];
     uint32_t uKvsDataChannelCount;
+    /* Open addressing index keyed by SCTP stream ID, each entry stores the
+     * dataChannels slot + 1, 0 means empty. */
+    uint8_t dataChannelIndex[ PEER_CONNECTION_SCTP_DATA_CHANNEL_INDEX_SIZE ];
     #endif /* ENABLE_SCTP_DATA_CHANNEL */
 
     PeerConnectionSrtpSender_t videoSrtpSender;
     PeerConnectionSrtpSender_t audioSrtpSender;
+    #if PEER_CONNECTION_ENABLE_AUDIO_RED
+    /* Protected by the audio sender mutex. */
+    PeerConnectionRedEncoder_t audioRedEncoder;
+    #endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
     PeerConnectionSrtpReceiver_t videoSrtpReceiver;
     PeerConnectionSrtpReceiver_t audioSrtpReceiver;
 
+    /* Smoothed round trip time in ms from receiver reports, 0 until measured. */
+    uint32_t roundTripTimeMs;
+
     TimerHandler_t rtcpAudioSenderReportTimer;
     TimerHandler_t rtcpVideoSenderReportTimer;
+    #if PEER_CONNECTION_ENABLE_RECEIVER_REPORT
+    TimerHandler_t rtcpReceiverReportTimer;
+    uint64_t lastReceiverReportTimeUs;
+    #endif /* PEER_CONNECTION_ENABLE_RECEIVER_REPORT */
     TimerHandler_t closeSessionTimer;
 
     uint64_t dtlsHandshakingTimeoutMs;
     uint64_t inactiveConnectionTimeoutMs;
 
+    /* DTLS cert/key/fingerprint used by this session, either taken from the
+     * pre-generated pool or pointing to the shared one in peer connection context. */
+    struct PeerConnectionDtlsContext * pDtlsContext;
+
     #if ENABLE_TWCC_SUPPORT
     PeerConnectionTwccMetaData_t twccMetaData;
     #endif
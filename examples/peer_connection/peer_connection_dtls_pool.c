@@ -0,0 +1,270 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "logging.h"
+#include "peer_connection_dtls_pool.h"
+
+#if PEER_CONNECTION_DTLS_CERT_POOL_SIZE > 0
+
+typedef enum PeerConnectionDtlsPoolSlotState
+{
+    PEER_CONNECTION_DTLS_POOL_SLOT_STATE_FREE = 0,
+    PEER_CONNECTION_DTLS_POOL_SLOT_STATE_GENERATING,
+    PEER_CONNECTION_DTLS_POOL_SLOT_STATE_READY,
+    PEER_CONNECTION_DTLS_POOL_SLOT_STATE_IN_USE,
+} PeerConnectionDtlsPoolSlotState_t;
+
+typedef struct PeerConnectionDtlsPool
+{
+    uint8_t isInited;
+    SemaphoreHandle_t mutex;
+    TaskHandle_t taskHandler;
+    PeerConnectionDtlsPoolSlotState_t slotStates[ PEER_CONNECTION_DTLS_CERT_POOL_SIZE ];
+    PeerConnectionDtlsContext_t slots[ PEER_CONNECTION_DTLS_CERT_POOL_SIZE ];
+} PeerConnectionDtlsPool_t;
+
+static PeerConnectionDtlsPool_t dtlsPool;
+
+static int32_t GenerateDtlsContext( PeerConnectionDtlsContext_t * pDtlsContext )
+{
+    int32_t ret = 0;
+    DtlsTransportStatus_t xNetworkStatus;
+
+    memset( pDtlsContext,
+            0,
+            sizeof( PeerConnectionDtlsContext_t ) );
+
+    xNetworkStatus = DTLS_CreateCertificateAndKey( GENERATED_CERTIFICATE_BITS,
+                                                   pdFALSE,
+                                                   &pDtlsContext->localCert,
+                                                   &pDtlsContext->localKey );
+    if( xNetworkStatus != DTLS_SUCCESS )
+    {
+        LogError( ( "Fail to DTLS_CreateCertificateAndKey, return %d", xNetworkStatus ) );
+        ret = -1;
+    }
+
+    if( ret == 0 )
+    {
+        xNetworkStatus = DTLS_CreateCertificateFingerprint( &pDtlsContext->localCert,
+                                                            pDtlsContext->localCertFingerprint,
+                                                            CERTIFICATE_FINGERPRINT_LENGTH );
+        if( xNetworkStatus != DTLS_SUCCESS )
+        {
+            LogError( ( "Fail to DTLS_CreateCertificateFingerprint, return %d", xNetworkStatus ) );
+            ( void ) DTLS_FreeCertificateAndKey( &pDtlsContext->localCert,
+                                                 &pDtlsContext->localKey );
+            ret = -2;
+        }
+    }
+
+    if( ret == 0 )
+    {
+        pDtlsContext->isInitialized = 1U;
+    }
+
+    return ret;
+}
+
+static int32_t ClaimFreeSlot( void )
+{
+    int32_t slotIndex = -1;
+    int32_t i;
+
+    if( xSemaphoreTake( dtlsPool.mutex,
+                        portMAX_DELAY ) == pdTRUE )
+    {
+        for( i = 0; i < PEER_CONNECTION_DTLS_CERT_POOL_SIZE; i++ )
+        {
+            if( dtlsPool.slotStates[ i ] == PEER_CONNECTION_DTLS_POOL_SLOT_STATE_FREE )
+            {
+                dtlsPool.slotStates[ i ] = PEER_CONNECTION_DTLS_POOL_SLOT_STATE_GENERATING;
+                slotIndex = i;
+                break;
+            }
+        }
+
+        xSemaphoreGive( dtlsPool.mutex );
+    }
+
+    return slotIndex;
+}
+
+static void PeerConnectionDtlsPool_Task( void * pParameter )
+{
+    int32_t slotIndex;
+    PeerConnectionDtlsPoolSlotState_t nextState;
+
+    ( void ) pParameter;
+
+    for( ;; )
+    {
+        slotIndex = ClaimFreeSlot();
+
+        if( slotIndex < 0 )
+        {
+            /* Pool is full, wait until a session releases its certificate. */
+            ( void ) ulTaskNotifyTake( pdTRUE,
+                                       portMAX_DELAY );
+        }
+        else
+        {
+            /* Key generation takes seconds, run it without holding the pool mutex. */
+            if( GenerateDtlsContext( &dtlsPool.slots[ slotIndex ] ) == 0 )
+            {
+                nextState = PEER_CONNECTION_DTLS_POOL_SLOT_STATE_READY;
+            }
+            else
+            {
+                nextState = PEER_CONNECTION_DTLS_POOL_SLOT_STATE_FREE;
+            }
+
+            if( xSemaphoreTake( dtlsPool.mutex,
+                                portMAX_DELAY ) == pdTRUE )
+            {
+                dtlsPool.slotStates[ slotIndex ] = nextState;
+                xSemaphoreGive( dtlsPool.mutex );
+            }
+
+            if( nextState == PEER_CONNECTION_DTLS_POOL_SLOT_STATE_FREE )
+            {
+                /* Back off before retrying a failed generation. */
+                vTaskDelay( pdMS_TO_TICKS( 1000 ) );
+            }
+            else
+            {
+                LogDebug( ( "DTLS certificate pool slot %ld is ready", slotIndex ) );
+            }
+        }
+    }
+}
+
+PeerConnectionResult_t PeerConnectionDtlsPool_Init( void )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+
+    if( dtlsPool.isInited == 0U )
+    {
+        memset( &dtlsPool,
+                0,
+                sizeof( PeerConnectionDtlsPool_t ) );
+
+        dtlsPool.mutex = xSemaphoreCreateMutex();
+        if( dtlsPool.mutex == NULL )
+        {
+            LogError( ( "Fail to create mutex for DTLS certificate pool." ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_CREATE_DTLS_POOL_MUTEX;
+        }
+
+        if( ret == PEER_CONNECTION_RESULT_OK )
+        {
+            /* Run at low priority so key generation never competes with media and ICE tasks. */
+            if( xTaskCreate( PeerConnectionDtlsPool_Task,
+                             PEER_CONNECTION_DTLS_POOL_TASK_NAME,
+                             PEER_CONNECTION_DTLS_POOL_TASK_STACK_SIZE,
+                             NULL,
+                             tskIDLE_PRIORITY + 1,
+                             &dtlsPool.taskHandler ) != pdPASS )
+            {
+                LogError( ( "xTaskCreate(%s) failed", PEER_CONNECTION_DTLS_POOL_TASK_NAME ) );
+                vSemaphoreDelete( dtlsPool.mutex );
+                dtlsPool.mutex = NULL;
+                ret = PEER_CONNECTION_RESULT_FAIL_CREATE_TASK_DTLS_POOL;
+            }
+        }
+
+        if( ret == PEER_CONNECTION_RESULT_OK )
+        {
+            dtlsPool.isInited = 1U;
+        }
+    }
+
+    return ret;
+}
+
+PeerConnectionDtlsContext_t * PeerConnectionDtlsPool_Acquire( void )
+{
+    PeerConnectionDtlsContext_t * pDtlsContext = NULL;
+    int32_t i;
+
+    if( ( dtlsPool.isInited != 0U ) &&
+        ( xSemaphoreTake( dtlsPool.mutex,
+                          portMAX_DELAY ) == pdTRUE ) )
+    {
+        for( i = 0; i < PEER_CONNECTION_DTLS_CERT_POOL_SIZE; i++ )
+        {
+            if( dtlsPool.slotStates[ i ] == PEER_CONNECTION_DTLS_POOL_SLOT_STATE_READY )
+            {
+                dtlsPool.slotStates[ i ] = PEER_CONNECTION_DTLS_POOL_SLOT_STATE_IN_USE;
+                pDtlsContext = &dtlsPool.slots[ i ];
+                break;
+            }
+        }
+
+        xSemaphoreGive( dtlsPool.mutex );
+    }
+
+    return pDtlsContext;
+}
+
+void PeerConnectionDtlsPool_Release( PeerConnectionDtlsContext_t * pDtlsContext )
+{
+    int32_t slotIndex;
+
+    if( ( dtlsPool.isInited != 0U ) &&
+        ( pDtlsContext >= &dtlsPool.slots[ 0 ] ) &&
+        ( pDtlsContext < &dtlsPool.slots[ PEER_CONNECTION_DTLS_CERT_POOL_SIZE ] ) )
+    {
+        slotIndex = ( int32_t ) ( pDtlsContext - &dtlsPool.slots[ 0 ] );
+
+        /* The slot is owned by the caller while IN_USE, free it before handing it back. */
+        ( void ) DTLS_FreeCertificateAndKey( &pDtlsContext->localCert,
+                                             &pDtlsContext->localKey );
+        pDtlsContext->isInitialized = 0U;
+
+        if( xSemaphoreTake( dtlsPool.mutex,
+                            portMAX_DELAY ) == pdTRUE )
+        {
+            dtlsPool.slotStates[ slotIndex ] = PEER_CONNECTION_DTLS_POOL_SLOT_STATE_FREE;
+            xSemaphoreGive( dtlsPool.mutex );
+        }
+
+        ( void ) xTaskNotifyGive( dtlsPool.taskHandler );
+    }
+}
+
+#else /* PEER_CONNECTION_DTLS_CERT_POOL_SIZE > 0 */
+
+PeerConnectionResult_t PeerConnectionDtlsPool_Init( void )
+{
+    return PEER_CONNECTION_RESULT_OK;
+}
+
+PeerConnectionDtlsContext_t * PeerConnectionDtlsPool_Acquire( void )
+{
+    return NULL;
+}
+
+void PeerConnectionDtlsPool_Release( PeerConnectionDtlsContext_t * pDtlsContext )
+{
+    ( void ) pDtlsContext;
+}
+
+#endif /* PEER_CONNECTION_DTLS_CERT_POOL_SIZE > 0 */
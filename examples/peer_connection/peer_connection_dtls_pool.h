@@ -0,0 +1,47 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PEER_CONNECTION_DTLS_POOL_H
+#define PEER_CONNECTION_DTLS_POOL_H
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Standard includes. */
+#include <stdint.h>
+
+#include "peer_connection_data_types.h"
+
+#define PEER_CONNECTION_DTLS_POOL_TASK_NAME "DtlsPoolTask"
+#define PEER_CONNECTION_DTLS_POOL_TASK_STACK_SIZE ( 4096 )
+
+/* Start the background task that keeps PEER_CONNECTION_DTLS_CERT_POOL_SIZE certificates ready. */
+PeerConnectionResult_t PeerConnectionDtlsPool_Init( void );
+
+/* Take a ready certificate from the pool, return NULL if none is ready yet. */
+PeerConnectionDtlsContext_t * PeerConnectionDtlsPool_Acquire( void );
+
+/* Return a certificate taken by PeerConnectionDtlsPool_Acquire(), it's freed and regenerated in background. */
+void PeerConnectionDtlsPool_Release( PeerConnectionDtlsContext_t * pDtlsContext );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PEER_CONNECTION_DTLS_POOL_H */
@@ -36,6 +36,9 @@
 #define PEER_CONNECTION_JITTER_BUFFER_DECREASE_WITH_WRAP( x, y, max ) ( PEER_CONNECTION_JITTER_BUFFER_WRAP( ( x ) - ( y ),\
                                                                                                             max ) )
 
+/* The reordering depth halves every this many milliseconds, so one late burst doesn't hold the delay up forever. */
+#define PEER_CONNECTION_JITTER_BUFFER_REORDER_HALF_LIFE_MS ( 2000 )
+
 static void DiscardPacket( PeerConnectionJitterBuffer_t * pJitterBuffer,
                            PeerConnectionJitterBufferPacket_t * pPacket );
 
@@ -125,6 +128,8 @@ static PeerConnectionResult_t ParseFramesInJitterBuffer( PeerConnectionJitterBuf
             index = PEER_CONNECTION_JITTER_BUFFER_WRAP( i,
                                                         PEER_CONNECTION_JITTER_BUFFER_MAX_ENTRY_NUM );
             pPacket = &pJitterBuffer->rtpPackets[ index ];
+            /* Continuity is judged by sequence number only. A timestamp jump without a sequence gap,
+             * e.g. the silence of Opus DTX, is played out as is rather than treated as loss. */
             if( pPacket->isPushed == 0U )
             {
                 isFrameDataContinuous = 0;
@@ -396,6 +401,103 @@ static PeerConnectionResult_t UpdateJitterBufferAddPacket( PeerConnectionJitterB
     return ret;
 }
 
+#if PEER_CONNECTION_ENABLE_RECEIVER_NACK
+static void RemoveNackEntry( PeerConnectionJitterBuffer_t * pJitterBuffer,
+                             size_t entryIndex )
+{
+    /* Shift the rest down to keep the list in sequence order. */
+    memmove( &pJitterBuffer->nackEntries[ entryIndex ],
+             &pJitterBuffer->nackEntries[ entryIndex + 1 ],
+             ( pJitterBuffer->nackEntryCount - entryIndex - 1 ) * sizeof( PeerConnectionJitterBufferNackEntry_t ) );
+    pJitterBuffer->nackEntryCount--;
+}
+
+static void UpdateNackEntries( PeerConnectionJitterBuffer_t * pJitterBuffer,
+                               PeerConnectionJitterBufferPacket_t * pPacket,
+                               uint16_t previousNewestSequenceNumber )
+{
+    size_t i;
+    uint16_t seq, gap;
+
+    /* The packet fills a gap, either reordered or retransmitted, stop asking for it. */
+    for( i = 0; i < pJitterBuffer->nackEntryCount; i++ )
+    {
+        if( pJitterBuffer->nackEntries[ i ].sequenceNumber == pPacket->sequenceNumber )
+        {
+            RemoveNackEntry( pJitterBuffer,
+                             i );
+            break;
+        }
+    }
+
+    /* The newest sequence number moved forward by more than one, everything skipped is missing. */
+    gap = ( uint16_t )( pJitterBuffer->newestReceivedSequenceNumber - previousNewestSequenceNumber );
+    if( ( pJitterBuffer->newestReceivedSequenceNumber == pPacket->sequenceNumber ) &&
+        ( gap > 1U ) &&
+        ( gap < pJitterBuffer->capacity / 2 ) )
+    {
+        seq = previousNewestSequenceNumber + 1U;
+        if( gap - 1U > PEER_CONNECTION_JITTER_BUFFER_NACK_MAX_ENTRY_NUM )
+        {
+            /* Only the latest ones have a chance to be useful. */
+            seq = ( uint16_t )( pPacket->sequenceNumber - PEER_CONNECTION_JITTER_BUFFER_NACK_MAX_ENTRY_NUM );
+        }
+
+        for( ; seq != pPacket->sequenceNumber; seq++ )
+        {
+            if( pJitterBuffer->nackEntryCount == PEER_CONNECTION_JITTER_BUFFER_NACK_MAX_ENTRY_NUM )
+            {
+                LogVerbose( ( "NACK list full, giving up seq: %u", pJitterBuffer->nackEntries[ 0 ].sequenceNumber ) );
+                RemoveNackEntry( pJitterBuffer,
+                                 0 );
+            }
+
+            pJitterBuffer->nackEntries[ pJitterBuffer->nackEntryCount ].sequenceNumber = seq;
+            pJitterBuffer->nackEntries[ pJitterBuffer->nackEntryCount ].retryCount = 0U;
+            pJitterBuffer->nackEntries[ pJitterBuffer->nackEntryCount ].nextRetryTick = pPacket->receiveTick;
+            pJitterBuffer->nackEntryCount++;
+        }
+    }
+}
+#endif /* PEER_CONNECTION_ENABLE_RECEIVER_NACK */
+
+#if PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER
+static void UpdateTolerence( PeerConnectionJitterBuffer_t * pJitterBuffer,
+                             PeerConnectionJitterBufferPacket_t * pPacket )
+{
+    uint32_t lateness = 0U;
+
+    if( pPacket->sequenceNumber != pJitterBuffer->newestReceivedSequenceNumber )
+    {
+        /* Late packet, reordered or retransmitted. */
+        lateness = pJitterBuffer->newestReceivedTimestamp - pPacket->rtpTimestamp;
+    }
+
+    pJitterBuffer->tolerenceRtpTimeStamp = PeerConnectionJitterEstimator_Update( &pJitterBuffer->estimator,
+                                                                                 ( uint32_t ) pPacket->receiveTick,
+                                                                                 lateness,
+                                                                                 pJitterBuffer->minTolerenceRtpTimeStamp,
+                                                                                 pJitterBuffer->maxTolerenceRtpTimeStamp );
+}
+
+static uint8_t HasArrivalTime( PeerConnectionJitterBufferPacket_t * pPacket )
+{
+    uint8_t hasArrivalTime = 1U;
+
+    #if PEER_CONNECTION_ENABLE_AUDIO_RED
+    /* A packet rebuilt from the redundancy of a later one never arrived by itself. */
+    if( pPacket->isRecovered != 0U )
+    {
+        hasArrivalTime = 0U;
+    }
+    #else
+    ( void ) pPacket;
+    #endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
+
+    return hasArrivalTime;
+}
+#endif /* PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER */
+
 static void DiscardPacket( PeerConnectionJitterBuffer_t * pJitterBuffer,
                            PeerConnectionJitterBufferPacket_t * pPacket )
 {
@@ -414,7 +516,8 @@ PeerConnectionResult_t PeerConnectionJitterBuffer_Create( PeerConnectionJitterBu
                                                           void * pOnFrameReadyCallbackContext,
                                                           OnJitterBufferFrameDropCallback_t onFrameDropCallbackFunc,
                                                           void * pOnFrameDropCallbackContext,
-                                                          uint32_t tolerenceBufferSec,  // buffer time in seconds
+                                                          uint32_t minDelayMs,  // buffer time bounds in milliseconds
+                                                          uint32_t maxDelayMs,
                                                           uint32_t codec,
                                                           uint32_t clockRate )
 {
@@ -442,14 +545,23 @@ PeerConnectionResult_t PeerConnectionJitterBuffer_Create( PeerConnectionJitterBu
         pJitterBuffer->newestReceivedSequenceNumber = 0xFFFF;
         pJitterBuffer->newestReceivedTimestamp = 0xFFFFFFFF;
         pJitterBuffer->oldestReceivedSequenceNumber = 0U;
-        /* Converting tolerence buffer in seconds into RTP time stamp format. */
-        pJitterBuffer->tolerenceRtpTimeStamp = tolerenceBufferSec * ( clockRate );
+        /* Converting tolerence buffer bounds in milliseconds into RTP time stamp format.
+         * Start at the upper bound until the delay adapts to what the network shows. */
+        pJitterBuffer->minTolerenceRtpTimeStamp = ( uint32_t )( ( ( uint64_t ) minDelayMs * clockRate ) / 1000U );
+        pJitterBuffer->maxTolerenceRtpTimeStamp = ( uint32_t )( ( ( uint64_t ) maxDelayMs * clockRate ) / 1000U );
+        pJitterBuffer->tolerenceRtpTimeStamp = pJitterBuffer->maxTolerenceRtpTimeStamp;
+        #if PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER
+        PeerConnectionJitterEstimator_Init( &pJitterBuffer->estimator,
+                                            ( uint32_t ) pdMS_TO_TICKS( PEER_CONNECTION_JITTER_BUFFER_REORDER_HALF_LIFE_MS ) );
+        #endif /* PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER */
 
         pJitterBuffer->onFrameReadyCallbackFunc = onFrameReadyCallbackFunc;
         pJitterBuffer->pOnFrameReadyCallbackContext = pOnFrameReadyCallbackContext;
         pJitterBuffer->onFrameDropCallbackFunc = onFrameDropCallbackFunc;
         pJitterBuffer->pOnFrameDropCallbackContext = pOnFrameDropCallbackContext;
-        LogInfo( ( "Creating jitter buffer with tolerence RTP timestamp: %lu", pJitterBuffer->tolerenceRtpTimeStamp ) );
+        LogInfo( ( "Creating jitter buffer with tolerence RTP timestamp: %lu - %lu",
+                   pJitterBuffer->minTolerenceRtpTimeStamp,
+                   pJitterBuffer->maxTolerenceRtpTimeStamp ) );
     }
 
     if( ret == PEER_CONNECTION_RESULT_OK )
@@ -633,6 +745,7 @@ PeerConnectionResult_t PeerConnectionJitterBuffer_Push( PeerConnectionJitterBuff
                                                         PeerConnectionJitterBufferPacket_t * pPacket )
 {
     PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    uint16_t previousNewestSequenceNumber = 0U;
 
     if( ( pJitterBuffer == NULL ) ||
         ( pPacket == NULL ) )
@@ -667,12 +780,32 @@ PeerConnectionResult_t PeerConnectionJitterBuffer_Push( PeerConnectionJitterBuff
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
         pPacket->isPushed = 1U;
+        previousNewestSequenceNumber = pJitterBuffer->newestReceivedSequenceNumber;
 
         /* Update variables in jitter buffer. */
         ret = UpdateJitterBufferAddPacket( pJitterBuffer,
                                            pPacket );
     }
 
+    #if PEER_CONNECTION_ENABLE_RECEIVER_NACK
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        UpdateNackEntries( pJitterBuffer,
+                           pPacket,
+                           previousNewestSequenceNumber );
+    }
+    #endif /* PEER_CONNECTION_ENABLE_RECEIVER_NACK */
+
+    #if PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( HasArrivalTime( pPacket ) != 0U ) )
+    {
+        /* Adjust the buffer time before parsing, so the expiry check uses the latest estimate. */
+        UpdateTolerence( pJitterBuffer,
+                         pPacket );
+    }
+    #endif /* PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER */
+
     if( ret != PEER_CONNECTION_RESULT_OK )
     {
         /* Remove this packet if any error happens. */
@@ -695,6 +828,128 @@ PeerConnectionResult_t PeerConnectionJitterBuffer_Push( PeerConnectionJitterBuff
     return ret;
 }
 
+#if PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER
+void PeerConnectionJitterBuffer_SetJitter( PeerConnectionJitterBuffer_t * pJitterBuffer,
+                                           uint32_t jitter )
+{
+    if( pJitterBuffer != NULL )
+    {
+        pJitterBuffer->estimator.jitter = jitter;
+    }
+}
+#endif /* PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER */
+
+#if ( PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER && PEER_CONNECTION_ENABLE_RECEIVER_NACK )
+void PeerConnectionJitterBuffer_SetNackWaitTime( PeerConnectionJitterBuffer_t * pJitterBuffer,
+                                                 uint32_t nackWaitMs )
+{
+    if( pJitterBuffer != NULL )
+    {
+        pJitterBuffer->estimator.floorRtpTimeStamp = ( uint32_t )( ( ( uint64_t ) nackWaitMs * pJitterBuffer->clockRate ) / 1000U );
+    }
+}
+#endif /* ( PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER && PEER_CONNECTION_ENABLE_RECEIVER_NACK ) */
+
+#if PEER_CONNECTION_ENABLE_AUDIO_RED
+uint8_t PeerConnectionJitterBuffer_IsPacketMissing( PeerConnectionJitterBuffer_t * pJitterBuffer,
+                                                    uint16_t rtpSeq )
+{
+    uint8_t isMissing = 0U;
+    PeerConnectionJitterBufferPacket_t * pPacket;
+
+    /* Sequence numbers before the oldest one have been popped or dropped already. */
+    if( ( pJitterBuffer != NULL ) &&
+        ( pJitterBuffer->isInit != 0U ) &&
+        ( pJitterBuffer->isStart != 0U ) &&
+        ( ( uint16_t )( rtpSeq - pJitterBuffer->oldestReceivedSequenceNumber ) < pJitterBuffer->capacity / 2 ) )
+    {
+        pPacket = &pJitterBuffer->rtpPackets[ PEER_CONNECTION_JITTER_BUFFER_WRAP( rtpSeq,
+                                                                                   PEER_CONNECTION_JITTER_BUFFER_MAX_ENTRY_NUM ) ];
+        if( ( pPacket->isPushed == 0U ) ||
+            ( pPacket->sequenceNumber != rtpSeq ) )
+        {
+            isMissing = 1U;
+        }
+    }
+
+    return isMissing;
+}
+#endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
+
+#if PEER_CONNECTION_ENABLE_RECEIVER_NACK
+PeerConnectionResult_t PeerConnectionJitterBuffer_GetNackList( PeerConnectionJitterBuffer_t * pJitterBuffer,
+                                                               TickType_t retryIntervalTicks,
+                                                               uint16_t * pSequenceNumbers,
+                                                               size_t * pSequenceNumbersCount )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    PeerConnectionJitterBufferNackEntry_t * pEntry;
+    TickType_t currentTick = xTaskGetTickCount();
+    uint16_t bufferedRange;
+    size_t i = 0, count = 0;
+
+    if( ( pJitterBuffer == NULL ) ||
+        ( pSequenceNumbers == NULL ) ||
+        ( pSequenceNumbersCount == NULL ) )
+    {
+        LogError( ( "Invalid input, pJitterBuffer: %p, pSequenceNumbers: %p, pSequenceNumbersCount: %p",
+                    pJitterBuffer, pSequenceNumbers, pSequenceNumbersCount ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+    else if( pJitterBuffer->isInit == 0U )
+    {
+        LogError( ( "Jitter buffer is not initialized yet or it has been freed." ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        bufferedRange = ( uint16_t )( pJitterBuffer->newestReceivedSequenceNumber - pJitterBuffer->oldestReceivedSequenceNumber );
+
+        while( i < pJitterBuffer->nackEntryCount )
+        {
+            pEntry = &pJitterBuffer->nackEntries[ i ];
+
+            if( ( uint16_t )( pEntry->sequenceNumber - pJitterBuffer->oldestReceivedSequenceNumber ) > bufferedRange )
+            {
+                /* The frame has been popped or dropped already, a retransmission can't help. */
+                RemoveNackEntry( pJitterBuffer,
+                                 i );
+            }
+            else if( ( ( TickType_t )( currentTick - pEntry->nextRetryTick ) <= ( portMAX_DELAY / 2 ) ) &&
+                     ( count < *pSequenceNumbersCount ) )
+            {
+                pSequenceNumbers[ count++ ] = pEntry->sequenceNumber;
+                pEntry->retryCount++;
+                pEntry->nextRetryTick = currentTick + retryIntervalTicks;
+
+                if( pEntry->retryCount >= PEER_CONNECTION_RECEIVER_NACK_MAX_RETRIES )
+                {
+                    RemoveNackEntry( pJitterBuffer,
+                                     i );
+                }
+                else
+                {
+                    i++;
+                }
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        *pSequenceNumbersCount = count;
+    }
+
+    return ret;
+}
+#endif /* PEER_CONNECTION_ENABLE_RECEIVER_NACK */
+
 PeerConnectionResult_t PeerConnectionJitterBuffer_FillFrame( PeerConnectionJitterBuffer_t * pJitterBuffer,
                                                              uint16_t rtpSeqStart,
                                                              uint16_t rtpSeqEnd,
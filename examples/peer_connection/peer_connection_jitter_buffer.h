@@ -36,7 +36,8 @@ PeerConnectionResult_t PeerConnectionJitterBuffer_Create( PeerConnectionJitterBu
                                                           void * pOnFrameReadyCallbackContext,
                                                           OnJitterBufferFrameDropCallback_t onFrameDropCallbackFunc,
                                                           void * pOnFrameDropCallbackContext,
-                                                          uint32_t tolerenceBufferSec,  // buffer time in seconds
+                                                          uint32_t minDelayMs,  // buffer time bounds in milliseconds
+                                                          uint32_t maxDelayMs,
                                                           uint32_t codec,
                                                           uint32_t clockRate );
 
@@ -54,6 +55,37 @@ PeerConnectionResult_t PeerConnectionJitterBuffer_GetPacket( PeerConnectionJitte
 PeerConnectionResult_t PeerConnectionJitterBuffer_Push( PeerConnectionJitterBuffer_t * pJitterBuffer,
                                                         PeerConnectionJitterBufferPacket_t * pPacket );
 
+#if PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER
+/* Feed the interarrival jitter of the stream, in RTP time stamp units scaled by 16 as in
+ * RFC 3550 appendix A.8. The buffer time follows it from the next push. */
+void PeerConnectionJitterBuffer_SetJitter( PeerConnectionJitterBuffer_t * pJitterBuffer,
+                                           uint32_t jitter );
+#endif /* PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER */
+
+#if ( PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER && PEER_CONNECTION_ENABLE_RECEIVER_NACK )
+/* Feed how long a NACKed packet takes to come back, in milliseconds. The buffer time doesn't
+ * adapt below it, so a retransmission still finds its frame waiting. */
+void PeerConnectionJitterBuffer_SetNackWaitTime( PeerConnectionJitterBuffer_t * pJitterBuffer,
+                                                 uint32_t nackWaitMs );
+#endif /* ( PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER && PEER_CONNECTION_ENABLE_RECEIVER_NACK ) */
+
+#if PEER_CONNECTION_ENABLE_AUDIO_RED
+/* Return 1 when the sequence number is neither buffered nor consumed yet, so a copy of it rebuilt
+ * from redundancy is still worth pushing. */
+uint8_t PeerConnectionJitterBuffer_IsPacketMissing( PeerConnectionJitterBuffer_t * pJitterBuffer,
+                                                    uint16_t rtpSeq );
+#endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
+
+#if PEER_CONNECTION_ENABLE_RECEIVER_NACK
+/* Collect the missing sequence numbers due for a NACK, in sequence order. The count is
+ * the array capacity on input and the number written on output. Each returned sequence
+ * number is scheduled again retryIntervalTicks later, until it arrives or runs out of retries. */
+PeerConnectionResult_t PeerConnectionJitterBuffer_GetNackList( PeerConnectionJitterBuffer_t * pJitterBuffer,
+                                                               TickType_t retryIntervalTicks,
+                                                               uint16_t * pSequenceNumbers,
+                                                               size_t * pSequenceNumbersCount );
+#endif /* PEER_CONNECTION_ENABLE_RECEIVER_NACK */
+
 PeerConnectionResult_t PeerConnectionJitterBuffer_FillFrame( PeerConnectionJitterBuffer_t * pJitterBuffer,
                                                              uint16_t rtpSeqStart,
                                                              uint16_t rtpSeqEnd,
@@ -0,0 +1,108 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include "peer_connection_jitter_estimator.h"
+
+/* The wait covers this many times the interarrival jitter plus the reordering depth. */
+#define PEER_CONNECTION_JITTER_ESTIMATOR_JITTER_MULTIPLIER ( 4 )
+/* After this many half-lives the reordering depth is gone whatever its peak was. */
+#define PEER_CONNECTION_JITTER_ESTIMATOR_MAX_HALF_LIVES ( 32 )
+
+void PeerConnectionJitterEstimator_Init( PeerConnectionJitterEstimator_t * pEstimator,
+                                         uint32_t reorderHalfLifeTicks )
+{
+    if( pEstimator != NULL )
+    {
+        pEstimator->jitter = 0U;
+        pEstimator->reorderPeakRtpTimeStamp = 0U;
+        pEstimator->reorderPeakTick = 0U;
+        pEstimator->reorderHalfLifeTicks = ( reorderHalfLifeTicks == 0U ) ? 1U : reorderHalfLifeTicks;
+        pEstimator->floorRtpTimeStamp = 0U;
+    }
+}
+
+uint32_t PeerConnectionJitterEstimator_GetReorderDepth( const PeerConnectionJitterEstimator_t * pEstimator,
+                                                        uint32_t tick )
+{
+    uint32_t reorder = 0U;
+    uint32_t elapsedTicks, halfLives;
+
+    if( pEstimator != NULL )
+    {
+        /* Unsigned subtraction keeps this right across a tick counter wrap. */
+        elapsedTicks = tick - pEstimator->reorderPeakTick;
+        halfLives = elapsedTicks / pEstimator->reorderHalfLifeTicks;
+
+        if( halfLives < PEER_CONNECTION_JITTER_ESTIMATOR_MAX_HALF_LIVES )
+        {
+            /* Halve once per full half-life, then interpolate linearly within the current one. */
+            reorder = pEstimator->reorderPeakRtpTimeStamp >> halfLives;
+            elapsedTicks -= halfLives * pEstimator->reorderHalfLifeTicks;
+            reorder -= ( uint32_t )( ( ( uint64_t ) reorder * elapsedTicks ) / ( 2U * ( uint64_t ) pEstimator->reorderHalfLifeTicks ) );
+        }
+    }
+
+    return reorder;
+}
+
+uint32_t PeerConnectionJitterEstimator_Update( PeerConnectionJitterEstimator_t * pEstimator,
+                                               uint32_t receiveTick,
+                                               uint32_t latenessRtpTimeStamp,
+                                               uint32_t minRtpTimeStamp,
+                                               uint32_t maxRtpTimeStamp )
+{
+    uint32_t reorder, tolerence = maxRtpTimeStamp;
+    uint64_t wait;
+
+    if( pEstimator != NULL )
+    {
+        /* Decay by the time elapsed, not by the packet count, so the depth fades at the same
+         * pace whatever the packet rate of the stream is. */
+        reorder = PeerConnectionJitterEstimator_GetReorderDepth( pEstimator,
+                                                                 receiveTick );
+
+        /* Late packet, reordered or retransmitted. Waiting this long would have caught it. */
+        if( ( latenessRtpTimeStamp <= maxRtpTimeStamp ) &&
+            ( latenessRtpTimeStamp > reorder ) )
+        {
+            pEstimator->reorderPeakRtpTimeStamp = latenessRtpTimeStamp;
+            pEstimator->reorderPeakTick = receiveTick;
+            reorder = latenessRtpTimeStamp;
+        }
+
+        wait = ( uint64_t ) PEER_CONNECTION_JITTER_ESTIMATOR_JITTER_MULTIPLIER * ( pEstimator->jitter >> 4 ) + reorder;
+        if( wait < pEstimator->floorRtpTimeStamp )
+        {
+            wait = pEstimator->floorRtpTimeStamp;
+        }
+
+        if( wait < minRtpTimeStamp )
+        {
+            tolerence = minRtpTimeStamp;
+        }
+        else if( wait > maxRtpTimeStamp )
+        {
+            tolerence = maxRtpTimeStamp;
+        }
+        else
+        {
+            tolerence = ( uint32_t ) wait;
+        }
+    }
+
+    return tolerence;
+}
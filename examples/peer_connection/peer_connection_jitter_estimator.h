@@ -0,0 +1,60 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PEER_CONNECTION_JITTER_ESTIMATOR_H
+#define PEER_CONNECTION_JITTER_ESTIMATOR_H
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Standard includes. */
+#include <stdint.h>
+
+/* Sizes the adaptive wait of a receive jitter buffer. It has no FreeRTOS dependency so the
+ * estimator can be replayed against packet traces on the host, ticks are passed in. */
+typedef struct PeerConnectionJitterEstimator
+{
+    uint32_t jitter; /* Interarrival jitter of the stream in RTP time stamp format, scaled by 16, fed from the reception statistics. */
+    uint32_t reorderPeakRtpTimeStamp; /* The latest peak of how far behind the newest timestamp late packets arrive. */
+    uint32_t reorderPeakTick; /* The tick the peak was taken at, it decays with the time elapsed since. */
+    uint32_t reorderHalfLifeTicks; /* The reordering depth halves every this many ticks. */
+    uint32_t floorRtpTimeStamp; /* The wait never adapts below this, 0 for no floor. */
+} PeerConnectionJitterEstimator_t;
+
+void PeerConnectionJitterEstimator_Init( PeerConnectionJitterEstimator_t * pEstimator,
+                                         uint32_t reorderHalfLifeTicks );
+
+/* The reordering depth at the given tick, the peak decayed by the time elapsed since it was taken. */
+uint32_t PeerConnectionJitterEstimator_GetReorderDepth( const PeerConnectionJitterEstimator_t * pEstimator,
+                                                        uint32_t tick );
+
+/* Account for a packet received at receiveTick, latenessRtpTimeStamp is how far its timestamp is behind
+ * the newest one, 0 for an in order packet. Return the wait in RTP time stamp format, within
+ * minRtpTimeStamp and maxRtpTimeStamp. Lateness beyond maxRtpTimeStamp can't be waited for and is ignored. */
+uint32_t PeerConnectionJitterEstimator_Update( PeerConnectionJitterEstimator_t * pEstimator,
+                                               uint32_t receiveTick,
+                                               uint32_t latenessRtpTimeStamp,
+                                               uint32_t minRtpTimeStamp,
+                                               uint32_t maxRtpTimeStamp );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PEER_CONNECTION_JITTER_ESTIMATOR_H */
@@ -15,11 +15,13 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include "logging.h"
 #include "peer_connection.h"
 #include "peer_connection_rolling_buffer.h"
 
 #include "FreeRTOS.h"
+#include "semphr.h"
 
 PeerConnectionResult_t PeerConnectionRollingBuffer_Create( PeerConnectionRollingBuffer_t * pRollingBuffer,
                                                            uint32_t rollingbufferBitRate,  // bps
@@ -42,6 +44,18 @@ PeerConnectionResult_t PeerConnectionRollingBuffer_Create( PeerConnectionRolling
         ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
     }
 
+    /* The rolling buffer lives in the session and is re-created per connection, keep the mutex across them. */
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( pRollingBuffer->bufferMutex == NULL ) )
+    {
+        pRollingBuffer->bufferMutex = xSemaphoreCreateMutex();
+        if( pRollingBuffer->bufferMutex == NULL )
+        {
+            LogError( ( "Fail to create mutex for rolling buffer." ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_CREATE_ROLLING_BUFFER_MUTEX;
+        }
+    }
+
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
         pRollingBuffer->maxSizePerPacket = maxSizePerPacket;
@@ -106,6 +120,16 @@ void PeerConnectionRollingBuffer_Free( PeerConnectionRollingBuffer_t * pRollingB
         /* Empty else marker. */
     }
 
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        if( xSemaphoreTake( pRollingBuffer->bufferMutex,
+                            portMAX_DELAY ) != pdTRUE )
+        {
+            LogError( ( "Fail to take rolling buffer mutex" ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_ROLLING_BUFFER_MUTEX;
+        }
+    }
+
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
         pRollingBuffer->isInit = 0U;
@@ -125,6 +149,8 @@ void PeerConnectionRollingBuffer_Free( PeerConnectionRollingBuffer_t * pRollingB
             vPortFree( pRollingBuffer->packetQueue.pRtpPacketInfoArray );
             pRollingBuffer->packetQueue.pRtpPacketInfoArray = NULL;
         }
+
+        xSemaphoreGive( pRollingBuffer->bufferMutex );
     }
 }
 
@@ -153,8 +179,8 @@ PeerConnectionResult_t PeerConnectionRollingBuffer_GetRtpSequenceBuffer( PeerCon
     }
     else
     {
-        *ppPacket = ( PeerConnectionRollingBufferPacket_t * )pvPortMalloc( sizeof( PeerConnectionRollingBufferPacket_t ) + pRollingBuffer->maxSizePerPacket );
-        ( *ppPacket )->pPacketBuffer = ( uint8_t * )( ( *ppPacket ) + 1 );
+        *ppPacket = ( PeerConnectionRollingBufferPacket_t * )pvPortMalloc( sizeof( PeerConnectionRollingBufferPacket_t ) + PEER_CONNECTION_PACKET_BUFFER_SIZE( pRollingBuffer->maxSizePerPacket ) );
+        ( *ppPacket )->pPacketBuffer = ( uint8_t * )( ( *ppPacket ) + 1 ) + PEER_CONNECTION_PACKET_HEADROOM_LENGTH;
         ( *ppPacket )->packetBufferLength = pRollingBuffer->maxSizePerPacket;
     }
 
@@ -182,27 +208,28 @@ void PeerConnectionRollingBuffer_DiscardRtpSequenceBuffer( PeerConnectionRolling
 
 PeerConnectionResult_t PeerConnectionRollingBuffer_SearchRtpSequenceBuffer( PeerConnectionRollingBuffer_t * pRollingBuffer,
                                                                             uint16_t rtpSeq,
-                                                                            PeerConnectionRollingBufferPacket_t ** ppPacket )
+                                                                            size_t dataOffset,
+                                                                            PeerConnectionRollingBufferPacket_t * pOutPacket,
+                                                                            uint8_t * pOutBuffer,
+                                                                            size_t outBufferLength )
 {
     PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
     RtpPacketQueueResult_t resultRtpPacketQueue = RTP_PACKET_QUEUE_RESULT_OK;
     RtpPacketInfo_t rtpPacketInfo;
+    PeerConnectionRollingBufferPacket_t * pStoredPacket = NULL;
+    uint8_t isLocked = 0U;
 
     if( ( pRollingBuffer == NULL ) ||
-        ( ppPacket == NULL ) )
-    {
-        LogError( ( "Invalid input, pRollingBuffer: %p, ppPacket: %p",
-                    pRollingBuffer, ppPacket ) );
-        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
-    }
-    else if( pRollingBuffer->isInit == 0U )
+        ( pOutPacket == NULL ) ||
+        ( pOutBuffer == NULL ) )
     {
-        LogWarn( ( "Rolling buffer is not initialized yet or it has been freed." ) );
+        LogError( ( "Invalid input, pRollingBuffer: %p, pOutPacket: %p, pOutBuffer: %p",
+                    pRollingBuffer, pOutPacket, pOutBuffer ) );
         ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
     }
-    else if( pRollingBuffer->capacity == 0 )
+    else if( pRollingBuffer->bufferMutex == NULL )
     {
-        LogError( ( "Rolling buffer is not initialized yet." ) );
+        LogWarn( ( "Rolling buffer is not initialized yet." ) );
         ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
     }
     else
@@ -210,6 +237,39 @@ PeerConnectionResult_t PeerConnectionRollingBuffer_SearchRtpSequenceBuffer( Peer
         /* Empty else marker. */
     }
 
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        if( xSemaphoreTake( pRollingBuffer->bufferMutex,
+                            portMAX_DELAY ) == pdTRUE )
+        {
+            isLocked = 1U;
+        }
+        else
+        {
+            LogError( ( "Fail to take rolling buffer mutex" ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_ROLLING_BUFFER_MUTEX;
+        }
+    }
+
+    /* Check the state under the lock, Free() might run in parallel. */
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        if( pRollingBuffer->isInit == 0U )
+        {
+            LogWarn( ( "Rolling buffer is not initialized yet or it has been freed." ) );
+            ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+        }
+        else if( pRollingBuffer->capacity == 0 )
+        {
+            LogError( ( "Rolling buffer is not initialized yet." ) );
+            ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+    }
+
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
         resultRtpPacketQueue = RtpPacketQueue_Retrieve( &pRollingBuffer->packetQueue,
@@ -226,8 +286,46 @@ PeerConnectionResult_t PeerConnectionRollingBuffer_SearchRtpSequenceBuffer( Peer
 
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        *ppPacket = ( PeerConnectionRollingBufferPacket_t * )rtpPacketInfo.pSerializedRtpPacket;
-        ( *ppPacket )->packetBufferLength = rtpPacketInfo.serializedPacketLength;
+        pStoredPacket = ( PeerConnectionRollingBufferPacket_t * )rtpPacketInfo.pSerializedRtpPacket;
+
+        if( dataOffset + rtpPacketInfo.serializedPacketLength > outBufferLength )
+        {
+            LogError( ( "Output buffer is too small, required: %u, outBufferLength: %u",
+                        dataOffset + rtpPacketInfo.serializedPacketLength,
+                        outBufferLength ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_ROLLING_BUFFER_COPY_TOO_SMALL;
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        /* The stored packet is freed once the buffer wraps, so hand the caller a copy
+         * instead of a pointer. Only the used bytes are copied, the writer may still be
+         * framing the newest packet in its headroom/tailroom. */
+        memcpy( pOutPacket,
+                pStoredPacket,
+                sizeof( PeerConnectionRollingBufferPacket_t ) );
+        pOutPacket->pPacketBuffer = pOutBuffer;
+        pOutPacket->packetBufferLength = rtpPacketInfo.serializedPacketLength;
+        memcpy( pOutBuffer + dataOffset,
+                pStoredPacket->pPacketBuffer + dataOffset,
+                rtpPacketInfo.serializedPacketLength );
+
+        /* Re-point the RTP packet into the copy. */
+        if( pStoredPacket->rtpPacket.header.extension.pExtensionPayload == pStoredPacket->extensionPayload )
+        {
+            pOutPacket->rtpPacket.header.extension.pExtensionPayload = pOutPacket->extensionPayload;
+        }
+
+        if( pStoredPacket->rtpPacket.pPayload != NULL )
+        {
+            pOutPacket->rtpPacket.pPayload = pOutBuffer + ( pStoredPacket->rtpPacket.pPayload - pStoredPacket->pPacketBuffer );
+        }
+    }
+
+    if( isLocked != 0U )
+    {
+        xSemaphoreGive( pRollingBuffer->bufferMutex );
     }
 
     return ret;
@@ -269,23 +367,38 @@ PeerConnectionResult_t PeerConnectionRollingBuffer_SetPacket( PeerConnectionRoll
         rtpPacket.pSerializedRtpPacket = ( uint8_t * )pPacket;
         rtpPacket.seqNum = rtpSeq;
         rtpPacket.serializedPacketLength = pPacket->packetBufferLength;
-        resultRtpPacketQueue = RtpPacketQueue_ForceEnqueue( &pRollingBuffer->packetQueue,
-                                                            &rtpPacket,
-                                                            &deletedRtpPacket );
-        if( ( resultRtpPacketQueue != RTP_PACKET_QUEUE_RESULT_OK ) && ( resultRtpPacketQueue != RTP_PACKET_QUEUE_RESULT_PACKET_DELETED ) )
+
+        if( xSemaphoreTake( pRollingBuffer->bufferMutex,
+                            portMAX_DELAY ) == pdTRUE )
         {
-            LogError( ( "Fail to enqueue RTP packet sequence number: %u with result: %d",
-                        rtpSeq,
-                        resultRtpPacketQueue ) );
-            ret = PEER_CONNECTION_RESULT_FAIL_RTP_PACKET_ENQUEUE;
+            resultRtpPacketQueue = RtpPacketQueue_ForceEnqueue( &pRollingBuffer->packetQueue,
+                                                                &rtpPacket,
+                                                                &deletedRtpPacket );
+
+            /* Release the evicted packet before unlocking, a reader might still be copying it otherwise. */
+            if( ( ( resultRtpPacketQueue == RTP_PACKET_QUEUE_RESULT_OK ) || ( resultRtpPacketQueue == RTP_PACKET_QUEUE_RESULT_PACKET_DELETED ) ) &&
+                ( deletedRtpPacket.pSerializedRtpPacket != NULL ) )
+            {
+                vPortFree( deletedRtpPacket.pSerializedRtpPacket );
+            }
+
+            xSemaphoreGive( pRollingBuffer->bufferMutex );
+        }
+        else
+        {
+            LogError( ( "Fail to take rolling buffer mutex" ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_ROLLING_BUFFER_MUTEX;
         }
     }
 
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        if( deletedRtpPacket.pSerializedRtpPacket )
+        if( ( resultRtpPacketQueue != RTP_PACKET_QUEUE_RESULT_OK ) && ( resultRtpPacketQueue != RTP_PACKET_QUEUE_RESULT_PACKET_DELETED ) )
         {
-            PeerConnectionRollingBuffer_DiscardRtpSequenceBuffer( pRollingBuffer, ( PeerConnectionRollingBufferPacket_t * ) deletedRtpPacket.pSerializedRtpPacket );
+            LogError( ( "Fail to enqueue RTP packet sequence number: %u with result: %d",
+                        rtpSeq,
+                        resultRtpPacketQueue ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_RTP_PACKET_ENQUEUE;
         }
     }
 
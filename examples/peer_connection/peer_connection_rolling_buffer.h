@@ -47,9 +47,14 @@ PeerConnectionResult_t PeerConnectionRollingBuffer_GetRtpSequenceBuffer( PeerCon
 void PeerConnectionRollingBuffer_DiscardRtpSequenceBuffer( PeerConnectionRollingBuffer_t * pRollingBuffer,
                                                            PeerConnectionRollingBufferPacket_t * pPacket );
 
+/* Copy the packet stored for rtpSeq into pOutPacket, the used bytes start at dataOffset
+ * of the stored buffer and are copied to the same offset of pOutBuffer. */
 PeerConnectionResult_t PeerConnectionRollingBuffer_SearchRtpSequenceBuffer( PeerConnectionRollingBuffer_t * pRollingBuffer,
                                                                             uint16_t rtpSeq,
-                                                                            PeerConnectionRollingBufferPacket_t ** ppPacket );
+                                                                            size_t dataOffset,
+                                                                            PeerConnectionRollingBufferPacket_t * pOutPacket,
+                                                                            uint8_t * pOutBuffer,
+                                                                            size_t outBufferLength );
 
 PeerConnectionResult_t PeerConnectionRollingBuffer_SetPacket( PeerConnectionRollingBuffer_t * pRollingBuffer,
                                                               uint16_t rtpSeq,
@@ -23,8 +23,7 @@
 #include "peer_connection_sctp.h"
 /*-----------------------------------------------------------*/
 
-static PeerConnectionDataChannel_t globalDataChannels[MAX_SCTP_DATA_CHANNELS];
-static int uKVSDataChannelCount = 0;
+#define PEER_CONNECTION_SCTP_DATA_CHANNEL_INDEX_HASH( channelId ) ( ( uint32_t ) ( channelId ) & ( PEER_CONNECTION_SCTP_DATA_CHANNEL_INDEX_SIZE - 1U ) )
 /*-----------------------------------------------------------*/
 
 static void OnSCTPSessionOutboundPacket( void * customData,
@@ -41,26 +40,72 @@ static void OnSCTPSessionDataChannelMessage( void * customData,
                                              uint32_t pMessageLen );
 static SctpUtilsResult_t OnSCTPSessionDataChannelAckOpen( void * customData,
                                                           uint16_t channelId );
+static void OnSCTPSessionSendBufferAvailable( void * customData,
+                                              uint32_t bufferedAmount );
+static void IndexDataChannel( PeerConnectionSession_t * pSession,
+                              PeerConnectionDataChannel_t * pChannel );
+static void RebuildDataChannelIndex( PeerConnectionSession_t * pSession );
 
 /*-----------------------------------------------------------*/
 
-/* Allocate a SCTP data channel from the global array of data channel */
-PeerConnectionDataChannel_t * PeerConnectionSCTP_AllocateDataChannel( void )
+/* Insert the channel into the session stream ID index with linear probing. */
+static void IndexDataChannel( PeerConnectionSession_t * pSession,
+                              PeerConnectionDataChannel_t * pChannel )
+{
+    uint32_t ulPosition = PEER_CONNECTION_SCTP_DATA_CHANNEL_INDEX_HASH( pChannel->dataChannel.channelId );
+    uint32_t ulIter;
+
+    for( ulIter = 0; ulIter < PEER_CONNECTION_SCTP_DATA_CHANNEL_INDEX_SIZE; ulIter++ )
+    {
+        if( pSession->dataChannelIndex[ ulPosition ] == 0U )
+        {
+            pSession->dataChannelIndex[ ulPosition ] = ( uint8_t ) ( pChannel - &( pSession->dataChannels[ 0 ] ) ) + 1U;
+            pChannel->ucChannelIdValid = 1U;
+            break;
+        }
+
+        ulPosition = ( ulPosition + 1U ) & ( PEER_CONNECTION_SCTP_DATA_CHANNEL_INDEX_SIZE - 1U );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Removing an entry would break the probe sequence of the ones after it,
+ * so the index is rebuilt instead. It holds only a handful of channels. */
+static void RebuildDataChannelIndex( PeerConnectionSession_t * pSession )
+{
+    uint32_t ulIter;
+
+    memset( pSession->dataChannelIndex, 0, sizeof( pSession->dataChannelIndex ) );
+
+    for( ulIter = 0; ulIter < PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER; ulIter++ )
+    {
+        if( ( pSession->dataChannels[ ulIter ].ucChannelActive != 0U ) &&
+            ( pSession->dataChannels[ ulIter ].ucChannelIdValid != 0U ) )
+        {
+            IndexDataChannel( pSession, &( pSession->dataChannels[ ulIter ] ) );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Allocate a SCTP data channel from the data channels owned by the session */
+PeerConnectionDataChannel_t * PeerConnectionSCTP_AllocateDataChannel( PeerConnectionSession_t * pSession )
 {
 
     PeerConnectionDataChannel_t * pChannel = NULL;
 
-    if( uKVSDataChannelCount < MAX_SCTP_DATA_CHANNELS )
+    if( ( pSession != NULL ) && ( pSession->uKvsDataChannelCount < PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER ) )
     {
         uint32_t ulIter = 0;
-        for(; ulIter < MAX_SCTP_DATA_CHANNELS; ulIter++ )
+        for(; ulIter < PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER; ulIter++ )
         {
-            if( globalDataChannels[ulIter].ucChannelActive == 0 )
+            if( pSession->dataChannels[ulIter].ucChannelActive == 0 )
             {
-                pChannel = &globalDataChannels[ulIter];
+                pChannel = &pSession->dataChannels[ulIter];
                 memset( pChannel, 0, sizeof( PeerConnectionDataChannel_t ) );
-                globalDataChannels[ulIter].ucChannelActive = 1;
-                uKVSDataChannelCount++;
+                pChannel->ucChannelActive = 1;
+                pChannel->pPeerConnection = pSession;
+                pSession->uKvsDataChannelCount++;
                 break;
             }
 
@@ -76,18 +121,33 @@ PeerConnectionDataChannel_t * PeerConnectionSCTP_AllocateDataChannel( void )
 PeerConnectionResult_t PeerConnectionSCTP_DeallocateDataChannel( PeerConnectionDataChannel_t * pChannel )
 {
     PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
-    if( pChannel == NULL )
+    PeerConnectionSession_t * pSession;
+
+    if( ( pChannel == NULL ) || ( pChannel->pPeerConnection == NULL ) )
     {
         LogError( ( "Invalid input, pChannel: %p", pChannel ) );
         ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
     }
-    else
+    else if( pChannel->ucChannelActive != 0U )
     {
+        pSession = pChannel->pPeerConnection;
         pChannel->ucChannelActive = 0;
-        if( uKVSDataChannelCount > 0 )
+        pChannel->ucChannelOpen = 0U;
+
+        if( pChannel->ucChannelIdValid != 0U )
         {
-            uKVSDataChannelCount--;
+            pChannel->ucChannelIdValid = 0U;
+            RebuildDataChannelIndex( pSession );
         }
+
+        if( pSession->uKvsDataChannelCount > 0 )
+        {
+            pSession->uKvsDataChannelCount--;
+        }
+    }
+    else
+    {
+        /* Empty else marker. */
     }
 
     return ret;
@@ -105,7 +165,6 @@ PeerConnectionResult_t PeerConnectionSCTP_CreateDataChannel( PeerConnectionSessi
 
     PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
     PeerConnectionDataChannel_t * pChannel;
-    PeerConnectionDataChannel_t * pxDataChannelIterator = NULL;
 
     if( ( pSession == NULL ) || ( ppChannel == NULL ) || ( pcDataChannelName == NULL ) )
     {
@@ -114,13 +173,13 @@ PeerConnectionResult_t PeerConnectionSCTP_CreateDataChannel( PeerConnectionSessi
     }
     else
     {
-        pChannel = PeerConnectionSCTP_AllocateDataChannel();
+        pChannel = PeerConnectionSCTP_AllocateDataChannel( pSession );
         if( pChannel == NULL )
         {
-            LogError( ( "No free data channel available input." ) );
+            LogError( ( "Sessions has more than PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER data channels opened." ) );
             ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
         }
-        else if( pSession->uKvsDataChannelCount < PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER )
+        else
         {
             /* Set channel name */
             strncpy( pChannel->ucDataChannelName, pcDataChannelName, MAX_DATA_CHANNEL_NAME_LEN );
@@ -138,45 +197,9 @@ PeerConnectionResult_t PeerConnectionSCTP_CreateDataChannel( PeerConnectionSessi
                 pChannel->dataChannelInitInfo.maxLifetimeInMilliseconds = 0;
                 pChannel->dataChannelInitInfo.numRetransmissions = 0;
             }
-            pChannel->pPeerConnection = pSession;
-
-            if( pSession->pDataChannels == NULL )
-            {
-                /* No other data channels are defined yet - so this is the first in the
-                 * list. */
-                pChannel->pxNext = NULL;
-                pSession->pDataChannels = pChannel;
-            }
-            else
-            {
-                pxDataChannelIterator = pSession->pDataChannels;
-                for( ; ; )
-                {
-                    if( pxDataChannelIterator == pChannel )
-                    {
-                        /* This data channel has already been added to the list. */
-                        break;
-                    }
-
-                    if( pxDataChannelIterator->pxNext == NULL )
-                    {
-                        pChannel->pxNext = NULL;
-                        pxDataChannelIterator->pxNext = pChannel;
-                        break;
-                    }
-
-                    pxDataChannelIterator = pxDataChannelIterator->pxNext;
-                }
-            }
-            pSession->uKvsDataChannelCount++;
 
             *ppChannel = pChannel;
         }
-        else
-        {
-            LogError( ( "Sessions has more than PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER data channels opened." ) );
-            ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
-        }
     }
 
     return ret;
@@ -191,6 +214,8 @@ PeerConnectionResult_t PeerConnectionSCTP_DataChannelSend( PeerConnectionDataCha
 {
     PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
     SctpSession_t * pSctpSession;
+    SctpUtilsResult_t sctpResult;
+    uint32_t bufferedAmount = 0;
 
 
     if( ( pMessage == NULL ) || ( pChannel == NULL ) )
@@ -203,11 +228,86 @@ PeerConnectionResult_t PeerConnectionSCTP_DataChannelSend( PeerConnectionDataCha
 
         pSctpSession = &( pChannel->pPeerConnection->sctpSession );
 
-        if( Sctp_SendMessage( pSctpSession, &( pChannel->dataChannel ), isBinary, pMessage, pMessageLen ) != SCTP_UTILS_RESULT_OK )
+        sctpResult = Sctp_SendMessage( pSctpSession, &( pChannel->dataChannel ), isBinary, pMessage, pMessageLen );
+        if( sctpResult == SCTP_UTILS_RESULT_WOULD_BLOCK )
+        {
+            /* Nothing was queued, the application retries after the buffered amount low callback. */
+            ret = PEER_CONNECTION_RESULT_FAIL_SCTP_WOULD_BLOCK;
+        }
+        else if( sctpResult != SCTP_UTILS_RESULT_OK )
         {
             LogError( ( "SCTP_WriteMessageSCTPSession error" ) );
             ret = PEER_CONNECTION_RESULT_FAIL_SCTP_WRITE;
         }
+        else
+        {
+            /* Empty else marker. */
+        }
+
+        if( pChannel->onBufferedAmountLow != NULL )
+        {
+            if( ret == PEER_CONNECTION_RESULT_FAIL_SCTP_WOULD_BLOCK )
+            {
+                pChannel->ucBufferedAmountLowPending = 1U;
+            }
+            else if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+                     ( Sctp_GetBufferedAmount( pSctpSession, &bufferedAmount ) == SCTP_UTILS_RESULT_OK ) &&
+                     ( bufferedAmount > pChannel->bufferedAmountLowThreshold ) )
+            {
+                pChannel->ucBufferedAmountLowPending = 1U;
+            }
+            else
+            {
+                /* Empty else marker. */
+            }
+        }
+    }
+
+    return ret;
+}
+/*-----------------------------------------------------------*/
+
+PeerConnectionResult_t PeerConnectionSCTP_DataChannelGetBufferedAmount( PeerConnectionDataChannel_t * pChannel,
+                                                                        uint32_t * pBufferedAmount )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+
+    if( ( pChannel == NULL ) || ( pChannel->pPeerConnection == NULL ) || ( pBufferedAmount == NULL ) )
+    {
+        LogError( ( "Invalid input, pChannel: %p, pBufferedAmount: %p", pChannel, pBufferedAmount ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+    else if( Sctp_GetBufferedAmount( &( pChannel->pPeerConnection->sctpSession ), pBufferedAmount ) != SCTP_UTILS_RESULT_OK )
+    {
+        ret = PEER_CONNECTION_RESULT_FAIL_SCTP_BUFFERED_AMOUNT;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    return ret;
+}
+/*-----------------------------------------------------------*/
+
+PeerConnectionResult_t PeerConnectionSCTP_SetBufferedAmountLowCallback( PeerConnectionDataChannel_t * pChannel,
+                                                                        uint32_t threshold,
+                                                                        OnDataChannelBufferedAmountLow_t onBufferedAmountLow,
+                                                                        void * pCustomData )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+
+    if( pChannel == NULL )
+    {
+        LogError( ( "Invalid input, pChannel: %p", pChannel ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+    else
+    {
+        pChannel->ucBufferedAmountLowPending = 0U;
+        pChannel->bufferedAmountLowThreshold = threshold;
+        pChannel->pBufferedAmountLowCustomData = pCustomData;
+        pChannel->onBufferedAmountLow = onBufferedAmountLow;
     }
 
     return ret;
@@ -262,16 +362,24 @@ PeerConnectionResult_t PeerConnectionSCTP_AllocateSCTP( PeerConnectionSession_t
     pSession->sctpSession.sctpSessionCallbacks.dataChannelMessageCallback = OnSCTPSessionDataChannelMessage;
     pSession->sctpSession.sctpSessionCallbacks.dataChannelOpenCallback = OnSCTPSessionDataChannelOpen;
     pSession->sctpSession.sctpSessionCallbacks.dataChannelOpenAckCallback = OnSCTPSessionDataChannelAckOpen;
+    pSession->sctpSession.sctpSessionCallbacks.sendBufferAvailableCallback = OnSCTPSessionSendBufferAvailable;
     pSession->sctpSession.sctpSessionCallbacks.pUserData = ( void * ) pSession;
 
     if( Sctp_CreateSession( &( pSession->sctpSession ), pSession->dtlsSession.isServer ) == SCTP_UTILS_RESULT_OK )
     {
         uint32_t ulChannelsCreateFailed = 0;
-        PeerConnectionDataChannel_t * pxIterator = pSession->pDataChannels;
+        uint32_t ulIter;
+        PeerConnectionDataChannel_t * pxIterator;
 
         /* Create the data channels initialized by the application, if any */
-        while( pxIterator != NULL )
+        for( ulIter = 0; ulIter < PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER; ulIter++ )
         {
+            pxIterator = &( pSession->dataChannels[ ulIter ] );
+            if( pxIterator->ucChannelActive == 0U )
+            {
+                continue;
+            }
+
             pxIterator->dataChannelInitInfo.pChannelName = &( pxIterator->ucDataChannelName[ 0 ] );
             pxIterator->dataChannelInitInfo.channelNameLen = strlen( pxIterator->ucDataChannelName );
 
@@ -284,6 +392,8 @@ PeerConnectionResult_t PeerConnectionSCTP_AllocateSCTP( PeerConnectionSession_t
             }
             else
             {
+                IndexDataChannel( pSession, pxIterator );
+
                 #if DATACHANNEL_CUSTOM_CALLBACK_HOOK
                 {
                     pxIterator->onDataChannelMessage = PeerConnectionSCTP_SetChannelOnMessageCallbackHook( \
@@ -296,7 +406,6 @@ PeerConnectionResult_t PeerConnectionSCTP_AllocateSCTP( PeerConnectionSession_t
                 }
                 #endif /* DATACHANNEL_CUSTOM_CALLBACK_HOOK */
             }
-            pxIterator = pxIterator->pxNext;
         }
 
         if( ulChannelsCreateFailed == 0 )
@@ -330,19 +439,30 @@ void PeerConnectionSCTP_ProcessSCTPData( PeerConnectionSession_t * pSession,
 PeerConnectionDataChannel_t * pxGetDataChannelWithID( PeerConnectionSession_t * pSession,
                                                       uint32_t channelId )
 {
-    PeerConnectionDataChannel_t * pxIterator;
+    PeerConnectionDataChannel_t * pChannel = NULL;
+    uint32_t ulPosition = PEER_CONNECTION_SCTP_DATA_CHANNEL_INDEX_HASH( channelId );
+    uint32_t ulIter;
+    uint8_t ucSlot;
 
-    pxIterator = pSession->pDataChannels;
-    while( pxIterator != NULL )
+    for( ulIter = 0; ulIter < PEER_CONNECTION_SCTP_DATA_CHANNEL_INDEX_SIZE; ulIter++ )
     {
-        if( pxIterator->dataChannel.channelId == channelId )
+        ucSlot = pSession->dataChannelIndex[ ulPosition ];
+        if( ucSlot == 0U )
         {
+            /* An empty entry ends the probe sequence. */
             break;
         }
-        pxIterator = pxIterator->pxNext;
+
+        if( pSession->dataChannels[ ucSlot - 1U ].dataChannel.channelId == channelId )
+        {
+            pChannel = &( pSession->dataChannels[ ucSlot - 1U ] );
+            break;
+        }
+
+        ulPosition = ( ulPosition + 1U ) & ( PEER_CONNECTION_SCTP_DATA_CHANNEL_INDEX_SIZE - 1U );
     }
 
-    return pxIterator;
+    return pChannel;
 }
 
 /*-----------------------------------------------------------*/
@@ -404,6 +524,37 @@ static void OnSCTPSessionDataChannelMessage( void * customData,
 }
 /*-----------------------------------------------------------*/
 
+/* Acknowledged data freed space in the SCTP send buffer, notify the channels
+ * waiting for their buffered amount to go low. */
+static void OnSCTPSessionSendBufferAvailable( void * customData,
+                                              uint32_t bufferedAmount )
+{
+    PeerConnectionSession_t * pPeerConnectionSession = ( PeerConnectionSession_t * ) customData;
+    PeerConnectionDataChannel_t * pChannel;
+    uint32_t ulIter;
+
+    if( customData == NULL )
+    {
+        LogError( ( "No context found" ) );
+        return;
+    }
+
+    for( ulIter = 0; ulIter < PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER; ulIter++ )
+    {
+        pChannel = &( pPeerConnectionSession->dataChannels[ ulIter ] );
+
+        if( ( pChannel->ucChannelActive != 0U ) &&
+            ( pChannel->ucBufferedAmountLowPending != 0U ) &&
+            ( pChannel->onBufferedAmountLow != NULL ) &&
+            ( bufferedAmount <= pChannel->bufferedAmountLowThreshold ) )
+        {
+            pChannel->ucBufferedAmountLowPending = 0U;
+            pChannel->onBufferedAmountLow( pChannel, bufferedAmount, pChannel->pBufferedAmountLowCustomData );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
 /* Callback function sets data channel to open when there is a valid
  * incoming DCEP DATA_CHANNEL_ACK Message from the remote. */
 static SctpUtilsResult_t OnSCTPSessionDataChannelAckOpen( void * customData,
@@ -439,20 +590,17 @@ static void OnSCTPSessionDataChannelOpen( void * customData,
     PeerConnectionSession_t * pPeerConnectionSession = ( PeerConnectionSession_t * ) customData;
     PeerConnectionDataChannel_t * pChannel = NULL;
 
-    if( ( pPeerConnectionSession == NULL ) || ( ( uKVSDataChannelCount >= MAX_SCTP_DATA_CHANNELS ) ) )
+    if( pPeerConnectionSession == NULL )
     {
-        LogError( ( "No context found or not enough data channel remaining" ) );
+        LogError( ( "No context found" ) );
         return;
     }
 
-    if( ( pPeerConnectionSession->uKvsDataChannelCount < PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER ) \
-        && ( ( pChannel = PeerConnectionSCTP_AllocateDataChannel() ) != NULL ) )
+    if( ( pChannel = PeerConnectionSCTP_AllocateDataChannel( pPeerConnectionSession ) ) != NULL )
     {
-        PeerConnectionDataChannel_t * pxIterator = NULL;
-
-        strncpy( ( pChannel->ucDataChannelName ), ( char * ) pName, nameLen );
-        pChannel->pPeerConnection = pPeerConnectionSession;
+        strncpy( ( pChannel->ucDataChannelName ), ( char * ) pName, nameLen < MAX_DATA_CHANNEL_NAME_LEN ? nameLen : MAX_DATA_CHANNEL_NAME_LEN );
         pChannel->dataChannel.channelId = channelId;
+        IndexDataChannel( pPeerConnectionSession, pChannel );
 
         #if DATACHANNEL_CUSTOM_CALLBACK_HOOK
         {
@@ -465,41 +613,10 @@ static void OnSCTPSessionDataChannelOpen( void * customData,
         #endif /* DATACHANNEL_CUSTOM_CALLBACK_HOOK */
 
         pChannel->ucChannelOpen = 1U;
-
-        if( pPeerConnectionSession->pDataChannels == NULL )
-        {
-            /* No other data channels are defined yet - so this is the first in the
-             * list. */
-            pChannel->pxNext = NULL;
-            pPeerConnectionSession->pDataChannels = pChannel;
-        }
-        else
-        {
-            pxIterator = pPeerConnectionSession->pDataChannels;
-            for( ; ; )
-            {
-                if( pxIterator == pChannel )
-                {
-                    /* This data channel has already been added to the list. */
-                    break;
-                }
-
-                if( pxIterator->pxNext == NULL )
-                {
-                    pChannel->pxNext = NULL;
-                    pxIterator->pxNext = pChannel;
-                    break;
-                }
-
-                pxIterator = pxIterator->pxNext;
-            }
-        }
-
-        pPeerConnectionSession->uKvsDataChannelCount++;
     }
     else
     {
-        LogError( ( "All %d data channel handles are open, no free handles available", MAX_SCTP_DATA_CHANNELS ) );
+        LogError( ( "All %d data channel handles of this session are open, no free handles available", PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER ) );
     }
 
 }
@@ -516,38 +633,6 @@ PeerConnectionResult_t PeerConnectionSCTP_CloseDataChannel( PeerConnectionDataCh
     }
     else
     {
-
-        PeerConnectionDataChannel_t * pxIterator = pPeerConnectionSession->pDataChannels;
-        PeerConnectionDataChannel_t * pxPrev = NULL;
-
-        pChannel->ucChannelOpen = 0U;
-        while( pxIterator != NULL )
-        {
-            if( pxIterator == pChannel )
-            {
-                break;
-            }
-            pxPrev = pxIterator;
-            pxIterator = pxIterator->pxNext;
-        }
-
-        if( pxIterator != NULL )
-        {
-            if( pxPrev == NULL )
-            {
-                pPeerConnectionSession->pDataChannels = pxIterator->pxNext;
-            }
-            else
-            {
-                pxPrev->pxNext = pxIterator->pxNext;
-            }
-
-            if( pPeerConnectionSession->uKvsDataChannelCount > 0 )
-            {
-                pPeerConnectionSession->uKvsDataChannelCount--;
-            }
-        }
-
         ret = PeerConnectionSCTP_DeallocateDataChannel( pChannel );
     }
     return ret;
@@ -558,16 +643,19 @@ PeerConnectionResult_t PeerConnectionSCTP_CloseDataChannel( PeerConnectionDataCh
 PeerConnectionResult_t PeerConnectionSCTP_DeallocateSCTP( PeerConnectionSession_t * pSession )
 {
     PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
-    PeerConnectionDataChannel_t * pxIterator = pSession->pDataChannels;
+    uint32_t ulIter;
 
-    while( pxIterator != NULL )
+    for( ulIter = 0; ulIter < PEER_CONNECTION_MAX_SCTP_DATA_CHANNELS_PER_PEER; ulIter++ )
     {
-        Sctp_CloseDataChannel( &( pSession->sctpSession ), &( pxIterator->dataChannel ) );
-        PeerConnectionSCTP_DeallocateDataChannel( pxIterator );
-        pxIterator = pxIterator->pxNext;
+        if( pSession->dataChannels[ ulIter ].ucChannelActive != 0U )
+        {
+            Sctp_CloseDataChannel( &( pSession->sctpSession ), &( pSession->dataChannels[ ulIter ].dataChannel ) );
+            PeerConnectionSCTP_DeallocateDataChannel( &( pSession->dataChannels[ ulIter ] ) );
+        }
     }
 
-    pSession->pDataChannels = NULL;
+    memset( pSession->dataChannelIndex, 0, sizeof( pSession->dataChannelIndex ) );
+    pSession->uKvsDataChannelCount = 0;
 
     if( Sctp_FreeSession( &( pSession->sctpSession ) ) != SCTP_UTILS_RESULT_OK )
     {
@@ -37,7 +37,7 @@ extern "C" {
 
 #define MASTER_DATA_CHANNEL_MESSAGE "This message is from the FreeRTOS-WebRTC-Application KVS Master"
 
-PeerConnectionDataChannel_t * PeerConnectionSCTP_AllocateDataChannel( void );
+PeerConnectionDataChannel_t * PeerConnectionSCTP_AllocateDataChannel( PeerConnectionSession_t * pSession );
 
 PeerConnectionResult_t PeerConnectionSCTP_DeallocateDataChannel( PeerConnectionDataChannel_t * pChannel );
 
@@ -53,6 +53,21 @@ PeerConnectionResult_t PeerConnectionSCTP_DataChannelSend( PeerConnectionDataCha
                                                            uint8_t * pMessage,
                                                            uint32_t pMessageLen );
 
+/* Bytes queued in the SCTP send buffer. The buffer is shared by all data channels
+ * of the session, so the amount covers every channel of the peer connection. */
+PeerConnectionResult_t PeerConnectionSCTP_DataChannelGetBufferedAmount( PeerConnectionDataChannel_t * pChannel,
+                                                                        uint32_t * pBufferedAmount );
+
+/* Register a callback fired from the SCTP stack context once the buffered amount drops
+ * to threshold or below, after a send left it above threshold or returned
+ * PEER_CONNECTION_RESULT_FAIL_SCTP_WOULD_BLOCK. The stack only reports drops below
+ * SCTP_SEND_BUFFER_SIZE - SCTP_SEND_BUFFER_WAKEUP_THRESHOLD, larger thresholds behave as that value.
+ * The callback must not block. Pass NULL to unregister. */
+PeerConnectionResult_t PeerConnectionSCTP_SetBufferedAmountLowCallback( PeerConnectionDataChannel_t * pChannel,
+                                                                        uint32_t threshold,
+                                                                        OnDataChannelBufferedAmountLow_t onBufferedAmountLow,
+                                                                        void * pCustomData );
+
 PeerConnectionResult_t PeerConnectionSCTP_AllocateSCTP( PeerConnectionSession_t * pSession );
 
 PeerConnectionResult_t PeerConnectionSCTP_DeallocateSCTP( PeerConnectionSession_t * pSession );
@@ -100,7 +100,7 @@
 #define PEER_CONNECTION_SDP_MEDIA_ATTRIBUTE_NAME_CANDIDATE_LENGTH ( 9 )
 
 #define PEER_CONNECTION_SDP_MEDIA_ATTRIBUTE_VALUE_FMTP_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION "level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=42e01f"
-#define PEER_CONNECTION_SDP_MEDIA_ATTRIBUTE_VALUE_FMTP_OPUS "minptime=10;useinbandfec=1"
+#define PEER_CONNECTION_SDP_MEDIA_ATTRIBUTE_VALUE_FMTP_OPUS "minptime=10;useinbandfec=1;usedtx=1"
 #define PEER_CONNECTION_SDP_MEDIA_ATTRIBUTE_VALUE_FMTP_H265 "profile-space=0;profile-id=0;tier-flag=0;level-id=0;interop-constraints=000000000000;sprop-vps=QAEMAf//" \
                                                             "AIAAAAMAAAMAAAMAAAMAALUCQA==;sprop-sps=QgEBAIAAAAMAAAMAAAMAAAMAAKACgIAtH+W1kkbQzkkktySqSfKSyA==;sprop-pps=RAHBpVgeSA=="
 
@@ -150,6 +150,8 @@
 #define PEER_CONNECTION_SDP_CODEC_ALAW_VALUE_LENGTH ( 9 )
 #define PEER_CONNECTION_SDP_CODEC_RTX_VALUE "rtx/90000"
 #define PEER_CONNECTION_SDP_CODEC_RTX_VALUE_LENGTH ( 9 )
+#define PEER_CONNECTION_SDP_CODEC_RED_VALUE "red/"
+#define PEER_CONNECTION_SDP_CODEC_RED_VALUE_LENGTH ( 4 )
 #define PEER_CONNECTION_SDP_CODEC_APT_VALUE "apt="
 #define PEER_CONNECTION_SDP_CODEC_APT_VALUE_LENGTH ( 4 )
 
@@ -158,23 +160,24 @@
 #define PEER_CONNECTION_SDP_CODEC_ALAW_DEFAULT_INDEX "8"
 #define PEER_CONNECTION_SDP_CODEC_ALAW_DEFAULT_INDEX_LENGTH ( 1 )
 
-static SdpControllerAttributes_t * FindH264FmtpAttribute( SdpControllerAttributes_t * pAttributes,
-                                                          uint8_t attributeCount,
-                                                          SdpControllerAttributes_t * pTargetRtpmapAttribute )
+static const SdpControllerAttributes_t * FindH264FmtpAttribute( const SdpControllerMediaDescription_t * pMediaDescription,
+                                                                const SdpControllerAttributes_t * pTargetRtpmapAttribute )
 {
     const char * pCodecStart = NULL;
     size_t codecStringLength = 0;
-    int i;
-    SdpControllerAttributes_t * pTargetFmtpAttribute = NULL;
+    uint32_t payloadType = 0;
+    const SdpControllerAttributes_t * pTargetFmtpAttribute = NULL;
 
-    if( pAttributes && pTargetRtpmapAttribute )
+    if( pMediaDescription && pTargetRtpmapAttribute )
     {
         /* Find the corresponding codec payload from target RTPMAP attribute. */
         pCodecStart = pTargetRtpmapAttribute->pAttributeValue;
         while( pCodecStart && codecStringLength < pTargetRtpmapAttribute->attributeValueLength )
         {
-            if( ( pCodecStart[ codecStringLength ] >= '0' ) && ( pCodecStart[ codecStringLength ] <= '9' ) )
+            if( ( pCodecStart[ codecStringLength ] >= '0' ) && ( pCodecStart[ codecStringLength ] <= '9' ) &&
+                ( payloadType < SDP_CONTROLLER_PAYLOAD_TYPE_INDEX_SIZE ) )
             {
+                payloadType = payloadType * 10 + ( pCodecStart[ codecStringLength ] - '0' );
                 codecStringLength++;
             }
             else
@@ -183,27 +186,19 @@ static SdpControllerAttributes_t * FindH264FmtpAttribute( SdpControllerAttribute
             }
         }
 
-        /* Find corresonding fmtp attribute. */
-        if( codecStringLength )
+        /* Find corresonding fmtp attribute from the index built while deserializing. */
+        if( codecStringLength &&
+            ( payloadType < SDP_CONTROLLER_PAYLOAD_TYPE_INDEX_SIZE ) &&
+            ( pMediaDescription->fmtpIndex[ payloadType ] != 0U ) )
         {
-            for( i = 0; i < attributeCount; i++ )
-            {
-                if( ( pAttributes[i].attributeNameLength == PEER_CONNECTION_SDP_MEDIA_ATTRIBUTE_NAME_FMTP_LENGTH ) &&
-                    ( strncmp( PEER_CONNECTION_SDP_MEDIA_ATTRIBUTE_NAME_FMTP, pAttributes[i].pAttributeName, PEER_CONNECTION_SDP_MEDIA_ATTRIBUTE_NAME_FMTP_LENGTH ) == 0 ) &&
-                    ( pAttributes[i].attributeValueLength >= codecStringLength ) &&
-                    ( strncmp( pCodecStart, pAttributes[i].pAttributeValue, codecStringLength ) == 0 ) )
-                {
-                    /* Found the fmtp. */
-                    pTargetFmtpAttribute = &pAttributes[i];
-                }
-            }
+            pTargetFmtpAttribute = &pMediaDescription->attributes[ pMediaDescription->fmtpIndex[ payloadType ] - 1U ];
         }
     }
 
     return pTargetFmtpAttribute;
 }
 
-static uint32_t CalculateH264ScoreByFmtp( SdpControllerAttributes_t * pTargetFmtpAttribute )
+static uint32_t CalculateH264ScoreByFmtp( const SdpControllerAttributes_t * pTargetFmtpAttribute )
 {
     uint32_t score = 0;
     const char * pProfileLevelIdStart = NULL;
@@ -262,14 +257,15 @@ static uint32_t CalculateH264ScoreByFmtp( SdpControllerAttributes_t * pTargetFmt
     return score;
 }
 
-static uint32_t CollectAttributesCodec( SdpControllerAttributes_t * pAttributes,
-                                        uint8_t attributeCount,
+static uint32_t CollectAttributesCodec( SdpControllerMediaDescription_t * pMediaDescription,
                                         uint32_t codecPayloads[TRANSCEIVER_RTC_CODEC_NUM] )
 {
+    SdpControllerAttributes_t * pAttributes = pMediaDescription->attributes;
+    uint8_t attributeCount = pMediaDescription->mediaAttributesCount;
     uint32_t codecBitMap = 0, h264Score = 0, highestH264Score = 0;
     int i, j;
     StringUtilsResult_t stringResult;
-    SdpControllerAttributes_t * pH264FmtpAttribute = NULL;
+    const SdpControllerAttributes_t * pH264FmtpAttribute = NULL;
     const char * pAtp = NULL;
     size_t stringLength;
     uint32_t rtxPayload;
@@ -292,7 +288,7 @@ static uint32_t CollectAttributesCodec( SdpControllerAttributes_t * pAttributes,
                 if( ( highestH264Score < PEER_CONNECTION_SDP_H264_FMTP_HIGHEST_SCORE ) && ( pAttributes[i].attributeValueLength >= PEER_CONNECTION_SDP_CODEC_H264_VALUE_LENGTH ) &&
                     ( strncmp( PEER_CONNECTION_SDP_CODEC_H264_VALUE, pAttributes[i].pAttributeValue + pAttributes[i].attributeValueLength - PEER_CONNECTION_SDP_CODEC_H264_VALUE_LENGTH, PEER_CONNECTION_SDP_CODEC_H264_VALUE_LENGTH ) == 0 ) )
                 {
-                    pH264FmtpAttribute = FindH264FmtpAttribute( pAttributes, attributeCount, &pAttributes[i] );
+                    pH264FmtpAttribute = FindH264FmtpAttribute( pMediaDescription, &pAttributes[i] );
                     h264Score = CalculateH264ScoreByFmtp( pH264FmtpAttribute );
                     if( ( h264Score >= PEER_CONNECTION_SDP_H264_FMTP_MINIMUM_SCORE ) && ( highestH264Score < h264Score ) )
                     {
@@ -532,8 +528,7 @@ static PeerConnectionResult_t GetPayloadTypesFromMedia( SdpControllerMediaDescri
         } while( pEnd != NULL );
 
         /* Find proper codec bit map by looking for rtpmap. */
-        *pCodecBitMap |= CollectAttributesCodec( pMediaDescription->attributes,
-                                                 pMediaDescription->mediaAttributesCount,
+        *pCodecBitMap |= CollectAttributesCodec( pMediaDescription,
                                                  codecPayloads );
         LogDebug( ( "Scanned codec from remote media description, *pCodecBitMap: 0x%lx", *pCodecBitMap ) );
     }
@@ -541,6 +536,73 @@ static PeerConnectionResult_t GetPayloadTypesFromMedia( SdpControllerMediaDescri
     return ret;
 }
 
+#if PEER_CONNECTION_ENABLE_AUDIO_RED
+static size_t ParsePayloadType( const char * pValue,
+                                size_t valueLength,
+                                uint32_t * pPayloadType )
+{
+    size_t digitsLength = 0;
+
+    *pPayloadType = 0;
+    while( ( digitsLength < valueLength ) &&
+           ( pValue[ digitsLength ] >= '0' ) && ( pValue[ digitsLength ] <= '9' ) &&
+           ( *pPayloadType < SDP_CONTROLLER_PAYLOAD_TYPE_INDEX_SIZE ) )
+    {
+        *pPayloadType = *pPayloadType * 10 + ( pValue[ digitsLength ] - '0' );
+        digitsLength++;
+    }
+
+    return digitsLength;
+}
+
+static uint32_t FindRedPayload( const SdpControllerMediaDescription_t * pMediaDescription,
+                                uint32_t primaryPayload )
+{
+    const SdpControllerAttributes_t * pAttributes = pMediaDescription->attributes;
+    const SdpControllerAttributes_t * pFmtpAttribute = NULL;
+    uint32_t redPayload = 0;
+    uint32_t payload;
+    uint32_t blockPayload;
+    size_t digitsLength;
+    int i;
+
+    for( i = 0; ( i < pMediaDescription->mediaAttributesCount ) && ( redPayload == 0 ); i++ )
+    {
+        /* rtpmap: ${red} red/${clock rate} */
+        if( ( pAttributes[i].attributeNameLength == PEER_CONNECTION_SDP_MEDIA_ATTRIBUTE_NAME_RTPMAP_LENGTH ) &&
+            ( strncmp( PEER_CONNECTION_SDP_MEDIA_ATTRIBUTE_NAME_RTPMAP, pAttributes[i].pAttributeName, PEER_CONNECTION_SDP_MEDIA_ATTRIBUTE_NAME_RTPMAP_LENGTH ) == 0 ) )
+        {
+            digitsLength = ParsePayloadType( pAttributes[i].pAttributeValue,
+                                             pAttributes[i].attributeValueLength,
+                                             &payload );
+            if( ( digitsLength > 0 ) &&
+                ( payload < SDP_CONTROLLER_PAYLOAD_TYPE_INDEX_SIZE ) &&
+                ( pAttributes[i].attributeValueLength >= digitsLength + 1 + PEER_CONNECTION_SDP_CODEC_RED_VALUE_LENGTH ) &&
+                ( strncmp( PEER_CONNECTION_SDP_CODEC_RED_VALUE, pAttributes[i].pAttributeValue + digitsLength + 1, PEER_CONNECTION_SDP_CODEC_RED_VALUE_LENGTH ) == 0 ) &&
+                ( pMediaDescription->fmtpIndex[ payload ] != 0U ) )
+            {
+                /* fmtp: ${red} ${codec}/${codec}, RED is only used when it carries the primary codec. */
+                pFmtpAttribute = &pAttributes[ pMediaDescription->fmtpIndex[ payload ] - 1U ];
+                digitsLength = ParsePayloadType( pFmtpAttribute->pAttributeValue,
+                                                 pFmtpAttribute->attributeValueLength,
+                                                 &blockPayload );
+                if( ( digitsLength > 0 ) &&
+                    ( pFmtpAttribute->attributeValueLength > digitsLength + 1 ) &&
+                    ( ParsePayloadType( pFmtpAttribute->pAttributeValue + digitsLength + 1,
+                                        pFmtpAttribute->attributeValueLength - digitsLength - 1,
+                                        &blockPayload ) > 0 ) &&
+                    ( blockPayload == primaryPayload ) )
+                {
+                    redPayload = payload;
+                }
+            }
+        }
+    }
+
+    return redPayload;
+}
+#endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
+
 static PeerConnectionResult_t SetPayloadType( PeerConnectionSession_t * pSession,
                                               SdpControllerMediaDescription_t * pMediaDescription,
                                               const uint32_t * pCodecBitMap,
@@ -736,6 +798,16 @@ static PeerConnectionResult_t SetPayloadType( PeerConnectionSession_t * pSession
         {
             LogWarn( ( "Unable to set payload type, mediaCodecBitMap: 0x%lx", *pCodecBitMap ) );
         }
+
+        #if PEER_CONNECTION_ENABLE_AUDIO_RED
+        if( ( trackKind == TRANSCEIVER_TRACK_KIND_AUDIO ) &&
+            ( *pIsTargetCodecPayloadSet == 1 ) )
+        {
+            pSession->rtpConfig.audioCodecRedPayload = FindRedPayload( pMediaDescription,
+                                                                       *pTargetCodecPayload );
+            LogDebug( ( "Audio RED payload: %lu", pSession->rtpConfig.audioCodecRedPayload ) );
+        }
+        #endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
     }
 
     return ret;
@@ -762,27 +834,36 @@ static PeerConnectionResult_t PopulateMediaDescriptions( PeerConnectionSession_t
     populateConfiguration.pPassword = pSession->pCtx->localPassword;
     populateConfiguration.passwordLength = strlen( pSession->pCtx->localPassword );
 
-    populateConfiguration.pLocalFingerprint = pSession->pCtx->dtlsContext.localCertFingerprint;
+    populateConfiguration.pLocalFingerprint = pSession->pDtlsContext->localCertFingerprint;
     populateConfiguration.localFingerprintLength = CERTIFICATE_FINGERPRINT_LENGTH;
 
     if( pRemoteBufferSessionDescription == NULL )
     {
         /* Populating SDP offer. */
         populateConfiguration.isOffer = 1U;
-        populateConfiguration.twccExtId = 0U;
+        populateConfiguration.rtpExtensionIds[ SDP_CONTROLLER_RTP_EXTENSION_TWCC ] = 0U;
+        #if PEER_CONNECTION_ENABLE_ABS_SEND_TIME_EXTENSION
+        populateConfiguration.rtpExtensionIds[ SDP_CONTROLLER_RTP_EXTENSION_ABS_SEND_TIME ] = PEER_CONNECTION_ABS_SEND_TIME_EXTENSION_LOCAL_ID;
+        #endif /* PEER_CONNECTION_ENABLE_ABS_SEND_TIME_EXTENSION */
 
         for( i = 0; i < pSession->transceiverCount; i++ )
         {
             populateConfiguration.pTransceiver = pSession->pTransceivers[i];
+            populateConfiguration.rtpExtensionIds[ SDP_CONTROLLER_RTP_EXTENSION_PLAYOUT_DELAY ] = 0U;
             if( populateConfiguration.pTransceiver->trackKind == TRANSCEIVER_TRACK_KIND_VIDEO )
             {
                 populateConfiguration.payloadType = pSession->rtpConfig.videoCodecPayload;
                 populateConfiguration.rtxPayloadType = pSession->rtpConfig.videoCodecRtxPayload;
+                populateConfiguration.redPayloadType = 0;
+                #if PEER_CONNECTION_ENABLE_PLAYOUT_DELAY_EXTENSION
+                populateConfiguration.rtpExtensionIds[ SDP_CONTROLLER_RTP_EXTENSION_PLAYOUT_DELAY ] = PEER_CONNECTION_PLAYOUT_DELAY_EXTENSION_LOCAL_ID;
+                #endif /* PEER_CONNECTION_ENABLE_PLAYOUT_DELAY_EXTENSION */
             }
             else
             {
                 populateConfiguration.payloadType = pSession->rtpConfig.audioCodecPayload;
                 populateConfiguration.rtxPayloadType = pSession->rtpConfig.audioCodecRtxPayload;
+                populateConfiguration.redPayloadType = pSession->rtpConfig.audioCodecRedPayload;
             }
 
             retSdpController = SdpController_PopulateSingleMedia( NULL,
@@ -839,20 +920,29 @@ static PeerConnectionResult_t PopulateMediaDescriptions( PeerConnectionSession_t
     {
         /* Populating SDP answer. */
         populateConfiguration.isOffer = 0U;
-        populateConfiguration.twccExtId = pSession->remoteSessionDescription.sdpDescription.quickAccess.twccExtId;
+        populateConfiguration.rtpExtensionIds[ SDP_CONTROLLER_RTP_EXTENSION_TWCC ] = pSession->remoteSessionDescription.sdpDescription.quickAccess.rtpExtensionIds[ SDP_CONTROLLER_RTP_EXTENSION_TWCC ];
+        #if PEER_CONNECTION_ENABLE_ABS_SEND_TIME_EXTENSION
+        populateConfiguration.rtpExtensionIds[ SDP_CONTROLLER_RTP_EXTENSION_ABS_SEND_TIME ] = pSession->remoteSessionDescription.sdpDescription.quickAccess.rtpExtensionIds[ SDP_CONTROLLER_RTP_EXTENSION_ABS_SEND_TIME ];
+        #endif /* PEER_CONNECTION_ENABLE_ABS_SEND_TIME_EXTENSION */
 
         for( i = 0; i < pSession->mLinesTransceiverCount; i++ )
         {
             populateConfiguration.pTransceiver = pSession->pMLinesTransceivers[i];
+            populateConfiguration.rtpExtensionIds[ SDP_CONTROLLER_RTP_EXTENSION_PLAYOUT_DELAY ] = 0U;
             if( populateConfiguration.pTransceiver->trackKind == TRANSCEIVER_TRACK_KIND_VIDEO )
             {
                 populateConfiguration.payloadType = pSession->rtpConfig.videoCodecPayload;
                 populateConfiguration.rtxPayloadType = pSession->rtpConfig.videoCodecRtxPayload;
+                populateConfiguration.redPayloadType = 0;
+                #if PEER_CONNECTION_ENABLE_PLAYOUT_DELAY_EXTENSION
+                populateConfiguration.rtpExtensionIds[ SDP_CONTROLLER_RTP_EXTENSION_PLAYOUT_DELAY ] = pSession->remoteSessionDescription.sdpDescription.quickAccess.rtpExtensionIds[ SDP_CONTROLLER_RTP_EXTENSION_PLAYOUT_DELAY ];
+                #endif /* PEER_CONNECTION_ENABLE_PLAYOUT_DELAY_EXTENSION */
             }
             else
             {
                 populateConfiguration.payloadType = pSession->rtpConfig.audioCodecPayload;
                 populateConfiguration.rtxPayloadType = pSession->rtpConfig.audioCodecRtxPayload;
+                populateConfiguration.redPayloadType = pSession->rtpConfig.audioCodecRedPayload;
             }
 
             retSdpController = SdpController_PopulateSingleMedia( &pRemoteBufferSessionDescription->sdpDescription.mediaDescriptions[ i ],
@@ -1110,6 +1200,387 @@ PeerConnectionResult_t PeerConnectionSdp_SetPayloadTypes( PeerConnectionSession_
     return ret;
 }
 
+#if PEER_CONNECTION_SDP_ANSWER_TEMPLATE_COUNT > 0
+
+/* Up to 2 SSRC lines per ssrc attribute set plus ssrc-group for each media, origin and fingerprints. */
+#define PEER_CONNECTION_SDP_ANSWER_TEMPLATE_MAX_SLOTS ( 48 )
+
+#define PEER_CONNECTION_SDP_FNV_OFFSET_BASIS ( 2166136261UL )
+#define PEER_CONNECTION_SDP_FNV_PRIME ( 16777619UL )
+
+typedef enum PeerConnectionSdpTemplateSlotType
+{
+    PEER_CONNECTION_SDP_TEMPLATE_SLOT_ORIGIN_SESSION_ID = 0,
+    PEER_CONNECTION_SDP_TEMPLATE_SLOT_FINGERPRINT,
+    PEER_CONNECTION_SDP_TEMPLATE_SLOT_SSRC,
+    PEER_CONNECTION_SDP_TEMPLATE_SLOT_RTX_SSRC,
+} PeerConnectionSdpTemplateSlotType_t;
+
+/* A per-session field inside the cached answer, patched when the template is reused. */
+typedef struct PeerConnectionSdpTemplateSlot
+{
+    size_t offset;
+    size_t length;
+    PeerConnectionSdpTemplateSlotType_t type;
+    uint32_t mediaIndex;
+} PeerConnectionSdpTemplateSlot_t;
+
+typedef struct PeerConnectionSdpAnswerTemplate
+{
+    uint8_t isValid;
+    uint32_t signature;
+    char sdp[ PEER_CONNECTION_SDP_DESCRIPTION_BUFFER_MAX_LENGTH ];
+    size_t sdpLength;
+    PeerConnectionSdpTemplateSlot_t slots[ PEER_CONNECTION_SDP_ANSWER_TEMPLATE_MAX_SLOTS ];
+    size_t slotCount;
+} PeerConnectionSdpAnswerTemplate_t;
+
+/* Answers are created from the signaling handling context only, so the cache is not locked. */
+static PeerConnectionSdpAnswerTemplate_t answerTemplates[ PEER_CONNECTION_SDP_ANSWER_TEMPLATE_COUNT ];
+static size_t nextAnswerTemplateIndex = 0;
+
+static uint32_t UpdateSignature( uint32_t signature,
+                                 const void * pData,
+                                 size_t dataLength )
+{
+    const uint8_t * pBytes = ( const uint8_t * ) pData;
+    size_t i;
+
+    for( i = 0; i < dataLength; i++ )
+    {
+        signature ^= pBytes[ i ];
+        signature *= PEER_CONNECTION_SDP_FNV_PRIME;
+    }
+
+    return signature;
+}
+
+static uint8_t IsPerSessionAttribute( const SdpControllerAttributes_t * pAttribute )
+{
+    static const char * const perSessionNames[] = { "candidate", "end-of-candidates", "ice-ufrag", "ice-pwd", "fingerprint", "ssrc", "ssrc-group", "msid", "msid-semantic" };
+    uint8_t isPerSession = 0U;
+    size_t i;
+
+    for( i = 0; i < sizeof( perSessionNames ) / sizeof( perSessionNames[ 0 ] ); i++ )
+    {
+        if( ( pAttribute->attributeNameLength == strlen( perSessionNames[ i ] ) ) &&
+            ( strncmp( perSessionNames[ i ], pAttribute->pAttributeName, pAttribute->attributeNameLength ) == 0 ) )
+        {
+            isPerSession = 1U;
+            break;
+        }
+    }
+
+    return isPerSession;
+}
+
+static uint32_t UpdateSignatureByAttributes( uint32_t signature,
+                                             const SdpControllerAttributes_t * pAttributes,
+                                             size_t attributeCount )
+{
+    size_t i;
+
+    for( i = 0; i < attributeCount; i++ )
+    {
+        /* Attributes unique to each viewer don't change the answer layout. */
+        if( IsPerSessionAttribute( &pAttributes[ i ] ) == 0U )
+        {
+            signature = UpdateSignature( signature, pAttributes[ i ].pAttributeName, pAttributes[ i ].attributeNameLength );
+            signature = UpdateSignature( signature, ":", 1 );
+            signature = UpdateSignature( signature, pAttributes[ i ].pAttributeValue, pAttributes[ i ].attributeValueLength );
+            signature = UpdateSignature( signature, "\n", 1 );
+        }
+    }
+
+    return signature;
+}
+
+/* Signature of every input the answer is built from, excluding the per-session fields that get patched. */
+static uint32_t CalculateAnswerSignature( PeerConnectionSession_t * pSession,
+                                          PeerConnectionBufferSessionDescription_t * pRemoteBufferSessionDescription )
+{
+    uint32_t signature = PEER_CONNECTION_SDP_FNV_OFFSET_BASIS;
+    const SdpControllerSdpDescription_t * pRemoteDescription = &pRemoteBufferSessionDescription->sdpDescription;
+    const Transceiver_t * pTransceiver;
+    uint32_t i;
+
+    signature = UpdateSignatureByAttributes( signature, pRemoteDescription->attributes, pRemoteDescription->sessionAttributesCount );
+    for( i = 0; i < pRemoteDescription->mediaCount; i++ )
+    {
+        signature = UpdateSignature( signature, pRemoteDescription->mediaDescriptions[ i ].pMediaName, pRemoteDescription->mediaDescriptions[ i ].mediaNameLength );
+        signature = UpdateSignatureByAttributes( signature, pRemoteDescription->mediaDescriptions[ i ].attributes, pRemoteDescription->mediaDescriptions[ i ].mediaAttributesCount );
+    }
+
+    for( i = 0; i < pSession->mLinesTransceiverCount; i++ )
+    {
+        pTransceiver = pSession->pMLinesTransceivers[ i ];
+        signature = UpdateSignature( signature, &pTransceiver->trackKind, sizeof( pTransceiver->trackKind ) );
+        signature = UpdateSignature( signature, &pTransceiver->direction, sizeof( pTransceiver->direction ) );
+        signature = UpdateSignature( signature, &pTransceiver->codecBitMap, sizeof( pTransceiver->codecBitMap ) );
+        signature = UpdateSignature( signature, pTransceiver->streamId, pTransceiver->streamIdLength );
+        signature = UpdateSignature( signature, pTransceiver->trackId, pTransceiver->trackIdLength );
+    }
+    signature = UpdateSignature( signature, &pSession->mLinesTransceiverCount, sizeof( pSession->mLinesTransceiverCount ) );
+    signature = UpdateSignature( signature, &pSession->rtpConfig.videoCodecPayload, sizeof( pSession->rtpConfig.videoCodecPayload ) );
+    signature = UpdateSignature( signature, &pSession->rtpConfig.videoCodecRtxPayload, sizeof( pSession->rtpConfig.videoCodecRtxPayload ) );
+    signature = UpdateSignature( signature, &pSession->rtpConfig.audioCodecPayload, sizeof( pSession->rtpConfig.audioCodecPayload ) );
+    signature = UpdateSignature( signature, &pSession->rtpConfig.audioCodecRtxPayload, sizeof( pSession->rtpConfig.audioCodecRtxPayload ) );
+    signature = UpdateSignature( signature, &pSession->rtpConfig.audioCodecRedPayload, sizeof( pSession->rtpConfig.audioCodecRedPayload ) );
+    #if ENABLE_SCTP_DATA_CHANNEL
+    signature = UpdateSignature( signature, &pSession->ucEnableDataChannelRemote, sizeof( pSession->ucEnableDataChannelRemote ) );
+    #endif /* ENABLE_SCTP_DATA_CHANNEL */
+    signature = UpdateSignature( signature, pSession->pCtx->localUserName, strlen( pSession->pCtx->localUserName ) );
+    signature = UpdateSignature( signature, pSession->pCtx->localPassword, strlen( pSession->pCtx->localPassword ) );
+    signature = UpdateSignature( signature, pSession->pCtx->localCname, strlen( pSession->pCtx->localCname ) );
+
+    return signature;
+}
+
+static size_t GetDigitsLength( const char * pStart,
+                               const char * pEnd )
+{
+    size_t length = 0;
+
+    while( ( pStart + length < pEnd ) && ( pStart[ length ] >= '0' ) && ( pStart[ length ] <= '9' ) )
+    {
+        length++;
+    }
+
+    return length;
+}
+
+static uint8_t AddTemplateSlot( PeerConnectionSdpAnswerTemplate_t * pTemplate,
+                                const char * pValue,
+                                size_t valueLength,
+                                PeerConnectionSdpTemplateSlotType_t type,
+                                uint32_t mediaIndex )
+{
+    uint8_t isAdded = 0U;
+
+    if( ( valueLength > 0U ) && ( pTemplate->slotCount < PEER_CONNECTION_SDP_ANSWER_TEMPLATE_MAX_SLOTS ) )
+    {
+        pTemplate->slots[ pTemplate->slotCount ].offset = pValue - pTemplate->sdp;
+        pTemplate->slots[ pTemplate->slotCount ].length = valueLength;
+        pTemplate->slots[ pTemplate->slotCount ].type = type;
+        pTemplate->slots[ pTemplate->slotCount ].mediaIndex = mediaIndex;
+        pTemplate->slotCount++;
+        isAdded = 1U;
+    }
+
+    return isAdded;
+}
+
+static uint8_t AddTemplateSsrcSlot( PeerConnectionSession_t * pSession,
+                                    PeerConnectionSdpAnswerTemplate_t * pTemplate,
+                                    const char * pValue,
+                                    size_t valueLength,
+                                    uint32_t mediaIndex )
+{
+    uint8_t isAdded = 0U;
+    uint32_t ssrc = 0;
+    StringUtilsResult_t stringResult;
+
+    if( ( mediaIndex < pSession->mLinesTransceiverCount ) && ( valueLength > 0U ) )
+    {
+        stringResult = StringUtils_ConvertStringToUl( pValue, valueLength, &ssrc );
+        if( stringResult != STRING_UTILS_RESULT_OK )
+        {
+            /* Not a number, keep isAdded 0 to skip caching. */
+        }
+        else if( ssrc == pSession->pMLinesTransceivers[ mediaIndex ]->ssrc )
+        {
+            isAdded = AddTemplateSlot( pTemplate, pValue, valueLength, PEER_CONNECTION_SDP_TEMPLATE_SLOT_SSRC, mediaIndex );
+        }
+        else if( ssrc == pSession->pMLinesTransceivers[ mediaIndex ]->rtxSsrc )
+        {
+            isAdded = AddTemplateSlot( pTemplate, pValue, valueLength, PEER_CONNECTION_SDP_TEMPLATE_SLOT_RTX_SSRC, mediaIndex );
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+    }
+
+    return isAdded;
+}
+
+static void StoreAnswerTemplate( PeerConnectionSession_t * pSession,
+                                 uint32_t signature,
+                                 const char * pSdp,
+                                 size_t sdpLength )
+{
+    PeerConnectionSdpAnswerTemplate_t * pTemplate = &answerTemplates[ nextAnswerTemplateIndex ];
+    const char * pLine;
+    const char * pLineEnd;
+    const char * pSdpEnd;
+    const char * pValue;
+    size_t valueLength;
+    uint32_t mediaIndex = 0;
+    uint8_t isMediaStarted = 0U;
+    uint8_t isValid = 1U;
+
+    if( sdpLength <= PEER_CONNECTION_SDP_DESCRIPTION_BUFFER_MAX_LENGTH )
+    {
+        pTemplate->isValid = 0U;
+        pTemplate->slotCount = 0;
+        memcpy( pTemplate->sdp, pSdp, sdpLength );
+        pTemplate->sdpLength = sdpLength;
+        pSdpEnd = pTemplate->sdp + sdpLength;
+
+        /* Record where the per-session fields are, line by line. */
+        pLine = pTemplate->sdp;
+        while( ( isValid != 0U ) && ( pLine < pSdpEnd ) )
+        {
+            pLineEnd = StringUtils_StrStr( pLine, pSdpEnd - pLine, "\r\n", 2 );
+            if( pLineEnd == NULL )
+            {
+                pLineEnd = pSdpEnd;
+            }
+
+            if( ( pLineEnd - pLine > 2 ) && ( strncmp( pLine, "m=", 2 ) == 0 ) )
+            {
+                if( isMediaStarted != 0U )
+                {
+                    mediaIndex++;
+                }
+                isMediaStarted = 1U;
+            }
+            else if( ( pLineEnd - pLine > 2 ) && ( strncmp( pLine, "o=", 2 ) == 0 ) )
+            {
+                /* o=<username> <sess-id> <sess-version> ... */
+                pValue = memchr( pLine, ' ', pLineEnd - pLine );
+                if( pValue != NULL )
+                {
+                    pValue++;
+                    valueLength = GetDigitsLength( pValue, pLineEnd );
+                    isValid = AddTemplateSlot( pTemplate, pValue, valueLength, PEER_CONNECTION_SDP_TEMPLATE_SLOT_ORIGIN_SESSION_ID, 0 );
+                }
+            }
+            else if( ( pLineEnd - pLine > 22 ) && ( strncmp( pLine, "a=fingerprint:sha-256 ", 22 ) == 0 ) )
+            {
+                isValid = AddTemplateSlot( pTemplate, pLine + 22, pLineEnd - pLine - 22, PEER_CONNECTION_SDP_TEMPLATE_SLOT_FINGERPRINT, mediaIndex );
+            }
+            else if( ( pLineEnd - pLine > 7 ) && ( strncmp( pLine, "a=ssrc:", 7 ) == 0 ) )
+            {
+                pValue = pLine + 7;
+                isValid = AddTemplateSsrcSlot( pSession, pTemplate, pValue, GetDigitsLength( pValue, pLineEnd ), mediaIndex );
+            }
+            else if( ( pLineEnd - pLine > 17 ) && ( strncmp( pLine, "a=ssrc-group:FID ", 17 ) == 0 ) )
+            {
+                /* a=ssrc-group:FID <ssrc> <rtx ssrc> */
+                pValue = pLine + 17;
+                valueLength = GetDigitsLength( pValue, pLineEnd );
+                isValid = AddTemplateSsrcSlot( pSession, pTemplate, pValue, valueLength, mediaIndex );
+
+                if( isValid != 0U )
+                {
+                    pValue += valueLength + 1;
+                    isValid = AddTemplateSsrcSlot( pSession, pTemplate, pValue, GetDigitsLength( pValue, pLineEnd ), mediaIndex );
+                }
+            }
+            else
+            {
+                /* Empty else marker. */
+            }
+
+            pLine = pLineEnd + 2;
+        }
+
+        if( isValid != 0U )
+        {
+            pTemplate->signature = signature;
+            pTemplate->isValid = 1U;
+            nextAnswerTemplateIndex = ( nextAnswerTemplateIndex + 1 ) % PEER_CONNECTION_SDP_ANSWER_TEMPLATE_COUNT;
+            LogDebug( ( "Cached SDP answer template, signature: 0x%lx, slots: %u", signature, pTemplate->slotCount ) );
+        }
+    }
+}
+
+static PeerConnectionResult_t PatchAnswerTemplate( PeerConnectionSession_t * pSession,
+                                                   uint32_t signature,
+                                                   char * pOutputSerializedSdpMessage,
+                                                   size_t * pOutputSerializedSdpMessageLength )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_FAIL_SDP_POPULATE_SESSION_DESCRIPTION;
+    const PeerConnectionSdpAnswerTemplate_t * pTemplate = NULL;
+    const PeerConnectionSdpTemplateSlot_t * pSlot;
+    size_t i, copyFrom = 0, copyLength, written = 0, remainSize = *pOutputSerializedSdpMessageLength;
+    int printed = 0;
+
+    for( i = 0; i < PEER_CONNECTION_SDP_ANSWER_TEMPLATE_COUNT; i++ )
+    {
+        if( ( answerTemplates[ i ].isValid != 0U ) && ( answerTemplates[ i ].signature == signature ) )
+        {
+            pTemplate = &answerTemplates[ i ];
+            break;
+        }
+    }
+
+    if( pTemplate != NULL )
+    {
+        ret = PEER_CONNECTION_RESULT_OK;
+
+        for( i = 0; ( ret == PEER_CONNECTION_RESULT_OK ) && ( i <= pTemplate->slotCount ); i++ )
+        {
+            /* Copy the constant part in front of the slot, or the tail after the last slot. */
+            pSlot = ( i < pTemplate->slotCount ) ? &pTemplate->slots[ i ] : NULL;
+            copyLength = ( pSlot != NULL ) ? ( pSlot->offset - copyFrom ) : ( pTemplate->sdpLength - copyFrom );
+            if( copyLength >= remainSize - written )
+            {
+                LogError( ( "No space to copy SDP answer template, length: %u", copyLength ) );
+                ret = PEER_CONNECTION_RESULT_FAIL_SDP_POPULATE_SESSION_DESCRIPTION;
+                break;
+            }
+            memcpy( pOutputSerializedSdpMessage + written, pTemplate->sdp + copyFrom, copyLength );
+            written += copyLength;
+
+            if( pSlot == NULL )
+            {
+                break;
+            }
+
+            switch( pSlot->type )
+            {
+                case PEER_CONNECTION_SDP_TEMPLATE_SLOT_ORIGIN_SESSION_ID:
+                    printed = snprintf( pOutputSerializedSdpMessage + written, remainSize - written, "%d", rand() );
+                    break;
+                case PEER_CONNECTION_SDP_TEMPLATE_SLOT_FINGERPRINT:
+                    printed = snprintf( pOutputSerializedSdpMessage + written, remainSize - written, "%.*s",
+                                        ( int ) CERTIFICATE_FINGERPRINT_LENGTH, pSession->pDtlsContext->localCertFingerprint );
+                    break;
+                case PEER_CONNECTION_SDP_TEMPLATE_SLOT_SSRC:
+                    printed = snprintf( pOutputSerializedSdpMessage + written, remainSize - written, "%lu",
+                                        pSession->pMLinesTransceivers[ pSlot->mediaIndex ]->ssrc );
+                    break;
+                default:
+                    printed = snprintf( pOutputSerializedSdpMessage + written, remainSize - written, "%lu",
+                                        pSession->pMLinesTransceivers[ pSlot->mediaIndex ]->rtxSsrc );
+                    break;
+            }
+
+            if( ( printed < 0 ) || ( ( size_t ) printed >= remainSize - written ) )
+            {
+                LogError( ( "No space to patch SDP answer template, printed: %d", printed ) );
+                ret = PEER_CONNECTION_RESULT_FAIL_SDP_POPULATE_SESSION_DESCRIPTION;
+            }
+            else
+            {
+                written += printed;
+                copyFrom = pSlot->offset + pSlot->length;
+            }
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        *pOutputSerializedSdpMessageLength = written;
+    }
+
+    return ret;
+}
+
+#endif /* PEER_CONNECTION_SDP_ANSWER_TEMPLATE_COUNT > 0 */
+
 PeerConnectionResult_t PeerConnectionSdp_PopulateSessionDescription( PeerConnectionSession_t * pSession,
                                                                      PeerConnectionBufferSessionDescription_t * pRemoteBufferSessionDescription,
                                                                      PeerConnectionBufferSessionDescription_t * pLocalBufferSessionDescription,
@@ -1120,6 +1591,10 @@ PeerConnectionResult_t PeerConnectionSdp_PopulateSessionDescription( PeerConnect
     char * pBuffer = NULL;
     size_t bufferLength = 0;
     SdpControllerResult_t retSdpController;
+    uint8_t isPopulated = 0U;
+    #if PEER_CONNECTION_SDP_ANSWER_TEMPLATE_COUNT > 0
+    uint32_t answerSignature = 0;
+    #endif /* PEER_CONNECTION_SDP_ANSWER_TEMPLATE_COUNT > 0 */
 
     if( ( pSession == NULL ) ||
         ( pLocalBufferSessionDescription == NULL ) ||
@@ -1147,7 +1622,22 @@ PeerConnectionResult_t PeerConnectionSdp_PopulateSessionDescription( PeerConnect
         /* Empty else marker. */
     }
 
-    if( ret == PEER_CONNECTION_RESULT_OK )
+    #if PEER_CONNECTION_SDP_ANSWER_TEMPLATE_COUNT > 0
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) && ( pRemoteBufferSessionDescription != NULL ) )
+    {
+        /* Reuse the answer built for an earlier offer with the same layout, only patching per-session fields. */
+        answerSignature = CalculateAnswerSignature( pSession, pRemoteBufferSessionDescription );
+        if( PatchAnswerTemplate( pSession,
+                                 answerSignature,
+                                 pOutputSerializedSdpMessage,
+                                 pOutputSerializedSdpMessageLength ) == PEER_CONNECTION_RESULT_OK )
+        {
+            isPopulated = 1U;
+        }
+    }
+    #endif /* PEER_CONNECTION_SDP_ANSWER_TEMPLATE_COUNT > 0 */
+
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) && ( isPopulated == 0U ) )
     {
         /* Add media descriptions, use the temp buffer to store SDP content for pointers to refer to. */
         pBuffer = pLocalBufferSessionDescription->pSdpBuffer;
@@ -1155,7 +1645,7 @@ PeerConnectionResult_t PeerConnectionSdp_PopulateSessionDescription( PeerConnect
         ret = PopulateMediaDescriptions( pSession, pRemoteBufferSessionDescription, pLocalBufferSessionDescription, &pBuffer, &bufferLength );
     }
 
-    if( ret == PEER_CONNECTION_RESULT_OK )
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) && ( isPopulated == 0U ) )
     {
         /* Add session descriptions.
          * Note that we need to session media count to populate session group attribute,
@@ -1163,7 +1653,7 @@ PeerConnectionResult_t PeerConnectionSdp_PopulateSessionDescription( PeerConnect
         ret = PopulateSessionDescription( pSession, pRemoteBufferSessionDescription, pLocalBufferSessionDescription, &pBuffer, &bufferLength );
     }
 
-    if( ret == PEER_CONNECTION_RESULT_OK )
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) && ( isPopulated == 0U ) )
     {
         /* Serialize the content into the buffer in pLocalBufferSessionDescription. */
         pBuffer = pOutputSerializedSdpMessage;
@@ -1180,6 +1670,16 @@ PeerConnectionResult_t PeerConnectionSdp_PopulateSessionDescription( PeerConnect
         else
         {
             *pOutputSerializedSdpMessageLength = bufferLength;
+
+            #if PEER_CONNECTION_SDP_ANSWER_TEMPLATE_COUNT > 0
+            if( pRemoteBufferSessionDescription != NULL )
+            {
+                StoreAnswerTemplate( pSession,
+                                     answerSignature,
+                                     pOutputSerializedSdpMessage,
+                                     bufferLength );
+            }
+            #endif /* PEER_CONNECTION_SDP_ANSWER_TEMPLATE_COUNT > 0 */
         }
     }
 
@@ -20,6 +20,7 @@
 #include "peer_connection_srtcp.h"
 #include "peer_connection_srtp.h"
 #include "peer_connection_rolling_buffer.h"
+#include "peer_connection_codec_helper.h"
 
 /* API includes. */
 #include "rtp_api.h"
@@ -35,9 +36,37 @@
 #define PEER_CONNECTION_SRTCP_NACK_MAX_SEQ_NUM                       ( 128 )
 #define PEER_CONNECTION_SRTCP_REMB_MAX_SSRC_NUM                      ( 255 )
 
+/* https://datatracker.ietf.org/doc/html/rfc4585#section-6.2.1 */
+#define PEER_CONNECTION_SRTCP_NACK_HEADER_LENGTH                     ( 12 )
+#define PEER_CONNECTION_SRTCP_NACK_FCI_LENGTH                        ( 4 )
+#define PEER_CONNECTION_SRTCP_NACK_FIRST_BYTE                        ( 0x81 ) /* V=2, P=0, FMT=1 (Generic NACK). */
+#define PEER_CONNECTION_SRTCP_NACK_PACKET_TYPE                       ( 205 ) /* RTPFB */
+#define PEER_CONNECTION_SRTCP_NACK_BLP_BITS                          ( 16 )
+
+/* https://datatracker.ietf.org/doc/html/rfc5104#section-4.3.1 */
+/* The FCI entries follow the packet sender SSRC and the unused media source SSRC. */
+#define PEER_CONNECTION_SRTCP_FIR_FCI_OFFSET                         ( 8 )
+#define PEER_CONNECTION_SRTCP_FIR_FCI_LENGTH                         ( 8 ) /* SSRC, Seq nr., Reserved. */
+
+/* https://datatracker.ietf.org/doc/html/rfc3550#section-6.4.2 */
+#define PEER_CONNECTION_SRTCP_RECEIVER_REPORT_HEADER_LENGTH          ( 8 )
+#define PEER_CONNECTION_SRTCP_RECEPTION_REPORT_LENGTH                ( 24 )
+#define PEER_CONNECTION_SRTCP_RECEIVER_REPORT_FIRST_BYTE             ( 0x80 ) /* V=2, P=0, RC in the low 5 bits. */
+#define PEER_CONNECTION_SRTCP_RECEIVER_REPORT_PACKET_TYPE            ( 201 )
+#define PEER_CONNECTION_SRTCP_CUMULATIVE_LOST_MAX                    ( 0x7FFFFF )
+#define PEER_CONNECTION_SRTCP_CUMULATIVE_LOST_MIN                    ( -0x800000 )
+
+/* E flag and SRTCP index (4 bytes) and authentication tag (10 bytes) appended by srtp_protect_rtcp(). */
+#define PEER_CONNECTION_SRTCP_TRAILER_LENGTH                         ( 14 )
+
 /* https://datatracker.ietf.org/doc/html/rfc3550#section-6.4.1 */
 #define PEER_CONNECTION_SRTCP_DLSR_TIMESCALE                         65536
 
+/* Round trip samples above this are clamped, and each one moves the stored RTT by 1/8th
+ * of the difference, starting from PEER_CONNECTION_RECEIVER_NACK_DEFAULT_RTT_MS. */
+#define PEER_CONNECTION_SRTCP_MAX_ROUND_TRIP_TIME_MS                 ( 2000 )
+#define PEER_CONNECTION_SRTCP_ROUND_TRIP_TIME_SMOOTHING_SHIFT        ( 3 )
+
 /* https://tools.ietf.org/html/rfc3550#section-4 */
 /* In some fields where a more compact representation is */
 /*   appropriate, only the middle 32 bits are used; that is, the low 16 */
@@ -76,16 +105,15 @@ static PeerConnectionResult_t ResendSrtpPacket( PeerConnectionSession_t * pSessi
 {
     PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
     PeerConnectionSrtpSender_t * pSrtpSender = NULL;
-    uint8_t isSenderLocked = 0;
-    PeerConnectionRollingBufferPacket_t * pRollingBufferPacket = NULL;
+    PeerConnectionRollingBufferPacket_t rollingBufferPacket;
     IceControllerResult_t resultIceController;
     uint8_t bufferAfterEncrypt = 1;
-    uint8_t srtpBuffer[ PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ];
+    uint8_t srtpBuffer[ PEER_CONNECTION_PACKET_BUFFER_SIZE( PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH ) ];
+    uint8_t rtxPayloadBuffer[ PEER_CONNECTION_SRTP_RTP_PAYLOAD_MAX_LENGTH ];
     uint8_t * pSrtpPacket = NULL;
     size_t srtpPacketLength = 0;
     uint32_t payloadType;
     uint16_t * pRtpSeq = NULL;
-    uint16_t * pOsn = NULL;
 
     if( ( pSession == NULL ) || ( pTransceiver == NULL ) )
     {
@@ -127,38 +155,45 @@ static PeerConnectionResult_t ResendSrtpPacket( PeerConnectionSession_t * pSessi
                 ssrc = pTransceiver->rtxSsrc;
             }
         }
+    }
 
-        /* Lock sender. */
-        if( xSemaphoreTake( pSrtpSender->senderMutex, portMAX_DELAY ) == pdTRUE )
+    /* The sender mutex is held by the frame writer for a whole frame, don't wait for it here.
+     * The rolling buffer copies the packet out under its own short-held lock instead,
+     * so the stored packet is never modified nor used after it's evicted. */
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        if( bufferAfterEncrypt == 0 )
         {
-            isSenderLocked = 1;
+            /* The payload is stored after PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES reserved for OSN. */
+            ret = PeerConnectionRollingBuffer_SearchRtpSequenceBuffer( &pSrtpSender->txRollingBuffer,
+                                                                       rtpSeq,
+                                                                       PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES,
+                                                                       &rollingBufferPacket,
+                                                                       rtxPayloadBuffer,
+                                                                       sizeof( rtxPayloadBuffer ) );
         }
         else
         {
-            LogError( ( "Fail to take sender mutex" ) );
-            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_SENDER_MUTEX;
+            /* Copy the encrypted SRTP packet straight into the send buffer, leaving the headroom for framing. */
+            ret = PeerConnectionRollingBuffer_SearchRtpSequenceBuffer( &pSrtpSender->txRollingBuffer,
+                                                                       rtpSeq,
+                                                                       0,
+                                                                       &rollingBufferPacket,
+                                                                       srtpBuffer + PEER_CONNECTION_PACKET_HEADROOM_LENGTH,
+                                                                       PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH );
         }
-    }
-
-    if( ret == PEER_CONNECTION_RESULT_OK )
-    {
-        ret = PeerConnectionRollingBuffer_SearchRtpSequenceBuffer( &pSrtpSender->txRollingBuffer,
-                                                                   rtpSeq,
-                                                                   &pRollingBufferPacket );
 
-        if( ( ret != PEER_CONNECTION_RESULT_OK ) || ( pRollingBufferPacket == NULL ) )
+        if( ret != PEER_CONNECTION_RESULT_OK )
         {
             LogWarn( ( "Fail to find target buffer, seq: %u", rtpSeq ) );
             ret = PEER_CONNECTION_RESULT_FAIL_RTP_PACKET_NOT_FOUND;
         }
         else
         {
-            LogDebug( ( "Found target buffer, pRollingBufferPacket: %p, packetBufferLength: %u, pPacketBuffer: %p",
-                        pRollingBufferPacket,
-                        pRollingBufferPacket->packetBufferLength,
-                        pRollingBufferPacket->pPacketBuffer ) );
-            LogDebug( ( "Found target buffer, sequence in buffer: %u, target sequence: %u",
-                        pRollingBufferPacket->rtpPacket.header.sequenceNumber, rtpSeq ) );
+            LogDebug( ( "Found target buffer, packetBufferLength: %u, sequence in buffer: %u, target sequence: %u",
+                        rollingBufferPacket.packetBufferLength,
+                        rollingBufferPacket.rtpPacket.header.sequenceNumber,
+                        rtpSeq ) );
         }
     }
 
@@ -167,39 +202,41 @@ static PeerConnectionResult_t ResendSrtpPacket( PeerConnectionSession_t * pSessi
         if( bufferAfterEncrypt == 0 )
         {
             /* Don't reset the header as re-using the setting from write frame.
-             * Update sequence, SSRC, payload type and OSN for RTX packet. */
-            pRollingBufferPacket->rtpPacket.header.sequenceNumber = ( *pRtpSeq )++;
-            pRollingBufferPacket->rtpPacket.header.ssrc = ssrc;
-            pRollingBufferPacket->rtpPacket.header.payloadType = payloadType;
-
-            /* Follow RTX format to add OSN(original RTP sequence number) at the very beginning of payload.
-             * Note that we reserve PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES at the beginning of buffer at write frame. */
-            pOsn = ( uint16_t * ) pRollingBufferPacket->pPacketBuffer;
-            *pOsn = htons( rtpSeq );
-            pRollingBufferPacket->rtpPacket.payloadLength = pRollingBufferPacket->packetBufferLength + 2;
-            pRollingBufferPacket->rtpPacket.pPayload = pRollingBufferPacket->pPacketBuffer;
-
-            pSrtpPacket = srtpBuffer;
+             * Update sequence, SSRC, payload type and OSN for RTX packet.
+             * The RTX sequence is only advanced here, on the RTCP receiving path. */
+            rollingBufferPacket.rtpPacket.header.sequenceNumber = ( *pRtpSeq )++;
+            rollingBufferPacket.rtpPacket.header.ssrc = ssrc;
+            rollingBufferPacket.rtpPacket.header.payloadType = payloadType;
+
+            /* Follow RTX format to add OSN(original RTP sequence number) at the very beginning of payload. */
+            rtxPayloadBuffer[ 0 ] = ( uint8_t ) ( rtpSeq >> 8 );
+            rtxPayloadBuffer[ 1 ] = ( uint8_t ) ( rtpSeq & 0xFF );
+            rollingBufferPacket.rtpPacket.payloadLength = rollingBufferPacket.packetBufferLength + PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES;
+            rollingBufferPacket.rtpPacket.pPayload = rtxPayloadBuffer;
+
+            pSrtpPacket = srtpBuffer + PEER_CONNECTION_PACKET_HEADROOM_LENGTH;
             srtpPacketLength = PEER_CONNECTION_SRTP_RTP_PACKET_MAX_LENGTH;
 
             /* PeerConnectionSrtp_ConstructSrtpPacket() serializes RTP packet and encrypt it. */
             ret = PeerConnectionSrtp_ConstructSrtpPacket( pSession,
-                                                          &pRollingBufferPacket->rtpPacket,
+                                                          &rollingBufferPacket.rtpPacket,
                                                           pSrtpPacket,
                                                           &srtpPacketLength );
         }
         else
         {
-            pSrtpPacket = pRollingBufferPacket->pPacketBuffer;
-            srtpPacketLength = pRollingBufferPacket->packetBufferLength;
+            pSrtpPacket = rollingBufferPacket.pPacketBuffer;
+            srtpPacketLength = rollingBufferPacket.packetBufferLength;
         }
     }
 
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        resultIceController = IceController_SendToRemotePeer( &pSession->iceControllerContext,
-                                                              pSrtpPacket,
-                                                              srtpPacketLength );
+        resultIceController = IceController_SendToRemotePeerInPlace( &pSession->iceControllerContext,
+                                                                     pSrtpPacket,
+                                                                     srtpPacketLength,
+                                                                     srtpPacketLength + PEER_CONNECTION_PACKET_TAILROOM_LENGTH,
+                                                                     ICE_CONTROLLER_SEND_PRIORITY_RETRANSMISSION );
 
         if( resultIceController != ICE_CONTROLLER_RESULT_OK )
         {
@@ -212,21 +249,27 @@ static PeerConnectionResult_t ResendSrtpPacket( PeerConnectionSession_t * pSessi
         }
     }
 
-    if( isSenderLocked )
-    {
-        xSemaphoreGive( pSrtpSender->senderMutex );
-    }
-
     return ret;
 }
 
+static uint32_t ReadUint32( const uint8_t * pBuffer )
+{
+    return ( ( uint32_t ) pBuffer[ 0 ] << 24 ) |
+           ( ( uint32_t ) pBuffer[ 1 ] << 16 ) |
+           ( ( uint32_t ) pBuffer[ 2 ] << 8 ) |
+           ( uint32_t ) pBuffer[ 3 ];
+}
+
 static PeerConnectionResult_t OnRtcpFirEvent( PeerConnectionSession_t * pSession,
                                               RtcpPacket_t * pRtcpPacket )
 {
     PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
     RtcpResult_t resultRtcp;
     RtcpFirPacket_t firPacket;
+    RtcpPliPacket_t pliPacket;
     const Transceiver_t * pTransceiver = NULL;
+    uint32_t targetSsrc = 0U;
+    size_t offset;
 
     if( ( pSession == NULL ) || ( pRtcpPacket == NULL ) )
     {
@@ -252,20 +295,41 @@ static PeerConnectionResult_t OnRtcpFirEvent( PeerConnectionSession_t * pSession
 
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        ret = PeerConnection_MatchTransceiverBySsrc( pSession,
-                                                     firPacket.senderSsrc,
-                                                     &pTransceiver );
+        /* The FIR targets the media senders listed in its FCI entries, not the packet sender.
+         * Take the first entry that names one of our streams. */
+        ret = PEER_CONNECTION_RESULT_UNKNOWN_SSRC;
+        for( offset = PEER_CONNECTION_SRTCP_FIR_FCI_OFFSET;
+             offset + PEER_CONNECTION_SRTCP_FIR_FCI_LENGTH <= pRtcpPacket->payloadLength;
+             offset += PEER_CONNECTION_SRTCP_FIR_FCI_LENGTH )
+        {
+            targetSsrc = ReadUint32( &pRtcpPacket->pPayload[ offset ] );
+            if( PeerConnection_MatchTransceiverBySsrc( pSession,
+                                                       targetSsrc,
+                                                       &pTransceiver ) == PEER_CONNECTION_RESULT_OK )
+            {
+                ret = PEER_CONNECTION_RESULT_OK;
+                break;
+            }
+        }
     }
 
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
-        /* Increase the FIR Counter as per our application design. */
-
-        /* Initiate a callback to transmit an intra-picture to achieve resynchronization. */
+        /* FIR and PLI both ask for an intra-picture, so report FIR through the same
+         * callback and let the application coalesce them into a single encoder IDR. */
+        if( pSession->onPictureLossIndicationCallback != NULL )
+        {
+            memset( &pliPacket,
+                    0,
+                    sizeof( RtcpPliPacket_t ) );
+            pliPacket.mediaSourceSsrc = pTransceiver->ssrc;
+            pSession->onPictureLossIndicationCallback( pSession->pPictureLossIndicationUserContext,
+                                                       &pliPacket );
+        }
     }
     else if( ret == PEER_CONNECTION_RESULT_UNKNOWN_SSRC )
     {
-        LogWarn( ( "Received FIR for non existing ssrc: %lu", firPacket.senderSsrc ) );
+        LogWarn( ( "Received FIR for non existing ssrc: %lu", targetSsrc ) );
     }
     else
     {
@@ -654,6 +718,27 @@ static PeerConnectionResult_t OnRtcpSenderReportEvent( PeerConnectionSession_t *
         }
     }
 
+    #if PEER_CONNECTION_ENABLE_RECEIVER_REPORT
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        /* Remember when the SR arrived, our next reception report echoes it as LSR/DLSR for the sender's RTT. */
+        if( senderReport.senderSsrc == pSession->rtpConfig.remoteVideoSsrc )
+        {
+            pSession->videoSrtpReceiver.rxStats.lastSenderReportNtp = PEER_CONNECTION_SRTCP_MID_NTP( senderReport.senderInfo.ntpTime );
+            pSession->videoSrtpReceiver.rxStats.lastSenderReportTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+        }
+        else if( senderReport.senderSsrc == pSession->rtpConfig.remoteAudioSsrc )
+        {
+            pSession->audioSrtpReceiver.rxStats.lastSenderReportNtp = PEER_CONNECTION_SRTCP_MID_NTP( senderReport.senderInfo.ntpTime );
+            pSession->audioSrtpReceiver.rxStats.lastSenderReportTimeUs = NetworkingUtils_GetCurrentTimeUs( NULL );
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+    }
+    #endif /* PEER_CONNECTION_ENABLE_RECEIVER_REPORT */
+
     return ret;
 }
 
@@ -665,7 +750,9 @@ static PeerConnectionResult_t OnRtcpReceiverReportEvent( PeerConnectionSession_t
     RtcpReceiverReport_t receiverReport;
     RtcpReceptionReport_t receptionReport[ PEER_CONNECTION_RTCP_RECEIVER_REPORT_RECEPTION_REPORT_NUM ];
     const Transceiver_t * pTransceiver = NULL;
+    int32_t roundTripPropagationDelayNtp;
     uint32_t roundTripPropagationDelay = 0;
+    uint32_t roundTripTimeMs;
     uint64_t currentTimeNTP = 0;
     int i;
 
@@ -744,8 +831,40 @@ static PeerConnectionResult_t OnRtcpReceiverReportEvent( PeerConnectionSession_t
                 /*      leave the round-trip propagation delay as (A - LSR - DLSR). */
                 currentTimeNTP = NetworkingUtils_GetNTPTimeFromUnixTimeUs( NetworkingUtils_GetCurrentTimeUs( NULL ) );
                 currentTimeNTP = PEER_CONNECTION_SRTCP_MID_NTP( currentTimeNTP );
-                roundTripPropagationDelay = currentTimeNTP - receiverReport.pReceptionReports[ 0 ].lastSR - receiverReport.pReceptionReports[ 0 ].delaySinceLastSR;
-                roundTripPropagationDelay = ( roundTripPropagationDelay * 1000 ) / PEER_CONNECTION_SRTCP_DLSR_TIMESCALE;                             /* The Round Trip Propogation Delay is in ms unit. */
+                /* The middle 32 bits of NTP wrap, so take the difference modulo 2^32 and read it as signed.
+                 * A result <= 0 comes from clock skew or a bogus DLSR and isn't a usable sample. */
+                roundTripPropagationDelayNtp = ( int32_t ) ( ( uint32_t ) currentTimeNTP - receiverReport.pReceptionReports[ 0 ].lastSR - receiverReport.pReceptionReports[ 0 ].delaySinceLastSR );
+                if( roundTripPropagationDelayNtp <= 0 )
+                {
+                    LogDebug( ( "Ignore receiver report with non-positive round trip: %ld", ( long ) roundTripPropagationDelayNtp ) );
+                    continue;
+                }
+
+                /* The Round Trip Propogation Delay is in ms unit. */
+                roundTripPropagationDelay = ( uint32_t ) ( ( ( uint64_t ) roundTripPropagationDelayNtp * 1000U ) / PEER_CONNECTION_SRTCP_DLSR_TIMESCALE );
+                if( roundTripPropagationDelay > PEER_CONNECTION_SRTCP_MAX_ROUND_TRIP_TIME_MS )
+                {
+                    roundTripPropagationDelay = PEER_CONNECTION_SRTCP_MAX_ROUND_TRIP_TIME_MS;
+                }
+
+                /* Until the first sample the NACK retries run on the default RTT, blend from there
+                 * so a single report doesn't swing the retry interval. */
+                roundTripTimeMs = pSession->roundTripTimeMs;
+                if( roundTripTimeMs == 0U )
+                {
+                    roundTripTimeMs = PEER_CONNECTION_RECEIVER_NACK_DEFAULT_RTT_MS;
+                }
+                if( roundTripPropagationDelay >= roundTripTimeMs )
+                {
+                    roundTripTimeMs += ( roundTripPropagationDelay - roundTripTimeMs ) >> PEER_CONNECTION_SRTCP_ROUND_TRIP_TIME_SMOOTHING_SHIFT;
+                }
+                else
+                {
+                    roundTripTimeMs -= ( roundTripTimeMs - roundTripPropagationDelay ) >> PEER_CONNECTION_SRTCP_ROUND_TRIP_TIME_SMOOTHING_SHIFT;
+                }
+
+                /* 0 is kept for "not measured yet". */
+                pSession->roundTripTimeMs = ( roundTripTimeMs == 0U ) ? 1U : roundTripTimeMs;
 
                 if( pTransceiver->trackKind == TRANSCEIVER_TRACK_KIND_AUDIO )
                 {
@@ -855,6 +974,322 @@ PeerConnectionResult_t PeerConnectionSrtcp_ConstructSenderReportPacket( PeerConn
     return ret;
 }
 
+PeerConnectionResult_t PeerConnectionSrtcp_ConstructNackPacket( PeerConnectionSession_t * pSession,
+                                                                uint32_t senderSsrc,
+                                                                uint32_t mediaSsrc,
+                                                                const uint16_t * pSequenceNumbers,
+                                                                size_t sequenceNumbersCount,
+                                                                uint8_t * pOutputSrtcpPacket,
+                                                                size_t * pOutputSrtcpPacketLength )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    size_t rtcpBufferLength = PEER_CONNECTION_SRTCP_NACK_HEADER_LENGTH;
+    size_t i = 0, j;
+    uint16_t pid, blp, offset;
+    srtp_err_status_t errorStatus;
+    uint8_t isLocked = 0U;
+
+    if( ( pSession == NULL ) ||
+        ( pSequenceNumbers == NULL ) ||
+        ( sequenceNumbersCount == 0 ) ||
+        ( pOutputSrtcpPacket == NULL ) ||
+        ( pOutputSrtcpPacketLength == NULL ) )
+    {
+        LogError( ( "Invalid input, pSession: %p, pSequenceNumbers: %p, sequenceNumbersCount: %u, pOutputSrtcpPacket: %p, pOutputSrtcpPacketLength: %p",
+                    pSession,
+                    pSequenceNumbers,
+                    sequenceNumbersCount,
+                    pOutputSrtcpPacket,
+                    pOutputSrtcpPacketLength ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+
+    /* Serialize the generic NACK. The RTCP library only parses feedback messages, so it's written here.
+     * The sequence numbers come in order, so each FCI covers a PID and the 16 following ones in its BLP. */
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        while( i < sequenceNumbersCount )
+        {
+            if( rtcpBufferLength + PEER_CONNECTION_SRTCP_NACK_FCI_LENGTH + PEER_CONNECTION_SRTCP_TRAILER_LENGTH > *pOutputSrtcpPacketLength )
+            {
+                LogError( ( "No space for NACK FCI, buffer length: %u", *pOutputSrtcpPacketLength ) );
+                ret = PEER_CONNECTION_RESULT_FAIL_RTCP_SERIALIZE_NACK;
+                break;
+            }
+
+            pid = pSequenceNumbers[ i ];
+            blp = 0U;
+            for( j = i + 1; j < sequenceNumbersCount; j++ )
+            {
+                offset = ( uint16_t )( pSequenceNumbers[ j ] - pid );
+                if( ( offset == 0U ) || ( offset > PEER_CONNECTION_SRTCP_NACK_BLP_BITS ) )
+                {
+                    break;
+                }
+                blp |= ( uint16_t )( 1U << ( offset - 1U ) );
+            }
+            i = j;
+
+            pOutputSrtcpPacket[ rtcpBufferLength++ ] = ( uint8_t )( pid >> 8 );
+            pOutputSrtcpPacket[ rtcpBufferLength++ ] = ( uint8_t )( pid & 0xFF );
+            pOutputSrtcpPacket[ rtcpBufferLength++ ] = ( uint8_t )( blp >> 8 );
+            pOutputSrtcpPacket[ rtcpBufferLength++ ] = ( uint8_t )( blp & 0xFF );
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        pOutputSrtcpPacket[ 0 ] = PEER_CONNECTION_SRTCP_NACK_FIRST_BYTE;
+        pOutputSrtcpPacket[ 1 ] = PEER_CONNECTION_SRTCP_NACK_PACKET_TYPE;
+        /* Length in 32-bit words minus one. */
+        pOutputSrtcpPacket[ 2 ] = ( uint8_t )( ( ( rtcpBufferLength / 4 ) - 1 ) >> 8 );
+        pOutputSrtcpPacket[ 3 ] = ( uint8_t )( ( ( rtcpBufferLength / 4 ) - 1 ) & 0xFF );
+        pOutputSrtcpPacket[ 4 ] = ( uint8_t )( senderSsrc >> 24 );
+        pOutputSrtcpPacket[ 5 ] = ( uint8_t )( senderSsrc >> 16 );
+        pOutputSrtcpPacket[ 6 ] = ( uint8_t )( senderSsrc >> 8 );
+        pOutputSrtcpPacket[ 7 ] = ( uint8_t )( senderSsrc & 0xFF );
+        pOutputSrtcpPacket[ 8 ] = ( uint8_t )( mediaSsrc >> 24 );
+        pOutputSrtcpPacket[ 9 ] = ( uint8_t )( mediaSsrc >> 16 );
+        pOutputSrtcpPacket[ 10 ] = ( uint8_t )( mediaSsrc >> 8 );
+        pOutputSrtcpPacket[ 11 ] = ( uint8_t )( mediaSsrc & 0xFF );
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        if( xSemaphoreTake( pSession->srtpSessionMutex,
+                            portMAX_DELAY ) == pdTRUE )
+        {
+            isLocked = 1U;
+        }
+        else
+        {
+            LogError( ( "Fail to take SRTP session mutex to construct SRTCP packet." ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_SRTP_MUTEX;
+        }
+    }
+
+    /* Encrypt it by SRTP. */
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        if( pSession->srtpTransmitSession != NULL )
+        {
+            errorStatus = srtp_protect_rtcp( pSession->srtpTransmitSession,
+                                             pOutputSrtcpPacket,
+                                             rtcpBufferLength,
+                                             pOutputSrtcpPacket,
+                                             pOutputSrtcpPacketLength,
+                                             0 );
+            if( errorStatus != srtp_err_status_ok )
+            {
+                LogError( ( "Fail to encrypt Tx SRTCP packet, errorStatus: %d", errorStatus ) );
+                ret = PEER_CONNECTION_RESULT_FAIL_ENCRYPT_SRTP_RTCP_PACKET;
+            }
+        }
+        else
+        {
+            LogWarn( ( "SRTP session has been freed before encrypting." ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_ENCRYPT_SRTP_RTCP_PACKET;
+        }
+    }
+
+    if( isLocked != 0U )
+    {
+        xSemaphoreGive( pSession->srtpSessionMutex );
+    }
+
+    return ret;
+}
+
+#if PEER_CONNECTION_ENABLE_RECEIVER_REPORT
+static void WriteUint32( uint8_t * pBuffer,
+                         uint32_t value )
+{
+    pBuffer[ 0 ] = ( uint8_t )( value >> 24 );
+    pBuffer[ 1 ] = ( uint8_t )( value >> 16 );
+    pBuffer[ 2 ] = ( uint8_t )( value >> 8 );
+    pBuffer[ 3 ] = ( uint8_t )( value & 0xFF );
+}
+
+PeerConnectionResult_t PeerConnectionSrtcp_GetReceptionReport( PeerConnectionSrtpReceiver_t * pSrtpReceiver,
+                                                               uint64_t currentTimeUs,
+                                                               RtcpReceptionReport_t * pReceptionReport )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    PeerConnectionRtpReceiverStats_t * pStats;
+    uint32_t extendedMax, expected, expectedInterval, receivedInterval;
+    int32_t lost, lostInterval;
+
+    if( ( pSrtpReceiver == NULL ) ||
+        ( pReceptionReport == NULL ) )
+    {
+        LogError( ( "Invalid input, pSrtpReceiver: %p, pReceptionReport: %p", pSrtpReceiver, pReceptionReport ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+    else if( pSrtpReceiver->rxStats.isStarted == 0U )
+    {
+        /* Nothing received on this stream yet. */
+        ret = PEER_CONNECTION_RESULT_UNKNOWN_SSRC;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        /* https://datatracker.ietf.org/doc/html/rfc3550#appendix-A.3 */
+        pStats = &pSrtpReceiver->rxStats;
+        extendedMax = pStats->sequenceCycles + pStats->maxSequenceNumber;
+        expected = extendedMax - pStats->baseSequenceNumber + 1;
+        lost = ( int32_t )( expected - pStats->packetsReceived );
+        if( lost > PEER_CONNECTION_SRTCP_CUMULATIVE_LOST_MAX )
+        {
+            lost = PEER_CONNECTION_SRTCP_CUMULATIVE_LOST_MAX;
+        }
+        else if( lost < PEER_CONNECTION_SRTCP_CUMULATIVE_LOST_MIN )
+        {
+            lost = PEER_CONNECTION_SRTCP_CUMULATIVE_LOST_MIN;
+        }
+        else
+        {
+            /* Empty else marker. */
+        }
+
+        expectedInterval = expected - pStats->expectedPrior;
+        receivedInterval = pStats->packetsReceived - pStats->receivedPrior;
+        lostInterval = ( int32_t )( expectedInterval - receivedInterval );
+        pStats->expectedPrior = expected;
+        pStats->receivedPrior = pStats->packetsReceived;
+
+        memset( pReceptionReport,
+                0,
+                sizeof( RtcpReceptionReport_t ) );
+        pReceptionReport->sourceSsrc = pStats->ssrc;
+        pReceptionReport->fractionLost = ( ( expectedInterval == 0U ) || ( lostInterval <= 0 ) ) ? 0U :
+                                         ( uint8_t )( ( ( uint32_t ) lostInterval << 8 ) / expectedInterval );
+        pReceptionReport->cumulativePacketsLost = ( uint32_t ) lost & 0xFFFFFF;
+        pReceptionReport->extendedHighestSeqNumReceived = extendedMax;
+        pReceptionReport->interArrivalJitter = pStats->jitter >> 4;
+        pReceptionReport->lastSR = pStats->lastSenderReportNtp;
+        if( pStats->lastSenderReportNtp != 0U )
+        {
+            /* DLSR in units of 1/65536 seconds. */
+            pReceptionReport->delaySinceLastSR = ( uint32_t )( ( ( currentTimeUs - pStats->lastSenderReportTimeUs ) * PEER_CONNECTION_SRTCP_DLSR_TIMESCALE ) / 1000000U );
+        }
+    }
+
+    return ret;
+}
+
+PeerConnectionResult_t PeerConnectionSrtcp_ConstructReceiverReportPacket( PeerConnectionSession_t * pSession,
+                                                                          uint32_t senderSsrc,
+                                                                          const RtcpReceptionReport_t * pReceptionReports,
+                                                                          size_t numReceptionReports,
+                                                                          uint8_t * pOutputSrtcpPacket,
+                                                                          size_t * pOutputSrtcpPacketLength )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    size_t rtcpBufferLength = PEER_CONNECTION_SRTCP_RECEIVER_REPORT_HEADER_LENGTH + ( numReceptionReports * PEER_CONNECTION_SRTCP_RECEPTION_REPORT_LENGTH );
+    uint8_t * pBlock;
+    size_t i;
+    srtp_err_status_t errorStatus;
+    uint8_t isLocked = 0U;
+
+    if( ( pSession == NULL ) ||
+        ( pReceptionReports == NULL ) ||
+        ( numReceptionReports == 0 ) ||
+        ( pOutputSrtcpPacket == NULL ) ||
+        ( pOutputSrtcpPacketLength == NULL ) )
+    {
+        LogError( ( "Invalid input, pSession: %p, pReceptionReports: %p, numReceptionReports: %u, pOutputSrtcpPacket: %p, pOutputSrtcpPacketLength: %p",
+                    pSession,
+                    pReceptionReports,
+                    numReceptionReports,
+                    pOutputSrtcpPacket,
+                    pOutputSrtcpPacketLength ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+    else if( ( numReceptionReports > PEER_CONNECTION_RTCP_RECEIVER_REPORT_RECEPTION_REPORT_NUM ) ||
+             ( rtcpBufferLength + PEER_CONNECTION_SRTCP_TRAILER_LENGTH > *pOutputSrtcpPacketLength ) )
+    {
+        LogError( ( "No space for %u reception reports, buffer length: %u", numReceptionReports, *pOutputSrtcpPacketLength ) );
+        ret = PEER_CONNECTION_RESULT_FAIL_RTCP_SERIALIZE_RECEIVER_REPORT;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    /* Serialize the receiver report. The RTCP library only serializes sender reports, so it's written here. */
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        pOutputSrtcpPacket[ 0 ] = ( uint8_t )( PEER_CONNECTION_SRTCP_RECEIVER_REPORT_FIRST_BYTE | numReceptionReports );
+        pOutputSrtcpPacket[ 1 ] = PEER_CONNECTION_SRTCP_RECEIVER_REPORT_PACKET_TYPE;
+        /* Length in 32-bit words minus one. */
+        pOutputSrtcpPacket[ 2 ] = ( uint8_t )( ( ( rtcpBufferLength / 4 ) - 1 ) >> 8 );
+        pOutputSrtcpPacket[ 3 ] = ( uint8_t )( ( ( rtcpBufferLength / 4 ) - 1 ) & 0xFF );
+        WriteUint32( &pOutputSrtcpPacket[ 4 ], senderSsrc );
+
+        for( i = 0; i < numReceptionReports; i++ )
+        {
+            pBlock = &pOutputSrtcpPacket[ PEER_CONNECTION_SRTCP_RECEIVER_REPORT_HEADER_LENGTH + ( i * PEER_CONNECTION_SRTCP_RECEPTION_REPORT_LENGTH ) ];
+            WriteUint32( &pBlock[ 0 ], pReceptionReports[ i ].sourceSsrc );
+            /* Fraction lost in the top byte, 24-bit cumulative lost below it. */
+            WriteUint32( &pBlock[ 4 ], ( ( uint32_t ) pReceptionReports[ i ].fractionLost << 24 ) | ( pReceptionReports[ i ].cumulativePacketsLost & 0xFFFFFF ) );
+            WriteUint32( &pBlock[ 8 ], pReceptionReports[ i ].extendedHighestSeqNumReceived );
+            WriteUint32( &pBlock[ 12 ], pReceptionReports[ i ].interArrivalJitter );
+            WriteUint32( &pBlock[ 16 ], pReceptionReports[ i ].lastSR );
+            WriteUint32( &pBlock[ 20 ], pReceptionReports[ i ].delaySinceLastSR );
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        if( xSemaphoreTake( pSession->srtpSessionMutex,
+                            portMAX_DELAY ) == pdTRUE )
+        {
+            isLocked = 1U;
+        }
+        else
+        {
+            LogError( ( "Fail to take SRTP session mutex to construct SRTCP packet." ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_TAKE_SRTP_MUTEX;
+        }
+    }
+
+    /* Encrypt it by SRTP. */
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        if( pSession->srtpTransmitSession != NULL )
+        {
+            errorStatus = srtp_protect_rtcp( pSession->srtpTransmitSession,
+                                             pOutputSrtcpPacket,
+                                             rtcpBufferLength,
+                                             pOutputSrtcpPacket,
+                                             pOutputSrtcpPacketLength,
+                                             0 );
+            if( errorStatus != srtp_err_status_ok )
+            {
+                LogError( ( "Fail to encrypt Tx SRTCP packet, errorStatus: %d", errorStatus ) );
+                ret = PEER_CONNECTION_RESULT_FAIL_ENCRYPT_SRTP_RTCP_PACKET;
+            }
+        }
+        else
+        {
+            LogWarn( ( "SRTP session has been freed before encrypting." ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_ENCRYPT_SRTP_RTCP_PACKET;
+        }
+    }
+
+    if( isLocked != 0U )
+    {
+        xSemaphoreGive( pSession->srtpSessionMutex );
+    }
+
+    return ret;
+}
+#endif /* PEER_CONNECTION_ENABLE_RECEIVER_REPORT */
+
 PeerConnectionResult_t PeerConnectionSrtp_HandleSrtcpPacket( PeerConnectionSession_t * pSession,
                                                              uint8_t * pBuffer,
                                                              size_t bufferLength )
@@ -31,6 +31,12 @@ extern "C" {
 /* 28 Bytes of RTCP with 0 Reception Reports + 14 bytes of SRTCP */
 #define PEER_CONNECTION_SRTCP_RTCP_PACKET_MIN_LENGTH      ( 42 )
 
+/* 12 bytes of RTCP header and SSRCs, one 4-byte FCI per missing packet at most, + 14 bytes of SRTCP */
+#define PEER_CONNECTION_SRTCP_NACK_PACKET_MAX_LENGTH      ( 12 + 4 * PEER_CONNECTION_JITTER_BUFFER_NACK_MAX_ENTRY_NUM + 14 )
+
+/* 8 bytes of RTCP header and sender SSRC, 24 bytes per reception report (one per receiver) + 14 bytes of SRTCP */
+#define PEER_CONNECTION_SRTCP_RECEIVER_REPORT_PACKET_MAX_LENGTH      ( 8 + 24 * PEER_CONNECTION_TRANSCEIVER_MAX_COUNT + 14 )
+
 PeerConnectionResult_t PeerConnectionSrtp_HandleSrtcpPacket( PeerConnectionSession_t * pSession,
                                                              uint8_t * pBuffer,
                                                              size_t bufferLength );
@@ -38,6 +44,26 @@ PeerConnectionResult_t PeerConnectionSrtcp_ConstructSenderReportPacket( PeerConn
                                                                         RtcpSenderReport_t * pSenderReport,
                                                                         uint8_t * pOutputSrtcpPacket,
                                                                         size_t * pOutputSrtcpPacketLength );
+#if PEER_CONNECTION_ENABLE_RECEIVER_REPORT
+/* Fill the reception report of one incoming stream and start a new fraction lost interval.
+ * Returns PEER_CONNECTION_RESULT_UNKNOWN_SSRC while nothing has been received on it. */
+PeerConnectionResult_t PeerConnectionSrtcp_GetReceptionReport( PeerConnectionSrtpReceiver_t * pSrtpReceiver,
+                                                               uint64_t currentTimeUs,
+                                                               RtcpReceptionReport_t * pReceptionReport );
+PeerConnectionResult_t PeerConnectionSrtcp_ConstructReceiverReportPacket( PeerConnectionSession_t * pSession,
+                                                                          uint32_t senderSsrc,
+                                                                          const RtcpReceptionReport_t * pReceptionReports,
+                                                                          size_t numReceptionReports,
+                                                                          uint8_t * pOutputSrtcpPacket,
+                                                                          size_t * pOutputSrtcpPacketLength );
+#endif /* PEER_CONNECTION_ENABLE_RECEIVER_REPORT */
+PeerConnectionResult_t PeerConnectionSrtcp_ConstructNackPacket( PeerConnectionSession_t * pSession,
+                                                                uint32_t senderSsrc,
+                                                                uint32_t mediaSsrc,
+                                                                const uint16_t * pSequenceNumbers,
+                                                                size_t sequenceNumbersCount,
+                                                                uint8_t * pOutputSrtcpPacket,
+                                                                size_t * pOutputSrtcpPacketLength );
 
 #ifdef __cplusplus
 }
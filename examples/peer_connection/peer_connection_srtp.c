@@ -18,6 +18,7 @@
 #include "logging.h"
 #include "peer_connection.h"
 #include "peer_connection_srtp.h"
+#include "peer_connection_srtcp.h"
 #include "peer_connection_rolling_buffer.h"
 #include "peer_connection_jitter_buffer.h"
 #if METRIC_PRINT_ENABLED
@@ -35,8 +36,89 @@
 #include "peer_connection_h265_helper.h"
 #include "peer_connection_opus_helper.h"
 
+/* https://datatracker.ietf.org/doc/html/rfc3550#appendix-A.1 */
+#define PEER_CONNECTION_SRTP_RECEIVER_STATS_MAX_DROPOUT ( 3000 )
+#define PEER_CONNECTION_SRTP_RECEIVER_STATS_MAX_MISORDER ( 100 )
+
 /*-----------------------------------------------------------*/
 
+static void DeliverFrame( PeerConnectionSrtpReceiver_t * pSrtpReceiver,
+                          size_t frameLength,
+                          uint32_t rtpTimestamp,
+                          uint32_t flags )
+{
+    PeerConnectionFrame_t frame;
+
+    if( pSrtpReceiver->onFrameReadyCallbackFunc )
+    {
+        memset( &frame, 0, sizeof( PeerConnectionFrame_t ) );
+        frame.version = PEER_CONNECTION_FRAME_CURRENT_VERSION;
+        frame.presentationUs = PEER_CONNECTION_SRTP_CONVERT_RTP_TIMESTAMP_TO_TIME_US( pSrtpReceiver->rxJitterBuffer.clockRate,
+                                                                                    rtpTimestamp );
+        frame.pData = pSrtpReceiver->frameBuffer;
+        frame.dataLength = frameLength;
+        frame.flags = flags;
+        pSrtpReceiver->onFrameReadyCallbackFunc( pSrtpReceiver->pOnFrameReadyCallbackCustomContext,
+                                                 &frame );
+    }
+}
+
+#if PEER_CONNECTION_ENABLE_OPUS_FEC_RECOVERY
+static void RecoverOpusFrames( PeerConnectionSrtpReceiver_t * pSrtpReceiver,
+                               uint16_t startSequence,
+                               uint16_t endSequence )
+{
+    PeerConnectionResult_t retFillFrame;
+    PeerConnectionJitterBufferPacket_t * pPacket;
+    size_t frameBufferLength;
+    uint32_t rtpTimestamp;
+    uint16_t i;
+
+    /* Every Opus packet is a whole frame, so the ones that did arrive in a dropped range are still
+     * playable. A lost one is covered by the FEC in the packet right after it, when that arrived. */
+    for( i = startSequence; i != ( uint16_t )( endSequence + 1U ); i++ )
+    {
+        pPacket = &pSrtpReceiver->rxJitterBuffer.rtpPackets[ PEER_CONNECTION_JITTER_BUFFER_WRAP( i,
+                                                                                                 PEER_CONNECTION_JITTER_BUFFER_MAX_ENTRY_NUM ) ];
+        frameBufferLength = PEER_CONNECTION_FRAME_BUFFER_SIZE;
+
+        if( ( pPacket->isPushed != 0U ) &&
+            ( pPacket->sequenceNumber == i ) )
+        {
+            retFillFrame = PeerConnectionJitterBuffer_FillFrame( &pSrtpReceiver->rxJitterBuffer,
+                                                                 i,
+                                                                 i,
+                                                                 pSrtpReceiver->frameBuffer,
+                                                                 &frameBufferLength,
+                                                                 &rtpTimestamp );
+            if( retFillFrame == PEER_CONNECTION_RESULT_OK )
+            {
+                DeliverFrame( pSrtpReceiver,
+                              frameBufferLength,
+                              rtpTimestamp,
+                              0U );
+            }
+        }
+        else
+        {
+            retFillFrame = PeerConnectionOpusHelper_FillFecFrameOpus( &pSrtpReceiver->rxJitterBuffer,
+                                                                      i,
+                                                                      pSrtpReceiver->frameBuffer,
+                                                                      &frameBufferLength,
+                                                                      &rtpTimestamp );
+            if( retFillFrame == PEER_CONNECTION_RESULT_OK )
+            {
+                LogDebug( ( "Recovering lost Opus packet seq: %u from in-band FEC", i ) );
+                DeliverFrame( pSrtpReceiver,
+                              frameBufferLength,
+                              rtpTimestamp,
+                              PEER_CONNECTION_FRAME_FLAG_OPUS_FEC );
+            }
+        }
+    }
+}
+#endif /* PEER_CONNECTION_ENABLE_OPUS_FEC_RECOVERY */
+
 static PeerConnectionResult_t OnJitterBufferFrameReady( void * pCustomContext,
                                                         uint16_t startSequence,
                                                         uint16_t endSequence )
@@ -44,7 +126,6 @@ static PeerConnectionResult_t OnJitterBufferFrameReady( void * pCustomContext,
     PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK, retFillFrame = PEER_CONNECTION_RESULT_OK;
     PeerConnectionSrtpReceiver_t * pSrtpReceiver = NULL;
     size_t frameBufferLength = PEER_CONNECTION_FRAME_BUFFER_SIZE;
-    PeerConnectionFrame_t frame;
     uint32_t rtpTimestamp;
 
     if( pCustomContext == NULL )
@@ -73,17 +154,10 @@ static PeerConnectionResult_t OnJitterBufferFrameReady( void * pCustomContext,
 
         if( retFillFrame == PEER_CONNECTION_RESULT_OK )
         {
-            if( pSrtpReceiver->onFrameReadyCallbackFunc )
-            {
-                memset( &frame, 0, sizeof( PeerConnectionFrame_t ) );
-                frame.version = PEER_CONNECTION_FRAME_CURRENT_VERSION;
-                frame.presentationUs = PEER_CONNECTION_SRTP_CONVERT_RTP_TIMESTAMP_TO_TIME_US( pSrtpReceiver->rxJitterBuffer.clockRate,
-                                                                                            rtpTimestamp );
-                frame.pData = pSrtpReceiver->frameBuffer;
-                frame.dataLength = frameBufferLength;
-                pSrtpReceiver->onFrameReadyCallbackFunc( pSrtpReceiver->pOnFrameReadyCallbackCustomContext,
-                                                         &frame );
-            }
+            DeliverFrame( pSrtpReceiver,
+                          frameBufferLength,
+                          rtpTimestamp,
+                          0U );
         }
     }
 
@@ -95,6 +169,9 @@ static PeerConnectionResult_t OnJitterBufferFrameDrop( void * pCustomContext,
                                                        uint16_t endSequence )
 {
     PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    #if PEER_CONNECTION_ENABLE_OPUS_FEC_RECOVERY
+    PeerConnectionSrtpReceiver_t * pSrtpReceiver = NULL;
+    #endif /* PEER_CONNECTION_ENABLE_OPUS_FEC_RECOVERY */
 
     if( pCustomContext == NULL )
     {
@@ -107,6 +184,17 @@ static PeerConnectionResult_t OnJitterBufferFrameDrop( void * pCustomContext,
         LogDebug( ( "Dropping packets from start seq: %u to end seq: %u",
                     startSequence,
                     endSequence ) );
+
+        #if PEER_CONNECTION_ENABLE_OPUS_FEC_RECOVERY
+        pSrtpReceiver = ( PeerConnectionSrtpReceiver_t * ) pCustomContext;
+        if( TRANSCEIVER_IS_CODEC_ENABLED( pSrtpReceiver->rxJitterBuffer.codec,
+                                          TRANSCEIVER_RTC_CODEC_OPUS_BIT ) )
+        {
+            RecoverOpusFrames( pSrtpReceiver,
+                               startSequence,
+                               endSequence );
+        }
+        #endif /* PEER_CONNECTION_ENABLE_OPUS_FEC_RECOVERY */
     }
 
     return ret;
@@ -201,6 +289,267 @@ PeerConnectionResult_t PeerConnectionSrtp_ConstructSrtpPacket( PeerConnectionSes
     return ret;
 }
 
+/* Write the negotiated RTP header extensions of one outgoing packet, it must be called
+ * under the sender mutex because it consumes the TWCC sequence number. */
+void PeerConnectionSrtp_WriteRtpHeaderExtensions( PeerConnectionSession_t * pSession,
+                                                  TransceiverTrackKind_t trackKind,
+                                                  PeerConnectionRollingBufferPacket_t * pRollingBufferPacket,
+                                                  size_t payloadLength )
+{
+    uint8_t elements[ PEER_CONNECTION_RTP_EXTENSION_MAX_WORDS * 4 ];
+    size_t elementsLength = 0;
+    size_t i;
+    uint32_t absSendTime;
+    #if ENABLE_TWCC_SUPPORT
+    TwccPacketInfo_t packetInfo;
+    #else
+    ( void ) payloadLength;
+    #endif /* ENABLE_TWCC_SUPPORT */
+
+    if( ( pSession->rtpConfig.twccId > 0 ) &&
+        ( pSession->rtpConfig.twccId <= PEER_CONNECTION_SRTP_RTP_EXTENSION_ONE_BYTE_MAX_ID ) )
+    {
+        elements[ elementsLength++ ] = PEER_CONNECTION_SRTP_RTP_EXTENSION_ONE_BYTE_HEADER( pSession->rtpConfig.twccId,
+                                                                                        PEER_CONNECTION_SRTP_TWCC_EXT_DATA_LENGTH );
+        elements[ elementsLength++ ] = ( uint8_t ) ( pSession->rtpConfig.twccSequence >> 8 );
+        elements[ elementsLength++ ] = ( uint8_t ) ( pSession->rtpConfig.twccSequence );
+
+        #if ENABLE_TWCC_SUPPORT
+        memset( &packetInfo, 0, sizeof( TwccPacketInfo_t ) );
+        packetInfo.packetSize = payloadLength;
+        packetInfo.localSentTime = NetworkingUtils_GetCurrentTimeUs( NULL );
+        packetInfo.packetSeqNum = pSession->rtpConfig.twccSequence;
+
+        RtcpTwccManager_AddPacketInfo( &pSession->pCtx->rtcpTwccManager,
+                                       &packetInfo );
+        #endif /* ENABLE_TWCC_SUPPORT */
+
+        pSession->rtpConfig.twccSequence++;
+    }
+
+    if( ( pSession->rtpConfig.absSendTimeId > 0 ) &&
+        ( pSession->rtpConfig.absSendTimeId <= PEER_CONNECTION_SRTP_RTP_EXTENSION_ONE_BYTE_MAX_ID ) )
+    {
+        absSendTime = PEER_CONNECTION_SRTP_GET_ABS_SEND_TIME( NetworkingUtils_GetCurrentTimeUs( NULL ) );
+        elements[ elementsLength++ ] = PEER_CONNECTION_SRTP_RTP_EXTENSION_ONE_BYTE_HEADER( pSession->rtpConfig.absSendTimeId,
+                                                                                        PEER_CONNECTION_SRTP_ABS_SEND_TIME_EXT_DATA_LENGTH );
+        elements[ elementsLength++ ] = ( uint8_t ) ( absSendTime >> 16 );
+        elements[ elementsLength++ ] = ( uint8_t ) ( absSendTime >> 8 );
+        elements[ elementsLength++ ] = ( uint8_t ) ( absSendTime );
+    }
+
+    if( ( trackKind == TRANSCEIVER_TRACK_KIND_VIDEO ) &&
+        ( pSession->rtpConfig.playoutDelayId > 0 ) &&
+        ( pSession->rtpConfig.playoutDelayId <= PEER_CONNECTION_SRTP_RTP_EXTENSION_ONE_BYTE_MAX_ID ) )
+    {
+        /* 12-bit MIN and 12-bit MAX delay, both in 10 ms units. */
+        elements[ elementsLength++ ] = PEER_CONNECTION_SRTP_RTP_EXTENSION_ONE_BYTE_HEADER( pSession->rtpConfig.playoutDelayId,
+                                                                                        PEER_CONNECTION_SRTP_PLAYOUT_DELAY_EXT_DATA_LENGTH );
+        elements[ elementsLength++ ] = ( uint8_t ) ( ( PEER_CONNECTION_PLAYOUT_DELAY_MIN_MS / PEER_CONNECTION_SRTP_PLAYOUT_DELAY_GRANULARITY_MS ) >> 4 );
+        elements[ elementsLength++ ] = ( uint8_t ) ( ( ( ( PEER_CONNECTION_PLAYOUT_DELAY_MIN_MS / PEER_CONNECTION_SRTP_PLAYOUT_DELAY_GRANULARITY_MS ) & 0xF ) << 4 ) |
+                                                     ( ( PEER_CONNECTION_PLAYOUT_DELAY_MAX_MS / PEER_CONNECTION_SRTP_PLAYOUT_DELAY_GRANULARITY_MS ) >> 8 ) );
+        elements[ elementsLength++ ] = ( uint8_t ) ( PEER_CONNECTION_PLAYOUT_DELAY_MAX_MS / PEER_CONNECTION_SRTP_PLAYOUT_DELAY_GRANULARITY_MS );
+    }
+
+    if( elementsLength > 0 )
+    {
+        /* Zero padding to 32-bit words. */
+        while( ( elementsLength & 0x3 ) != 0 )
+        {
+            elements[ elementsLength++ ] = 0;
+        }
+
+        /* The RTP serializer writes each payload word in network order. */
+        for( i = 0; i < elementsLength / 4; i++ )
+        {
+            pRollingBufferPacket->extensionPayload[ i ] = ( ( uint32_t ) elements[ i * 4 ] << 24 ) |
+                                                          ( ( uint32_t ) elements[ i * 4 + 1 ] << 16 ) |
+                                                          ( ( uint32_t ) elements[ i * 4 + 2 ] << 8 ) |
+                                                          ( ( uint32_t ) elements[ i * 4 + 3 ] );
+        }
+
+        pRollingBufferPacket->rtpPacket.header.flags |= RTP_HEADER_FLAG_EXTENSION;
+        pRollingBufferPacket->rtpPacket.header.extension.extensionProfile = PEER_CONNECTION_SRTP_RTP_EXTENSION_ONE_BYTE_PROFILE;
+        pRollingBufferPacket->rtpPacket.header.extension.extensionPayloadLength = elementsLength / 4;
+        pRollingBufferPacket->rtpPacket.header.extension.pExtensionPayload = pRollingBufferPacket->extensionPayload;
+    }
+}
+
+void PeerConnectionSrtp_GetPrimaryPayload( PeerConnectionJitterBufferPacket_t * pPacket,
+                                           uint8_t ** ppPayload,
+                                           size_t * pPayloadLength )
+{
+    #if PEER_CONNECTION_ENABLE_AUDIO_RED
+    PeerConnectionRedBlock_t primaryBlock;
+    size_t blockCount = 1U;
+    #endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
+
+    *ppPayload = pPacket->pPacketBuffer;
+    *pPayloadLength = pPacket->packetBufferLength;
+
+    #if PEER_CONNECTION_ENABLE_AUDIO_RED
+    /* RED packets are validated before buffering, so parsing only fails on a corrupted buffer. */
+    if( ( pPacket->isRedundantEncoding != 0U ) &&
+        ( PeerConnectionSrtp_ParseRedPayload( pPacket->pPacketBuffer,
+                                              pPacket->packetBufferLength,
+                                              &primaryBlock,
+                                              &blockCount ) == PEER_CONNECTION_RESULT_OK ) )
+    {
+        *ppPayload = primaryBlock.pData;
+        *pPayloadLength = primaryBlock.dataLength;
+    }
+    #endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
+}
+
+#if PEER_CONNECTION_ENABLE_AUDIO_RED
+size_t PeerConnectionSrtp_GetRedHeadroom( PeerConnectionSession_t * pSession,
+                                          uint32_t rtpTimestamp )
+{
+    size_t headroom = 0U;
+    PeerConnectionRedEncoder_t * pRedEncoder = &pSession->audioRedEncoder;
+
+    if( pSession->rtpConfig.audioCodecRedPayload != 0U )
+    {
+        headroom = PEER_CONNECTION_SRTP_RED_PRIMARY_HEADER_LENGTH;
+
+        /* Repeat the previous payload only when the 14-bit timestamp offset still reaches it. */
+        if( ( pRedEncoder->payloadLength > 0U ) &&
+            ( ( uint32_t )( rtpTimestamp - pRedEncoder->rtpTimestamp ) <= PEER_CONNECTION_SRTP_RED_MAX_TIMESTAMP_OFFSET ) )
+        {
+            headroom += PEER_CONNECTION_SRTP_RED_HEADER_LENGTH + pRedEncoder->payloadLength;
+        }
+    }
+
+    return headroom;
+}
+
+size_t PeerConnectionSrtp_WriteRedPayload( PeerConnectionSession_t * pSession,
+                                           uint32_t rtpTimestamp,
+                                           uint8_t * pPayload,
+                                           size_t headroom,
+                                           size_t primaryLength )
+{
+    PeerConnectionRedEncoder_t * pRedEncoder = &pSession->audioRedEncoder;
+    uint8_t payloadType = ( uint8_t )( pSession->rtpConfig.audioCodecPayload & PEER_CONNECTION_SRTP_RED_PAYLOAD_TYPE_MASK );
+    uint32_t timestampOffset;
+    size_t offset = 0U;
+
+    if( headroom > PEER_CONNECTION_SRTP_RED_PRIMARY_HEADER_LENGTH )
+    {
+        /* The headroom was sized by PeerConnectionSrtp_GetRedHeadroom() for the kept payload. */
+        timestampOffset = rtpTimestamp - pRedEncoder->rtpTimestamp;
+        pPayload[ offset++ ] = PEER_CONNECTION_SRTP_RED_FOLLOW_BIT | payloadType;
+        pPayload[ offset++ ] = ( uint8_t )( timestampOffset >> 6 );
+        pPayload[ offset++ ] = ( uint8_t )( ( ( timestampOffset & 0x3F ) << 2 ) | ( pRedEncoder->payloadLength >> 8 ) );
+        pPayload[ offset++ ] = ( uint8_t )( pRedEncoder->payloadLength );
+    }
+
+    pPayload[ offset++ ] = payloadType;
+
+    if( headroom > PEER_CONNECTION_SRTP_RED_PRIMARY_HEADER_LENGTH )
+    {
+        memcpy( &pPayload[ offset ], pRedEncoder->payload, pRedEncoder->payloadLength );
+    }
+
+    /* Keep this payload as the redundant block of the next packet. */
+    if( primaryLength <= PEER_CONNECTION_AUDIO_RED_MAX_BLOCK_LENGTH )
+    {
+        memcpy( pRedEncoder->payload, &pPayload[ headroom ], primaryLength );
+        pRedEncoder->payloadLength = primaryLength;
+        pRedEncoder->rtpTimestamp = rtpTimestamp;
+    }
+    else
+    {
+        pRedEncoder->payloadLength = 0U;
+    }
+
+    return headroom + primaryLength;
+}
+
+PeerConnectionResult_t PeerConnectionSrtp_ParseRedPayload( uint8_t * pPayload,
+                                                           size_t payloadLength,
+                                                           PeerConnectionRedBlock_t * pBlocks,
+                                                           size_t * pBlockCount )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    size_t headerOffset = 0U;
+    size_t dataOffset = 0U;
+    size_t redundantCount = 0U;
+    size_t skipCount = 0U;
+    size_t dataLength;
+    size_t i;
+    uint8_t * pHeader;
+
+    if( ( pPayload == NULL ) ||
+        ( pBlocks == NULL ) ||
+        ( pBlockCount == NULL ) ||
+        ( *pBlockCount == 0U ) )
+    {
+        LogError( ( "Invalid input, pPayload: %p, pBlocks: %p, pBlockCount: %p", pPayload, pBlocks, pBlockCount ) );
+        ret = PEER_CONNECTION_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        /* The redundant block headers come first, then the primary block header. */
+        while( ( headerOffset < payloadLength ) &&
+               ( ( pPayload[ headerOffset ] & PEER_CONNECTION_SRTP_RED_FOLLOW_BIT ) != 0U ) )
+        {
+            headerOffset += PEER_CONNECTION_SRTP_RED_HEADER_LENGTH;
+            redundantCount++;
+        }
+
+        if( headerOffset >= payloadLength )
+        {
+            LogWarn( ( "RED payload without primary block, length: %u", payloadLength ) );
+            ret = PEER_CONNECTION_RESULT_FAIL_RED_DESERIALIZE;
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        dataOffset = headerOffset + PEER_CONNECTION_SRTP_RED_PRIMARY_HEADER_LENGTH;
+        if( redundantCount + 1U > *pBlockCount )
+        {
+            skipCount = redundantCount + 1U - *pBlockCount;
+        }
+
+        for( i = 0U; i < redundantCount; i++ )
+        {
+            pHeader = &pPayload[ i * PEER_CONNECTION_SRTP_RED_HEADER_LENGTH ];
+            dataLength = ( ( size_t )( pHeader[ 2 ] & 0x03 ) << 8 ) | pHeader[ 3 ];
+            if( dataLength > payloadLength - dataOffset )
+            {
+                LogWarn( ( "RED block length: %u exceeds the payload, remaining: %u", dataLength, payloadLength - dataOffset ) );
+                ret = PEER_CONNECTION_RESULT_FAIL_RED_DESERIALIZE;
+                break;
+            }
+
+            if( i >= skipCount )
+            {
+                pBlocks[ i - skipCount ].payloadType = pHeader[ 0 ] & PEER_CONNECTION_SRTP_RED_PAYLOAD_TYPE_MASK;
+                pBlocks[ i - skipCount ].timestampOffset = ( uint16_t )( ( ( uint16_t ) pHeader[ 1 ] << 6 ) | ( pHeader[ 2 ] >> 2 ) );
+                pBlocks[ i - skipCount ].pData = &pPayload[ dataOffset ];
+                pBlocks[ i - skipCount ].dataLength = dataLength;
+            }
+            dataOffset += dataLength;
+        }
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        /* The primary block takes the rest of the payload. */
+        pBlocks[ redundantCount - skipCount ].payloadType = pPayload[ headerOffset ] & PEER_CONNECTION_SRTP_RED_PAYLOAD_TYPE_MASK;
+        pBlocks[ redundantCount - skipCount ].timestampOffset = 0U;
+        pBlocks[ redundantCount - skipCount ].pData = &pPayload[ dataOffset ];
+        pBlocks[ redundantCount - skipCount ].dataLength = payloadLength - dataOffset;
+        *pBlockCount = redundantCount + 1U - skipCount;
+    }
+
+    return ret;
+}
+#endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
+
 PeerConnectionResult_t PeerConnectionSrtp_Init( PeerConnectionSession_t * pSession )
 {
     PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
@@ -391,7 +740,8 @@ PeerConnectionResult_t PeerConnectionSrtp_Init( PeerConnectionSession_t * pSessi
                                                          pSrtpReceiver,
                                                          OnJitterBufferFrameDrop,
                                                          pSrtpReceiver,
-                                                         PEER_CONNECTION_SRTP_JITTER_BUFFER_TOLERENCE_TIME_SECOND,   // buffer time in seconds
+                                                         PEER_CONNECTION_JITTER_BUFFER_VIDEO_MIN_DELAY_MS,
+                                                         PEER_CONNECTION_JITTER_BUFFER_VIDEO_MAX_DELAY_MS,
                                                          pSession->pTransceivers[i]->codecBitMap,
                                                          PEER_CONNECTION_SRTP_VIDEO_CLOCKRATE );
             }
@@ -412,9 +762,11 @@ PeerConnectionResult_t PeerConnectionSrtp_Init( PeerConnectionSession_t * pSessi
                                                          pSrtpReceiver,
                                                          OnJitterBufferFrameDrop,
                                                          pSrtpReceiver,
-                                                         PEER_CONNECTION_SRTP_JITTER_BUFFER_TOLERENCE_TIME_SECOND,   // buffer time in seconds
+                                                         PEER_CONNECTION_JITTER_BUFFER_AUDIO_MIN_DELAY_MS,
+                                                         PEER_CONNECTION_JITTER_BUFFER_AUDIO_MAX_DELAY_MS,
                                                          pSession->pTransceivers[i]->codecBitMap,
-                                                         PEER_CONNECTION_SRTP_PCM_CLOCKRATE );
+                                                         TRANSCEIVER_IS_CODEC_ENABLED( pSession->pTransceivers[i]->codecBitMap,
+                                                                                       TRANSCEIVER_RTC_CODEC_OPUS_BIT ) ? PEER_CONNECTION_SRTP_OPUS_CLOCKRATE : PEER_CONNECTION_SRTP_PCM_CLOCKRATE );
             }
             else
             {
@@ -506,6 +858,9 @@ PeerConnectionResult_t PeerConnectionSrtp_DeInit( PeerConnectionSession_t * pSes
                               portMAX_DELAY ) == pdTRUE ) )
         {
             PeerConnectionRollingBuffer_Free( &pSession->audioSrtpSender.txRollingBuffer );
+            #if PEER_CONNECTION_ENABLE_AUDIO_RED
+            memset( &pSession->audioRedEncoder, 0, sizeof( PeerConnectionRedEncoder_t ) );
+            #endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
             xSemaphoreGive( pSession->audioSrtpSender.senderMutex );
         }
     }
@@ -515,6 +870,9 @@ PeerConnectionResult_t PeerConnectionSrtp_DeInit( PeerConnectionSession_t * pSes
         /* Clean up Video SRTP Receiver */
         memset( pSession->videoSrtpReceiver.frameBuffer, 0, PEER_CONNECTION_FRAME_BUFFER_SIZE );
         PeerConnectionJitterBuffer_Free( &pSession->videoSrtpReceiver.rxJitterBuffer );
+        #if PEER_CONNECTION_ENABLE_RECEIVER_STATS
+        memset( &pSession->videoSrtpReceiver.rxStats, 0, sizeof( PeerConnectionRtpReceiverStats_t ) );
+        #endif /* PEER_CONNECTION_ENABLE_RECEIVER_STATS */
     }
 
     if( ret == PEER_CONNECTION_RESULT_OK )
@@ -522,6 +880,9 @@ PeerConnectionResult_t PeerConnectionSrtp_DeInit( PeerConnectionSession_t * pSes
         /* Clean up Audio SRTP Receiver */
         memset( pSession->audioSrtpReceiver.frameBuffer, 0, PEER_CONNECTION_FRAME_BUFFER_SIZE );
         PeerConnectionJitterBuffer_Free( &pSession->audioSrtpReceiver.rxJitterBuffer );
+        #if PEER_CONNECTION_ENABLE_RECEIVER_STATS
+        memset( &pSession->audioSrtpReceiver.rxStats, 0, sizeof( PeerConnectionRtpReceiverStats_t ) );
+        #endif /* PEER_CONNECTION_ENABLE_RECEIVER_STATS */
     }
 
     if( ret == PEER_CONNECTION_RESULT_OK )
@@ -536,6 +897,246 @@ PeerConnectionResult_t PeerConnectionSrtp_DeInit( PeerConnectionSession_t * pSes
     return ret;
 }
 
+#if PEER_CONNECTION_ENABLE_RECEIVER_STATS
+static void UpdateReceiverStats( PeerConnectionRtpReceiverStats_t * pStats,
+                                 uint32_t clockRate,
+                                 const RtpPacket_t * pRtpPacket,
+                                 size_t packetLength )
+{
+    uint16_t delta;
+    uint32_t arrival, transit;
+    int32_t d;
+
+    /* https://datatracker.ietf.org/doc/html/rfc3550#appendix-A.8 measures the arrival time in RTP timestamp units. */
+    arrival = PEER_CONNECTION_SRTP_CONVERT_TIME_US_TO_RTP_TIMESTAMP( clockRate,
+                                                                     NetworkingUtils_GetCurrentTimeUs( NULL ) );
+    transit = arrival - pRtpPacket->header.timestamp;
+
+    if( pStats->isStarted == 0U )
+    {
+        /* The statistics are zeroed with the session, only the first packet fields are set. */
+        pStats->isStarted = 1U;
+        pStats->ssrc = pRtpPacket->header.ssrc;
+        pStats->baseSequenceNumber = pRtpPacket->header.sequenceNumber;
+        pStats->maxSequenceNumber = pRtpPacket->header.sequenceNumber;
+    }
+    else
+    {
+        /* https://datatracker.ietf.org/doc/html/rfc3550#appendix-A.1 */
+        delta = ( uint16_t )( pRtpPacket->header.sequenceNumber - pStats->maxSequenceNumber );
+        if( delta < PEER_CONNECTION_SRTP_RECEIVER_STATS_MAX_DROPOUT )
+        {
+            if( pRtpPacket->header.sequenceNumber < pStats->maxSequenceNumber )
+            {
+                pStats->sequenceCycles += 0x10000;
+            }
+            pStats->maxSequenceNumber = pRtpPacket->header.sequenceNumber;
+        }
+        else if( delta <= ( uint16_t )( 0x10000 - PEER_CONNECTION_SRTP_RECEIVER_STATS_MAX_MISORDER ) )
+        {
+            /* The sender restarted its sequence, count from here. */
+            LogInfo( ( "RTP sequence jumped from %u to %u, restarting reception statistics.",
+                       pStats->maxSequenceNumber,
+                       pRtpPacket->header.sequenceNumber ) );
+            pStats->sequenceCycles = 0U;
+            pStats->baseSequenceNumber = pRtpPacket->header.sequenceNumber;
+            pStats->maxSequenceNumber = pRtpPacket->header.sequenceNumber;
+            pStats->packetsReceived = 0U;
+            pStats->expectedPrior = 0U;
+            pStats->receivedPrior = 0U;
+        }
+        else
+        {
+            /* Duplicate or reordered packet, the highest sequence stays. */
+        }
+
+        d = ( int32_t )( transit - pStats->lastTransit );
+        if( d < 0 )
+        {
+            d = -d;
+        }
+        pStats->jitter += ( uint32_t ) d - ( ( pStats->jitter + 8 ) >> 4 );
+    }
+
+    pStats->lastTransit = transit;
+    pStats->packetsReceived++;
+    pStats->bytesReceived += packetLength;
+}
+#endif /* PEER_CONNECTION_ENABLE_RECEIVER_STATS */
+
+#if PEER_CONNECTION_ENABLE_RECEIVER_NACK
+static uint32_t GetRoundTripTimeMs( const PeerConnectionSession_t * pSession )
+{
+    uint32_t roundTripTimeMs = pSession->roundTripTimeMs;
+
+    if( roundTripTimeMs == 0U )
+    {
+        roundTripTimeMs = PEER_CONNECTION_RECEIVER_NACK_DEFAULT_RTT_MS;
+    }
+
+    return roundTripTimeMs;
+}
+
+static uint32_t GetNackRetryIntervalMs( const PeerConnectionSession_t * pSession )
+{
+    /* Ask again once per RTT, the retransmission should have arrived by then. */
+    uint32_t retryIntervalMs = GetRoundTripTimeMs( pSession );
+
+    if( retryIntervalMs < PEER_CONNECTION_RECEIVER_NACK_MIN_RETRY_INTERVAL_MS )
+    {
+        retryIntervalMs = PEER_CONNECTION_RECEIVER_NACK_MIN_RETRY_INTERVAL_MS;
+    }
+
+    return retryIntervalMs;
+}
+
+static void SendReceiverNack( PeerConnectionSession_t * pSession,
+                              PeerConnectionSrtpReceiver_t * pSrtpReceiver,
+                              TransceiverTrackKind_t trackKind,
+                              uint32_t mediaSsrc )
+{
+    PeerConnectionResult_t ret;
+    IceControllerResult_t iceControllerResult;
+    uint16_t sequenceNumbers[ PEER_CONNECTION_JITTER_BUFFER_NACK_MAX_ENTRY_NUM ];
+    size_t sequenceNumbersCount = PEER_CONNECTION_JITTER_BUFFER_NACK_MAX_ENTRY_NUM;
+    uint8_t srtcpPacket[ PEER_CONNECTION_SRTCP_NACK_PACKET_MAX_LENGTH ];
+    size_t srtcpPacketLength = sizeof( srtcpPacket );
+    uint32_t retryIntervalMs = GetNackRetryIntervalMs( pSession );
+    uint32_t senderSsrc = 0U;
+    uint32_t i;
+
+    ret = PeerConnectionJitterBuffer_GetNackList( &pSrtpReceiver->rxJitterBuffer,
+                                                  pdMS_TO_TICKS( retryIntervalMs ),
+                                                  sequenceNumbers,
+                                                  &sequenceNumbersCount );
+
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) && ( sequenceNumbersCount > 0 ) )
+    {
+        for( i = 0; i < pSession->transceiverCount; i++ )
+        {
+            if( pSession->pTransceivers[ i ]->trackKind == trackKind )
+            {
+                senderSsrc = pSession->pTransceivers[ i ]->ssrc;
+                break;
+            }
+        }
+
+        ret = PeerConnectionSrtcp_ConstructNackPacket( pSession,
+                                                       senderSsrc,
+                                                       mediaSsrc,
+                                                       sequenceNumbers,
+                                                       sequenceNumbersCount,
+                                                       srtcpPacket,
+                                                       &srtcpPacketLength );
+
+        if( ret == PEER_CONNECTION_RESULT_OK )
+        {
+            iceControllerResult = IceController_SendToRemotePeer( &( pSession->iceControllerContext ),
+                                                                  srtcpPacket,
+                                                                  srtcpPacketLength );
+            if( iceControllerResult != ICE_CONTROLLER_RESULT_OK )
+            {
+                LogWarn( ( "Fail to send RTCP NACK packet, ret: %d", iceControllerResult ) );
+            }
+            else
+            {
+                LogVerbose( ( "Sent NACK for %u packets to SSRC: %lu, first seq: %u",
+                              sequenceNumbersCount,
+                              mediaSsrc,
+                              sequenceNumbers[ 0 ] ) );
+            }
+        }
+    }
+}
+#endif /* PEER_CONNECTION_ENABLE_RECEIVER_NACK */
+
+#if PEER_CONNECTION_ENABLE_AUDIO_RED
+static PeerConnectionResult_t RecoverRedundantPackets( PeerConnectionSession_t * pSession,
+                                                       PeerConnectionSrtpReceiver_t * pSrtpReceiver,
+                                                       RtpPacket_t * pRtpPacket )
+{
+    PeerConnectionResult_t ret = PEER_CONNECTION_RESULT_OK;
+    PeerConnectionRedBlock_t blocks[ PEER_CONNECTION_SRTP_RED_MAX_BLOCKS ];
+    size_t blockCount = PEER_CONNECTION_SRTP_RED_MAX_BLOCKS;
+    PeerConnectionJitterBufferPacket_t * pJitterBufferPacket = NULL;
+    PeerConnectionRedBlock_t * pBlock;
+    uint8_t isOpus = TRANSCEIVER_IS_CODEC_ENABLED( pSrtpReceiver->rxJitterBuffer.codec,
+                                                   TRANSCEIVER_RTC_CODEC_OPUS_BIT ) ? 1U : 0U;
+    uint32_t duration;
+    uint32_t expectedOffset = 0U;
+    uint16_t rtpSeq;
+    size_t i;
+
+    ret = PeerConnectionSrtp_ParseRedPayload( pRtpPacket->pPayload,
+                                              pRtpPacket->payloadLength,
+                                              blocks,
+                                              &blockCount );
+
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( blocks[ blockCount - 1U ].payloadType != pSession->rtpConfig.audioCodecPayload ) )
+    {
+        LogWarn( ( "Ignoring RED packet with primary payload type: %u", blocks[ blockCount - 1U ].payloadType ) );
+        ret = PEER_CONNECTION_RESULT_FAIL_RED_DESERIALIZE;
+    }
+
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        /* RED carries no sequence numbers. A redundant block is the packet k sequence numbers back only
+         * if its timestamp offset equals the durations of the k blocks up to it. Walk them newest first
+         * and stop at the first one that breaks the chain, e.g. because the sender skipped a DTX frame.
+         * Rebuild only the ones still missing, before the primary is pushed. */
+        for( i = blockCount - 1U; i > 0U; i-- )
+        {
+            pBlock = &blocks[ i - 1U ];
+            rtpSeq = ( uint16_t )( pRtpPacket->header.sequenceNumber - ( blockCount - i ) );
+
+            if( pBlock->payloadType != pSession->rtpConfig.audioCodecPayload )
+            {
+                break;
+            }
+
+            /* G.711 is one byte per sample at its 8 kHz clock, Opus durations are in its 48 kHz clock. */
+            duration = ( isOpus != 0U ) ? PeerConnectionOpusHelper_GetOpusPacketDuration( pBlock->pData,
+                                                                                          pBlock->dataLength ) :
+                       ( uint32_t ) pBlock->dataLength;
+            expectedOffset += duration;
+            if( ( duration == 0U ) ||
+                ( pBlock->timestampOffset != expectedOffset ) )
+            {
+                LogVerbose( ( "RED block with offset: %u doesn't follow seq: %u, expected offset: %lu",
+                              pBlock->timestampOffset,
+                              ( uint16_t )( rtpSeq + 1U ),
+                              expectedOffset ) );
+                break;
+            }
+
+            if( ( PeerConnectionJitterBuffer_IsPacketMissing( &pSrtpReceiver->rxJitterBuffer,
+                                                              rtpSeq ) != 0U ) &&
+                ( PeerConnectionJitterBuffer_AllocateBuffer( &pSrtpReceiver->rxJitterBuffer,
+                                                             &pJitterBufferPacket,
+                                                             pBlock->dataLength,
+                                                             rtpSeq ) == PEER_CONNECTION_RESULT_OK ) )
+            {
+                memcpy( pJitterBufferPacket->pPacketBuffer, pBlock->pData, pBlock->dataLength );
+                pJitterBufferPacket->receiveTick = xTaskGetTickCount();
+                pJitterBufferPacket->rtpTimestamp = pRtpPacket->header.timestamp - pBlock->timestampOffset;
+                pJitterBufferPacket->sequenceNumber = rtpSeq;
+                pJitterBufferPacket->isRedundantEncoding = 0U;
+                pJitterBufferPacket->isRecovered = 1U;
+
+                if( PeerConnectionJitterBuffer_Push( &pSrtpReceiver->rxJitterBuffer,
+                                                     pJitterBufferPacket ) == PEER_CONNECTION_RESULT_OK )
+                {
+                    LogVerbose( ( "Recovered seq: %u from RED packet seq: %u", rtpSeq, pRtpPacket->header.sequenceNumber ) );
+                }
+            }
+        }
+    }
+
+    return ret;
+}
+#endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
+
 PeerConnectionResult_t PeerConnectionSrtp_HandleSrtpPacket( PeerConnectionSession_t * pSession,
                                                             uint8_t * pBuffer,
                                                             size_t bufferLength )
@@ -548,7 +1149,15 @@ PeerConnectionResult_t PeerConnectionSrtp_HandleSrtpPacket( PeerConnectionSessio
     RtpPacket_t rtpPacket;
     PeerConnectionJitterBufferPacket_t * pJitterBufferPacket = NULL;
     PeerConnectionSrtpReceiver_t * pSrtpReceiver = NULL;
+    TransceiverTrackKind_t trackKind = TRANSCEIVER_TRACK_KIND_VIDEO;
+    uint8_t isRetransmission = 0U;
     uint8_t isLocked = 0U;
+    #if PEER_CONNECTION_ENABLE_RECEIVER_NACK
+    uint8_t isPaddingOnly = 0U;
+    #endif /* PEER_CONNECTION_ENABLE_RECEIVER_NACK */
+    #if PEER_CONNECTION_ENABLE_AUDIO_RED
+    uint8_t isRedundantEncoding = 0U;
+    #endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
 
     if( ( pSession == NULL ) || ( pBuffer == NULL ) )
     {
@@ -616,6 +1225,39 @@ PeerConnectionResult_t PeerConnectionSrtp_HandleSrtpPacket( PeerConnectionSessio
         }
     }
 
+    #if PEER_CONNECTION_ENABLE_RECEIVER_NACK
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        /* Retransmissions answering our NACKs come on the RTX stream with its own SSRC and sequence.
+         * Map them back to the media stream by payload type and restore the OSN(original RTP sequence number). */
+        if( ( ( pSession->rtpConfig.videoCodecRtxPayload != 0 ) &&
+              ( pSession->rtpConfig.videoCodecRtxPayload != pSession->rtpConfig.videoCodecPayload ) &&
+              ( rtpPacket.header.payloadType == pSession->rtpConfig.videoCodecRtxPayload ) ) ||
+            ( ( pSession->rtpConfig.audioCodecRtxPayload != 0 ) &&
+              ( pSession->rtpConfig.audioCodecRtxPayload != pSession->rtpConfig.audioCodecPayload ) &&
+              ( rtpPacket.header.payloadType == pSession->rtpConfig.audioCodecRtxPayload ) ) )
+        {
+            if( rtpPacket.payloadLength <= PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES )
+            {
+                /* Padding only RTX packets are bandwidth probes, nothing to buffer.
+                 * Skip the rest of the handling here, the result is reset to OK at the end. */
+                LogVerbose( ( "Ignoring RTX packet without media, payload length: %u", rtpPacket.payloadLength ) );
+                isPaddingOnly = 1U;
+                ret = PEER_CONNECTION_RESULT_PACKET_OUTDATED;
+            }
+            else
+            {
+                rtpPacket.header.ssrc = ( rtpPacket.header.payloadType == pSession->rtpConfig.videoCodecRtxPayload ) ? pSession->rtpConfig.remoteVideoSsrc :
+                                        pSession->rtpConfig.remoteAudioSsrc;
+                rtpPacket.header.sequenceNumber = ( uint16_t )( ( rtpPacket.pPayload[ 0 ] << 8 ) | rtpPacket.pPayload[ 1 ] );
+                rtpPacket.pPayload += PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES;
+                rtpPacket.payloadLength -= PEER_CONNECTION_SRTP_RTX_WRITE_RESERVED_BYTES;
+                isRetransmission = 1U;
+            }
+        }
+    }
+    #endif /* PEER_CONNECTION_ENABLE_RECEIVER_NACK */
+
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
         if( pSession->rtpConfig.remoteVideoSsrc == rtpPacket.header.ssrc )
@@ -625,6 +1267,7 @@ PeerConnectionResult_t PeerConnectionSrtp_HandleSrtpPacket( PeerConnectionSessio
         else if( pSession->rtpConfig.remoteAudioSsrc == rtpPacket.header.ssrc )
         {
             pSrtpReceiver = &pSession->audioSrtpReceiver;
+            trackKind = TRANSCEIVER_TRACK_KIND_AUDIO;
         }
         else
         {
@@ -633,6 +1276,44 @@ PeerConnectionResult_t PeerConnectionSrtp_HandleSrtpPacket( PeerConnectionSessio
         }
     }
 
+    #if PEER_CONNECTION_ENABLE_RECEIVER_STATS
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( isRetransmission == 0U ) &&
+        ( pSrtpReceiver->rxJitterBuffer.isInit != 0U ) )
+    {
+        /* Retransmissions belong to the RTX stream, they don't count as received media. */
+        UpdateReceiverStats( &pSrtpReceiver->rxStats,
+                             pSrtpReceiver->rxJitterBuffer.clockRate,
+                             &rtpPacket,
+                             rtpBufferLength );
+        #if PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER
+        PeerConnectionJitterBuffer_SetJitter( &pSrtpReceiver->rxJitterBuffer,
+                                              pSrtpReceiver->rxStats.jitter );
+        #if PEER_CONNECTION_ENABLE_RECEIVER_NACK
+        /* A lost packet is NACKed, possibly again one retry interval later, and its retransmission
+         * needs an RTT to come back. Don't adapt below that or the frame is gone before it arrives. */
+        PeerConnectionJitterBuffer_SetNackWaitTime( &pSrtpReceiver->rxJitterBuffer,
+                                                    GetRoundTripTimeMs( pSession ) + GetNackRetryIntervalMs( pSession ) );
+        #endif /* PEER_CONNECTION_ENABLE_RECEIVER_NACK */
+        #endif /* PEER_CONNECTION_ENABLE_ADAPTIVE_JITTER_BUFFER */
+    }
+    #endif /* PEER_CONNECTION_ENABLE_RECEIVER_STATS */
+
+    #if PEER_CONNECTION_ENABLE_AUDIO_RED
+    if( ( ret == PEER_CONNECTION_RESULT_OK ) &&
+        ( trackKind == TRANSCEIVER_TRACK_KIND_AUDIO ) &&
+        ( pSession->rtpConfig.audioCodecRedPayload != 0U ) &&
+        ( rtpPacket.header.payloadType == pSession->rtpConfig.audioCodecRedPayload ) )
+    {
+        /* Fill the losses this packet has redundancy for, then buffer it whole.
+         * The fill frame functions take its primary block only. */
+        ret = RecoverRedundantPackets( pSession,
+                                       pSrtpReceiver,
+                                       &rtpPacket );
+        isRedundantEncoding = 1U;
+    }
+    #endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
+
     if( ret == PEER_CONNECTION_RESULT_OK )
     {
         ret = PeerConnectionJitterBuffer_AllocateBuffer( &pSrtpReceiver->rxJitterBuffer,
@@ -647,6 +1328,10 @@ PeerConnectionResult_t PeerConnectionSrtp_HandleSrtpPacket( PeerConnectionSessio
         pJitterBufferPacket->receiveTick = xTaskGetTickCount();
         pJitterBufferPacket->rtpTimestamp = rtpPacket.header.timestamp;
         pJitterBufferPacket->sequenceNumber = rtpPacket.header.sequenceNumber;
+        #if PEER_CONNECTION_ENABLE_AUDIO_RED
+        pJitterBufferPacket->isRedundantEncoding = isRedundantEncoding;
+        pJitterBufferPacket->isRecovered = 0U;
+        #endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
         // LogInfo( ( "Dumping RTP payload: %u, seq: %u, timestamp: %lu", rtpPacket.payloadLength, rtpPacket.header.sequenceNumber, rtpPacket.header.timestamp ) );
         // for( int i = 0; i < rtpPacket.payloadLength; i++ )
         // {
@@ -658,5 +1343,23 @@ PeerConnectionResult_t PeerConnectionSrtp_HandleSrtpPacket( PeerConnectionSessio
                                                pJitterBufferPacket );
     }
 
+    #if PEER_CONNECTION_ENABLE_RECEIVER_NACK
+    if( ret == PEER_CONNECTION_RESULT_OK )
+    {
+        /* Every received packet drives the NACK schedule, new gaps go out right away
+         * and pending ones are repeated once their retry interval has passed. */
+        SendReceiverNack( pSession,
+                          pSrtpReceiver,
+                          trackKind,
+                          rtpPacket.header.ssrc );
+    }
+
+    if( isPaddingOnly != 0U )
+    {
+        /* A probe is valid traffic from the peer, it just carries no media. */
+        ret = PEER_CONNECTION_RESULT_OK;
+    }
+    #endif /* PEER_CONNECTION_ENABLE_RECEIVER_NACK */
+
     return ret;
 }
@@ -46,6 +46,37 @@ PeerConnectionResult_t PeerConnectionSrtp_ConstructSrtpPacket( PeerConnectionSes
                                                                RtpPacket_t * pPacketRtp,
                                                                uint8_t * pOutputSrtpPacket,
                                                                size_t * pOutputSrtpPacketLength );
+void PeerConnectionSrtp_WriteRtpHeaderExtensions( PeerConnectionSession_t * pSession,
+                                                  TransceiverTrackKind_t trackKind,
+                                                  PeerConnectionRollingBufferPacket_t * pRollingBufferPacket,
+                                                  size_t payloadLength );
+
+/* Get the media payload of a buffered packet, the primary block when it is RED encoded. */
+void PeerConnectionSrtp_GetPrimaryPayload( PeerConnectionJitterBufferPacket_t * pPacket,
+                                           uint8_t ** ppPayload,
+                                           size_t * pPayloadLength );
+
+#if PEER_CONNECTION_ENABLE_AUDIO_RED
+/* The bytes to reserve in front of the next audio payload for its RED headers and redundant block,
+ * 0 when RED is not negotiated. It must be called under the audio sender mutex. */
+size_t PeerConnectionSrtp_GetRedHeadroom( PeerConnectionSession_t * pSession,
+                                          uint32_t rtpTimestamp );
+
+/* Write the RED headers and the redundant block into the headroom in front of the primary payload,
+ * and keep the primary payload for the next packet. Returns the length of the whole RED payload. */
+size_t PeerConnectionSrtp_WriteRedPayload( PeerConnectionSession_t * pSession,
+                                           uint32_t rtpTimestamp,
+                                           uint8_t * pPayload,
+                                           size_t headroom,
+                                           size_t primaryLength );
+
+/* Split a RED payload into its blocks, oldest first and the primary block last. The count is the
+ * array capacity on input and the number of blocks written on output. */
+PeerConnectionResult_t PeerConnectionSrtp_ParseRedPayload( uint8_t * pPayload,
+                                                           size_t payloadLength,
+                                                           PeerConnectionRedBlock_t * pBlocks,
+                                                           size_t * pBlockCount );
+#endif /* PEER_CONNECTION_ENABLE_AUDIO_RED */
 
 #ifdef __cplusplus
 }
@@ -83,6 +83,10 @@
 #define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_RTPMAP_MULAW_LENGTH ( 9 )
 #define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_RTPMAP_ALAW "PCMA/8000"
 #define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_RTPMAP_ALAW_LENGTH ( 9 )
+#define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_RTPMAP_RED_OPUS "red/48000/2"
+#define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_RTPMAP_RED_OPUS_LENGTH ( 11 )
+#define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_RTPMAP_RED_PCM "red/8000"
+#define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_RTPMAP_RED_PCM_LENGTH ( 8 )
 #define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_RTPMAP_H265 "H265/90000"
 #define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_RTPMAP_H265_LENGTH ( 10 )
 #define SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_RTCP_FB "rtcp-fb"
@@ -97,6 +101,10 @@
 #define SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_EXTMAP_LENGTH ( 6 )
 #define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_TWCC_EXT_URL "http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01"
 #define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_TWCC_EXT_URL_LENGTH ( 73 )
+#define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_ABS_SEND_TIME_EXT_URL "http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time"
+#define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_ABS_SEND_TIME_EXT_URL_LENGTH ( 58 )
+#define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_PLAYOUT_DELAY_EXT_URL "http://www.webrtc.org/experiments/rtp-hdrext/playout-delay"
+#define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_PLAYOUT_DELAY_EXT_URL_LENGTH ( 58 )
 #define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_RTCP_FB_TRANSPORT_CC "transport-cc"
 #define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_RTCP_FB_TRANSPORT_CC_LENGTH ( 12 )
 #define SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_CANDIDATE "candidate"
@@ -104,7 +112,7 @@
 #define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_FINGERPRINT_PREFIX_LENGTH ( 8 ) // the length of "sha-256 "
 
 #define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_FMTP_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION "level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=42e01f"
-#define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_FMTP_OPUS "minptime=10;useinbandfec=1"
+#define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_FMTP_OPUS "minptime=10;useinbandfec=1;usedtx=1"
 #define SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_FMTP_H265 "profile-space=0;profile-id=0;tier-flag=0;level-id=0;interop-constraints=000000000000;sprop-vps=QAEMAf//" \
     "AIAAAAMAAAMAAAMAAAMAALUCQA==;sprop-sps=QgEBAIAAAAMAAAMAAAMAAAMAAKACgIAtH+W1kkbQzkkktySqSfKSyA==;sprop-pps=RAHBpVgeSA=="
 
@@ -167,6 +175,22 @@
 #define SDP_CONTROLLER_CODEC_ALAW_DEFAULT_INDEX "8"
 #define SDP_CONTROLLER_CODEC_ALAW_DEFAULT_INDEX_LENGTH ( 1 )
 
+typedef struct SdpControllerRtpExtensionUrl
+{
+    const char * pUrl;
+    size_t urlLength;
+} SdpControllerRtpExtensionUrl_t;
+
+/* Indexed by SdpControllerRtpExtension_t. */
+static const SdpControllerRtpExtensionUrl_t rtpExtensionUrls[ SDP_CONTROLLER_RTP_EXTENSION_MAX ] = {
+    { SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_TWCC_EXT_URL, SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_TWCC_EXT_URL_LENGTH },
+    { SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_ABS_SEND_TIME_EXT_URL, SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_ABS_SEND_TIME_EXT_URL_LENGTH },
+    { SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_PLAYOUT_DELAY_EXT_URL, SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_PLAYOUT_DELAY_EXT_URL_LENGTH },
+};
+
+static SdpControllerRtpExtension_t MatchRtpExtensionUrl( const char * pExtmapValue,
+                                                         size_t extmapValueLength,
+                                                         size_t * pIdLength );
 static SdpControllerResult_t ParseExtraAttributes( SdpControllerSdpDescription_t * pSdpDescription,
                                                    SdpAttribute_t * pAttribute );
 static SdpControllerResult_t ParseMediaAttributes( SdpControllerSdpDescription_t * pSdpDescription,
@@ -202,6 +226,18 @@ static SdpControllerResult_t PopulateRtcpFb( uint32_t payload,
                                              char ** ppBuffer,
                                              size_t * pBufferLength,
                                              SdpControllerMediaDescription_t * pLocalMediaDescription );
+static SdpControllerResult_t PopulateRed( uint32_t payload,
+                                          uint32_t redPayload,
+                                          const char * pRedRtpmapValue,
+                                          char ** ppBuffer,
+                                          size_t * pBufferLength,
+                                          SdpControllerMediaDescription_t * pLocalMediaDescription );
+static SdpControllerResult_t PopulateExtmap( SdpControllerMediaDescription_t * pRemoteMediaDescription,
+                                             const uint16_t * pRtpExtensionIds,
+                                             uint8_t isOffer,
+                                             char ** ppBuffer,
+                                             size_t * pBufferLength,
+                                             SdpControllerMediaDescription_t * pLocalMediaDescription );
 static SdpControllerResult_t PopulateCodecAttributesH264Profile42E01FLevelAsymmetryAllowedPacketization( SdpControllerMediaDescription_t * pRemoteMediaDescription,
                                                                                                          const Transceiver_t * pTransceiver,
                                                                                                          uint32_t payload,
@@ -249,19 +285,115 @@ static SdpControllerResult_t PopulateCodecAttributes( SdpControllerMediaDescript
                                                       char ** ppBuffer,
                                                       size_t * pBufferLength,
                                                       SdpControllerMediaDescription_t * pLocalMediaDescription );
-static const SdpControllerAttributes_t * FindAttributeName( const SdpControllerAttributes_t * pAttributes,
-                                                            size_t attributeCount,
-                                                            char * pPattern,
-                                                            size_t patternLength );
-static const SdpControllerAttributes_t * FindFmtpBasedOnCodec( const SdpControllerAttributes_t * pAttributes,
-                                                               size_t attributeCount,
+static const SdpControllerAttributes_t * FindFmtpBasedOnCodec( const SdpControllerMediaDescription_t * pMediaDescription,
                                                                uint32_t codec );
 
+static SdpControllerRtpExtension_t MatchRtpExtensionUrl( const char * pExtmapValue,
+                                                         size_t extmapValueLength,
+                                                         size_t * pIdLength )
+{
+    SdpControllerRtpExtension_t extension = SDP_CONTROLLER_RTP_EXTENSION_MAX;
+    size_t length;
+    int i;
+
+    /* extmap value is "<id>[/<direction>] <URL>", match the URL at the end of value. */
+    for( i = 0; i < SDP_CONTROLLER_RTP_EXTENSION_MAX; i++ )
+    {
+        /* The attribute value length must be larger than URL to hold the ID. */
+        if( extmapValueLength > rtpExtensionUrls[ i ].urlLength )
+        {
+            length = extmapValueLength - rtpExtensionUrls[ i ].urlLength;
+            if( strncmp( rtpExtensionUrls[ i ].pUrl, pExtmapValue + length, rtpExtensionUrls[ i ].urlLength ) == 0 )
+            {
+                extension = ( SdpControllerRtpExtension_t ) i;
+                if( pIdLength != NULL )
+                {
+                    *pIdLength = length;
+                }
+                break;
+            }
+        }
+    }
+
+    return extension;
+}
+
+static void IndexMediaAttribute( SdpControllerMediaDescription_t * pMediaDescription,
+                                 uint8_t attributeIndex )
+{
+    const SdpControllerAttributes_t * pAttribute = &pMediaDescription->attributes[ attributeIndex ];
+    uint32_t payloadType = 0;
+    size_t i;
+    SdpControllerRtpExtension_t extension;
+
+    if( ( pAttribute->attributeNameLength == SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_FMTP_LENGTH ) &&
+        ( strncmp( SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_FMTP, pAttribute->pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_FMTP_LENGTH ) == 0 ) )
+    {
+        /* fmtp value starts with payload type, e.g. "111 minptime=10;useinbandfec=1;usedtx=1". */
+        for( i = 0; i < pAttribute->attributeValueLength; i++ )
+        {
+            if( ( pAttribute->pAttributeValue[ i ] < '0' ) ||
+                ( pAttribute->pAttributeValue[ i ] > '9' ) ||
+                ( payloadType >= SDP_CONTROLLER_PAYLOAD_TYPE_INDEX_SIZE ) )
+            {
+                break;
+            }
+            payloadType = payloadType * 10 + ( pAttribute->pAttributeValue[ i ] - '0' );
+        }
+
+        if( ( i > 0 ) &&
+            ( payloadType < SDP_CONTROLLER_PAYLOAD_TYPE_INDEX_SIZE ) &&
+            ( ( i == pAttribute->attributeValueLength ) || ( pAttribute->pAttributeValue[ i ] == ' ' ) ) &&
+            ( pMediaDescription->fmtpIndex[ payloadType ] == 0U ) )
+        {
+            pMediaDescription->fmtpIndex[ payloadType ] = attributeIndex + 1U;
+        }
+    }
+    else if( ( pAttribute->attributeNameLength == SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_MID_LENGTH ) &&
+             ( strncmp( SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_MID, pAttribute->pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_MID_LENGTH ) == 0 ) )
+    {
+        if( pMediaDescription->midIndex == 0U )
+        {
+            pMediaDescription->midIndex = attributeIndex + 1U;
+        }
+    }
+    else if( ( ( pAttribute->attributeNameLength == SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDRECV_LENGTH ) &&
+               ( strncmp( SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDRECV, pAttribute->pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDRECV_LENGTH ) == 0 ) ) ||
+             ( ( pAttribute->attributeNameLength == SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDONLY_LENGTH ) &&
+               ( strncmp( SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDONLY, pAttribute->pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDONLY_LENGTH ) == 0 ) ) ||
+             ( ( pAttribute->attributeNameLength == SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_RECVONLY_LENGTH ) &&
+               ( strncmp( SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_RECVONLY, pAttribute->pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_RECVONLY_LENGTH ) == 0 ) ) ||
+             ( ( pAttribute->attributeNameLength == SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_INACTIVE_LENGTH ) &&
+               ( strncmp( SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_INACTIVE, pAttribute->pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_INACTIVE_LENGTH ) == 0 ) ) )
+    {
+        if( pMediaDescription->directionIndex == 0U )
+        {
+            pMediaDescription->directionIndex = attributeIndex + 1U;
+        }
+    }
+    else if( ( pAttribute->attributeNameLength == SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_EXTMAP_LENGTH ) &&
+             ( strncmp( SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_EXTMAP, pAttribute->pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_EXTMAP_LENGTH ) == 0 ) )
+    {
+        extension = MatchRtpExtensionUrl( pAttribute->pAttributeValue, pAttribute->attributeValueLength, NULL );
+        if( ( extension != SDP_CONTROLLER_RTP_EXTENSION_MAX ) &&
+            ( pMediaDescription->extmapIndex[ extension ] == 0U ) )
+        {
+            pMediaDescription->extmapIndex[ extension ] = attributeIndex + 1U;
+        }
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+}
+
 static SdpControllerResult_t ParseExtraAttributes( SdpControllerSdpDescription_t * pSdpDescription,
                                                    SdpAttribute_t * pAttribute )
 {
     SdpControllerResult_t ret = SDP_CONTROLLER_RESULT_OK;
     StringUtilsResult_t stringResult;
+    SdpControllerRtpExtension_t extension;
+    size_t length = 0;
 
     if( ( pSdpDescription == NULL ) ||
         ( pAttribute == NULL ) )
@@ -315,27 +447,24 @@ static SdpControllerResult_t ParseExtraAttributes( SdpControllerSdpDescription_t
             pSdpDescription->quickAccess.icePwdLength = pAttribute->attributeValueLength;
         }
         else if( ( pAttribute->attributeNameLength == SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_EXTMAP_LENGTH ) &&
-                 ( strncmp( SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_EXTMAP, pAttribute->pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_EXTMAP_LENGTH ) == 0 ) &&
-                 ( pAttribute->attributeValueLength > SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_TWCC_EXT_URL_LENGTH ) )
+                 ( strncmp( SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_EXTMAP, pAttribute->pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_EXTMAP_LENGTH ) == 0 ) )
         {
-            /* The attribute value length is confirmed larger than URL. */
-            size_t length = pAttribute->attributeValueLength - SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_TWCC_EXT_URL_LENGTH;
-            const char * pFindStart = pAttribute->pAttributeValue + length;
-            if( strncmp( SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_TWCC_EXT_URL, pFindStart, SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_TWCC_EXT_URL_LENGTH ) == 0 )
+            extension = MatchRtpExtensionUrl( pAttribute->pAttributeValue, pAttribute->attributeValueLength, &length );
+            if( extension != SDP_CONTROLLER_RTP_EXTENSION_MAX )
             {
-                /* Found TWCC ext URL. */
-                stringResult = StringUtils_ConvertStringToUl( pAttribute->pAttributeValue, length, &pSdpDescription->quickAccess.twccExtId );
+                /* Found supported ext URL, the ID is in front of it. */
+                stringResult = StringUtils_ConvertStringToUl( pAttribute->pAttributeValue, length, &pSdpDescription->quickAccess.rtpExtensionIds[ extension ] );
                 if( stringResult != STRING_UTILS_RESULT_OK )
                 {
                     LogError( ( "StringUtils_ConvertStringToUl fail, result %d, converting %.*s to %lu",
                                 stringResult,
                                 ( int ) length, pAttribute->pAttributeValue,
-                                pSdpDescription->quickAccess.twccExtId ) );
-                    ret = SDP_CONTROLLER_RESULT_SDP_INVALID_TWCC_ID;
+                                pSdpDescription->quickAccess.rtpExtensionIds[ extension ] ) );
+                    ret = SDP_CONTROLLER_RESULT_SDP_INVALID_EXTMAP_ID;
                 }
                 else
                 {
-                    LogDebug( ( "Found TWCC, ID: %lu", pSdpDescription->quickAccess.twccExtId ) );
+                    LogDebug( ( "Found RTP extension %d, ID: %lu", extension, pSdpDescription->quickAccess.rtpExtensionIds[ extension ] ) );
                 }
             }
         }
@@ -389,6 +518,8 @@ static SdpControllerResult_t ParseMediaAttributes( SdpControllerSdpDescription_t
         pSdpDescription->mediaDescriptions[ mediaIndex ].attributes[ *pAttributeCount ].attributeNameLength = attribute.attributeNameLength;
         pSdpDescription->mediaDescriptions[ mediaIndex ].attributes[ *pAttributeCount ].pAttributeValue = attribute.pAttributeValue;
         pSdpDescription->mediaDescriptions[ mediaIndex ].attributes[ *pAttributeCount ].attributeValueLength = attribute.attributeValueLength;
+        IndexMediaAttribute( &pSdpDescription->mediaDescriptions[ mediaIndex ],
+                             *pAttributeCount );
         ( *pAttributeCount )++;
     }
 
@@ -1063,6 +1194,213 @@ static SdpControllerResult_t PopulateRtcpFb( uint32_t payload,
     return ret;
 }
 
+/* RFC 2198 redundant audio carrying the primary codec, https://datatracker.ietf.org/doc/html/rfc2198#section-5 */
+static SdpControllerResult_t PopulateRed( uint32_t payload,
+                                          uint32_t redPayload,
+                                          const char * pRedRtpmapValue,
+                                          char ** ppBuffer,
+                                          size_t * pBufferLength,
+                                          SdpControllerMediaDescription_t * pLocalMediaDescription )
+{
+    SdpControllerResult_t ret = SDP_CONTROLLER_RESULT_OK;
+    SdpControllerAttributes_t * pTargetAttribute = NULL;
+    uint8_t * pTargetAttributeCount = NULL;
+    int written = 0;
+    char * pCurBuffer = NULL;
+    size_t remainSize = 0;
+
+    if( ( ppBuffer == NULL ) ||
+        ( pBufferLength == NULL ) ||
+        ( pRedRtpmapValue == NULL ) ||
+        ( pLocalMediaDescription == NULL ) )
+    {
+        LogError( ( "Invalid input, ppBuffer: %p, pBufferLength: %p, pRedRtpmapValue: %p, pLocalMediaDescription: %p",
+                    ppBuffer,
+                    pBufferLength,
+                    pRedRtpmapValue,
+                    pLocalMediaDescription ) );
+        ret = SDP_CONTROLLER_RESULT_BAD_PARAMETER;
+    }
+
+    /* rtpmap: ${red} red/${clock rate} */
+    if( ret == SDP_CONTROLLER_RESULT_OK )
+    {
+        pCurBuffer = *ppBuffer;
+        remainSize = *pBufferLength;
+        pTargetAttributeCount = &pLocalMediaDescription->mediaAttributesCount;
+
+        pTargetAttribute = &pLocalMediaDescription->attributes[ *pTargetAttributeCount ];
+        pTargetAttribute->pAttributeName = SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_RTPMAP;
+        pTargetAttribute->attributeNameLength = SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_RTPMAP_LENGTH;
+
+        written = snprintf( pCurBuffer, remainSize, "%lu %s",
+                            redPayload,
+                            pRedRtpmapValue );
+        if( written < 0 )
+        {
+            ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
+            LogError( ( "snprintf return unexpected value %d", written ) );
+        }
+        else if( written == remainSize )
+        {
+            ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
+            LogError( ( "buffer has no space for rtpmap RED" ) );
+        }
+        else
+        {
+            pTargetAttribute->pAttributeValue = pCurBuffer;
+            pTargetAttribute->attributeValueLength = strlen( pCurBuffer );
+            *pTargetAttributeCount += 1;
+
+            pCurBuffer += written;
+            remainSize -= written;
+        }
+    }
+
+    /* fmtp: ${red} ${codec}/${codec}, the primary block and one level of redundancy. */
+    if( ret == SDP_CONTROLLER_RESULT_OK )
+    {
+        pTargetAttribute = &pLocalMediaDescription->attributes[ *pTargetAttributeCount ];
+        pTargetAttribute->pAttributeName = SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_FMTP;
+        pTargetAttribute->attributeNameLength = SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_FMTP_LENGTH;
+
+        written = snprintf( pCurBuffer, remainSize, "%lu %lu/%lu",
+                            redPayload,
+                            payload,
+                            payload );
+        if( written < 0 )
+        {
+            ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
+            LogError( ( "snprintf return unexpected value %d", written ) );
+        }
+        else if( written == remainSize )
+        {
+            ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
+            LogError( ( "buffer has no space for fmtp RED" ) );
+        }
+        else
+        {
+            pTargetAttribute->pAttributeValue = pCurBuffer;
+            pTargetAttribute->attributeValueLength = strlen( pCurBuffer );
+            *pTargetAttributeCount += 1;
+
+            pCurBuffer += written;
+            remainSize -= written;
+        }
+    }
+
+    if( ret == SDP_CONTROLLER_RESULT_OK )
+    {
+        *ppBuffer = pCurBuffer;
+        *pBufferLength = remainSize;
+    }
+
+    return ret;
+}
+
+static SdpControllerResult_t PopulateExtmap( SdpControllerMediaDescription_t * pRemoteMediaDescription,
+                                             const uint16_t * pRtpExtensionIds,
+                                             uint8_t isOffer,
+                                             char ** ppBuffer,
+                                             size_t * pBufferLength,
+                                             SdpControllerMediaDescription_t * pLocalMediaDescription )
+{
+    SdpControllerResult_t ret = SDP_CONTROLLER_RESULT_OK;
+    SdpControllerAttributes_t * pTargetAttribute = NULL;
+    const SdpControllerAttributes_t * pSourceAttribute = NULL;
+    uint8_t * pTargetAttributeCount = NULL;
+    int written = 0;
+    char * pCurBuffer = NULL;
+    size_t remainSize = 0;
+    int i;
+
+    if( ( pRtpExtensionIds == NULL ) ||
+        ( ppBuffer == NULL ) ||
+        ( pBufferLength == NULL ) ||
+        ( pLocalMediaDescription == NULL ) ||
+        ( ( isOffer == 0U ) && ( pRemoteMediaDescription == NULL ) ) )
+    {
+        LogError( ( "Invalid input, pRtpExtensionIds: %p, ppBuffer: %p, pBufferLength: %p, pLocalMediaDescription: %p, pRemoteMediaDescription: %p",
+                    pRtpExtensionIds,
+                    ppBuffer,
+                    pBufferLength,
+                    pLocalMediaDescription,
+                    pRemoteMediaDescription ) );
+        ret = SDP_CONTROLLER_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == SDP_CONTROLLER_RESULT_OK )
+    {
+        pCurBuffer = *ppBuffer;
+        remainSize = *pBufferLength;
+        pTargetAttributeCount = &pLocalMediaDescription->mediaAttributesCount;
+    }
+
+    for( i = 0; ( ret == SDP_CONTROLLER_RESULT_OK ) && ( i < SDP_CONTROLLER_RTP_EXTENSION_MAX ); i++ )
+    {
+        if( pRtpExtensionIds[ i ] == 0U )
+        {
+            /* The extension is not used. */
+            continue;
+        }
+
+        pSourceAttribute = NULL;
+        if( isOffer == 0U )
+        {
+            /* Answer only the extensions offered in this m-line, with the ID remote chose. */
+            if( pRemoteMediaDescription->extmapIndex[ i ] == 0U )
+            {
+                continue;
+            }
+            pSourceAttribute = &pRemoteMediaDescription->attributes[ pRemoteMediaDescription->extmapIndex[ i ] - 1U ];
+        }
+
+        pTargetAttribute = &pLocalMediaDescription->attributes[ *pTargetAttributeCount ];
+        pTargetAttribute->pAttributeName = SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_EXTMAP;
+        pTargetAttribute->attributeNameLength = SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_EXTMAP_LENGTH;
+
+        if( pSourceAttribute != NULL )
+        {
+            pTargetAttribute->pAttributeValue = pSourceAttribute->pAttributeValue;
+            pTargetAttribute->attributeValueLength = pSourceAttribute->attributeValueLength;
+            *pTargetAttributeCount += 1;
+        }
+        else
+        {
+            written = snprintf( pCurBuffer, remainSize, "%u %.*s",
+                                pRtpExtensionIds[ i ],
+                                ( int ) rtpExtensionUrls[ i ].urlLength, rtpExtensionUrls[ i ].pUrl );
+            if( written < 0 )
+            {
+                ret = SDP_CONTROLLER_RESULT_SDP_FAIL_SNPRINTF;
+                LogError( ( "snprintf return unexpected value %d", written ) );
+            }
+            else if( written >= remainSize )
+            {
+                ret = SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL;
+                LogError( ( "buffer has no space for extmap" ) );
+            }
+            else
+            {
+                pTargetAttribute->pAttributeValue = pCurBuffer;
+                pTargetAttribute->attributeValueLength = written;
+                *pTargetAttributeCount += 1;
+
+                pCurBuffer += written;
+                remainSize -= written;
+            }
+        }
+    }
+
+    if( ret == SDP_CONTROLLER_RESULT_OK )
+    {
+        *ppBuffer = pCurBuffer;
+        *pBufferLength = remainSize;
+    }
+
+    return ret;
+}
+
 static SdpControllerResult_t PopulateCodecAttributesH264Profile42E01FLevelAsymmetryAllowedPacketization( SdpControllerMediaDescription_t * pRemoteMediaDescription,
                                                                                                          const Transceiver_t * pTransceiver,
                                                                                                          uint32_t payload,
@@ -1149,8 +1487,7 @@ static SdpControllerResult_t PopulateCodecAttributesH264Profile42E01FLevelAsymme
         if( !isOffer )
         {
             /* If creating SDP answer, try find fmtp from the remote description. */
-            pSourceAttribute = FindFmtpBasedOnCodec( pRemoteMediaDescription->attributes,
-                                                     pRemoteMediaDescription->mediaAttributesCount,
+            pSourceAttribute = FindFmtpBasedOnCodec( pRemoteMediaDescription,
                                                      payload );
         }
 
@@ -1339,8 +1676,7 @@ static SdpControllerResult_t PopulateCodecAttributesOpus( SdpControllerMediaDesc
         if( !isOffer )
         {
             /* If creating SDP answer, try find fmtp from the remote description. */
-            pSourceAttribute = FindFmtpBasedOnCodec( pRemoteMediaDescription->attributes,
-                                                     pRemoteMediaDescription->mediaAttributesCount,
+            pSourceAttribute = FindFmtpBasedOnCodec( pRemoteMediaDescription,
                                                      payload );
         }
 
@@ -1770,8 +2106,7 @@ static SdpControllerResult_t PopulateCodecAttributesH265( SdpControllerMediaDesc
         if( !isOffer )
         {
             /* If creating SDP answer, try find fmtp from the remote description. */
-            pSourceAttribute = FindFmtpBasedOnCodec( pRemoteMediaDescription->attributes,
-                                                     pRemoteMediaDescription->mediaAttributesCount,
+            pSourceAttribute = FindFmtpBasedOnCodec( pRemoteMediaDescription,
                                                      payload );
         }
 
@@ -1885,81 +2220,52 @@ static SdpControllerResult_t PopulateCodecAttributes( SdpControllerMediaDescript
         }
     }
 
+    /* rtpmap: ${red} red/${clock rate}
+     * fmtp: ${red} ${codec}/${codec} */
+    if( ( ret == SDP_CONTROLLER_RESULT_OK ) && ( populateConfiguration.redPayloadType != 0 ) )
+    {
+        if( TRANSCEIVER_IS_CODEC_ENABLED( pTransceiver->codecBitMap, TRANSCEIVER_RTC_CODEC_OPUS_BIT ) )
+        {
+            ret = PopulateRed( payload, populateConfiguration.redPayloadType, SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_RTPMAP_RED_OPUS, ppBuffer, pBufferLength, pLocalMediaDescription );
+        }
+        else if( TRANSCEIVER_IS_CODEC_ENABLED( pTransceiver->codecBitMap, TRANSCEIVER_RTC_CODEC_MULAW_BIT ) ||
+                 TRANSCEIVER_IS_CODEC_ENABLED( pTransceiver->codecBitMap, TRANSCEIVER_RTC_CODEC_ALAW_BIT ) )
+        {
+            ret = PopulateRed( payload, populateConfiguration.redPayloadType, SDP_CONTROLLER_MEDIA_ATTRIBUTE_VALUE_RTPMAP_RED_PCM, ppBuffer, pBufferLength, pLocalMediaDescription );
+        }
+        else
+        {
+            LogWarn( ( "Ignore RED for codec bit map: %x, RED payload: %lu.", ( int ) pTransceiver->codecBitMap, populateConfiguration.redPayloadType ) );
+        }
+    }
+
     /* rtcp-fb: ${codec} goog-remb
      * rtcp-fb: ${codec} transport-cc */
     if( ret == SDP_CONTROLLER_RESULT_OK )
     {
-        ret = PopulateRtcpFb( payload, populateConfiguration.twccExtId, ppBuffer, pBufferLength, pLocalMediaDescription );
+        ret = PopulateRtcpFb( payload, populateConfiguration.rtpExtensionIds[ SDP_CONTROLLER_RTP_EXTENSION_TWCC ], ppBuffer, pBufferLength, pLocalMediaDescription );
     }
 
     return ret;
 }
 
-static const SdpControllerAttributes_t * FindAttributeName( const SdpControllerAttributes_t * pAttributes,
-                                                            size_t attributeCount,
-                                                            char * pPattern,
-                                                            size_t patternLength )
+static const SdpControllerAttributes_t * FindFmtpBasedOnCodec( const SdpControllerMediaDescription_t * pMediaDescription,
+                                                               uint32_t codec )
 {
     const SdpControllerAttributes_t * pRet = NULL;
-    int i;
 
-    if( ( pAttributes == NULL ) ||
-        ( pPattern == NULL ) )
+    if( pMediaDescription == NULL )
     {
-        LogError( ( "Invalid input, pAttributes: %p, pPattern: %p", pAttributes, pPattern ) );
-    }
-    else
-    {
-        for( i = 0; i < attributeCount; i++ )
-        {
-            if( ( pAttributes[i].attributeNameLength == patternLength ) && ( strncmp( pAttributes[i].pAttributeName, pPattern, patternLength ) == 0 ) )
-            {
-                pRet = &pAttributes[i];
-                break;
-            }
-        }
+        LogError( ( "Invalid input, pMediaDescription: %p", pMediaDescription ) );
     }
-
-    return pRet;
-}
-
-static const SdpControllerAttributes_t * FindFmtpBasedOnCodec( const SdpControllerAttributes_t * pAttributes,
-                                                               size_t attributeCount,
-                                                               uint32_t codec )
-{
-    const SdpControllerAttributes_t * pRet = NULL;
-    char codecString[ TRANSCEIVER_CODEC_STRING_MAX_LENGTH + 1 ];
-    int i, written;
-
-    if( pAttributes == NULL )
+    else if( ( codec < SDP_CONTROLLER_PAYLOAD_TYPE_INDEX_SIZE ) &&
+             ( pMediaDescription->fmtpIndex[ codec ] != 0U ) )
     {
-        LogError( ( "Invalid input, pAttributes: %p", pAttributes ) );
+        pRet = &pMediaDescription->attributes[ pMediaDescription->fmtpIndex[ codec ] - 1U ];
     }
     else
     {
-        written = snprintf( codecString, TRANSCEIVER_CODEC_STRING_MAX_LENGTH + 1, "%lu", codec );
-        if( written < 0 )
-        {
-            LogError( ( "snprintf return unexpected value %d", written ) );
-        }
-        else if( written == TRANSCEIVER_CODEC_STRING_MAX_LENGTH + 1 )
-        {
-            LogError( ( "buffer has no space for codec string" ) );
-        }
-        else
-        {
-            for( i = 0; i < attributeCount; i++ )
-            {
-                if( ( pAttributes[i].attributeNameLength == SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_FMTP_LENGTH ) &&
-                    ( strncmp( pAttributes[i].pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_FMTP, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_FMTP_LENGTH ) == 0 ) &&
-                    ( pAttributes[i].attributeValueLength >= written ) &&
-                    ( strncmp( pAttributes[i].pAttributeValue, codecString, written ) == 0 ) )
-                {
-                    pRet = &pAttributes[i];
-                    break;
-                }
-            }
-        }
+        /* Empty else marker. */
     }
 
     return pRet;
@@ -2632,7 +2938,6 @@ SdpControllerResult_t SdpController_PopulateSingleMedia( SdpControllerMediaDescr
     uint8_t * pTargetAttributeCount = NULL;
     const SdpControllerAttributes_t * pSourceAttribute = NULL;
     int written = 0;
-    int i;
 
     if( ( pLocalMediaDescription == NULL ) ||
         ( ppBuffer == NULL ) ||
@@ -2691,7 +2996,19 @@ SdpControllerResult_t SdpController_PopulateSingleMedia( SdpControllerMediaDescr
             }
             case TRANSCEIVER_TRACK_KIND_AUDIO:
             {
-                if( populateConfiguration.rtxPayloadType == 0 )
+                if( populateConfiguration.redPayloadType != 0 )
+                {
+                    /* RED is listed first so that peers supporting it send redundancy as well. */
+                    if( populateConfiguration.rtxPayloadType == 0 )
+                    {
+                        written = snprintf( pCurBuffer, remainSize, "audio 9 UDP/TLS/RTP/SAVPF %lu %lu", populateConfiguration.redPayloadType, populateConfiguration.payloadType );
+                    }
+                    else
+                    {
+                        written = snprintf( pCurBuffer, remainSize, "audio 9 UDP/TLS/RTP/SAVPF %lu %lu %lu", populateConfiguration.redPayloadType, populateConfiguration.payloadType, populateConfiguration.rtxPayloadType );
+                    }
+                }
+                else if( populateConfiguration.rtxPayloadType == 0 )
                 {
                     written = snprintf( pCurBuffer, remainSize, "audio 9 UDP/TLS/RTP/SAVPF %lu", populateConfiguration.payloadType );
                 }
@@ -2925,10 +3242,10 @@ SdpControllerResult_t SdpController_PopulateSingleMedia( SdpControllerMediaDescr
         if( populateConfiguration.isOffer == 0 )
         {
             /* Try to match the mid number in the remote media description. */
-            pSourceAttribute = FindAttributeName( pRemoteMediaDescription->attributes,
-                                                  pRemoteMediaDescription->mediaAttributesCount,
-                                                  SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_MID,
-                                                  SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_MID_LENGTH );
+            if( pRemoteMediaDescription->midIndex != 0U )
+            {
+                pSourceAttribute = &pRemoteMediaDescription->attributes[ pRemoteMediaDescription->midIndex - 1U ];
+            }
         }
         pTargetAttribute = &pLocalMediaDescription->attributes[ *pTargetAttributeCount ];
         pTargetAttribute->pAttributeName = SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_MID;
@@ -2990,32 +3307,34 @@ SdpControllerResult_t SdpController_PopulateSingleMedia( SdpControllerMediaDescr
             }
             else
             {
-                for( i = 0; i < pRemoteMediaDescription->mediaAttributesCount; i++ )
+                pSourceAttribute = NULL;
+                if( pRemoteMediaDescription->directionIndex != 0U )
                 {
-                    if( ( pRemoteMediaDescription->attributes[i].attributeNameLength == SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDRECV_LENGTH ) &&
-                        ( strncmp( pRemoteMediaDescription->attributes[i].pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDRECV, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDRECV_LENGTH ) == 0 ) )
-                    {
-                        targetDirection = TRANSCEIVER_TRACK_DIRECTION_SENDRECV;
-                        break;
-                    }
-                    else if( ( pRemoteMediaDescription->attributes[i].attributeNameLength == SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDONLY_LENGTH ) &&
-                             ( strncmp( pRemoteMediaDescription->attributes[i].pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDONLY, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDONLY_LENGTH ) == 0 ) )
-                    {
-                        targetDirection = TRANSCEIVER_TRACK_DIRECTION_RECVONLY;
-                        break;
-                    }
-                    else if( ( pRemoteMediaDescription->attributes[i].attributeNameLength == SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_RECVONLY_LENGTH ) &&
-                             ( strncmp( pRemoteMediaDescription->attributes[i].pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_RECVONLY, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_RECVONLY_LENGTH ) == 0 ) )
-                    {
-                        targetDirection = TRANSCEIVER_TRACK_DIRECTION_SENDONLY;
-                        break;
-                    }
-                    else if( ( pRemoteMediaDescription->attributes[i].attributeNameLength == SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_INACTIVE_LENGTH ) &&
-                             ( strncmp( pRemoteMediaDescription->attributes[i].pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_INACTIVE, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_INACTIVE_LENGTH ) == 0 ) )
-                    {
-                        targetDirection = TRANSCEIVER_TRACK_DIRECTION_INACTIVE;
-                        break;
-                    }
+                    pSourceAttribute = &pRemoteMediaDescription->attributes[ pRemoteMediaDescription->directionIndex - 1U ];
+                }
+
+                if( pSourceAttribute == NULL )
+                {
+                    /* No direction attribute in remote description. */
+                }
+                else if( ( pSourceAttribute->attributeNameLength == SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDRECV_LENGTH ) &&
+                         ( strncmp( pSourceAttribute->pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDRECV, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDRECV_LENGTH ) == 0 ) )
+                {
+                    targetDirection = TRANSCEIVER_TRACK_DIRECTION_SENDRECV;
+                }
+                else if( ( pSourceAttribute->attributeNameLength == SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDONLY_LENGTH ) &&
+                         ( strncmp( pSourceAttribute->pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDONLY, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_SENDONLY_LENGTH ) == 0 ) )
+                {
+                    targetDirection = TRANSCEIVER_TRACK_DIRECTION_RECVONLY;
+                }
+                else if( ( pSourceAttribute->attributeNameLength == SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_RECVONLY_LENGTH ) &&
+                         ( strncmp( pSourceAttribute->pAttributeName, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_RECVONLY, SDP_CONTROLLER_MEDIA_ATTRIBUTE_NAME_RECVONLY_LENGTH ) == 0 ) )
+                {
+                    targetDirection = TRANSCEIVER_TRACK_DIRECTION_SENDONLY;
+                }
+                else
+                {
+                    targetDirection = TRANSCEIVER_TRACK_DIRECTION_INACTIVE;
                 }
             }
         }
@@ -3065,6 +3384,17 @@ SdpControllerResult_t SdpController_PopulateSingleMedia( SdpControllerMediaDescr
         *pTargetAttributeCount += 1;
     }
 
+    /* extmap */
+    if( ( ret == SDP_CONTROLLER_RESULT_OK ) && ( trackKind != TRANSCEIVER_TRACK_KIND_DATA_CHANNEL ) )
+    {
+        ret = PopulateExtmap( pRemoteMediaDescription,
+                              populateConfiguration.rtpExtensionIds,
+                              populateConfiguration.isOffer,
+                              &pCurBuffer,
+                              &remainSize,
+                              pLocalMediaDescription );
+    }
+
     /* Popupate codec relevant attributes. */
     if( ( ret == SDP_CONTROLLER_RESULT_OK ) && ( trackKind != TRANSCEIVER_TRACK_KIND_DATA_CHANNEL ) )
     {
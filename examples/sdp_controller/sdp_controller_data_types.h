@@ -31,6 +31,8 @@ extern "C" {
 #define SDP_CONTROLLER_MAX_SDP_SESSION_TIMEZONE_COUNT ( 2 )
 #define SDP_CONTROLLER_MAX_SDP_ATTRIBUTES_COUNT ( 255 )
 #define SDP_CONTROLLER_MAX_SDP_MEDIA_DESCRIPTIONS_COUNT ( 5 )
+/* RTP payload type is 7 bits, so fmtp attributes can be indexed directly by payload type. */
+#define SDP_CONTROLLER_PAYLOAD_TYPE_INDEX_SIZE ( 128 )
 
 typedef enum SdpControllerResult
 {
@@ -51,11 +53,20 @@ typedef enum SdpControllerResult
     SDP_CONTROLLER_RESULT_SDP_SESSION_ATTRIBUTE_MAX_EXCEDDED,
     SDP_CONTROLLER_RESULT_SDP_MEDIA_ATTRIBUTE_MAX_EXCEDDED,
     SDP_CONTROLLER_RESULT_SDP_INVALID_VERSION,
-    SDP_CONTROLLER_RESULT_SDP_INVALID_TWCC_ID,
+    SDP_CONTROLLER_RESULT_SDP_INVALID_EXTMAP_ID,
     SDP_CONTROLLER_RESULT_SDP_CONVERTED_BUFFER_TOO_SMALL,
     SDP_CONTROLLER_RESULT_SDP_POPULATE_BUFFER_TOO_SMALL,
 } SdpControllerResult_t;
 
+/* RTP header extensions negotiated through a=extmap, indexed into the extension ID arrays. */
+typedef enum SdpControllerRtpExtension
+{
+    SDP_CONTROLLER_RTP_EXTENSION_TWCC = 0,
+    SDP_CONTROLLER_RTP_EXTENSION_ABS_SEND_TIME,
+    SDP_CONTROLLER_RTP_EXTENSION_PLAYOUT_DELAY,
+    SDP_CONTROLLER_RTP_EXTENSION_MAX,
+} SdpControllerRtpExtension_t;
+
 typedef enum SdpControllerDtlsRole
 {
     SDP_CONTROLLER_DTLS_ROLE_NONE = 0,
@@ -143,6 +154,13 @@ typedef struct SdpControllerMediaDescription
     SdpControllerAttributes_t attributes[ SDP_CONTROLLER_MAX_SDP_ATTRIBUTES_COUNT ];
 
     uint8_t mediaAttributesCount;
+
+    /* Attribute index built while deserializing, so answer creation doesn't rescan the attributes.
+     * Each entry stores the attributes slot + 1, 0 means not present. */
+    uint8_t fmtpIndex[ SDP_CONTROLLER_PAYLOAD_TYPE_INDEX_SIZE ];
+    uint8_t midIndex;
+    uint8_t directionIndex;
+    uint8_t extmapIndex[ SDP_CONTROLLER_RTP_EXTENSION_MAX ];
 } SdpControllerMediaDescription_t;
 
 typedef struct SdpControllerQuickAccess
@@ -155,7 +173,7 @@ typedef struct SdpControllerQuickAccess
     size_t iceUfragLength;
     const char * pIcePwd;
     size_t icePwdLength;
-    uint32_t twccExtId;
+    uint32_t rtpExtensionIds[ SDP_CONTROLLER_RTP_EXTENSION_MAX ]; /* 0 means not offered. */
     uint8_t isVideoCodecPayloadSet;
     uint8_t isAudioCodecPayloadSet;
     uint32_t videoCodecPayload;
@@ -242,13 +260,14 @@ typedef struct SdpControllerPopulateMediaConfiguration
     const Transceiver_t * pTransceiver;
     uint32_t payloadType;
     uint32_t rtxPayloadType;
+    uint32_t redPayloadType; /* RFC 2198 redundant audio, 0 means RED is not used. */
 
     /* Fingerprint. */
     const char * pLocalFingerprint;
     size_t localFingerprintLength;
 
-    /* TWCC EXT ID */
-    uint16_t twccExtId;
+    /* RTP header extension IDs, 0 means the extension is not used. */
+    uint16_t rtpExtensionIds[ SDP_CONTROLLER_RTP_EXTENSION_MAX ];
 } SdpControllerPopulateMediaConfiguration_t;
 
 typedef struct SdpControllerPopulateSessionConfiguration
@@ -592,6 +592,9 @@ static SignalingControllerResult_t FetchTemporaryCredentials( SignalingControlle
             memcpy( pCtx->secretAccessKey, retCredentials.pSecretAccessKey, retCredentials.secretAccessKeyLength );
             pCtx->secretAccessKeyLength = retCredentials.secretAccessKeyLength;
             pCtx->secretAccessKey[ pCtx->secretAccessKeyLength ] = '\0';
+
+            /* Signing keys derived from the previous secret are useless now. */
+            NetworkingUtils_InvalidateSigningKeyCache();
         }
     }
 
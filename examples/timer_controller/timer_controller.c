@@ -17,9 +17,386 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <string.h>
 #include "logging.h"
 #include "timer_controller.h"
 
+#include "task.h"
+#include "semphr.h"
+
+#if TIMER_CONTROLLER_ENABLE_TIMER_WHEEL > 0
+
+#define TIMER_CONTROLLER_WHEEL_SLOT_COUNT ( 1U << TIMER_CONTROLLER_WHEEL_SLOT_BITS )
+#define TIMER_CONTROLLER_WHEEL_SLOT_MASK ( TIMER_CONTROLLER_WHEEL_SLOT_COUNT - 1U )
+
+typedef struct TimerControllerWheel
+{
+    uint8_t isInited;
+    SemaphoreHandle_t mutex;
+    TaskHandle_t taskHandler;
+
+    /* Wheel ticks elapsed since the worker started, wraps around. */
+    uint32_t currentTick;
+
+    /* Level 0 holds timers expiring within TIMER_CONTROLLER_WHEEL_SLOT_COUNT ticks, one slot per tick.
+     * Level 1 holds the later ones, one slot per TIMER_CONTROLLER_WHEEL_SLOT_COUNT ticks, and is
+     * cascaded into level 0 each time level 0 wraps. */
+    TimerHandler_t * pNearSlots[ TIMER_CONTROLLER_WHEEL_SLOT_COUNT ];
+    TimerHandler_t * pFarSlots[ TIMER_CONTROLLER_WHEEL_SLOT_COUNT ];
+
+    /* Timers expired in the current tick and not run yet. */
+    TimerHandler_t * pExpiredList;
+} TimerControllerWheel_t;
+
+static TimerControllerWheel_t timerWheel;
+
+static void PushTimer( TimerHandler_t ** ppListHead,
+                       TimerHandler_t * pTimerHandler )
+{
+    pTimerHandler->pPrev = NULL;
+    pTimerHandler->pNext = *ppListHead;
+    if( *ppListHead != NULL )
+    {
+        ( *ppListHead )->pPrev = pTimerHandler;
+    }
+    *ppListHead = pTimerHandler;
+    pTimerHandler->ppListHead = ppListHead;
+}
+
+static void RemoveTimer( TimerHandler_t * pTimerHandler )
+{
+    if( pTimerHandler->pPrev != NULL )
+    {
+        pTimerHandler->pPrev->pNext = pTimerHandler->pNext;
+    }
+    else
+    {
+        *pTimerHandler->ppListHead = pTimerHandler->pNext;
+    }
+
+    if( pTimerHandler->pNext != NULL )
+    {
+        pTimerHandler->pNext->pPrev = pTimerHandler->pPrev;
+    }
+
+    pTimerHandler->pNext = NULL;
+    pTimerHandler->pPrev = NULL;
+    pTimerHandler->ppListHead = NULL;
+}
+
+static uint32_t ConvertMsToWheelTicks( uint32_t timeMs )
+{
+    uint32_t ticks = ( timeMs + TIMER_CONTROLLER_WHEEL_TICK_MS - 1U ) / TIMER_CONTROLLER_WHEEL_TICK_MS;
+
+    /* Never expire in the tick being processed. */
+    return ( ticks == 0U ) ? 1U : ticks;
+}
+
+/* Must be called with the wheel mutex held. */
+static void InsertTimer( TimerHandler_t * pTimerHandler )
+{
+    uint32_t remainingTicks = pTimerHandler->expireTick - timerWheel.currentTick;
+    uint32_t slotIndex;
+
+    if( remainingTicks < TIMER_CONTROLLER_WHEEL_SLOT_COUNT )
+    {
+        slotIndex = pTimerHandler->expireTick & TIMER_CONTROLLER_WHEEL_SLOT_MASK;
+        PushTimer( &timerWheel.pNearSlots[ slotIndex ],
+                   pTimerHandler );
+    }
+    else
+    {
+        if( remainingTicks < TIMER_CONTROLLER_WHEEL_SLOT_COUNT * TIMER_CONTROLLER_WHEEL_SLOT_COUNT )
+        {
+            slotIndex = ( pTimerHandler->expireTick >> TIMER_CONTROLLER_WHEEL_SLOT_BITS ) & TIMER_CONTROLLER_WHEEL_SLOT_MASK;
+        }
+        else
+        {
+            /* Beyond the wheel span, park it in the last level 1 slot to be cascaded and placed again. */
+            slotIndex = ( ( timerWheel.currentTick >> TIMER_CONTROLLER_WHEEL_SLOT_BITS ) - 1U ) & TIMER_CONTROLLER_WHEEL_SLOT_MASK;
+        }
+
+        PushTimer( &timerWheel.pFarSlots[ slotIndex ],
+                   pTimerHandler );
+    }
+}
+
+/* Must be called with the wheel mutex held. */
+static void AdvanceWheel( void )
+{
+    TimerHandler_t * pTimerHandler;
+    uint32_t slotIndex;
+
+    timerWheel.currentTick++;
+    slotIndex = timerWheel.currentTick & TIMER_CONTROLLER_WHEEL_SLOT_MASK;
+
+    if( slotIndex == 0U )
+    {
+        /* Level 0 wrapped, spread the next level 1 slot over it. */
+        while( timerWheel.pFarSlots[ ( timerWheel.currentTick >> TIMER_CONTROLLER_WHEEL_SLOT_BITS ) & TIMER_CONTROLLER_WHEEL_SLOT_MASK ] != NULL )
+        {
+            pTimerHandler = timerWheel.pFarSlots[ ( timerWheel.currentTick >> TIMER_CONTROLLER_WHEEL_SLOT_BITS ) & TIMER_CONTROLLER_WHEEL_SLOT_MASK ];
+            RemoveTimer( pTimerHandler );
+            InsertTimer( pTimerHandler );
+        }
+    }
+
+    while( timerWheel.pNearSlots[ slotIndex ] != NULL )
+    {
+        pTimerHandler = timerWheel.pNearSlots[ slotIndex ];
+        RemoveTimer( pTimerHandler );
+        PushTimer( &timerWheel.pExpiredList,
+                   pTimerHandler );
+    }
+}
+
+static void TimerController_WheelTask( void * pParameter )
+{
+    TickType_t lastWakeTime = xTaskGetTickCount();
+    TimerHandler_t * pTimerHandler;
+    TimerControllerTimerExpireCallback onTimerExpire;
+    void * pUserContext = NULL;
+
+    ( void ) pParameter;
+
+    for( ;; )
+    {
+        /* Catches up without sleeping if callbacks made the worker fall behind. */
+        vTaskDelayUntil( &lastWakeTime,
+                         pdMS_TO_TICKS( TIMER_CONTROLLER_WHEEL_TICK_MS ) );
+
+        if( xSemaphoreTake( timerWheel.mutex,
+                            portMAX_DELAY ) == pdTRUE )
+        {
+            AdvanceWheel();
+            xSemaphoreGive( timerWheel.mutex );
+        }
+
+        /* Run the expiries of this tick one by one without holding the lock,
+         * so callbacks can set, reset or delete any timer, including their own. */
+        do
+        {
+            onTimerExpire = NULL;
+
+            if( xSemaphoreTake( timerWheel.mutex,
+                                portMAX_DELAY ) == pdTRUE )
+            {
+                pTimerHandler = timerWheel.pExpiredList;
+                if( pTimerHandler != NULL )
+                {
+                    RemoveTimer( pTimerHandler );
+
+                    if( pTimerHandler->reloadTicks != 0U )
+                    {
+                        pTimerHandler->expireTick = timerWheel.currentTick + pTimerHandler->reloadTicks;
+                        InsertTimer( pTimerHandler );
+                    }
+
+                    onTimerExpire = pTimerHandler->onTimerExpire;
+                    pUserContext = pTimerHandler->pUserContext;
+                }
+
+                xSemaphoreGive( timerWheel.mutex );
+            }
+
+            if( onTimerExpire != NULL )
+            {
+                onTimerExpire( pUserContext );
+            }
+        } while( onTimerExpire != NULL );
+    }
+}
+
+TimerControllerResult_t TimerController_Init( void )
+{
+    TimerControllerResult_t ret = TIMER_CONTROLLER_RESULT_OK;
+
+    if( timerWheel.isInited == 0U )
+    {
+        memset( &timerWheel,
+                0,
+                sizeof( TimerControllerWheel_t ) );
+
+        timerWheel.mutex = xSemaphoreCreateMutex();
+        if( timerWheel.mutex == NULL )
+        {
+            LogError( ( "Fail to create mutex for timer wheel." ) );
+            ret = TIMER_CONTROLLER_RESULT_FAIL_CREATE_MUTEX;
+        }
+
+        if( ret == TIMER_CONTROLLER_RESULT_OK )
+        {
+            if( xTaskCreate( TimerController_WheelTask,
+                             TIMER_CONTROLLER_WHEEL_TASK_NAME,
+                             TIMER_CONTROLLER_WHEEL_TASK_STACK_SIZE,
+                             NULL,
+                             TIMER_CONTROLLER_WHEEL_TASK_PRIORITY,
+                             &timerWheel.taskHandler ) != pdPASS )
+            {
+                LogError( ( "xTaskCreate(%s) failed", TIMER_CONTROLLER_WHEEL_TASK_NAME ) );
+                vSemaphoreDelete( timerWheel.mutex );
+                timerWheel.mutex = NULL;
+                ret = TIMER_CONTROLLER_RESULT_FAIL_CREATE_TASK;
+            }
+        }
+
+        if( ret == TIMER_CONTROLLER_RESULT_OK )
+        {
+            timerWheel.isInited = 1U;
+        }
+    }
+
+    return ret;
+}
+
+TimerControllerResult_t TimerController_Create( TimerHandler_t * pTimerHandler,
+                                                const char * pTimerName,
+                                                uint32_t initialTimeMs,
+                                                uint32_t repeatTimeMs,
+                                                TimerControllerTimerExpireCallback onTimerExpire,
+                                                void * pUserContext )
+{
+    TimerControllerResult_t ret = TIMER_CONTROLLER_RESULT_OK;
+
+    ( void ) initialTimeMs;
+
+    if( ( pTimerHandler == NULL ) || ( onTimerExpire == NULL ) || ( pTimerName == NULL ) )
+    {
+        LogError( ( "Invalid input parameters, pTimerHandler=%p, onTimerExpire=%p, pTimerName=%p", pTimerHandler, onTimerExpire, pTimerName ) );
+        ret = TIMER_CONTROLLER_RESULT_BAD_PARAMETER;
+    }
+    else if( timerWheel.isInited == 0U )
+    {
+        LogError( ( "Timer wheel is not initialized, fail to create timer %s", pTimerName ) );
+        ret = TIMER_CONTROLLER_RESULT_FAIL_TIMER_CREATE;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    if( ret == TIMER_CONTROLLER_RESULT_OK )
+    {
+        /* Nothing is allocated, the handler itself is the wheel entry. */
+        pTimerHandler->pNext = NULL;
+        pTimerHandler->pPrev = NULL;
+        pTimerHandler->ppListHead = NULL;
+        pTimerHandler->expireTick = 0U;
+        pTimerHandler->reloadTicks = 0U;
+        pTimerHandler->isAutoReload = ( repeatTimeMs == 0U ) ? 0U : 1U;
+        pTimerHandler->onTimerExpire = onTimerExpire;
+        pTimerHandler->pUserContext = pUserContext;
+    }
+
+    return ret;
+}
+
+TimerControllerResult_t TimerController_SetTimer( TimerHandler_t * pTimerHandler,
+                                                  uint32_t initialTimeMs,
+                                                  uint32_t repeatTimeMs )
+{
+    TimerControllerResult_t ret = TIMER_CONTROLLER_RESULT_OK;
+    uint32_t ticks;
+
+    ( void ) repeatTimeMs;
+
+    if( pTimerHandler == NULL )
+    {
+        ret = TIMER_CONTROLLER_RESULT_BAD_PARAMETER;
+    }
+    else if( timerWheel.isInited == 0U )
+    {
+        LogError( ( "Timer wheel is not initialized" ) );
+        ret = TIMER_CONTROLLER_RESULT_FAIL_TIMER_SET;
+    }
+    else
+    {
+        /* Empty else marker. */
+    }
+
+    if( ret == TIMER_CONTROLLER_RESULT_OK )
+    {
+        if( xSemaphoreTake( timerWheel.mutex,
+                            portMAX_DELAY ) == pdTRUE )
+        {
+            /* Same as xTimerChangePeriod(), an auto-reload timer repeats with the new period. */
+            if( pTimerHandler->ppListHead != NULL )
+            {
+                RemoveTimer( pTimerHandler );
+            }
+
+            ticks = ConvertMsToWheelTicks( initialTimeMs );
+            pTimerHandler->reloadTicks = ( pTimerHandler->isAutoReload != 0U ) ? ticks : 0U;
+            pTimerHandler->expireTick = timerWheel.currentTick + ticks;
+            InsertTimer( pTimerHandler );
+
+            xSemaphoreGive( timerWheel.mutex );
+        }
+        else
+        {
+            LogError( ( "Fail to set timer" ) );
+            ret = TIMER_CONTROLLER_RESULT_FAIL_TIMER_SET;
+        }
+    }
+
+    return ret;
+}
+
+void TimerController_Reset( TimerHandler_t * pTimerHandler )
+{
+    if( ( pTimerHandler != NULL ) &&
+        ( timerWheel.isInited != 0U ) )
+    {
+        if( xSemaphoreTake( timerWheel.mutex,
+                            portMAX_DELAY ) == pdTRUE )
+        {
+            // Cancel the timer
+            if( pTimerHandler->ppListHead != NULL )
+            {
+                RemoveTimer( pTimerHandler );
+            }
+
+            xSemaphoreGive( timerWheel.mutex );
+        }
+        else
+        {
+            LogError( ( "Fail to reset timer" ) );
+        }
+    }
+}
+
+void TimerController_Delete( TimerHandler_t * pTimerHandler )
+{
+    /* The handler owns no resource in the wheel, cancelling it is enough. */
+    TimerController_Reset( pTimerHandler );
+}
+
+TimerControllerResult_t TimerController_IsTimerSet( TimerHandler_t * pTimerHandler )
+{
+    TimerControllerResult_t ret = TIMER_CONTROLLER_RESULT_OK;
+
+    if( pTimerHandler == NULL )
+    {
+        ret = TIMER_CONTROLLER_RESULT_BAD_PARAMETER;
+    }
+
+    if( ret == TIMER_CONTROLLER_RESULT_OK )
+    {
+        if( pTimerHandler->ppListHead != NULL )
+        {
+            ret = TIMER_CONTROLLER_RESULT_SET;
+        }
+        else
+        {
+            ret = TIMER_CONTROLLER_RESULT_NOT_SET;
+        }
+    }
+
+    return ret;
+}
+
+#else /* TIMER_CONTROLLER_ENABLE_TIMER_WHEEL > 0 */
+
 static void generalTimerCallback( TimerHandle_t xTimer )
 {
     TimerHandler_t * pTimerHandler = ( TimerHandler_t * ) pvTimerGetTimerID( xTimer );
@@ -34,6 +411,12 @@ static void generalTimerCallback( TimerHandle_t xTimer )
     }
 }
 
+TimerControllerResult_t TimerController_Init( void )
+{
+    /* FreeRTOS software timers run on the timer daemon task, nothing to start. */
+    return TIMER_CONTROLLER_RESULT_OK;
+}
+
 TimerControllerResult_t TimerController_Create( TimerHandler_t * pTimerHandler,
                                                 const char * pTimerName,
                                                 uint32_t initialTimeMs,
@@ -115,7 +498,7 @@ TimerControllerResult_t TimerController_SetTimer( TimerHandler_t * pTimerHandler
 
 void TimerController_Reset( TimerHandler_t * pTimerHandler )
 {
-    if( pTimerHandler != NULL )
+    if( ( pTimerHandler != NULL ) && ( pTimerHandler->timer != NULL ) )
     {
         // Cancel the timer
         if( xTimerStop( pTimerHandler->timer, 0 ) != pdPASS )
@@ -162,3 +545,5 @@ TimerControllerResult_t TimerController_IsTimerSet( TimerHandler_t * pTimerHandl
 
     return ret;
 }
+
+#endif /* TIMER_CONTROLLER_ENABLE_TIMER_WHEEL > 0 */
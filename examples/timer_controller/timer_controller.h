@@ -25,8 +25,37 @@ extern "C" {
 
 #include <stdio.h>
 #include <stdint.h>
+#include "FreeRTOS.h"
 #include "timers.h"
 
+/**
+ * Serve all timers from one hierarchical timer wheel driven by a dedicated
+ * worker task, instead of one FreeRTOS software timer per handler on the timer
+ * daemon task. Arming and cancelling are O(1) and the expiries of a tick are
+ * run in one batch by the worker. 0 keeps the FreeRTOS software timers.
+ */
+#ifndef TIMER_CONTROLLER_ENABLE_TIMER_WHEEL
+#define TIMER_CONTROLLER_ENABLE_TIMER_WHEEL ( 0 )
+#endif /* TIMER_CONTROLLER_ENABLE_TIMER_WHEEL */
+
+/* Resolution of the wheel, timers are rounded up to it. */
+#ifndef TIMER_CONTROLLER_WHEEL_TICK_MS
+#define TIMER_CONTROLLER_WHEEL_TICK_MS ( 10 )
+#endif /* TIMER_CONTROLLER_WHEEL_TICK_MS */
+
+/* Each of the two wheel levels has ( 1 << TIMER_CONTROLLER_WHEEL_SLOT_BITS ) slots. With 10 ms ticks
+ * the first level spans 640 ms and the second about 41 seconds, longer timers are cascaded again. */
+#ifndef TIMER_CONTROLLER_WHEEL_SLOT_BITS
+#define TIMER_CONTROLLER_WHEEL_SLOT_BITS ( 6 )
+#endif /* TIMER_CONTROLLER_WHEEL_SLOT_BITS */
+
+#ifndef TIMER_CONTROLLER_WHEEL_TASK_PRIORITY
+#define TIMER_CONTROLLER_WHEEL_TASK_PRIORITY ( tskIDLE_PRIORITY + 3 )
+#endif /* TIMER_CONTROLLER_WHEEL_TASK_PRIORITY */
+
+#define TIMER_CONTROLLER_WHEEL_TASK_NAME "TimerWheelTask"
+#define TIMER_CONTROLLER_WHEEL_TASK_STACK_SIZE ( 4096 )
+
 typedef enum TimerControllerResult
 {
     TIMER_CONTROLLER_RESULT_OK = 0,
@@ -36,17 +65,32 @@ typedef enum TimerControllerResult
     TIMER_CONTROLLER_RESULT_FAIL_TIMER_CREATE,
     TIMER_CONTROLLER_RESULT_FAIL_TIMER_SET,
     TIMER_CONTROLLER_RESULT_FAIL_GETTIME,
+    TIMER_CONTROLLER_RESULT_FAIL_CREATE_MUTEX,
+    TIMER_CONTROLLER_RESULT_FAIL_CREATE_TASK,
 } TimerControllerResult_t;
 
 typedef void (* TimerControllerTimerExpireCallback)( void * pUserContext );
 
 typedef struct TimerHandler
 {
+    #if TIMER_CONTROLLER_ENABLE_TIMER_WHEEL > 0
+    /* Links in the wheel slot or pending expiry list the timer is armed in, ppListHead is NULL when not armed. */
+    struct TimerHandler * pNext;
+    struct TimerHandler * pPrev;
+    struct TimerHandler ** ppListHead;
+    uint32_t expireTick;
+    uint32_t reloadTicks; /* 0 for one-shot timers. */
+    uint8_t isAutoReload;
+    #else
     TimerHandle_t timer;
+    #endif /* TIMER_CONTROLLER_ENABLE_TIMER_WHEEL > 0 */
     TimerControllerTimerExpireCallback onTimerExpire;
     void * pUserContext;
 } TimerHandler_t;
 
+/* Start the timer wheel worker task, no-op with FreeRTOS software timers. Call it once before creating timers. */
+TimerControllerResult_t TimerController_Init( void );
+
 TimerControllerResult_t TimerController_Create( TimerHandler_t * pTimerHandler,
                                                 const char * pTimerName,
                                                 uint32_t initialTimeMs,
@@ -0,0 +1,267 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Replays packet traces through the adaptive jitter buffer estimator on the host. Lateness is
+ * derived the same way PeerConnectionJitterBuffer_Push does it, from the newest sequence number
+ * and timestamp seen so far, and the interarrival jitter the same way the reception statistics do. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "peer_connection_jitter_estimator.h"
+
+/* Host ticks are milliseconds. */
+#define TEST_HALF_LIFE_TICKS ( 2000U )
+#define TEST_CLOCK_RATE ( 48000U )
+#define TEST_MS_TO_RTP( ms ) ( ( uint32_t )( ( ms ) * ( TEST_CLOCK_RATE / 1000U ) ) )
+#define TEST_MIN_TOLERENCE TEST_MS_TO_RTP( 20U )
+#define TEST_MAX_TOLERENCE TEST_MS_TO_RTP( 1000U )
+
+typedef struct TestPacket
+{
+    uint32_t arrivalTick;
+    uint16_t sequenceNumber;
+    uint32_t rtpTimestamp;
+} TestPacket_t;
+
+typedef struct TestReplay
+{
+    PeerConnectionJitterEstimator_t estimator;
+    uint8_t isStart;
+    uint16_t newestSequenceNumber;
+    uint32_t newestTimestamp;
+    uint32_t lastTransit;
+    uint32_t tolerence;
+} TestReplay_t;
+
+static int failureCount = 0;
+
+#define TEST_EXPECT( condition )                                        \
+    do {                                                                \
+        if( !( condition ) )                                            \
+        {                                                               \
+            printf( "%s:%d: expect %s\n", __FILE__, __LINE__, #condition ); \
+            failureCount++;                                             \
+        }                                                               \
+    } while( 0 )
+
+static void ReplayInit( TestReplay_t * pReplay,
+                        uint32_t startTick )
+{
+    PeerConnectionJitterEstimator_Init( &pReplay->estimator,
+                                        TEST_HALF_LIFE_TICKS );
+    pReplay->estimator.reorderPeakTick = startTick;
+    pReplay->isStart = 0U;
+    pReplay->newestSequenceNumber = 0U;
+    pReplay->newestTimestamp = 0U;
+    pReplay->lastTransit = 0U;
+    pReplay->tolerence = TEST_MAX_TOLERENCE;
+}
+
+static void ReplayPacket( TestReplay_t * pReplay,
+                          const TestPacket_t * pPacket )
+{
+    uint32_t lateness = 0U;
+    uint32_t transit;
+    int32_t d;
+
+    /* RFC 3550 appendix A.8, as UpdateReceiverStats does it. */
+    transit = TEST_MS_TO_RTP( pPacket->arrivalTick ) - pPacket->rtpTimestamp;
+    if( pReplay->isStart != 0U )
+    {
+        d = ( int32_t )( transit - pReplay->lastTransit );
+        if( d < 0 )
+        {
+            d = -d;
+        }
+        pReplay->estimator.jitter += ( uint32_t ) d - ( ( pReplay->estimator.jitter + 8 ) >> 4 );
+    }
+    pReplay->lastTransit = transit;
+
+    if( ( pReplay->isStart == 0U ) ||
+        ( ( int16_t )( pPacket->sequenceNumber - pReplay->newestSequenceNumber ) > 0 ) )
+    {
+        pReplay->isStart = 1U;
+        pReplay->newestSequenceNumber = pPacket->sequenceNumber;
+        pReplay->newestTimestamp = pPacket->rtpTimestamp;
+    }
+    else
+    {
+        lateness = pReplay->newestTimestamp - pPacket->rtpTimestamp;
+    }
+
+    pReplay->tolerence = PeerConnectionJitterEstimator_Update( &pReplay->estimator,
+                                                               pPacket->arrivalTick,
+                                                               lateness,
+                                                               TEST_MIN_TOLERENCE,
+                                                               TEST_MAX_TOLERENCE );
+}
+
+/* Replay an evenly paced stream from startTick up to endTick, and return the final tolerence. */
+static uint32_t ReplayPaced( TestReplay_t * pReplay,
+                             uint32_t startTick,
+                             uint32_t endTick,
+                             uint32_t intervalMs,
+                             uint16_t * pSequenceNumber )
+{
+    TestPacket_t packet;
+    uint32_t tick;
+
+    for( tick = startTick; ( int32_t )( endTick - tick ) >= 0; tick += intervalMs )
+    {
+        packet.arrivalTick = tick;
+        packet.sequenceNumber = ( *pSequenceNumber )++;
+        packet.rtpTimestamp = TEST_MS_TO_RTP( tick - startTick );
+        ReplayPacket( pReplay,
+                      &packet );
+    }
+
+    return pReplay->tolerence;
+}
+
+/* 20 ms Opus packets with some arrival jitter, seq 4 arrives 60 ms behind the newest timestamp. */
+static const TestPacket_t reorderTrace[] =
+{
+    { 0U, 1U, TEST_MS_TO_RTP( 0U ) },
+    { 21U, 2U, TEST_MS_TO_RTP( 20U ) },
+    { 40U, 3U, TEST_MS_TO_RTP( 40U ) },
+    { 81U, 5U, TEST_MS_TO_RTP( 80U ) },
+    { 100U, 6U, TEST_MS_TO_RTP( 100U ) },
+    { 119U, 7U, TEST_MS_TO_RTP( 120U ) },
+    { 121U, 4U, TEST_MS_TO_RTP( 60U ) },
+    { 140U, 8U, TEST_MS_TO_RTP( 140U ) },
+    { 161U, 9U, TEST_MS_TO_RTP( 160U ) },
+};
+
+static void TestSteadyStreamStaysAtMin( void )
+{
+    TestReplay_t replay;
+    uint16_t seq = 0U;
+
+    ReplayInit( &replay,
+                0U );
+    TEST_EXPECT( ReplayPaced( &replay, 0U, 10000U, 20U, &seq ) == TEST_MIN_TOLERENCE );
+}
+
+static void TestReorderTraceRaisesTolerence( void )
+{
+    TestReplay_t replay;
+    size_t i;
+
+    ReplayInit( &replay,
+                0U );
+    for( i = 0; i < sizeof( reorderTrace ) / sizeof( reorderTrace[ 0 ] ); i++ )
+    {
+        ReplayPacket( &replay,
+                      &reorderTrace[ i ] );
+    }
+
+    /* Seq 4 came 60 ms behind the newest timestamp, the wait must cover that. */
+    TEST_EXPECT( replay.estimator.reorderPeakRtpTimeStamp == TEST_MS_TO_RTP( 60U ) );
+    TEST_EXPECT( replay.tolerence >= TEST_MS_TO_RTP( 60U ) );
+    TEST_EXPECT( replay.tolerence <= TEST_MAX_TOLERENCE );
+}
+
+/* The same late packet followed by streams of different packet rates decays at the same pace. */
+static void TestDecayFollowsElapsedTime( void )
+{
+    static const uint32_t intervalsMs[] = { 10U, 20U, 60U, 100U };
+    uint32_t reorder[ sizeof( intervalsMs ) / sizeof( intervalsMs[ 0 ] ) ];
+    TestReplay_t replay;
+    uint16_t seq;
+    size_t i;
+
+    for( i = 0; i < sizeof( intervalsMs ) / sizeof( intervalsMs[ 0 ] ); i++ )
+    {
+        ReplayInit( &replay,
+                    0U );
+        replay.estimator.reorderPeakRtpTimeStamp = TEST_MS_TO_RTP( 400U );
+        seq = 0U;
+        ( void ) ReplayPaced( &replay, 0U, 3000U, intervalsMs[ i ], &seq );
+        reorder[ i ] = PeerConnectionJitterEstimator_GetReorderDepth( &replay.estimator,
+                                                                      3000U );
+    }
+
+    /* 1.5 half-lives: halved once, then a quarter of that off. */
+    for( i = 0; i < sizeof( intervalsMs ) / sizeof( intervalsMs[ 0 ] ); i++ )
+    {
+        TEST_EXPECT( reorder[ i ] == reorder[ 0 ] );
+    }
+    TEST_EXPECT( reorder[ 0 ] == TEST_MS_TO_RTP( 150U ) );
+}
+
+static void TestDecayAcrossTickWrap( void )
+{
+    PeerConnectionJitterEstimator_t estimator;
+    uint32_t startTick = 0xFFFFFFFFU - 500U;
+    uint32_t tolerence;
+
+    PeerConnectionJitterEstimator_Init( &estimator,
+                                        TEST_HALF_LIFE_TICKS );
+    tolerence = PeerConnectionJitterEstimator_Update( &estimator, startTick, TEST_MS_TO_RTP( 200U ),
+                                                      TEST_MIN_TOLERENCE, TEST_MAX_TOLERENCE );
+    TEST_EXPECT( tolerence == TEST_MS_TO_RTP( 200U ) );
+
+    /* One half-life later, the tick counter has wrapped in between. */
+    TEST_EXPECT( PeerConnectionJitterEstimator_GetReorderDepth( &estimator, startTick + TEST_HALF_LIFE_TICKS ) == TEST_MS_TO_RTP( 100U ) );
+
+    /* Long after, nothing is left. */
+    TEST_EXPECT( PeerConnectionJitterEstimator_GetReorderDepth( &estimator, startTick + 64U * TEST_HALF_LIFE_TICKS ) == 0U );
+}
+
+static void TestLatenessBeyondMaxIgnored( void )
+{
+    PeerConnectionJitterEstimator_t estimator;
+    uint32_t tolerence;
+
+    PeerConnectionJitterEstimator_Init( &estimator,
+                                        TEST_HALF_LIFE_TICKS );
+    tolerence = PeerConnectionJitterEstimator_Update( &estimator, 0U, TEST_MAX_TOLERENCE + 1U,
+                                                      TEST_MIN_TOLERENCE, TEST_MAX_TOLERENCE );
+    TEST_EXPECT( tolerence == TEST_MIN_TOLERENCE );
+    TEST_EXPECT( estimator.reorderPeakRtpTimeStamp == 0U );
+}
+
+/* With NACK the wait is floored at RTT plus the retry interval, still capped by the maximum. */
+static void TestNackFloor( void )
+{
+    TestReplay_t replay;
+    uint16_t seq = 0U;
+
+    ReplayInit( &replay,
+                0U );
+    replay.estimator.floorRtpTimeStamp = TEST_MS_TO_RTP( 100U + 100U );
+    TEST_EXPECT( ReplayPaced( &replay, 0U, 10000U, 20U, &seq ) == TEST_MS_TO_RTP( 200U ) );
+
+    replay.estimator.floorRtpTimeStamp = TEST_MS_TO_RTP( 2000U + 2000U );
+    TEST_EXPECT( ReplayPaced( &replay, 10020U, 11000U, 20U, &seq ) == TEST_MAX_TOLERENCE );
+}
+
+int main( void )
+{
+    TestSteadyStreamStaysAtMin();
+    TestReorderTraceRaisesTolerence();
+    TestDecayFollowsElapsedTime();
+    TestDecayAcrossTickWrap();
+    TestLatenessBeyondMaxIgnored();
+    TestNackFloor();
+
+    if( failureCount == 0 )
+    {
+        printf( "All jitter estimator tests passed.\n" );
+    }
+
+    return ( failureCount == 0 ) ? 0 : 1;
+}